@@ -0,0 +1,219 @@
+#!/usr/bin/env julia
+# build_performance.jl - How JMake scales with project size and shape
+# Generates synthetic projects (see synthetic_projects.jl) next to copies of
+# examples/mathlib and examples/cmake_import, and times separately:
+#
+#   discover            Discovery.discover on the project
+#   dependency_graph    ASTWalker.build_dependency_graph over all sources and headers
+#   cold_build          LLVMake.compile_project with empty build dir and artifact cache
+#   noop_build          incremental rebuild, nothing changed
+#   touch_build         incremental rebuild after editing one widely included header
+#   warm_build          build dir and build state removed, artifact cache kept
+#   wrap_cached/lazy    wrapper generation for the project's exported symbols
+#   rpc_roundtrip       DaemonRPC request latency (median and p99), small and 1 MB payloads
+#
+# Results are written as JSON (one record per project and metric) to
+# benchmarks/results/, or to --out; compare two runs with compare_results.jl.
+#
+# Run with: julia --project=. benchmarks/build_performance.jl [--sizes 10,1000,10000]
+#           [--layouts wide,deep] [--no-build] [--out results.json]
+
+using JMake
+using JSON
+using Dates
+
+include(joinpath(@__DIR__, "synthetic_projects.jl"))
+
+const ROOT = dirname(@__DIR__)
+
+function option(name::String, default)
+    i = findfirst(==(name), ARGS)
+    return isnothing(i) || i == length(ARGS) ? default : ARGS[i + 1]
+end
+
+const SIZES = parse.(Int, split(option("--sizes", "10,1000"), ','))
+const LAYOUTS = Symbol.(split(option("--layouts", "wide,deep"), ','))
+const BUILD = !("--no-build" in ARGS)
+const OUT = option("--out", "")
+
+const RECORDS = Dict{String,Any}[]
+
+"""
+Record one measurement (seconds unless `unit` says otherwise)
+"""
+function record!(project::String, metric::String, value::Real; unit::String="s",
+                 meta::AbstractDict=Dict{String,Any}())
+    push!(RECORDS, merge(Dict{String,Any}(meta), Dict{String,Any}(
+        "project" => project, "metric" => metric, "value" => Float64(value), "unit" => unit)))
+    println("  $(rpad(metric, 22)) $(round(value, digits=4)) $unit")
+end
+
+"""
+Seconds taken by `f`, with its console output discarded
+"""
+quiet_elapsed(f) = @elapsed redirect_stdout(f, devnull)
+
+"""
+Best of `n` runs, for steps cheap enough to repeat
+"""
+best_of(f, n::Int) = minimum(quiet_elapsed(f) for _ in 1:n)
+
+function sources_and_headers(root::String)
+    return sort!([joinpath(dir, f) for (dir, _, files) in walkdir(root) for f in files
+                  if any(ext -> endswith(f, ext), (".cpp", ".cc", ".h", ".hpp"))
+                  && !occursin("/build/", joinpath(dir, f))])
+end
+
+"""
+Time discovery, the include graph, the four build scenarios and wrapper generation
+"""
+function bench_project(name::String, root::String; touch_header::String="", symbols::Int=0,
+                       meta::Dict{String,Any}=Dict{String,Any}())
+    println("\n▶ $name")
+    files = sources_and_headers(root)
+    meta["files"] = length(files)
+
+    record!(name, "discover", quiet_elapsed(() -> JMake.Discovery.discover(root; force=true)); meta=meta)
+
+    include_dirs = filter(isdir, [joinpath(root, "include"), root])
+    repeats = length(files) > 2000 ? 1 : 3
+    record!(name, "dependency_graph",
+            best_of(() -> JMake.ASTWalker.build_dependency_graph(files, include_dirs), repeats); meta=meta)
+
+    BUILD && bench_builds(name, root, touch_header, meta)
+
+    if symbols > 0
+        bench_wrappers(name, symbols, meta)
+    end
+end
+
+function bench_builds(name::String, root::String, touch_header::String, meta::Dict{String,Any})
+    compiler = try
+        JMake.LLVMake.LLVMJuliaCompiler(joinpath(root, "llvmake.toml"))
+    catch e
+        @warn "Skipping builds of $name: $(sprint(showerror, e))"
+        return
+    end
+    build!() = JMake.LLVMake.compile_project(compiler)
+    reset!(dirs...) = foreach(d -> rm(joinpath(root, d); recursive=true, force=true), dirs)
+
+    reset!("build", "julia", ".jmake_cache")
+    record!(name, "cold_build", quiet_elapsed(build!); meta=meta)
+    record!(name, "noop_build", quiet_elapsed(build!); meta=meta)
+
+    if !isempty(touch_header)
+        open(io -> println(io, "// touched $(now())"), joinpath(root, touch_header), "a")
+        record!(name, "touch_build", quiet_elapsed(build!); meta=merge(meta, Dict("header" => touch_header)))
+    end
+
+    # Artifacts come back from the content-addressed cache
+    reset!("build", "julia")
+    record!(name, "warm_build", quiet_elapsed(build!); meta=meta)
+end
+
+function bench_wrappers(name::String, count::Int, meta::Dict{String,Any})
+    dir = mktempdir()
+    symbols = synthetic_symbols(count)
+    binary = JMake.JuliaWrapItUp.BinaryInfo(joinpath(dir, "lib$name.so"), "lib$name", :shared_lib,
+                                            string(Sys.ARCH), symbols, String[], Dict{String,Any}())
+    for mode in ("cached", "lazy")
+        config_file = joinpath(dir, "wrapper_$mode.toml")
+        write(config_file, """
+        project_root = "$(escape_string(dir))"
+
+        [wrapper]
+        call_mode = "$mode"
+        """)
+        wrapper = JMake.JuliaWrapItUp.BinaryWrapper(config_file)
+        generate() = mode == "lazy" ? JMake.JuliaWrapItUp.generate_lazy_wrapper(wrapper, binary) :
+                                      JMake.JuliaWrapItUp.generate_advanced_wrapper(wrapper, binary)
+        generate()  # compile the generator first
+        record!(name, "wrap_$mode", best_of(generate, 3); meta=merge(meta, Dict("symbols" => count)))
+    end
+    rm(dir; recursive=true, force=true)
+end
+
+"""
+Median and p99 latency of DaemonRPC calls to an echo handler on this host
+"""
+function bench_rpc()
+    println("\n▶ daemon RPC")
+    port = 47000 + rand(0:800)
+    echo(args) = Dict(:success => true, :value => args["value"])
+    server = JMake.DaemonRPC.serve_rpc(port, [echo])
+    try
+        for (label, value) in [("small", 1), ("1mb", rand(UInt8, 1 << 20))]
+            call() = JMake.DaemonRPC.call(port, :echo, Dict("value" => value))
+            call()
+            n = label == "small" ? 1000 : 50
+            times = sort!([@elapsed(call()) for _ in 1:n])
+            record!("daemon_rpc", "rpc_roundtrip_$(label)_median", 1e3 * times[cld(n, 2)]; unit="ms")
+            record!("daemon_rpc", "rpc_roundtrip_$(label)_p99", 1e3 * times[ceil(Int, 0.99n)]; unit="ms")
+        end
+    finally
+        close(server)
+    end
+end
+
+"""
+Copy an example project (sources, headers and CMake files) to a scratch directory
+"""
+function example_copy(name::String, workspace::String)
+    dest = joinpath(workspace, name)
+    cp(joinpath(ROOT, "examples", name), dest)
+    foreach(d -> rm(joinpath(dest, d); recursive=true, force=true), ["build", "julia", ".jmake_cache"])
+    write_llvmake_config(dest)
+    return dest
+end
+
+git_revision() = try
+    readchomp(`git -C $ROOT rev-parse --short HEAD`)
+catch
+    "unknown"
+end
+
+# ============================================================================
+# RUN
+# ============================================================================
+
+workspace = mktempdir()
+try
+    for size in SIZES, layout in LAYOUTS
+        spec = SyntheticSpec(size, layout)
+        root = joinpath(workspace, spec.name)
+        generation = @elapsed generate_project(root, spec)
+        println("\nGenerated $(spec.name) in $(round(generation, digits=2)) s")
+        bench_project(spec.name, root; touch_header=joinpath("include", header_name(1, 1)),
+                      symbols=size * spec.functions,
+                      meta=Dict{String,Any}("tus" => size, "layout" => string(layout)))
+    end
+
+    mathlib = example_copy("mathlib", workspace)
+    bench_project("mathlib", mathlib; touch_header=joinpath("include", "vector.h"), symbols=0)
+
+    cmake_import = example_copy("cmake_import", workspace)
+    record!("cmake_import", "parse_cmake",
+            best_of(() -> JMake.CMakeParser.parse_cmake_file(joinpath(cmake_import, "CMakeLists.txt")), 5))
+    bench_project("cmake_import", cmake_import)
+
+    bench_rpc()
+finally
+    rm(workspace; recursive=true, force=true)
+end
+
+results = Dict(
+    "benchmark" => "build_performance",
+    "jmake" => string(JMake.VERSION),
+    "git" => git_revision(),
+    "julia" => string(VERSION),
+    "cpu" => Sys.cpu_info()[1].model,
+    "threads" => Threads.nthreads(),
+    "cores" => Sys.CPU_THREADS,
+    "timestamp" => string(now()),
+    "records" => RECORDS
+)
+
+out = isempty(OUT) ? joinpath(@__DIR__, "results", "build_performance_$(Dates.format(now(), "yyyymmdd_HHMMSS"))_$(results["git"]).json") : OUT
+mkpath(dirname(out))
+open(io -> JSON.print(io, results, 2), out, "w")
+println("\nResults written to $out")
@@ -0,0 +1,51 @@
+#!/usr/bin/env julia
+# compare_results.jl - Diff two build_performance.jl result files
+# Prints every (project, metric) present in both runs with the new/old ratio, and
+# exits non-zero when one got slower than the threshold (default 10%) allows.
+#
+# Run with: julia --project=. benchmarks/compare_results.jl old.json new.json [--threshold 0.1]
+
+using JSON
+
+length(ARGS) >= 2 || error("Usage: compare_results.jl old.json new.json [--threshold 0.1]")
+
+const THRESHOLD = let i = findfirst(==("--threshold"), ARGS)
+    isnothing(i) ? 0.10 : parse(Float64, ARGS[i + 1])
+end
+
+# Noise floor: steps faster than this are reported but never flagged
+const MIN_SECONDS = 0.005
+
+load_records(file) = Dict((r["project"], r["metric"]) => r for r in JSON.parsefile(file)["records"])
+
+old_run = JSON.parsefile(ARGS[1])
+new_run = JSON.parsefile(ARGS[2])
+old = load_records(ARGS[1])
+new = load_records(ARGS[2])
+
+println("old: $(old_run["git"]) ($(old_run["timestamp"]))")
+println("new: $(new_run["git"]) ($(new_run["timestamp"]))")
+println()
+println(rpad("project", 24), rpad("metric", 30), lpad("old", 12), lpad("new", 12), lpad("ratio", 9))
+
+regressions = 0
+for key in sort!(collect(intersect(keys(old), keys(new))))
+    a, b = old[key]["value"], new[key]["value"]
+    ratio = a > 0 ? b / a : NaN
+    floor = old[key]["unit"] == "ms" ? 1e3 * MIN_SECONDS : MIN_SECONDS
+    slower = ratio > 1 + THRESHOLD && b > floor
+    global regressions += slower
+    println(rpad(key[1], 24), rpad(key[2], 30), lpad(round(a, digits=4), 12), lpad(round(b, digits=4), 12),
+            lpad(round(ratio, digits=2), 9), slower ? "  ⚠️ slower" : "")
+end
+
+for key in sort!(collect(setdiff(keys(new), keys(old))))
+    println(rpad(key[1], 24), rpad(key[2], 30), lpad("-", 12), lpad(round(new[key]["value"], digits=4), 12))
+end
+
+println()
+if regressions > 0
+    println("❌ $regressions metric(s) slower by more than $(round(Int, 100THRESHOLD))%")
+    exit(1)
+end
+println("✅ No regressions above $(round(Int, 100THRESHOLD))%")
@@ -0,0 +1,168 @@
+# synthetic_projects.jl - Generated C++ projects for the build-performance benchmarks
+# Deterministic for a given spec (fixed seed), so results compare across versions.
+#
+#   :wide - many components (one directory each) of a few TUs, shallow header chains
+#   :deep - few components split over nested directories, long header include chains
+#
+# Every TU includes the project-wide `common.h`, its component header and `fanout`
+# other headers, and defines `functions` extern "C" functions (the exported symbols).
+
+struct SyntheticSpec
+    name::String
+    tus::Int
+    layout::Symbol      # :wide or :deep
+    fanout::Int         # extra headers included per TU
+    functions::Int      # extern "C" functions per TU
+end
+
+SyntheticSpec(tus::Int, layout::Symbol; fanout::Int=6, functions::Int=8) =
+    SyntheticSpec("synthetic_$(layout)_$(tus)", tus, layout, fanout, functions)
+
+"""
+Component count and TUs per component for a layout
+"""
+function component_layout(spec::SyntheticSpec)
+    per_component = spec.layout == :wide ? 10 : max(10, spec.tus ÷ 8)
+    components = cld(spec.tus, per_component)
+    return components, per_component
+end
+
+"""
+Source directory of a TU inside its component (:deep nests every 25 TUs one level further)
+"""
+function tu_dir(spec::SyntheticSpec, component::Int, index::Int)
+    base = joinpath("src", "comp_$(lpad(component, 4, '0'))")
+    spec.layout == :wide && return base
+    levels = min(index ÷ 25, 6)
+    return joinpath(base, ["level_$l" for l in 1:levels]...)
+end
+
+header_name(component::Int, h::Int) = "comp_$(lpad(component, 4, '0'))/h_$(lpad(h, 3, '0')).h"
+
+"""
+Write a header with a record type and inline helpers, including the previous header of its chain
+"""
+function write_header(root::String, component::Int, h::Int, chain_parent::Union{String,Nothing})
+    path = joinpath(root, "include", header_name(component, h))
+    mkpath(dirname(path))
+    guard = uppercase(replace(header_name(component, h), r"[^A-Za-z0-9]" => "_"))
+    open(path, "w") do io
+        println(io, "#ifndef $guard\n#define $guard\n")
+        println(io, "#include \"common.h\"")
+        isnothing(chain_parent) || println(io, "#include \"$chain_parent\"")
+        println(io)
+        println(io, "struct Record_$(component)_$h { double values[4]; int count; };")
+        for k in 1:4
+            println(io, "static inline double inline_$(component)_$(h)_$k(double x) { return x * $k.0 + $h.0; }")
+        end
+        println(io, "\n#endif")
+    end
+end
+
+"""
+Generate a project under `root` and return its TU paths. Also writes `llvmake.toml`
+(LLVMake compiler config; `jmake.toml` is left to discovery).
+"""
+function generate_project(root::String, spec::SyntheticSpec; seed::UInt64=0x2545f4914f6cdd1d)
+    # Small LCG instead of Random: the same project on every Julia version
+    state = Ref(seed)
+    next_index(n) = (state[] = state[] * 0x5851f42d4c957f2d + 0x14057b7ef767814f; Int((state[] >> 33) % n) + 1)
+    components, per_component = component_layout(spec)
+    headers_per_component = max(2, per_component ÷ 3)
+    chain = spec.layout == :wide ? 2 : 8
+
+    mkpath(joinpath(root, "include"))
+    write(joinpath(root, "include", "common.h"), """
+    #ifndef SYNTHETIC_COMMON_H
+    #define SYNTHETIC_COMMON_H
+    #include <stddef.h>
+    #define SYNTHETIC_VERSION 1
+    typedef double real_t;
+    #endif
+    """)
+
+    all_headers = String[]
+    for c in 1:components, h in 1:headers_per_component
+        parent = (h - 1) % chain == 0 ? nothing : header_name(c, h - 1)
+        write_header(root, c, h, parent)
+        push!(all_headers, header_name(c, h))
+    end
+
+    tus = String[]
+    for t in 0:spec.tus-1
+        c = t ÷ per_component + 1
+        index = t % per_component
+        dir = joinpath(root, tu_dir(spec, c, index))
+        mkpath(dir)
+
+        own = header_name(c, index % headers_per_component + 1)
+        others = unique([all_headers[next_index(length(all_headers))] for _ in 1:spec.fanout])
+
+        path = joinpath(dir, "tu_$(lpad(t, 5, '0')).cpp")
+        open(path, "w") do io
+            println(io, "#include \"common.h\"")
+            println(io, "#include \"$own\"")
+            foreach(h -> println(io, "#include \"$h\""), others)
+            println(io, "\nextern \"C\" {\n")
+            for k in 1:spec.functions
+                fn = "fn_$(t)_$k"
+                if isodd(k)
+                    println(io, """
+                    double $fn(const double* values, int n) {
+                        double acc = 0.0;
+                        for (int i = 0; i < n; ++i) acc += values[i] * $k.0;
+                        return acc;
+                    }
+                    """)
+                else
+                    println(io, "int $fn(int a, int b) { return a * $k + b; }\n")
+                end
+            end
+            println(io, "}")
+        end
+        push!(tus, path)
+    end
+
+    write_llvmake_config(root)
+    return tus
+end
+
+"""
+LLVMake config for a benchmark project: `src`/`include` layout, cache inside the project
+"""
+function write_llvmake_config(root::String; opt_level::String="O1")
+    write(joinpath(root, "llvmake.toml"), """
+    project_root = "$(escape_string(root))"
+
+    [paths]
+    source = "src"
+    output = "julia"
+    build = "build"
+
+    [target]
+    opt_level = "$opt_level"
+
+    [compile]
+    include_dirs = ["include"]
+    keep_going = true
+
+    [cache]
+    enabled = true
+    directory = ".jmake_cache"
+    """)
+end
+
+"""
+Symbol tables shaped like what the scanners produce, for wrapper-generation timing
+"""
+function synthetic_symbols(count::Int)
+    return [isodd(i) ?
+        Dict{String,Any}("name" => "fn_$i", "type" => "function", "return_type" => "double",
+                         "parameters" => [Dict("name" => "values", "type" => "const double *"),
+                                          Dict("name" => "n", "type" => "int")],
+                         "signature" => "double fn_$i(const double * values, int n)") :
+        Dict{String,Any}("name" => "fn_$i", "type" => "function", "return_type" => "int",
+                         "parameters" => [Dict("name" => "a", "type" => "int"), Dict("name" => "b", "type" => "int")],
+                         "signature" => "int fn_$i(int a, int b)")
+        for i in 1:count]
+end
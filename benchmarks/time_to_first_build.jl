@@ -0,0 +1,95 @@
+#!/usr/bin/env julia
+# time_to_first_build.jl - Fresh-process latency of JMake, with and without the sysimage
+# Each trial starts a new Julia process that loads JMake, runs discovery on a copy of
+# examples/simple_math (the first command) and builds it (the first build), timing
+# each step; the wall time of the whole process is measured from outside.
+#
+# Run with: julia --project=. benchmarks/time_to_first_build.jl [--trials N]
+#           [--sysimage sysimage/JMakeSysimage.so] [--json results.json]
+
+using JSON
+
+const ROOT = dirname(@__DIR__)
+
+function option(name::String, default)
+    i = findfirst(==(name), ARGS)
+    return isnothing(i) || i == length(ARGS) ? default : ARGS[i + 1]
+end
+
+const TRIALS = parse(Int, option("--trials", "3"))
+const SYSIMAGE = option("--sysimage", joinpath(ROOT, "sysimage", "JMakeSysimage.so"))
+const JSON_OUT = option("--json", "")
+
+# Script run by every trial; prints one JMAKE_TIMING line with its measurements
+const TRIAL_SCRIPT = """
+load = @elapsed using JMake
+project = mktempdir()
+for dir in ("src", "include")
+    cp(joinpath($(repr(ROOT)), "examples", "simple_math", dir), joinpath(project, dir))
+end
+first_command = @elapsed redirect_stdout(devnull) do
+    JMake.scan(project)
+end
+first_build = try
+    @elapsed redirect_stdout(devnull) do
+        cd(() -> JMake.compile(joinpath(project, "jmake.toml")), project)
+    end
+catch
+    NaN  # No toolchain on this machine
+end
+println("JMAKE_TIMING load=\$load first_command=\$first_command first_build=\$first_build")
+"""
+
+"""
+Run one fresh process; returns its step timings and the outside wall time (seconds)
+"""
+function run_trial(sysimage::Union{String,Nothing})
+    julia = [Base.julia_cmd().exec[1], "--project=$ROOT", "--startup-file=no"]
+    isnothing(sysimage) || push!(julia, "-J", sysimage)
+    cmd = Cmd([julia..., "-e", TRIAL_SCRIPT])
+
+    output = IOBuffer()
+    wall = @elapsed run(pipeline(cmd, stdout=output, stderr=devnull))
+    lines = filter(l -> startswith(l, "JMAKE_TIMING"), split(String(take!(output)), '\n'))
+    isempty(lines) && error("Trial printed no timings")
+    line = last(lines)
+    timings = Dict{String,Float64}("wall" => wall)
+    for m in eachmatch(r"(\w+)=(\S+)", line)
+        timings[m.captures[1]] = parse(Float64, m.captures[2])
+    end
+    return timings
+end
+
+median(xs) = (v = sort!(collect(xs)); n = length(v); isodd(n) ? v[(n + 1) ÷ 2] : (v[n ÷ 2] + v[n ÷ 2 + 1]) / 2)
+
+function measure(name::String, sysimage::Union{String,Nothing})
+    trials = [run_trial(sysimage) for _ in 1:TRIALS]
+    steps = ["load", "first_command", "first_build", "wall"]
+    return Dict{String,Any}(
+        "variant" => name,
+        "sysimage" => something(sysimage, ""),
+        "trials" => TRIALS,
+        "median_seconds" => Dict(step => median(t[step] for t in trials) for step in steps),
+        "samples" => trials
+    )
+end
+
+variants = [("stock", nothing)]
+isfile(SYSIMAGE) ? push!(variants, ("sysimage", SYSIMAGE)) :
+    @warn "No sysimage at $SYSIMAGE; build one with sysimage/build_sysimage.jl"
+
+results = [measure(name, image) for (name, image) in variants]
+
+println("Time to first build (median of $TRIALS fresh processes, seconds)")
+println(rpad("variant", 10), lpad("load", 10), lpad("discover", 10), lpad("build", 10), lpad("wall", 10))
+for r in results
+    m = r["median_seconds"]
+    println(rpad(r["variant"], 10),
+            (lpad(round(m[step], digits=3), 10) for step in ["load", "first_command", "first_build", "wall"])...)
+end
+
+if !isempty(JSON_OUT)
+    open(io -> JSON.print(io, Dict("benchmark" => "time_to_first_build", "julia" => string(VERSION),
+                                   "results" => results), 2), JSON_OUT, "w")
+    println("Results written to $JSON_OUT")
+end
@@ -0,0 +1,93 @@
+#!/usr/bin/env julia
+# wrapper_call_overhead.jl - Per-call cost of generated JuliaWrapItUp wrappers
+# Compares a hand-written `ccall` against wrappers generated with `call_mode = "cached"`
+# (pointer resolved once in __init__, with and without CHECK_CALLS) and `"dynamic"`
+#
+# Run with: julia --project=. benchmarks/wrapper_call_overhead.jl [calls]
+
+using JMake
+using JMake.JuliaWrapItUp
+using Libdl
+
+const CALLS = length(ARGS) >= 1 ? parse(Int, ARGS[1]) : 10_000_000
+const TRIALS = 7
+
+# fabs is a single instruction, so what is measured is the call itself
+const LIBM = Libdl.dlpath(Libdl.dlopen(Base.Math.libm))
+
+fabs_ccall(x::Cdouble) = ccall((:fabs, LIBM), Cdouble, (Cdouble,), x)
+
+"""
+Generate and load a wrapper module for libm's fabs with the given settings
+"""
+function load_wrapper(dir::String, name::Symbol, call_mode::String, safety_checks::Bool)
+    config_file = joinpath(dir, "$name.toml")
+    write(config_file, """
+    project_root = "$(escape_string(dir))"
+
+    [wrapper]
+    style = "advanced"
+    call_mode = "$call_mode"
+    safety_checks = $safety_checks
+    """)
+
+    wrapper = BinaryWrapper(config_file)
+    symbols = [Dict{String,Any}(
+        "name" => "fabs", "type" => "function", "return_type" => "double",
+        "parameters" => [Dict("name" => "x", "type" => "double")],
+        "signature" => "double fabs(double x)"
+    )]
+    binary = BinaryInfo(LIBM, "libm", :shared_lib, string(Sys.ARCH), symbols, String[], Dict{String,Any}())
+
+    file = joinpath(dir, "$name.jl")
+    write(file, JuliaWrapItUp.generate_advanced_wrapper(wrapper, binary))
+
+    mod = Module(name)
+    Base.include(mod, file)
+    return getfield(getfield(mod, :Libm), :fabs)
+end
+
+function run_calls(f::F, xs::Vector{Cdouble}) where {F}
+    acc = 0.0
+    @inbounds for x in xs
+        acc += f(x)
+    end
+    return acc
+end
+
+"""
+Best nanoseconds per call over TRIALS runs
+"""
+function ns_per_call(f, xs::Vector{Cdouble})
+    run_calls(f, xs)  # compile
+    best = minimum(@elapsed(run_calls(f, xs)) for _ in 1:TRIALS)
+    return best * 1e9 / length(xs)
+end
+
+function main()
+    println("="^60)
+    println("Wrapper call overhead ($CALLS calls of fabs, best of $TRIALS)")
+    println("Library: $LIBM")
+    println("="^60)
+
+    xs = randn(CALLS)
+    variants = mktempdir() do dir
+        [
+            "hand-written ccall" => fabs_ccall,
+            "cached, CHECK_CALLS=false" => load_wrapper(dir, :CachedUnchecked, "cached", false),
+            "cached, CHECK_CALLS=true" => load_wrapper(dir, :CachedChecked, "cached", true),
+            "dynamic (ccall by name)" => load_wrapper(dir, :Dynamic, "dynamic", true)
+        ]
+    end
+
+    baseline = ns_per_call(fabs_ccall, xs)
+    for (label, f) in variants
+        t = label == "hand-written ccall" ? baseline : ns_per_call(f, xs)
+        println(rpad(label, 30), lpad(string(round(t, digits=2)), 8), " ns/call",
+                lpad("+" * string(round(t - baseline, digits=2)), 10), " ns")
+    end
+end
+
+if abspath(PROGRAM_FILE) == @__FILE__
+    main()
+end
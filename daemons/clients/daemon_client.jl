@@ -8,13 +8,10 @@ Usage:
     julia daemon_client.jl --server watcher --command start_watch --path ./src
 """
 
-using DaemonMode
+# Typed RPC client; reuse JMake's copy when it is already loaded (orchestrator)
+isdefined(@__MODULE__, :DaemonRPC) || include(joinpath(@__DIR__, "..", "..", "src", "DaemonRPC.jl"))
 
-const SERVERS = Dict(
-    "build" => 3001,
-    "error" => 3002,
-    "watcher" => 3003
-)
+const SERVERS = DaemonRPC.SERVICE_PORTS
 
 """
 Send a request to a daemon server
@@ -28,20 +25,16 @@ function send_request(server::String, func::String, args::Dict)
 
     port = SERVERS[server]
 
-    try
-        # Build expression to call the function with arguments
-        expr = :($(Symbol(func))($args))
+    # Progress events streamed by the handler are printed as they arrive
+    result = DaemonRPC.call(port, func, args;
+                            on_progress=event -> println("  … ", join(["$k=$v" for (k, v) in event], " ")))
 
-        # Send to daemon
-        result = runexpr(expr, port=port)
-
-        return result
-
-    catch e
+    if result isa Dict && get(result, :success, true) == false && haskey(result, :port)
         println("Error communicating with daemon on port $port:")
-        println(e)
+        println(result[:error])
         return nothing
     end
+    return result
 end
 
 """
@@ -92,9 +85,15 @@ function main()
             julia daemon_client.jl --server <server> --command <function> [--args...]
 
         Servers:
-            build    - Build daemon (port 3001)
-            error    - Error handler daemon (port 3002)
-            watcher  - File watcher daemon (port 3003)
+            discovery    - Discovery daemon (port 3001)
+            setup        - Setup daemon (port 3002)
+            compilation  - Compilation daemon (port 3003)
+            orchestrator - Orchestrator daemon (port 3004)
+            error        - Error handler daemon (port 3005)
+            watcher      - File watcher daemon (port 3006)
+            build        - Build daemon (port 3007)
+
+        Requests use the binary RPC listener of each daemon (service port + 100).
 
         Examples:
             # Build a target
@@ -104,7 +103,7 @@ function main()
             julia daemon_client.jl --server error --command handle_error --error "undefined reference"
 
             # Start watching files
-            julia daemon_client.jl --server watcher --command start_watch --path ./src --interval 1.0
+            julia daemon_client.jl --server watcher --command start_watch --path ./src --debounce 1.0
 
             # Check for changes
             julia daemon_client.jl --server watcher --command check_changes --path ./src
@@ -15,6 +15,10 @@ Flow:
 using DaemonMode
 using TOML
 
+# Discovery data lives in the config's binary index, not the TOML
+include(joinpath(@__DIR__, "..", "src", "ConfigurationManager.jl"))
+using .ConfigurationManager
+
 const DAEMON_PORTS = Dict(
     "discovery" => 3001,
     "setup" => 3002,
@@ -34,7 +38,7 @@ function analyze_toml_for_jobs(toml_path::String)
 
     # Check discovery section
     if haskey(toml, "discovery")
-        disc = toml["discovery"]
+        disc = ConfigurationManager.load_config(toml_path).discovery
 
         if !haskey(disc, "files") || isempty(get(disc, "files", Dict()))
             push!(jobs, Dict(
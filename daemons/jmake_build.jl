@@ -14,9 +14,17 @@ Usage:
 Requires: All JMake daemons running (./start_all.sh)
 """
 
-using DaemonMode
+# Typed RPC client (stdlib only, no JMake load)
+include(joinpath(@__DIR__, "..", "src", "DaemonRPC.jl"))
 
-const ORCHESTRATOR_PORT = 3004
+const ORCHESTRATOR_PORT = DaemonRPC.SERVICE_PORTS["orchestrator"]
+
+"""
+Print per-file progress streamed back by the daemons
+"""
+function print_progress(event::Dict)
+    haskey(event, "file") && println("  $(event["status"]): $(basename(event["file"]))")
+end
 
 function main()
     if length(ARGS) == 0 || ARGS[1] == "--help"
@@ -111,9 +119,9 @@ end
 function check_daemon_status()
     println("Checking daemon status...")
 
-    result = runexpr("check_daemons(Dict())", port=ORCHESTRATOR_PORT)
+    result = DaemonRPC.call(ORCHESTRATOR_PORT, "check_daemons")
 
-    if result[:all_running]
+    if get(result, :all_running, false)
         println("✅ All daemons are running!")
         for (daemon, status) in result[:daemons]
             if status
@@ -122,7 +130,8 @@ function check_daemon_status()
         end
     else
         println("⚠️  Some daemons are not running:")
-        for (daemon, status) in result[:daemons]
+        haskey(result, :error) && println("  ✗ orchestrator: $(result[:error])")
+        for (daemon, status) in get(result, :daemons, Dict())
             if status
                 println("  ✓ $daemon: running")
             else
@@ -136,7 +145,7 @@ end
 function get_build_stats()
     println("Gathering build statistics...")
 
-    result = runexpr(:(get_stats(Dict())), port=ORCHESTRATOR_PORT)
+    result = DaemonRPC.call(ORCHESTRATOR_PORT, "get_stats")
 
     if result[:success]
         stats = result[:stats]
@@ -184,11 +193,11 @@ end
 function full_build(project_path::String)
     println("Starting full build: $project_path")
 
-    result = runexpr(:(build_project(Dict(
-        "path" => $project_path,
+    result = DaemonRPC.call(ORCHESTRATOR_PORT, "build_project", Dict(
+        "path" => project_path,
         "force_discovery" => false,
         "force_compile" => false
-    ))), port=ORCHESTRATOR_PORT)
+    ); on_progress=print_progress)
 
     handle_build_result(result)
 end
@@ -196,10 +205,10 @@ end
 function quick_build(project_path::String)
     println("Starting quick build: $project_path")
 
-    result = runexpr(:(quick_compile(Dict(
-        "path" => $project_path,
+    result = DaemonRPC.call(ORCHESTRATOR_PORT, "quick_compile", Dict(
+        "path" => project_path,
         "force" => false
-    ))), port=ORCHESTRATOR_PORT)
+    ); on_progress=print_progress)
 
     handle_build_result(result)
 end
@@ -207,9 +216,9 @@ end
 function incremental_build(project_path::String)
     println("Starting incremental build: $project_path")
 
-    result = runexpr(:(incremental_build(Dict(
-        "path" => $project_path
-    ))), port=ORCHESTRATOR_PORT)
+    result = DaemonRPC.call(ORCHESTRATOR_PORT, "incremental_build", Dict(
+        "path" => project_path
+    ); on_progress=print_progress)
 
     handle_build_result(result)
 end
@@ -218,9 +227,9 @@ function clean_build(project_path::String)
     println("Starting clean build: $project_path")
     println("(clearing all caches...)")
 
-    result = runexpr(:(clean_build(Dict(
-        "path" => $project_path
-    ))), port=ORCHESTRATOR_PORT)
+    result = DaemonRPC.call(ORCHESTRATOR_PORT, "clean_build", Dict(
+        "path" => project_path
+    ); on_progress=print_progress)
 
     handle_build_result(result)
 end
@@ -229,10 +238,10 @@ function watch_mode(project_path::String)
     println("Starting watch mode: $project_path")
     println("Press Ctrl+C to stop")
 
-    result = runexpr(:(watch_and_build(Dict(
-        "path" => $project_path,
-        "interval" => 2.0
-    ))), port=ORCHESTRATOR_PORT)
+    result = DaemonRPC.call(ORCHESTRATOR_PORT, "watch_and_build", Dict(
+        "path" => project_path,
+        "debounce" => 2.0
+    ); on_progress=print_progress)
 
     # Watch mode runs indefinitely until interrupted
     if haskey(result, :stopped) && result[:stopped]
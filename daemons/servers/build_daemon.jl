@@ -3,13 +3,13 @@
 Build Daemon Server - Handles compilation and build requests
 
 Start with: julia build_daemon.jl
-Port: 3001
+Port: 3007
 """
 
 using DaemonMode
 using JMake
 
-const PORT = 3001
+const PORT = 3007
 const BUILD_CACHE = Dict{String, Any}()
 
 """
@@ -60,7 +60,8 @@ function main()
     println("Ready to accept build requests...")
     println()
 
-    # Start the daemon server
+    # Typed RPC listener for other daemons, then DaemonMode for the CLI
+    DaemonRPC.start_service(PORT, [handle_build_request])
     serve(PORT)
 end
 
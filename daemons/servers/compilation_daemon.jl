@@ -2,12 +2,25 @@
 """
 Compilation Daemon Server - Parallel C++ → IR → Binary with aggressive caching
 
-Start with: julia --project=.. -p 4 compilation_daemon.jl
+Start with: julia --project=.. compilation_daemon.jl
 Port: 3003
 
 Features:
-- Parallel compilation with Distributed.@spawn
-- Cached IR files (only recompile changed sources)
+- Parallel compilation on a Distributed worker pool that grows with queued TUs
+  and shrinks when idle (JMAKE_MIN_WORKERS / JMAKE_MAX_WORKERS)
+- One global TU queue: concurrent requests for the same cache key share one compile,
+  slots are shared fairly across projects and clients, interactive requests go first
+- Content-addressed IR cache on disk (source + headers + flags + toolchain); each TU
+  only gets the -I dirs its headers come from
+- compile_units takes TUs streamed by the orchestrator while discovery is still running
+- Optional precompiled header of the project's most widely included headers
+  (`[compile] pch = true`, members included by at least `pch_threshold` of the TUs)
+- Optional remote artifact store shared by build nodes (`[cache] remote` / JMAKE_REMOTE_CACHE)
+- TUs farmed out to compilation daemons on other hosts (JMAKE_COMPILE_HOSTS), preprocessed
+  locally and only sent to hosts whose toolchain matches. Hosts take them on a separate,
+  token-checked listener (JMAKE_REMOTE_BIND + JMAKE_COMPILE_TOKEN); the full RPC service
+  stays on loopback
+- Bitcode end to end; textual .ll only with `[compile] emit_bc = false` / `emit_ir = true`
 - Persistent LLVM environment (no reload overhead)
 - Build queue with dependency ordering
 - Error handler integration for intelligent retry
@@ -16,130 +29,712 @@ Features:
 using DaemonMode
 using Distributed
 using Dates
+using Sockets
+using SHA
 
-# Add workers if not already added
-if nprocs() == 1
-    addprocs(4)  # Add 4 worker processes
-end
+# Worker pool bounds: starts at the minimum, grows while TUs wait for a slot
+const MIN_WORKERS = max(1, parse(Int, get(ENV, "JMAKE_MIN_WORKERS", "1")))
+const MAX_WORKERS = max(MIN_WORKERS, parse(Int, get(ENV, "JMAKE_MAX_WORKERS", string(Sys.CPU_THREADS))))
+
+# Seconds a worker above the minimum may sit idle before it is removed
+const WORKER_IDLE_TIMEOUT = 60.0
+
+# Code every process needs; evaluated again on each worker added later
+const WORKER_CODE = quote
+    push!(LOAD_PATH, $(joinpath(@__DIR__, "..", "..", "src")))
+
+    using JMake
+    using JMake.ConfigurationManager
+    using JMake.LLVMEnvironment
+    using JMake.BuildBridge
+    using JMake.LLVMake
+
+    # Toolchain from the shared manifest (no llvm-config or directory scans when unchanged)
+    try
+        BuildBridge.LLVMEnvironment.get_toolchain()
+    catch e
+        @warn "LLVM toolchain unavailable: $e"
+    end
+
+    function compile_source_to_ir(source_path::String, output_dir::String,
+                                  ir_flags::Vector{String}, clang_path::String,
+                                  cache_root::String, key::String, ir_ext::String)
+        try
+            # Ensure output directory exists
+            mkpath(output_dir)
+
+            # Generate output path (unique per source path, not just basename)
+            ir_path = BuildCache.output_path(output_dir, source_path, ir_ext)
+
+            # Build clang command
+            args = vcat(ir_flags, ["-o", ir_path], [source_path])
+
+            # Execute compilation
+            output, exitcode = BuildBridge.execute(clang_path, args, use_llvm_env=true)
+
+            if exitcode != 0
+                return Dict(
+                    :success => false,
+                    :source => source_path,
+                    :error => output,
+                    :exitcode => exitcode
+                )
+            end
+
+            # Publish to the shared store straight from the worker (the daemon uploads to the remote one)
+            isempty(key) || BuildCache.store!(BuildCache.ArtifactCache(cache_root; remote=nothing), key, ir_ext, ir_path)
 
-# Load project on all workers
-@everywhere push!(LOAD_PATH, joinpath(@__DIR__, "..", "..", "src"))
+            return Dict(
+                :success => true,
+                :source => source_path,
+                :ir_path => ir_path,
+                :key => key,
+                :cached => false
+            )
+
+        catch e
+            return Dict(
+                :success => false,
+                :source => source_path,
+                :error => string(e),
+                :exception => true
+            )
+        end
+    end
+end
 
-@everywhere using JMake
-@everywhere using JMake.ConfigurationManager
-@everywhere using JMake.LLVMEnvironment
-@everywhere using JMake.BuildBridge
-@everywhere using JMake.LLVMake
+# The main process loads (or first writes) the toolchain manifest, so workers started
+# now and later read it instead of probing the installation themselves
+@everywhere [1] $WORKER_CODE
+nprocs() == 1 && addprocs(MIN_WORKERS)
+@everywhere workers() $WORKER_CODE
 
 const PORT = 3003
 
+# Interface the remote TU listener binds to (e.g. 0.0.0.0); unset, no remote TUs are taken.
+# The full RPC service always stays on loopback.
+const REMOTE_BIND = get(ENV, "JMAKE_REMOTE_BIND", "")
+
 # ============================================================================
 # PERSISTENT CACHES
 # ============================================================================
 
-const IR_CACHE = Dict{String, Tuple{String, Float64}}()  # source_path => (ir_path, mtime)
+const IR_CACHE = Dict{String, Tuple{String, String}}()  # source_path => (ir_path, cache_key) for this session
 const BINARY_CACHE = Dict{String, Tuple{String, Float64}}()  # project_hash => (binary_path, mtime)
 const BUILD_STATS = Dict{String, Any}()  # Statistics tracking
 
+# Persistent content-addressed IR store, one per cache directory (survives daemon restarts)
+const ARTIFACT_CACHES = Dict{String, BuildCache.ArtifactCache}()
+
 """
-Compute hash of source file for cache invalidation
+Get the artifact cache for a cache directory; `remote` is the shared store spec
+(URL or path, see `BuildCache.remote_store`) and defaults to JMAKE_REMOTE_CACHE
 """
-function source_hash(path::String)
-    if !isfile(path)
-        return ""
-    end
-    return string(hash((path, mtime(path))), base=16)
+function artifact_cache(cache_dir::String, remote::String=get(ENV, "JMAKE_REMOTE_CACHE", ""))
+    root = abspath(cache_dir)
+    return get!(() -> BuildCache.ArtifactCache(root; remote=BuildCache.remote_store(remote)),
+                ARTIFACT_CACHES, root)
 end
 
 """
-Check if IR cache is valid for source file
+Get the on-disk artifact cache for a project
 """
-function is_ir_cached(source_path::String, ir_output_dir::String)
-    if !haskey(IR_CACHE, source_path)
-        return false, ""
-    end
+function get_artifact_cache(config)
+    cache_dir = joinpath(config.project_root,
+                         get(config.cache, "directory", BuildCache.default_cache_dir(config.project_root)))
+    return artifact_cache(cache_dir, get(config.cache, "remote", get(ENV, "JMAKE_REMOTE_CACHE", "")))
+end
 
-    ir_path, cached_mtime = IR_CACHE[source_path]
+"""
+IR file extension for a project: `.bc` unless `[compile] emit_bc = false`
+"""
+ir_extension(config) = ir_extension(config.compile)
+ir_extension(compile::AbstractDict) = get(compile, "emit_bc", true) ? ".bc" : ".ll"
 
-    # Check if source file has been modified
+"""
+Full flag vector of one TU (exactly what goes into its cache key): output kind,
+`[compile] flags`, then `-I` for the include dirs the TU actually uses
+"""
+function unit_ir_flags(compile::AbstractDict, include_dirs::Vector{String})
+    output_kind = ir_extension(compile) == ".bc" ? ["-c", "-emit-llvm"] : ["-S", "-emit-llvm"]
+    flags = get(compile, "flags", ["-std=c++17", "-fPIC"])
+    return String[vcat(output_kind, flags, ["-I$dir" for dir in include_dirs])...]
+end
+
+"""
+Precompiled header of a project's hot headers (`[compile] pch = true`), built on this
+process with the `[compile] flags` and every include dir, under `<output_dir>/pch`.
+`nothing` when no header reaches `pch_threshold` or the PCH does not build.
+"""
+function project_pch(config, sources::Vector{String}, include_dirs::Vector{String},
+                     clang_path::String, cache::BuildCache.ArtifactCache, toolchain::String)
+    pch_dir = joinpath(config.project_root, get(config.compile, "output_dir", "build/ir"), "pch")
+    graph = Dict(source => BuildCache.resolve_header_closure(source, include_dirs)
+                 for source in sources if isfile(source))
+    headers = BuildCache.hot_headers(graph; threshold=get(config.compile, "pch_threshold", 0.5),
+                                     exclude_dir=pch_dir)
+    isempty(headers) && return nothing
+
+    umbrella = BuildCache.write_pch_umbrella(joinpath(pch_dir, "project.h"), headers)
+    flags = String["-x", "c++-header", get(config.compile, "flags", ["-std=c++17", "-fPIC"])...,
+                   ["-I$dir" for dir in include_dirs]...]
+    pch = BuildCache.precompile_header!(cache, umbrella, flags; toolchain=toolchain) do args
+        BuildBridge.execute(clang_path, args, use_llvm_env=true)
+    end
+    isnothing(pch) || println("[COMPILE] PCH: $(length(headers)) headers → $(basename(pch))")
+    return pch
+end
+
+"""
+Check if IR cache is valid for source file.
+The key covers source bytes, header closure, flags and toolchain version, so a
+header edit or flag change is a miss even when the source mtime is unchanged.
+"""
+function is_ir_cached(cache::BuildCache.ArtifactCache, source_path::String, key::String,
+                      ir_output_dir::String, ir_ext::String)
     if !isfile(source_path)
         return false, ""
     end
 
-    current_mtime = mtime(source_path)
-    if current_mtime > cached_mtime
-        return false, ""
+    ir_path = BuildCache.output_path(ir_output_dir, source_path, ir_ext)
+
+    # Same key served this session and the output is still in place
+    session_hit = haskey(IR_CACHE, source_path) && IR_CACHE[source_path] == (ir_path, key) && isfile(ir_path)
+    if JMake.Tracing.count_cache!("daemon_ir_session", session_hit)
+        return true, ir_path
     end
 
-    # Check if IR file exists
-    if !isfile(ir_path)
-        return false, ""
+    if BuildCache.fetch!(cache, key, ir_ext, ir_path)
+        IR_CACHE[source_path] = (ir_path, key)
+        return true, ir_path
     end
 
-    return true, ir_path
+    return false, ""
 end
 
 # ============================================================================
-# COMPILATION FUNCTIONS
+# TU SCHEDULER
 # ============================================================================
 
-@everywhere function compile_source_to_ir(source_path::String, output_dir::String,
-                                          include_dirs::Vector{String}, flags::Vector{String},
-                                          clang_path::String)
-    try
-        # Ensure output directory exists
-        mkpath(output_dir)
-
-        # Generate output path
-        source_name = splitext(basename(source_path))[1]
-        ir_path = joinpath(output_dir, "$source_name.ll")
-
-        # Build clang command
-        args = vcat(
-            ["-S", "-emit-llvm"],
-            flags,
-            ["-I$dir" for dir in include_dirs],
-            ["-o", ir_path],
-            [source_path]
-        )
+# Request priorities: watcher-driven rebuilds jump ahead of background full builds
+const BACKGROUND_PRIORITY = 0
+const INTERACTIVE_PRIORITY = 10
 
-        # Execute compilation
-        output, exitcode = BuildBridge.execute(clang_path, args, use_llvm_env=true)
+"""
+One TU compilation, shared by every request that asks for the same cache key
+"""
+mutable struct CompileTask
+    key::String
+    source::String
+    output_dir::String
+    ir_flags::Vector{String}
+    clang_path::String
+    cache_root::String
+    ir_ext::String
+    toolchain::String            # `clang --version` of clang_path; "" keeps the TU on this host
+    flow::Tuple{String,String}   # (project, client) of the first requester
+    priority::Int                # highest priority among its requesters
+    waiters::Int
+    result::Channel{Dict}        # holds the single result; every requester fetch()es it
+end
 
-        if exitcode != 0
-            return Dict(
-                :success => false,
-                :source => source_path,
-                :error => output,
-                :exitcode => exitcode
-            )
+"""
+Global queue of TU compilations over the worker pool
+"""
+mutable struct TUScheduler
+    lock::ReentrantLock
+    wakeup::Threads.Condition
+    queues::Dict{Tuple{String,String},Vector{CompileTask}}  # (project, client) => FIFO
+    inflight::Dict{String,CompileTask}                      # cache key => queued or running
+    last_served::Dict{Any,Float64}                          # project or flow => last dispatch
+    workers::Set{Int}
+    idle_workers::Int
+    starting_workers::Int
+    stats::Dict{String,Int}
+end
+
+function TUScheduler()
+    lock = ReentrantLock()
+    return TUScheduler(lock, Threads.Condition(lock), Dict{Tuple{String,String},Vector{CompileTask}}(),
+                       Dict{String,CompileTask}(), Dict{Any,Float64}(), Set{Int}(), 0, 0,
+                       Dict("submitted" => 0, "coalesced" => 0, "compiled" => 0, "requeued" => 0,
+                            "remote_compiled" => 0, "workers_added" => 0, "workers_removed" => 0))
+end
+
+const SCHEDULER = TUScheduler()
+
+"""
+Queue a TU compile, or join the one already queued/running for the same cache key.
+Returns `(task, joined)`.
+"""
+function submit_compile(source::String, output_dir::String, ir_flags::Vector{String},
+                        clang_path::String, cache_root::String, key::String, ir_ext::String;
+                        project::String, client::String, priority::Int, toolchain::String="")
+    lock(SCHEDULER.lock) do
+        if !isempty(key) && haskey(SCHEDULER.inflight, key)
+            task = SCHEDULER.inflight[key]
+            task.waiters += 1
+            task.priority = max(task.priority, priority)
+            SCHEDULER.stats["coalesced"] += 1
+            return task, true
         end
 
-        return Dict(
-            :success => true,
-            :source => source_path,
-            :ir_path => ir_path,
-            :cached => false
-        )
+        task = CompileTask(key, source, output_dir, ir_flags, clang_path, cache_root, ir_ext,
+                           toolchain, (project, client), priority, 1, Channel{Dict}(1))
+        isempty(key) || (SCHEDULER.inflight[key] = task)
+        push!(get!(SCHEDULER.queues, task.flow, CompileTask[]), task)
+        SCHEDULER.stats["submitted"] += 1
+
+        notify(SCHEDULER.wakeup)
+        scale_up!()
+        return task, false
+    end
+end
+
+"""
+Wait for a submitted TU and return the result for this requester's own source and
+output path (a joined compile may have written its IR elsewhere)
+"""
+function await_compile(task::CompileTask, source::String, output_dir::String)
+    result = fetch(task.result)
+    result[:success] || return merge(result, Dict(:source => source))
+
+    ir_path = BuildCache.output_path(output_dir, source, task.ir_ext)
+    if result[:ir_path] != ir_path
+        mkpath(dirname(ir_path))
+        cp(result[:ir_path], ir_path, force=true)
+    end
+    return merge(result, Dict(:source => source, :ir_path => ir_path))
+end
+
+"""
+Take the next TU to run (caller holds the scheduler lock): highest priority first;
+among equal priorities the project, then the client, served longest ago.
+Only TUs passing `accept` are considered (remote hosts take the ones matching their toolchain).
+"""
+function pop_next_task!(accept::Function=_ -> true)
+    best = nothing
+    best_rank = nothing
+    for (flow, queue) in SCHEDULER.queues
+        candidates = findall(accept, queue)
+        isempty(candidates) && continue
+        index = candidates[argmax([queue[i].priority for i in candidates])]   # first of the highest priority
+        rank = (queue[index].priority,
+                -get(SCHEDULER.last_served, flow[1], 0.0),
+                -get(SCHEDULER.last_served, flow, 0.0))
+        if best_rank === nothing || rank > best_rank
+            best, best_rank = (flow, index), rank
+        end
+    end
+    best === nothing && return nothing
+
+    flow, index = best
+    task = popat!(SCHEDULER.queues[flow], index)
+    isempty(SCHEDULER.queues[flow]) && delete!(SCHEDULER.queues, flow)
+
+    now_t = time()
+    SCHEDULER.last_served[flow[1]] = now_t
+    SCHEDULER.last_served[flow] = now_t
+    return task
+end
+
+queued_tasks() = sum(length, values(SCHEDULER.queues); init=0)
+
+"""
+Put a TU back at the head of its flow's queue (a remote host could not take it)
+"""
+function requeue!(task::CompileTask)
+    lock(SCHEDULER.lock) do
+        pushfirst!(get!(SCHEDULER.queues, task.flow, CompileTask[]), task)
+        SCHEDULER.stats["requeued"] += 1
+        notify(SCHEDULER.wakeup)
+        scale_up!()
+    end
+end
+
+"""
+Complete a TU: publish its IR to the remote store and hand the result to every requester
+"""
+function finish_task!(task::CompileTask, result::Dict)
+    if result[:success] && !isempty(task.key)
+        BuildCache.publish!(artifact_cache(task.cache_root), task.key, task.ir_ext)
+    end
+    lock(SCHEDULER.lock) do
+        isempty(task.key) || delete!(SCHEDULER.inflight, task.key)
+        SCHEDULER.stats["compiled"] += 1
+    end
+    put!(task.result, result)
+end
 
+"""
+Start another worker when TUs are waiting and no idle or starting worker will take them
+(caller holds the scheduler lock)
+"""
+function scale_up!()
+    capacity = SCHEDULER.idle_workers + SCHEDULER.starting_workers
+    queued_tasks() > capacity || return
+    length(SCHEDULER.workers) + SCHEDULER.starting_workers < MAX_WORKERS || return
+
+    SCHEDULER.starting_workers += 1
+    @async try
+        pid = only(addprocs(1))
+        Distributed.remotecall_eval(Main, pid, WORKER_CODE)
+        lock(SCHEDULER.lock) do
+            push!(SCHEDULER.workers, pid)
+            SCHEDULER.stats["workers_added"] += 1
+        end
+        println("[COMPILE] ➕ Worker $pid started ($(length(SCHEDULER.workers)) running)")
+        @async worker_loop(pid)
     catch e
+        println("[COMPILE] ⚠️  Could not start worker: $e")
+    finally
+        lock(SCHEDULER.lock) do
+            SCHEDULER.starting_workers -= 1
+            scale_up!()
+        end
+    end
+end
+
+"""
+Wait for a TU for worker `pid`. Returns `nothing` when the worker has been idle for
+WORKER_IDLE_TIMEOUT and the pool is above MIN_WORKERS.
+"""
+function next_task!(pid::Int)
+    lock(SCHEDULER.lock) do
+        idle_since = time()
+        SCHEDULER.idle_workers += 1
+        try
+            while true
+                task = pop_next_task!()
+                task === nothing || return task
+
+                if time() - idle_since >= WORKER_IDLE_TIMEOUT && length(SCHEDULER.workers) > MIN_WORKERS
+                    delete!(SCHEDULER.workers, pid)
+                    return nothing
+                end
+                wait(SCHEDULER.wakeup)
+            end
+        finally
+            SCHEDULER.idle_workers -= 1
+        end
+    end
+end
+
+"""
+Run TUs on one worker until it is retired or dies
+"""
+function worker_loop(pid::Int)
+    while true
+        task = next_task!(pid)
+        if isnothing(task)
+            rmprocs(pid)
+            lock(() -> SCHEDULER.stats["workers_removed"] += 1, SCHEDULER.lock)
+            println("[COMPILE] ➖ Worker $pid retired (idle)")
+            return
+        end
+
+        result = try
+            remotecall_fetch(Main.compile_source_to_ir, pid, task.source, task.output_dir, task.ir_flags,
+                             task.clang_path, task.cache_root, task.key, task.ir_ext)
+        catch e
+            Dict(:success => false, :source => task.source, :error => string(e), :exception => true)
+        end
+
+        finish_task!(task, result)
+
+        if !(pid in workers())
+            # The worker process died; let the pool replace it
+            lock(SCHEDULER.lock) do
+                delete!(SCHEDULER.workers, pid)
+                scale_up!()
+            end
+            return
+        end
+    end
+end
+
+"""
+Scheduler snapshot for cache_stats
+"""
+function scheduler_stats()
+    lock(SCHEDULER.lock) do
         return Dict(
-            :success => false,
-            :source => source_path,
-            :error => string(e),
-            :exception => true
+            "workers" => length(SCHEDULER.workers),
+            "idle_workers" => SCHEDULER.idle_workers,
+            "starting_workers" => SCHEDULER.starting_workers,
+            "queued" => Dict("$(project) [$(client)]" => length(q) for ((project, client), q) in SCHEDULER.queues),
+            "inflight" => length(SCHEDULER.inflight),
+            "remote_hosts" => ["$(h.host):$(h.port) ($(h.slots) slots)" for h in REMOTE_HOSTS],
+            "counters" => copy(SCHEDULER.stats)
         )
     end
 end
 
+# Workers present at startup; idle ones are woken periodically to check their timeout
+for pid in workers()
+    pid == myid() && continue
+    push!(SCHEDULER.workers, pid)
+    @async worker_loop(pid)
+end
+const IDLE_TICK = Timer(_ -> lock(() -> notify(SCHEDULER.wakeup), SCHEDULER.lock),
+                        WORKER_IDLE_TIMEOUT / 4; interval=WORKER_IDLE_TIMEOUT / 4)
+
+# ============================================================================
+# REMOTE HOSTS
+# ============================================================================
+
+# Seconds before a host that failed its handshake or a TU is tried again
+const REMOTE_RETRY_INTERVAL = 30.0
+
+# Upper bound for one remote TU (transfer + compile)
+const REMOTE_COMPILE_TIMEOUT = 600.0
+
+"""
+Compilation daemon on another build node; `slots` TUs are sent to it at once
+"""
+struct RemoteHost
+    host::String
+    port::Int
+    slots::Int
+end
+
+"""
+Parse JMAKE_COMPILE_HOSTS: `host[:port][*slots],...` (port defaults to the
+compilation daemon's, slots to 4)
+"""
+function parse_compile_hosts(spec::AbstractString)
+    hosts = RemoteHost[]
+    for entry in split(spec, ',', keepempty=false)
+        m = match(r"^\s*([^:*\s]+)(?::(\d+))?(?:\*(\d+))?\s*$", entry)
+        if m === nothing
+            println("[COMPILE] ⚠️  Ignoring compile host '$entry' (expected host[:port][*slots])")
+            continue
+        end
+        push!(hosts, RemoteHost(m[1], m[2] === nothing ? PORT : parse(Int, m[2]),
+                                m[3] === nothing ? 4 : max(1, parse(Int, m[3]))))
+    end
+    return hosts
+end
+
+"""
+Shared secret of the compile hosts: JMAKE_COMPILE_TOKEN, or the first line of the file
+JMAKE_COMPILE_TOKEN_FILE names. Clients present it; hosts refuse calls without it.
+"""
+function compile_token()
+    token = get(ENV, "JMAKE_COMPILE_TOKEN", "")
+    file = get(ENV, "JMAKE_COMPILE_TOKEN_FILE", "")
+    isempty(token) && isfile(file) && (token = strip(readline(file)))
+    return String(token)
+end
+
+const COMPILE_TOKEN = compile_token()
+
+const REMOTE_HOSTS = let hosts = parse_compile_hosts(get(ENV, "JMAKE_COMPILE_HOSTS", ""))
+    if !isempty(hosts) && isempty(COMPILE_TOKEN)
+        println("[COMPILE] ⚠️  Ignoring JMAKE_COMPILE_HOSTS: no JMAKE_COMPILE_TOKEN set")
+        empty!(hosts)
+    end
+    hosts
+end
+
+# -f options that load code or name files; never accepted from (or sent to) another host
+const REMOTE_DENIED_F_OPTIONS = ["plugin", "pass-plugin", "load", "profile", "sanitize-", "xray",
+                                 "crash-diagnostics", "module", "implicit-module", "prebuilt",
+                                 "pch", "save-", "embed-", "record-", "depfile", "debug-compilation-dir",
+                                 "debug-prefix-map", "macro-prefix-map", "file-prefix-map",
+                                 "coverage-", "diagnostics-", "time-trace", "output-"]
+
+"""
+Whether a TU may be compiled on another host with `flags`: output kind, -O, -std, -g,
+warnings, -D/-U, and -f/-m codegen options without file arguments. Plugins, -o,
+-Xclang, -mllvm, -Wl/-Wp/-Wa pass-throughs and anything else unknown are refused.
+"""
+remote_flags_allowed(flags::Vector{String}) = all(remote_flag_allowed, flags)
+
+function remote_flag_allowed(flag::String)
+    flag in ("-c", "-S", "-emit-llvm", "-w", "-pthread", "-pedantic") && return true
+    occursin(r"^-O([0-3sz]|fast)?$", flag) && return true
+    occursin(r"^-std=[a-z0-9+]+$", flag) && return true
+    occursin(r"^-g[a-z0-9-]*$", flag) && return true
+    occursin(r"^-W[a-z0-9+=-]+$", flag) && return true
+    occursin(r"^-[DU][A-Za-z_][A-Za-z0-9_]*(=\S*)?$", flag) && return true
+    occursin(r"^--target=[A-Za-z0-9_.-]+$", flag) && return true
+
+    m = match(r"^-f(?:no-)?([A-Za-z0-9+-]+)(?:=[A-Za-z0-9_.,+-]+)?$", flag)
+    m === nothing || return !any(p -> startswith(lowercase(m[1]), p), REMOTE_DENIED_F_OPTIONS)
+    m = match(r"^-m([a-z0-9+-]+)(?:=[A-Za-z0-9_.,+-]+)?$", flag)
+    m === nothing || return m[1] != "llvm"
+    return false
+end
+
+# Flags that only matter to the preprocessor; the remote host compiles preprocessed text
+const PREPROCESSOR_ARG_FLAGS = Set(["-I", "-isystem", "-iquote", "-idirafter", "-include", "-D", "-U"])
+
+"""
+Split a TU's flags into preprocessing flags (`clang -E`) and the flags the remote host
+compiles the preprocessed text with
+"""
+function split_preprocessor_flags(flags::Vector{String})
+    pp_flags = String[]
+    compile_flags = String[]
+    i = 1
+    while i <= length(flags)
+        flag = flags[i]
+        if flag == "-include-pch" && i < length(flags)
+            # The remote host has no PCH: the umbrella header is preprocessed in instead
+            push!(pp_flags, "-include", BuildCache.pch_umbrella(flags[i + 1]))
+            i += 2
+            continue
+        elseif flag == "-fpch-validate-input-files-content"
+            i += 1
+            continue
+        end
+        if flag in PREPROCESSOR_ARG_FLAGS && i < length(flags)
+            push!(pp_flags, flag, flags[i + 1])
+            i += 2
+            continue
+        end
+        if any(p -> startswith(flag, p), PREPROCESSOR_ARG_FLAGS)
+            push!(pp_flags, flag)
+        elseif flag in ("-c", "-S", "-emit-llvm")
+            # Output kind: the remote compile only
+            push!(compile_flags, flag)
+        else
+            # Language/target flags affect both steps
+            push!(pp_flags, flag)
+            push!(compile_flags, flag)
+        end
+        i += 1
+    end
+    return pp_flags, compile_flags
+end
+
+"""
+Wait for a TU a remote host with `toolchain` can build; `nothing` once `deadline` passes
+so the slot re-checks its host
+"""
+function next_remote_task!(toolchain::String, deadline::Float64)
+    lock(SCHEDULER.lock) do
+        while time() < deadline
+            task = pop_next_task!(t -> !isempty(t.toolchain) && t.toolchain == toolchain)
+            task === nothing || return task
+            wait(SCHEDULER.wakeup)
+        end
+        return nothing
+    end
+end
+
 """
-Compile all sources to IR in parallel
+Build one TU on a remote host: preprocess here (the host needs no checkout or headers),
+compile there, store the returned IR locally. `nothing` means the host could not take
+it (unreachable, toolchain changed) and the TU should go back to the queue; `:local`
+that it must be compiled on this host.
+"""
+function compile_remote(remote::RemoteHost, task::CompileTask)
+    pp_flags, compile_flags = split_preprocessor_flags(task.ir_flags)
+    language = endswith(task.source, ".c") ? "cpp-output" : "c++-cpp-output"
+
+    preprocessed = mktempdir() do dir
+        output = joinpath(dir, "unit.i")
+        _, exitcode = BuildBridge.execute(task.clang_path, vcat(pp_flags, ["-E", task.source, "-o", output]))
+        exitcode == 0 ? read(output) : nothing
+    end
+    # Preprocessing errors are reported by the local compile with proper diagnostics
+    preprocessed === nothing && return :local
+    # Flags a host would refuse (e.g. -Xclang pass-throughs) keep the TU here
+    remote_flags_allowed(compile_flags) || return :local
+
+    result = DaemonRPC.call_remote(remote.host, remote.port, :compile_preprocessed, Dict(
+        "source" => task.source,
+        "language" => language,
+        "preprocessed" => preprocessed,
+        "flags" => compile_flags,
+        "toolchain" => task.toolchain,
+        "ir_ext" => task.ir_ext,
+        "client" => gethostname()
+    ); token=COMPILE_TOKEN, timeout=REMOTE_COMPILE_TIMEOUT)
+
+    result isa Dict || return nothing
+    get(result, :rejected, false) && return :local
+    if !get(result, :success, false)
+        # A compile error is final; anything else is the host's problem
+        haskey(result, :exitcode) || return nothing
+        return Dict(:success => false, :source => task.source, :error => result[:error],
+                    :exitcode => result[:exitcode], :host => remote.host)
+    end
+
+    ir_path = BuildCache.output_path(task.output_dir, task.source, task.ir_ext)
+    mkpath(dirname(ir_path))
+    write(ir_path, result[:ir])
+    # finish_task! uploads it, as for TUs built by local workers
+    isempty(task.key) || BuildCache.store!(BuildCache.ArtifactCache(task.cache_root; remote=nothing),
+                                           task.key, task.ir_ext, ir_path)
+    return Dict(:success => true, :source => task.source, :ir_path => ir_path, :key => task.key,
+                :cached => false, :host => remote.host)
+end
+
+"""
+One remote slot: handshake (toolchain), then keep taking matching TUs. A host that
+is unreachable or whose toolchain changes is retried after REMOTE_RETRY_INTERVAL.
+"""
+function remote_loop(remote::RemoteHost)
+    while true
+        info = DaemonRPC.call_remote(remote.host, remote.port, :toolchain_info; token=COMPILE_TOKEN, timeout=10.0)
+        if !(info isa Dict && get(info, :success, false))
+            sleep(REMOTE_RETRY_INTERVAL)
+            continue
+        end
+        toolchain = info[:toolchain]
+
+        while true
+            task = next_remote_task!(toolchain, time() + REMOTE_RETRY_INTERVAL)
+            task === nothing && break   # idle: re-check the toolchain before taking more
+
+            result = try
+                compile_remote(remote, task)
+            catch e
+                println("[COMPILE] ⚠️  Remote compile on $(remote.host) failed: $e")
+                nothing
+            end
+
+            if result === :local
+                task.toolchain = ""
+                requeue!(task)
+                continue
+            elseif result === nothing
+                requeue!(task)
+                println("[COMPILE] ⚠️  $(remote.host) unavailable, $(basename(task.source)) requeued")
+                sleep(REMOTE_RETRY_INTERVAL)
+                break
+            end
+            lock(() -> SCHEDULER.stats["remote_compiled"] += 1, SCHEDULER.lock)
+            finish_task!(task, result)
+        end
+    end
+end
+
+# Remote slots never count as idle workers: the local pool still grows for TUs they cannot take
+for remote in REMOTE_HOSTS, _ in 1:remote.slots
+    @async remote_loop(remote)
+end
+
+# ============================================================================
+# COMPILATION FUNCTIONS
+# ============================================================================
+
+"""
+Compile all sources to IR in parallel.
+With `changed_files` (a watcher batch), only the TUs they affect through the reverse
+include graph are re-keyed; the others keep this session's key and IR.
 """
 function compile_parallel(args::Dict)
     config_path = get(args, "config", "jmake.toml")
     force = get(args, "force", false)
+    changed_files = String[abspath(f) for f in get(args, "changed_files", String[])]
+    priority = get(args, "priority", BACKGROUND_PRIORITY)
+    client = get(args, "client", "default")
 
-    println("[COMPILE] Starting parallel compilation")
+    println("[COMPILE] Starting parallel compilation (client: $client, priority: $priority)")
 
     try
         # Load configuration
@@ -165,25 +760,73 @@ function compile_parallel(args::Dict)
         # Get compilation settings
         output_dir = get(config.compile, "output_dir", "build/ir")
         output_dir = joinpath(config.project_root, output_dir)
-        include_dirs = ConfigurationManager.get_include_dirs(config)
+        include_dirs = String[ConfigurationManager.get_include_dirs(config)...]
         flags = get(config.compile, "flags", ["-std=c++17", "-fPIC"])
 
         # Get clang path
         clang_path = get(config.llvm, "tools", Dict())["clang++"]
 
+        # Bitcode unless textual IR was asked for; the output-kind flag is part of the key
+        ir_ext = ir_extension(config)
+        forced = BuildCache.forced_includes_from_flags(String[flags...])
+
+        # Each TU gets only the include dirs its headers come from, so its key matches a
+        # compile streamed before discovery finished and survives new header directories
+        unit_flags = Dict(source => unit_ir_flags(config.compile, something(
+            BuildCache.unit_include_dirs(source, include_dirs; forced=forced), include_dirs))
+            for source in all_sources)
+        cache = get_artifact_cache(config)
+        toolchain = BuildCache.toolchain_version(clang_path)
+
+        # C++ TUs share one PCH of the project's hot headers; its path (and key) joins their flags
+        if get(config.compile, "pch", false)
+            cxx_sources = filter(source -> !endswith(source, ".c"), all_sources)
+            pch = project_pch(config, cxx_sources, include_dirs, clang_path, cache, toolchain)
+            isnothing(pch) || foreach(source -> append!(unit_flags[source], BuildCache.pch_flags(pch)), cxx_sources)
+        end
+
         println("[COMPILE] Compiling $(length(all_sources)) source files...")
         println("[COMPILE] Output: $output_dir")
-        println("[COMPILE] Workers: $(nprocs())")
+        println("[COMPILE] Workers: $(length(SCHEDULER.workers)) (up to $MAX_WORKERS)")
+
+        # TUs a change batch can have touched; the rest are unchanged since this session
+        # compiled them. A changed file outside the graph (config, deleted header) re-keys all.
+        affected = nothing
+        if !isempty(changed_files) && !force
+            include_graph = Dict(source => BuildCache.resolve_header_closure(source, include_dirs)
+                                 for source in all_sources if isfile(source))
+            reverse_graph = LLVMake.reverse_include_graph(include_graph)
+            sources = Set(all_sources)
+            if all(f -> f in sources || haskey(reverse_graph, f), changed_files)
+                affected = LLVMake.affected_sources(changed_files, reverse_graph, sources)
+            end
+        end
+        isnothing(affected) ||
+            println("[COMPILE] Change set: $(length(changed_files)) file(s) → $(length(affected)) affected TU(s)")
 
         # Check cache and filter sources that need compilation
         sources_to_compile = String[]
+        source_keys = Dict{String, String}()
         cached_results = Dict[]
 
         for source in all_sources
-            cached, ir_path = is_ir_cached(source, output_dir)
+            if !isfile(source)
+                push!(sources_to_compile, source)
+                continue
+            end
 
-            if cached && !force
+            session = get(IR_CACHE, source, nothing)
+            key = if !isnothing(affected) && !(source in affected) && !isnothing(session)
+                session[2]
+            else
+                BuildCache.cache_key(source, unit_flags[source]; toolchain=toolchain)
+            end
+            source_keys[source] = key
+            cached, ir_path = force ? (false, "") : is_ir_cached(cache, source, key, output_dir, ir_ext)
+
+            if cached
                 println("[COMPILE] ✓ Cached: $(basename(source))")
+                DaemonRPC.progress(Dict("file" => source, "status" => "cached"))
                 push!(cached_results, Dict(
                     :success => true,
                     :source => source,
@@ -201,24 +844,27 @@ function compile_parallel(args::Dict)
         if !isempty(sources_to_compile)
             println("[COMPILE] Compiling $(length(sources_to_compile)) files in parallel...")
 
-            # Distribute compilation across workers
-            futures = [@spawnat :any compile_source_to_ir(
-                source, output_dir, include_dirs, flags, clang_path
+            # Queue every TU at once; identical keys in flight for other requests are joined
+            submitted = [submit_compile(
+                source, output_dir, unit_flags[source], clang_path, cache.root, get(source_keys, source, ""), ir_ext;
+                project=config.project_root, client=client, priority=priority, toolchain=toolchain
             ) for source in sources_to_compile]
 
             # Collect results
-            for (i, future) in enumerate(futures)
-                result = fetch(future)
+            for (source, (task, joined)) in zip(sources_to_compile, submitted)
+                result = await_compile(task, source, output_dir)
                 push!(compile_results, result)
 
                 if result[:success]
                     # Update cache
-                    IR_CACHE[result[:source]] = (result[:ir_path], mtime(result[:source]))
-                    println("[COMPILE] ✓ Compiled: $(basename(result[:source]))")
+                    IR_CACHE[result[:source]] = (result[:ir_path], result[:key])
+                    println("[COMPILE] ✓ $(joined ? "Shared" : "Compiled"): $(basename(result[:source]))")
                 else
                     println("[COMPILE] ✗ Failed: $(basename(result[:source]))")
                     println("    Error: $(result[:error])")
                 end
+                # Streamed to RPC callers as each TU finishes (no-op under runexpr)
+                DaemonRPC.progress(Dict("file" => source, "status" => result[:success] ? (joined ? "shared" : "compiled") : "failed"))
             end
         end
 
@@ -243,6 +889,8 @@ function compile_parallel(args::Dict)
             :success_count => success_count,
             :failed_count => failed_count,
             :cached_count => cached_count,
+            :affected => isnothing(affected) ? all_sources : collect(affected),
+            :keys => source_keys,
             :results => all_results,
             :ir_files => [r[:ir_path] for r in all_results if r[:success]]
         )
@@ -256,6 +904,134 @@ function compile_parallel(args::Dict)
     end
 end
 
+"""
+Compile TUs planned before jmake.toml exists (streamed builds). Each unit carries its
+own include dirs; the IR lands in the same cache compile_parallel reads, so the staged
+build that follows finds it (or joins the compile still in flight).
+"""
+function compile_units(args::Dict)
+    project_root = get(args, "project_root", pwd())
+    compile = get(args, "compile", ConfigurationManager.default_compile_section())
+    clang_path = get(args, "clang", "")
+    units = get(args, "units", Dict[])
+    cache_dir = get(args, "cache_dir", BuildCache.default_cache_dir(project_root))
+    priority = get(args, "priority", BACKGROUND_PRIORITY)
+    client = get(args, "client", "default")
+
+    println("[COMPILE] Streamed batch: $(length(units)) TU(s) (client: $client)")
+
+    try
+        cache = artifact_cache(cache_dir, get(args, "remote_cache", get(ENV, "JMAKE_REMOTE_CACHE", "")))
+        output_dir = joinpath(project_root, get(compile, "output_dir", "build/ir"))
+        ir_ext = ir_extension(compile)
+        toolchain = BuildCache.toolchain_version(clang_path)
+
+        cached_count = 0
+        submitted = []
+        for unit in units
+            source = unit["source"]
+            flags = unit_ir_flags(compile, String[unit["include_dirs"]...])
+            key = BuildCache.cache_key(source, flags; toolchain=toolchain)
+
+            if first(is_ir_cached(cache, source, key, output_dir, ir_ext))
+                cached_count += 1
+                DaemonRPC.progress(Dict("file" => source, "status" => "cached"))
+                continue
+            end
+            push!(submitted, (source, submit_compile(
+                source, output_dir, flags, clang_path, cache.root, key, ir_ext;
+                project=project_root, client=client, priority=priority, toolchain=toolchain
+            )))
+        end
+
+        failed_count = 0
+        for (source, (task, joined)) in submitted
+            result = await_compile(task, source, output_dir)
+            if result[:success]
+                IR_CACHE[source] = (result[:ir_path], result[:key])
+            else
+                # Not fatal here: the staged build recompiles it with the final flags
+                failed_count += 1
+            end
+            DaemonRPC.progress(Dict("file" => source, "status" => result[:success] ? (joined ? "shared" : "compiled") : "failed"))
+        end
+
+        return Dict(
+            :success => failed_count == 0,
+            :total => length(units),
+            :compiled_count => length(submitted) - failed_count,
+            :cached_count => cached_count,
+            :failed_count => failed_count
+        )
+
+    catch e
+        return Dict(
+            :success => false,
+            :error => string(e),
+            :stacktrace => sprint(showerror, e, catch_backtrace())
+        )
+    end
+end
+
+"""
+Toolchain fingerprint of this host (handshake of remote compile slots)
+"""
+function toolchain_info(args::Dict)
+    clang_path = LLVMEnvironment.get_tool("clang++")
+    return Dict(
+        :success => true,
+        :host => gethostname(),
+        :toolchain => BuildCache.toolchain_version(clang_path),
+        :workers => length(SCHEDULER.workers),
+        :max_workers => MAX_WORKERS
+    )
+end
+
+"""
+Compile a TU preprocessed on another build node and return its IR bytes. Runs on this
+host's worker pool with this host's clang; rejected when the caller's toolchain differs
+from ours, so IR from two LLVM versions never meets in one cache, and when its flags
+fail `remote_flags_allowed`.
+"""
+function compile_preprocessed(args::Dict)
+    source = string(get(args, "source", "unit"))
+    language = get(args, "language", "c++-cpp-output")
+    flags = String[get(args, "flags", String[])...]
+    ir_ext = get(args, "ir_ext", ".bc")
+    client = string(get(args, "client", "remote"))
+
+    if !(language in ("c++-cpp-output", "cpp-output") && ir_ext in (".bc", ".ll") && remote_flags_allowed(flags))
+        return Dict(:success => false, :rejected => true, :source => source,
+                    :error => "Remote compile refused on $(gethostname()): unsupported language, output or flags")
+    end
+
+    clang_path = LLVMEnvironment.get_tool("clang++")
+    toolchain = BuildCache.toolchain_version(clang_path)
+    if get(args, "toolchain", "") != toolchain
+        return Dict(
+            :success => false,
+            :toolchain_mismatch => true,
+            :error => "Toolchain mismatch on $(gethostname()): $(first(split(toolchain, '\n')))"
+        )
+    end
+
+    try
+        mktempdir() do dir
+            input = joinpath(dir, splitext(basename(source))[1] * (language == "cpp-output" ? ".i" : ".ii"))
+            write(input, args["preprocessed"])
+
+            # No cache key: the caller stores the result; an empty toolchain keeps it on this host
+            task, _ = submit_compile(input, dir, vcat(["-x", language], flags), clang_path, "", "", ir_ext;
+                                     project="remote:$client", client=source, priority=BACKGROUND_PRIORITY)
+            result = fetch(task.result)
+            result[:success] || return merge(result, Dict(:source => source, :exitcode => get(result, :exitcode, 1)))
+            return Dict(:success => true, :source => source, :ir => read(result[:ir_path]))
+        end
+    catch e
+        return Dict(:success => false, :source => source, :error => string(e))
+    end
+end
+
 """
 Link IR files into single module
 """
@@ -263,6 +1039,7 @@ function link_ir(args::Dict)
     ir_files = get(args, "ir_files", String[])
     output_path = get(args, "output", "")
     llvm_link_path = get(args, "llvm_link", "")
+    text = get(args, "text", false)
 
     println("[COMPILE] Linking $(length(ir_files)) IR files...")
 
@@ -279,7 +1056,7 @@ function link_ir(args::Dict)
         mkpath(dirname(output_path))
 
         # Build llvm-link command
-        args_list = vcat(["-S", "-o", output_path], ir_files)
+        args_list = vcat(text ? ["-S"] : String[], ["-o", output_path], ir_files)
 
         # Execute linking
         output, exitcode = BuildBridge.execute(llvm_link_path, args_list, use_llvm_env=true)
@@ -315,12 +1092,13 @@ function optimize_ir(args::Dict)
     output_path = get(args, "output", "")
     opt_level = get(args, "opt_level", "O2")
     opt_path = get(args, "opt", "")
+    text = get(args, "text", false)
 
     println("[COMPILE] Optimizing IR: $ir_path")
 
     try
         # Build opt command
-        args_list = ["-$opt_level", "-S", "-o", output_path, ir_path]
+        args_list = vcat(["-$opt_level"], text ? ["-S"] : String[], ["-o", output_path, ir_path])
 
         # Execute optimization
         output, exitcode = BuildBridge.execute(opt_path, args_list, use_llvm_env=true)
@@ -388,6 +1166,69 @@ function compile_to_object(args::Dict)
     end
 end
 
+"""
+Optimize and generate code for a bitcode module in one clang invocation
+(the module is parsed once instead of once for opt and again for llc)
+"""
+function optimize_to_object(args::Dict)
+    ir_path = get(args, "ir_path", "")
+    output_path = get(args, "output", "")
+    opt_level = get(args, "opt_level", "O2")
+    clang_path = get(args, "clang", "")
+
+    println("[COMPILE] Optimizing and compiling to object: $ir_path")
+
+    try
+        args_list = ["-c", "-$opt_level", "-fPIC", "-o", output_path, ir_path]
+
+        output, exitcode = BuildBridge.execute(clang_path, args_list, use_llvm_env=true)
+
+        if exitcode != 0
+            return Dict(
+                :success => false,
+                :error => output,
+                :exitcode => exitcode
+            )
+        end
+
+        println("[COMPILE] ✓ Object file: $output_path")
+
+        return Dict(
+            :success => true,
+            :output => output_path
+        )
+
+    catch e
+        return Dict(
+            :success => false,
+            :error => string(e)
+        )
+    end
+end
+
+"""
+Write a textual copy of a bitcode module with llvm-dis (debugging only)
+"""
+function disassemble_ir(args::Dict)
+    ir_path = get(args, "ir_path", "")
+    output_path = get(args, "output", splitext(ir_path)[1] * ".ll")
+    llvm_dis_path = get(args, "llvm_dis", "llvm-dis")
+
+    try
+        output, exitcode = BuildBridge.execute(llvm_dis_path, ["-o", output_path, ir_path], use_llvm_env=true)
+
+        if exitcode != 0
+            return Dict(:success => false, :error => output, :exitcode => exitcode)
+        end
+
+        println("[COMPILE] 📝 Text IR: $output_path")
+        return Dict(:success => true, :output => output_path)
+
+    catch e
+        return Dict(:success => false, :error => string(e))
+    end
+end
+
 """
 Link object files into shared library
 """
@@ -435,11 +1276,29 @@ function link_shared_library(args::Dict)
 end
 
 """
-Full compilation pipeline: sources → IR → optimize → object → library
+Digest of everything the stages after IR depend on: each TU's cache key, the link,
+optimize and library settings and the tools
+"""
+function pipeline_digest(config, keys::AbstractDict)
+    parts = sort(["$source=$key" for (source, key) in keys])
+    for section in (config.link, config.binary, config.llvm["tools"])
+        push!(parts, repr(sort(collect(Dict(section)); by=first)))
+    end
+    return bytes2hex(sha256(join(parts, "\n")))
+end
+
+# Library path => pipeline_digest of its last successful build (this session)
+const PIPELINE_DIGESTS = Dict{String, String}()
+
+"""
+Full compilation pipeline: sources → IR → optimize → object → library.
+`changed_files` (a watcher batch) limits re-keying to the TUs they affect; when no
+TU's IR changed and the library is in place, link, optimize and library are skipped.
 """
 function compile_full_pipeline(args::Dict)
     config_path = get(args, "config", "jmake.toml")
     force = get(args, "force", false)
+    changed_files = get(args, "changed_files", String[])
 
     println("[COMPILE] Running full compilation pipeline")
 
@@ -447,56 +1306,99 @@ function compile_full_pipeline(args::Dict)
         config = ConfigurationManager.load_config(config_path)
 
         # Stage 1: Compile sources to IR in parallel
-        compile_result = compile_parallel(Dict("config" => config_path, "force" => force))
+        compile_result = compile_parallel(Dict(
+            "config" => config_path,
+            "force" => force,
+            "changed_files" => changed_files,
+            "priority" => get(args, "priority", BACKGROUND_PRIORITY),
+            "client" => get(args, "client", "default")
+        ))
         if !compile_result[:success]
             return compile_result
         end
 
         ir_files = compile_result[:ir_files]
 
+        library_name = get(config.binary, "library_name", "lib$(lowercase(config.project_name)).so")
+        library_path = joinpath(config.project_root, get(config.binary, "output_dir", "julia"), library_name)
+
+        # Same IR and settings as the library on disk: the later stages would reproduce it
+        digest = pipeline_digest(config, compile_result[:keys])
+        if !force && get(PIPELINE_DIGESTS, library_path, "") == digest && isfile(library_path)
+            reason = "no translation unit's IR changed"
+            println("[COMPILE] ⏭  Link, optimize and library skipped: $reason")
+            return Dict(
+                :success => true,
+                :library_path => library_path,
+                :compile_stats => compile_result,
+                :skipped => Dict(stage => reason for stage in ["link", "optimize", "object", "library"]),
+                :stages => Dict("compile" => true, "link" => true, "optimize" => true,
+                                "object" => true, "library" => true)
+            )
+        end
+
         # Stage 2: Link IR files
-        linked_ir_path = joinpath(config.project_root, get(config.link, "output_dir", "build/linked"), "linked.ll")
+        ir_ext = ir_extension(config)
+        text = ir_ext == ".ll"
+        tools = config.llvm["tools"]
+        linked_ir_path = joinpath(config.project_root, get(config.link, "output_dir", "build/linked"), "linked$ir_ext")
         link_result = link_ir(Dict(
             "ir_files" => ir_files,
             "output" => linked_ir_path,
-            "llvm_link" => config.llvm["tools"]["llvm-link"]
+            "llvm_link" => tools["llvm-link"],
+            "text" => text
         ))
 
         if !link_result[:success]
             return link_result
         end
 
-        # Stage 3: Optimize
         opt_level = get(config.link, "opt_level", "O2")
-        optimized_ir_path = joinpath(dirname(linked_ir_path), "optimized.ll")
-
-        opt_result = optimize_ir(Dict(
-            "ir_path" => linked_ir_path,
-            "output" => optimized_ir_path,
-            "opt_level" => opt_level,
-            "opt" => config.llvm["tools"]["opt"]
-        ))
+        object_path = joinpath(dirname(linked_ir_path), "output.o")
+
+        if text
+            # Stage 3: Optimize
+            optimized_ir_path = joinpath(dirname(linked_ir_path), "optimized.ll")
+
+            opt_result = optimize_ir(Dict(
+                "ir_path" => linked_ir_path,
+                "output" => optimized_ir_path,
+                "opt_level" => opt_level,
+                "opt" => tools["opt"],
+                "text" => true
+            ))
+
+            if !opt_result[:success]
+                return opt_result
+            end
 
-        if !opt_result[:success]
-            return opt_result
+            # Stage 4: Compile to object
+            obj_result = compile_to_object(Dict(
+                "ir_path" => optimized_ir_path,
+                "output" => object_path,
+                "llc" => tools["llc"]
+            ))
+        else
+            get(config.compile, "emit_ir", false) && disassemble_ir(Dict(
+                "ir_path" => linked_ir_path,
+                "llvm_dis" => get(tools, "llvm-dis", joinpath(dirname(tools["llvm-link"]), "llvm-dis"))
+            ))
+
+            # Stages 3+4: optimize and generate code from the linked bitcode in one process
+            obj_result = optimize_to_object(Dict(
+                "ir_path" => linked_ir_path,
+                "output" => object_path,
+                "opt_level" => opt_level,
+                "clang" => tools["clang++"]
+            ))
+            opt_result = obj_result
         end
 
-        # Stage 4: Compile to object
-        object_path = joinpath(dirname(optimized_ir_path), "output.o")
-        obj_result = compile_to_object(Dict(
-            "ir_path" => optimized_ir_path,
-            "output" => object_path,
-            "llc" => config.llvm["tools"]["llc"]
-        ))
-
         if !obj_result[:success]
             return obj_result
         end
 
         # Stage 5: Link shared library
-        library_name = get(config.binary, "library_name", "lib$(lowercase(config.project_name)).so")
-        library_path = joinpath(config.project_root, get(config.binary, "output_dir", "julia"), library_name)
-
         lib_result = link_shared_library(Dict(
             "object_files" => [object_path],
             "output" => library_path,
@@ -508,6 +1410,8 @@ function compile_full_pipeline(args::Dict)
             return lib_result
         end
 
+        PIPELINE_DIGESTS[library_path] = digest
+
         println("[COMPILE] ✅ Full pipeline complete!")
         println("[COMPILE] Library: $library_path")
 
@@ -541,6 +1445,14 @@ function clear_caches(args::Dict)
 
     empty!(IR_CACHE)
     empty!(BINARY_CACHE)
+    empty!(PIPELINE_DIGESTS)
+
+    # Persistent store is only wiped on request
+    if get(args, "persistent", false)
+        for cache in values(ARTIFACT_CACHES)
+            BuildCache.clear!(cache)
+        end
+    end
 
     return Dict(
         :success => true,
@@ -548,6 +1460,30 @@ function clear_caches(args::Dict)
     )
 end
 
+"""
+Forget session state for changed or deleted source files (pushed by the orchestrator
+from watcher batches). The persistent store is content-addressed and needs no eviction.
+"""
+function invalidate_files(args::Dict)
+    files = get(args, "files", String[])
+    dropped = 0
+
+    for file in files
+        if haskey(IR_CACHE, abspath(file))
+            delete!(IR_CACHE, abspath(file))
+            dropped += 1
+        elseif haskey(IR_CACHE, file)
+            delete!(IR_CACHE, file)
+            dropped += 1
+        end
+    end
+
+    return Dict(
+        :success => true,
+        :invalidated => dropped
+    )
+end
+
 """
 Get cache statistics
 """
@@ -557,7 +1493,10 @@ function cache_stats(args::Dict)
         :stats => Dict(
             "ir_files" => length(IR_CACHE),
             "binaries" => length(BINARY_CACHE),
-            "workers" => nprocs()
+            "workers" => nprocs(),
+            "scheduler" => scheduler_stats(),
+            "artifact_caches" => [BuildCache.cache_stats(c) for c in values(ARTIFACT_CACHES)],
+            "counters" => JMake.Tracing.counters()
         )
     )
 end
@@ -573,25 +1512,48 @@ function main()
     println("="^70)
     println("JMake Compilation Daemon Server")
     println("Port: $PORT")
-    println("Workers: $(nprocs())")
+    println("Workers: $(length(SCHEDULER.workers)) (load-following, $MIN_WORKERS-$MAX_WORKERS)")
+    isempty(REMOTE_HOSTS) || println("Remote hosts: $(join(["$(h.host):$(h.port)*$(h.slots)" for h in REMOTE_HOSTS], ", "))")
     println("="^70)
 
     println()
     println("Available Functions:")
-    println("  • compile_parallel(config, force=false) - Parallel C++ → IR")
-    println("  • link_ir(ir_files, output, llvm_link)")
-    println("  • optimize_ir(ir_path, output, opt_level='O2', opt)")
+    println("  • compile_parallel(config, force=false, priority=0, client) - Parallel C++ → IR")
+    println("  • compile_units(project_root, compile, clang, units, cache_dir) - Streamed TUs")
+    println("  • toolchain_info()")
+    println("  • link_ir(ir_files, output, llvm_link, text=false)")
+    println("  • optimize_ir(ir_path, output, opt_level='O2', opt, text=false)")
     println("  • compile_to_object(ir_path, output, llc)")
+    println("  • optimize_to_object(ir_path, output, opt_level='O2', clang) - opt + codegen")
+    println("  • disassemble_ir(ir_path, output, llvm_dis)")
     println("  • link_shared_library(object_files, output, libraries, clang)")
-    println("  • compile_full_pipeline(config, force=false) - Complete build")
+    println("  • compile_full_pipeline(config, force=false, changed_files, priority=0, client) - Complete build")
     println("  • cache_stats()")
-    println("  • clear_caches()")
+    println("  • invalidate_files(files)")
+    println("  • clear_caches(persistent=false)")
+    isempty(REMOTE_BIND) || println("  • compile_preprocessed(source, language, preprocessed, flags, toolchain), toolchain_info() - remote listener")
     println()
     println("Ready to accept compilation requests...")
     println("="^70)
 
-    # Start the daemon server
-    serve(PORT)
+    # Typed RPC listener for other daemons on this host (each request in its own task), then
+    # DaemonMode; requests run concurrently so they can share TU compiles. Its handlers run
+    # caller-named tools, so it never leaves loopback
+    DaemonRPC.start_service(PORT, [compile_parallel, compile_units, toolchain_info,
+                                   link_ir, optimize_ir, compile_to_object,
+                                   optimize_to_object, disassemble_ir, link_shared_library,
+                                   compile_full_pipeline, cache_stats, invalidate_files, clear_caches])
+
+    # Other build nodes reach only the TU entry points, data-only and token-checked
+    if !isempty(REMOTE_BIND)
+        if isempty(COMPILE_TOKEN)
+            println("⚠️  JMAKE_REMOTE_BIND is set but JMAKE_COMPILE_TOKEN is not: not taking remote TUs")
+        else
+            DaemonRPC.serve_remote(PORT, [compile_preprocessed, toolchain_info];
+                                   token=COMPILE_TOKEN, host=parse(IPAddr, REMOTE_BIND))
+        end
+    end
+    serve(PORT, async=true)
 end
 
 # Start the daemon if run directly
@@ -87,18 +87,56 @@ end
 # ============================================================================
 
 """
-Fast file scanning with caching
+Stream one scanned directory to the RPC caller (no-op under runexpr): its sources and
+whether it holds headers. Consumed by the orchestrator's pipelined build.
+"""
+function emit_directory(target_dir::String, rel_dir::String, sources::Vector{String}, has_headers::Bool)
+    DaemonRPC.progress(Dict(
+        "status" => "scanned",
+        "dir" => rel_dir,
+        "sources" => [abspath(joinpath(target_dir, f)) for f in sources],
+        "has_headers" => has_headers
+    ))
+end
+
+function emit_directory(target_dir::String, rel_dir::String, listing::Discovery.DirIndex)
+    sources = [joinpath(rel_dir, e.name) for e in listing.files if e.category in (:cpp_sources, :c_sources)]
+    has_headers = any(e -> e.category in (:cpp_headers, :c_headers), listing.files)
+    emit_directory(target_dir, rel_dir, sources, has_headers)
+end
+
+"""
+Replay a cached scan as directory events
+"""
+function emit_scan(target_dir::String, scan::Discovery.ScanResults)
+    dirs = Dict{String,Tuple{Vector{String},Bool}}()
+    for f in vcat(scan.cpp_sources, scan.c_sources)
+        push!(get!(() -> (String[], false), dirs, dirname(f))[1], f)
+    end
+    for h in vcat(scan.cpp_headers, scan.c_headers)
+        sources, _ = get(dirs, dirname(h), (String[], false))
+        dirs[dirname(h)] = (sources, true)
+    end
+    for (rel_dir, (sources, has_headers)) in sort(collect(dirs), by=first)
+        emit_directory(target_dir, rel_dir, sources, has_headers)
+    end
+end
+
+"""
+Fast file scanning with caching; each directory is streamed as it is listed
 """
 function scan_files(args::Dict)
     target_dir = get(args, "path", pwd())
     force = get(args, "force", false)
+    stream = get(args, "stream", true)
 
     println("[DISCOVERY] Scanning files: $target_dir")
 
     # Check cache
     cache_key = dir_hash(target_dir)
-    if !force && haskey(FILE_SCAN_CACHE, cache_key)
+    if !force && JMake.Tracing.count_cache!("daemon_file_scans", haskey(FILE_SCAN_CACHE, cache_key))
         println("[DISCOVERY] Using cached scan results")
+        stream && emit_scan(target_dir, FILE_SCAN_CACHE[cache_key])
         return Dict(
             :success => true,
             :cached => true,
@@ -108,7 +146,8 @@ function scan_files(args::Dict)
 
     try
         # Use Discovery module's scan function
-        scan_results = Discovery.scan_all_files(target_dir)
+        scan_results = Discovery.scan_all_files(target_dir;
+            on_directory=stream ? (rel_dir, listing) -> emit_directory(target_dir, rel_dir, listing) : nothing)
 
         # Cache results
         FILE_SCAN_CACHE[cache_key] = scan_results
@@ -146,7 +185,7 @@ function detect_binaries(args::Dict)
 
     # Check cache
     cache_key = dir_hash(target_dir)
-    if !force && haskey(BINARY_CACHE, cache_key)
+    if !force && JMake.Tracing.count_cache!("daemon_binaries", haskey(BINARY_CACHE, cache_key))
         println("[DISCOVERY] Using cached binary results")
         return Dict(
             :success => true,
@@ -157,7 +196,7 @@ function detect_binaries(args::Dict)
 
     try
         # Need scan results first
-        scan_result = scan_files(Dict("path" => target_dir, "force" => force))
+        scan_result = scan_files(Dict("path" => target_dir, "force" => force, "stream" => false))
         if !scan_result[:success]
             return scan_result
         end
@@ -195,7 +234,7 @@ function walk_ast_dependencies(args::Dict)
 
     # Check cache
     cache_key = dir_hash(target_dir)
-    if !force && haskey(AST_CACHE, cache_key)
+    if !force && JMake.Tracing.count_cache!("daemon_ast_graphs", haskey(AST_CACHE, cache_key))
         println("[DISCOVERY] Using cached AST dependency graph")
         return Dict(
             :success => true,
@@ -205,8 +244,8 @@ function walk_ast_dependencies(args::Dict)
     end
 
     try
-        # Get scan results
-        scan_result = scan_files(Dict("path" => target_dir, "force" => force))
+        # Get scan results (already streamed by discover_project)
+        scan_result = scan_files(Dict("path" => target_dir, "force" => force, "stream" => false))
         if !scan_result[:success]
             return scan_result
         end
@@ -218,12 +257,8 @@ function walk_ast_dependencies(args::Dict)
             include_dirs = Discovery.build_include_dirs(target_dir, scan_data)
         end
 
-        # Walk dependencies using cached clang path
-        clang_path = get(TOOL_CACHE, "clang++", "")
-        if isempty(clang_path)
-            @warn "Clang not found in cache, using system"
-            clang_path = LLVMEnvironment.get_tool("clang++")
-        end
+        # Edges harvested from compile-time depfiles; files not compiled yet use the regex scan
+        depfile_graph = ASTWalker.load_depfile_graph(Discovery.depfile_graph_file(target_dir))
 
         # Get all source files
         all_sources = vcat(
@@ -245,8 +280,7 @@ function walk_ast_dependencies(args::Dict)
         dep_graph = ASTWalker.build_dependency_graph(
             all_sources,
             include_dirs,
-            use_clang=true,
-            clang_path=clang_path
+            depfile_graph=depfile_graph
         )
 
         # Cache results
@@ -256,8 +290,8 @@ function walk_ast_dependencies(args::Dict)
             :success => true,
             :cached => false,
             :graph => dep_graph,
-            :nodes => length(dep_graph.nodes),
-            :edges => length(dep_graph.edges)
+            :nodes => length(dep_graph.files),
+            :edges => sum(length(v) for v in values(dep_graph.include_graph); init=0)
         )
 
     catch e
@@ -400,7 +434,8 @@ function cache_stats(args::Dict)
             "tools" => length(TOOL_CACHE),
             "file_scans" => length(FILE_SCAN_CACHE),
             "binaries" => length(BINARY_CACHE),
-            "ast_graphs" => length(AST_CACHE)
+            "ast_graphs" => length(AST_CACHE),
+            "counters" => JMake.Tracing.counters()
         )
     )
 end
@@ -423,7 +458,7 @@ function main()
 
     println()
     println("Available Functions:")
-    println("  • scan_files(path, force=false)")
+    println("  • scan_files(path, force=false, stream=true) - streams each directory")
     println("  • detect_binaries(path, force=false)")
     println("  • walk_ast_dependencies(path, include_dirs=[], force=false)")
     println("  • discover_project(path, force=false) - Full pipeline")
@@ -435,7 +470,9 @@ function main()
     println("Ready to accept discovery requests...")
     println("="^70)
 
-    # Start the daemon server
+    # Typed RPC listener for other daemons, then DaemonMode for the CLI
+    DaemonRPC.start_service(PORT, [scan_files, detect_binaries, walk_ast_dependencies, discover_project,
+                                   get_tool, get_all_tools, cache_stats, clear_caches])
     serve(PORT)
 end
 
@@ -2,16 +2,83 @@
 """
 Error Handler Daemon Server - Processes compilation errors and learns from them
 
+Owns the error databases: one ErrorStore (lookup connection + background batched
+writer) per database file, so build processes queue their failures here instead of
+each opening and writing `jmake_errors.db` themselves.
+
 Start with: julia error_handler_daemon.jl
-Port: 3002
+Port: 3005
 """
 
 using DaemonMode
 using JMake
-using JMake.ErrorLearning
 
-const PORT = 3002
-const ERROR_QUEUE = []
+const PORT = 3005
+const DEFAULT_DB = get(ENV, "JMAKE_ERROR_DB", "jmake_errors.db")
+
+# ============================================================================
+# STORES AND TICKETS
+# ============================================================================
+
+"""
+Store of the database named in a request (the daemon's default database otherwise)
+"""
+store_for(args::Dict) = ErrorLearning.open_store(get(args, "db_path", DEFAULT_DB))
+
+# Callers get a ticket for each queued error so later fixes can refer to it
+const TICKETS = Dict{Int,ErrorLearning.PendingError}()
+const TICKETS_LOCK = ReentrantLock()
+const NEXT_TICKET = Ref(0)
+const MAX_TICKETS = 10_000
+
+function issue_ticket(pending::ErrorLearning.PendingError)
+    lock(TICKETS_LOCK) do
+        ticket = NEXT_TICKET[] += 1
+        TICKETS[ticket] = pending
+        # Fixes follow their error within one build; forget the oldest tickets
+        haskey(TICKETS, ticket - MAX_TICKETS) && delete!(TICKETS, ticket - MAX_TICKETS)
+        return ticket
+    end
+end
+
+# ============================================================================
+# HANDLERS
+# ============================================================================
+
+"""
+Queue a failure and return its pattern and fix suggestions (the write happens in the background)
+"""
+function queue_error(args::Dict)
+    store = store_for(args)
+    output = get(args, "output", "")
+    project_path = get(args, "project_path", "")
+
+    suggestions = get(args, "suggest", true) ?
+        ErrorLearning.suggest_fixes(store, output; project_path=project_path) : []
+    (pending, pattern_name, description) = ErrorLearning.record_error!(
+        store, get(args, "command", ""), output;
+        project_path=project_path, file_path=get(args, "file_path", ""))
+
+    return Dict(
+        :success => true,
+        :ticket => issue_ticket(pending),
+        :pattern => pattern_name,
+        :description => description,
+        :suggestions => suggestions
+    )
+end
+
+"""
+Queue a fix attempt for a ticket from queue_error
+"""
+function queue_fix(args::Dict)
+    pending = lock(() -> get(TICKETS, get(args, "ticket", 0), nothing), TICKETS_LOCK)
+    isnothing(pending) && return Dict(:success => false, :error => "Unknown ticket: $(get(args, "ticket", 0))")
+
+    ErrorLearning.record_fix!(store_for(args), pending, get(args, "description", ""),
+                              get(args, "action", ""), get(args, "type", "manual"), get(args, "success", false))
+    return Dict(:success => true)
+end
 
 """
 Process and learn from compilation errors
@@ -24,25 +91,26 @@ function handle_error(args::Dict)
     println("[ERROR DAEMON] Processing error...")
 
     try
-        # Parse and categorize the error
-        error_info = ErrorLearning.parse_error(error_text)
+        store = store_for(args)
+        project_path = string(get(context, "project_path", get(context, "project", "")))
 
-        # Store in learning database
-        ErrorLearning.record_error(error_info, context)
-
-        # Check for known solutions
-        solutions = ErrorLearning.find_solutions(error_info)
+        # Check for known solutions, then queue the error for the learning database
+        solutions = ErrorLearning.suggest_fixes(store, error_text; project_path=project_path)
+        (pending, pattern_name, _) = ErrorLearning.record_error!(
+            store, get(context, "command", ""), error_text; project_path=project_path)
 
+        confidence = length(solutions) > 0 ? solutions[1]["confidence"] : 0.0
         result = Dict(
             :success => true,
-            :error_type => error_info[:type],
+            :error_type => pattern_name,
+            :ticket => issue_ticket(pending),
             :solutions => solutions,
-            :confidence => length(solutions) > 0 ? solutions[1][:confidence] : 0.0
+            :confidence => confidence
         )
 
         # Auto-apply fix if requested and high confidence
-        if auto_fix && length(solutions) > 0 && solutions[1][:confidence] > 0.8
-            println("[ERROR DAEMON] Auto-applying fix with confidence: $(solutions[1][:confidence])")
+        if auto_fix && confidence > 0.8
+            println("[ERROR DAEMON] Auto-applying fix with confidence: $confidence")
             fix_result = apply_fix(solutions[1], context)
             result[:fix_applied] = fix_result
         end
@@ -65,7 +133,7 @@ function apply_fix(solution::Dict, context::Dict)
     # This would contain logic to actually apply the fix
     # For now, return the recommended action
     return Dict(
-        :action => solution[:fix],
+        :action => solution["action"],
         :applied => false,
         :reason => "Manual review required"
     )
@@ -74,9 +142,13 @@ end
 """
 Get error statistics
 """
-function get_error_stats(args::Dict)
+function error_stats(args::Dict)
     try
-        stats = ErrorLearning.get_statistics()
+        store = store_for(args)
+        stats = ErrorLearning.get_error_stats(store)
+        stats["common_patterns"] = [Dict("pattern" => row.error_pattern, "count" => row.count)
+                                    for row in eachrow(stats["common_patterns"])]
+        stats["written"] = store.written[]
         return Dict(
             :success => true,
             :stats => stats
@@ -89,6 +161,14 @@ function get_error_stats(args::Dict)
     end
 end
 
+"""
+Wait until every queued error and fix of a database is committed
+"""
+function flush_errors(args::Dict)
+    ErrorLearning.flush!(store_for(args))
+    return Dict(:success => true)
+end
+
 """
 Main daemon serve function
 """
@@ -96,14 +176,22 @@ function main()
     println("="^60)
     println("JMake Error Handler Daemon Server")
     println("Port: $PORT")
+    println("Database: $(abspath(DEFAULT_DB))")
     println("="^60)
     println("Ready to process errors and learn from them...")
     println()
 
-    # Initialize error learning database
-    ErrorLearning.init_db()
-
-    # Start the daemon server
+    # Open the default database (schema migration and index backfill happen here)
+    ErrorLearning.open_store(DEFAULT_DB)
+
+    # Typed RPC listener for other daemons, then DaemonMode for the CLI
+    DaemonRPC.start_service(PORT, [
+        handle_error,
+        "report_error" => queue_error,
+        "record_fix" => queue_fix,
+        "get_error_stats" => error_stats,
+        "flush" => flush_errors
+    ])
     serve(PORT)
 end
 
@@ -9,10 +9,15 @@ Coordinates:
 - Discovery Daemon (3001) - File scanning, AST, binaries
 - Setup Daemon (3002) - Configuration management
 - Compilation Daemon (3003) - Parallel builds
-- Error Handler Daemon (3002) - Error learning
-- Watcher Daemon (3003) - File monitoring
+- Error Handler Daemon (3005) - Error learning
+- Watcher Daemon (3006) - File monitoring
+
+Daemon-to-daemon calls go through DaemonRPC (typed frames on service port + 100);
+DaemonMode stays on the service ports for CLI use.
 
 Pipeline: compile(path) → discover → setup → compile → return
+Cold builds are pipelined: discovery streams each scanned directory, setup resolves
+per-TU include dirs as they become known and those TUs compile while the scan goes on.
 """
 
 using DaemonMode
@@ -25,14 +30,13 @@ using JMake
 
 const PORT = 3004
 
-# Daemon ports
-const DAEMON_PORTS = Dict(
-    "discovery" => 3001,
-    "setup" => 3002,
-    "compilation" => 3003,
-    "error" => 3002,
-    "watcher" => 3003
-)
+# Compilation daemon request priorities (see BACKGROUND/INTERACTIVE_PRIORITY there)
+const BACKGROUND_PRIORITY = 0
+const INTERACTIVE_PRIORITY = 10
+
+# Daemon ports (shared table in DaemonRPC)
+const DAEMON_PORTS = Dict(name => DaemonRPC.SERVICE_PORTS[name]
+                          for name in ("discovery", "setup", "compilation", "error", "watcher"))
 
 # Include daemon client utilities
 include("../clients/daemon_client.jl")
@@ -42,9 +46,21 @@ include("../clients/daemon_client.jl")
 # ============================================================================
 
 """
-Send request to a specific daemon
+Print a daemon's per-file progress and forward it to our own caller
+"""
+function forward_progress(daemon::String)
+    return event -> begin
+        haskey(event, "file") && println("[ORCHESTRATOR]   $(event["status"]): $(basename(event["file"]))")
+        DaemonRPC.progress(merge(event, Dict("daemon" => daemon)))
+    end
+end
+
 """
-function call_daemon(daemon::String, func::String, args::Dict)
+Send request to a specific daemon; its progress events go to `on_progress`
+(by default forwarded to our caller)
+"""
+function call_daemon(daemon::String, func::String, args::Dict;
+                     on_progress::Function=forward_progress(daemon))
     port = get(DAEMON_PORTS, daemon, 0)
 
     if port == 0
@@ -54,23 +70,12 @@ function call_daemon(daemon::String, func::String, args::Dict)
         )
     end
 
-    try
-        # Build expression to call the function with arguments
-        expr = :($(Symbol(func))($args))
-
-        # Send to daemon
-        result = runexpr(expr, port=port)
+    result = DaemonRPC.call(port, func, args; on_progress=on_progress)
 
-        return result
-
-    catch e
-        return Dict(
-            :success => false,
-            :error => "Daemon communication error: $e",
-            :daemon => daemon,
-            :port => port
-        )
+    if result isa Dict && get(result, :success, true) == false && haskey(result, :port)
+        result[:daemon] = daemon
     end
+    return result
 end
 
 """
@@ -82,13 +87,10 @@ function check_daemons(args::Dict)
     status = Dict{String, Bool}()
 
     for (daemon, port) in DAEMON_PORTS
-        try
-            # Try simple expression
-            result = runexpr(:(1 + 1), port=port)
-            status[daemon] = true
+        status[daemon] = DaemonRPC.ping(port)
+        if status[daemon]
             println("[ORCHESTRATOR] ✓ $daemon daemon (port $port)")
-        catch e
-            status[daemon] = false
+        else
             println("[ORCHESTRATOR] ✗ $daemon daemon (port $port) - NOT RUNNING")
         end
     end
@@ -102,13 +104,111 @@ function check_daemons(args::Dict)
     )
 end
 
+# ============================================================================
+# PIPELINED DISCOVERY
+# ============================================================================
+
 """
-Full build pipeline: discover → setup → compile
+Consume directory events from discovery while it runs: resolve each new TU's include
+dirs against the directories scanned so far (setup daemon) and send the ready ones to
+the compilation daemon at once. Returns the compile_units calls still in flight.
+"""
+function stream_compile(project_path::String, events::Channel, clang::String, force::Bool)
+    header_dirs = String[]
+    seen = Set{String}()
+    pending = String[]
+    batches = Task[]
+
+    function dispatch!(complete::Bool)
+        isempty(pending) && return
+        resolved = call_daemon("setup", "resolve_unit_flags", Dict(
+            "path" => project_path,
+            "sources" => copy(pending),
+            "include_dirs" => Discovery.build_include_dirs(project_path, header_dirs),
+            "complete" => complete,
+            "force" => force
+        ))
+        resolved[:success] || return
+
+        empty!(pending)
+        append!(pending, resolved[:pending])
+        isempty(resolved[:units]) && return
+
+        push!(batches, @async call_daemon("compilation", "compile_units", Dict(
+            "project_root" => project_path,
+            "compile" => resolved[:compile],
+            "cache_dir" => resolved[:cache_dir],
+            "clang" => clang,
+            "units" => resolved[:units],
+            "priority" => BACKGROUND_PRIORITY,
+            "client" => "orchestrator"
+        )))
+    end
+
+    for event in events
+        # Take whatever else arrived meanwhile: one setup round trip per scan level
+        batch = [event]
+        while isready(events)
+            push!(batch, take!(events))
+        end
+
+        for e in batch
+            e["has_headers"] && push!(header_dirs, e["dir"])
+            for source in e["sources"]
+                source in seen && continue
+                push!(seen, source)
+                push!(pending, source)
+            end
+        end
+        dispatch!(false)
+    end
+
+    # Scan finished: TUs still waiting get the final include list
+    dispatch!(true)
+    return batches
+end
+
+"""
+Discovery with TU compiles overlapping the scan. The staged compile that follows
+finds the streamed TUs in the IR cache or joins them while they are still running.
+"""
+function pipelined_discovery(project_path::String, force::Bool)
+    clang = call_daemon("discovery", "get_tool", Dict("tool" => "clang++"))
+    if !get(clang, :success, false)
+        println("[ORCHESTRATOR]   clang++ not known yet, streaming disabled")
+        return call_daemon("discovery", "discover_project", Dict("path" => project_path, "force" => force)), Task[]
+    end
+
+    events = Channel{Dict{String,Any}}(Inf)
+    streamer = @async stream_compile(project_path, events, clang[:path], force)
+
+    discovery_result = try
+        call_daemon("discovery", "discover_project", Dict("path" => project_path, "force" => force);
+                    on_progress=event -> get(event, "status", "") == "scanned" && put!(events, event))
+    finally
+        close(events)
+    end
+
+    # Streaming only warms the cache; the staged compile is authoritative
+    batches = try
+        fetch(streamer)
+    catch e
+        println("[ORCHESTRATOR]   ⚠️  Streamed compiles stopped: $e")
+        Task[]
+    end
+    return discovery_result, batches
+end
+
+"""
+Full build pipeline: discover → setup → compile.
+With `pipeline` (default for projects without jmake.toml) TUs start compiling while
+discovery is still scanning.
 """
 function build_project(args::Dict)
     project_path = get(args, "path", pwd())
     force_discovery = get(args, "force_discovery", false)
     force_compile = get(args, "force_compile", false)
+    pipeline = get(args, "pipeline", !isfile(joinpath(project_path, "jmake.toml")))
 
     println("="^70)
     println("[ORCHESTRATOR] Starting JMake Build Pipeline")
@@ -130,13 +230,18 @@ function build_project(args::Dict)
         end
 
         # Stage 1: Discovery
-        println("\n📍 Stage 1: Discovery")
+        println("\n📍 Stage 1: Discovery$(pipeline ? " (pipelined: TUs compile as they are found)" : "")")
         println("-"^70)
 
-        discovery_result = call_daemon("discovery", "discover_project", Dict(
-            "path" => project_path,
-            "force" => force_discovery
-        ))
+        stream_batches = Task[]
+        if pipeline
+            discovery_result, stream_batches = pipelined_discovery(project_path, force_discovery)
+        else
+            discovery_result = call_daemon("discovery", "discover_project", Dict(
+                "path" => project_path,
+                "force" => force_discovery
+            ))
+        end
 
         results[:discovery] = discovery_result
 
@@ -196,7 +301,9 @@ function build_project(args::Dict)
 
         compile_result = call_daemon("compilation", "compile_full_pipeline", Dict(
             "config" => config_path,
-            "force" => force_compile
+            "force" => force_compile,
+            "priority" => BACKGROUND_PRIORITY,
+            "client" => "orchestrator"
         ))
 
         results[:compilation] = compile_result
@@ -231,6 +338,13 @@ function build_project(args::Dict)
             println("[ORCHESTRATOR]   From cache: $(stats[:cached_count])")
         end
 
+        if !isempty(stream_batches)
+            streamed = [fetch(t) for t in stream_batches if !istaskfailed(t)]
+            results[:stream] = streamed
+            overlapped = sum((get(r, :compiled_count, 0) for r in streamed); init=0)
+            println("[ORCHESTRATOR]   Compiled during discovery: $overlapped")
+        end
+
         # Success!
         elapsed = time() - start_time
 
@@ -267,7 +381,8 @@ function build_project(args::Dict)
 end
 
 """
-Quick compile (assumes discovery already done)
+Quick compile (assumes discovery already done). `changes` (watcher batch entries with a
+`"file"`) are passed on, so only the TUs they affect are re-keyed.
 """
 function quick_compile(args::Dict)
     project_path = get(args, "path", pwd())
@@ -286,7 +401,10 @@ function quick_compile(args::Dict)
         # Just run compilation stage
         compile_result = call_daemon("compilation", "compile_full_pipeline", Dict(
             "config" => config_path,
-            "force" => get(args, "force", false)
+            "force" => get(args, "force", false),
+            "changed_files" => String[change["file"] for change in get(args, "changes", [])],
+            "priority" => get(args, "priority", BACKGROUND_PRIORITY),
+            "client" => get(args, "client", "orchestrator")
         ))
 
         return compile_result
@@ -307,10 +425,14 @@ function incremental_build(args::Dict)
 
     println("[ORCHESTRATOR] Incremental build: $project_path")
 
-    # Just force=false compile (uses IR cache)
+    # force=false compile (uses IR cache) limited to the change set when there is one;
+    # someone is waiting on it, so it goes first
     return quick_compile(Dict(
         "path" => project_path,
-        "force" => false
+        "force" => false,
+        "changes" => get(args, "changes", []),
+        "priority" => get(args, "priority", INTERACTIVE_PRIORITY),
+        "client" => get(args, "client", "incremental")
     ))
 end
 
@@ -345,68 +467,62 @@ end
 
 """
 Watch and rebuild on file changes
+The watcher pushes debounced change batches to `on_file_changes`; nothing is polled.
 """
 function watch_and_build(args::Dict)
-    project_path = get(args, "path", pwd())
-    interval = get(args, "interval", 2.0)
+    project_path = abspath(get(args, "path", pwd()))
+    debounce = get(args, "debounce", get(args, "interval", 0.3))
 
     println("[ORCHESTRATOR] Starting watch mode: $project_path")
-    println("[ORCHESTRATOR] Checking for changes every $(interval)s")
-    println("[ORCHESTRATOR] Press Ctrl+C to stop")
-
-    try
-        # Start watching
-        watch_result = call_daemon("watcher", "start_watch", Dict(
-            "path" => project_path,
-            "interval" => interval,
-            "patterns" => ["*.cpp", "*.h", "*.c", "*.hpp"]
-        ))
 
-        if !watch_result[:success]
-            return watch_result
-        end
-
-        println("[ORCHESTRATOR] Watching $(watch_result[:files_count]) files")
+    watch_result = call_daemon("watcher", "start_watch", Dict(
+        "path" => project_path,
+        "debounce" => debounce,
+        "patterns" => ["*.cpp", "*.h", "*.c", "*.hpp"],
+        "notify" => [Dict("port" => PORT, "function" => "on_file_changes")]
+    ))
 
-        # Poll for changes
-        while true
-            sleep(interval)
+    if !watch_result[:success]
+        return watch_result
+    end
 
-            changes = call_daemon("watcher", "check_changes", Dict(
-                "path" => project_path,
-                "patterns" => ["*.cpp", "*.h", "*.c", "*.hpp"]
-            ))
+    println("[ORCHESTRATOR] Watching $(watch_result[:files_count]) files in $(watch_result[:directories]) directories")
+    println("[ORCHESTRATOR] Rebuilds run when the watcher pushes a change batch")
 
-            if changes[:success] && changes[:count] > 0
-                println("\n[ORCHESTRATOR] 🔔 Detected $(changes[:count]) change(s)")
+    return Dict(
+        :success => true,
+        :watching => project_path,
+        :files_count => watch_result[:files_count]
+    )
+end
 
-                for change in changes[:changes]
-                    println("[ORCHESTRATOR]    $(change[:type]): $(change[:file])")
-                end
+"""
+Handle a debounced change batch pushed by the watcher daemon
+"""
+function on_file_changes(args::Dict)
+    project_path = get(args, "path", pwd())
+    changes = get(args, "changes", [])
 
-                println("[ORCHESTRATOR] Triggering incremental rebuild...")
+    println("\n[ORCHESTRATOR] 🔔 Batch $(get(args, "sequence", 0)): $(length(changes)) change(s)")
+    for change in changes
+        println("[ORCHESTRATOR]    $(change["type"]): $(change["file"])")
+    end
 
-                rebuild_result = incremental_build(Dict("path" => project_path))
+    # Drop session state for the changed files before rebuilding
+    call_daemon("compilation", "invalidate_files", Dict(
+        "files" => [change["file"] for change in changes]
+    ))
 
-                if rebuild_result[:success]
-                    println("[ORCHESTRATOR] ✅ Rebuild successful")
-                else
-                    println("[ORCHESTRATOR] ❌ Rebuild failed: $(rebuild_result[:error])")
-                end
-            end
-        end
+    println("[ORCHESTRATOR] Triggering incremental rebuild...")
+    rebuild_result = incremental_build(Dict("path" => project_path, "changes" => changes))
 
-    catch e
-        if isa(e, InterruptException)
-            println("\n[ORCHESTRATOR] Watch mode stopped")
-            return Dict(:success => true, :stopped => true)
-        else
-            return Dict(
-                :success => false,
-                :error => string(e)
-            )
-        end
+    if rebuild_result[:success]
+        println("[ORCHESTRATOR] ✅ Rebuild successful")
+    else
+        println("[ORCHESTRATOR] ❌ Rebuild failed: $(get(rebuild_result, :error, "unknown error"))")
     end
+
+    return rebuild_result
 end
 
 """
@@ -454,18 +570,21 @@ function main()
     end
     println()
     println("Available Functions:")
-    println("  • build_project(path, force_discovery=false, force_compile=false)")
+    println("  • build_project(path, force_discovery=false, force_compile=false, pipeline)")
     println("  • quick_compile(path, force=false)")
     println("  • incremental_build(path)")
     println("  • clean_build(path)")
-    println("  • watch_and_build(path, interval=2.0)")
+    println("  • watch_and_build(path, debounce=0.3)")
+    println("  • on_file_changes(path, changes) - pushed by the watcher")
     println("  • check_daemons()")
     println("  • get_stats()")
     println()
     println("Ready to orchestrate builds...")
     println("="^70)
 
-    # Start the daemon server
+    # Typed RPC listener for other daemons, then DaemonMode for the CLI
+    DaemonRPC.start_service(PORT, [build_project, quick_compile, incremental_build, clean_build,
+                                   watch_and_build, on_file_changes, check_daemons, get_stats])
     serve(PORT)
 end
 
@@ -385,6 +385,76 @@ function get_config_section(args::Dict)
     end
 end
 
+# `[compile]` fields a streamed TU compile reads (flags, output kind, IR directory)
+const UNIT_COMPILE_FIELDS = ("flags", "emit_bc", "output_dir")
+
+"""
+The `[compile]` fields streamed compiles need, as a plain Dict: the loaded section is
+index-backed and is not sent with every batch
+"""
+function unit_compile_fields(compile::AbstractDict)
+    return Dict{String,Any}(field => compile[field] for field in UNIT_COMPILE_FIELDS if haskey(compile, field))
+end
+
+"""
+Per-TU include dirs for a streamed build, before jmake.toml is written.
+`include_dirs` is the candidate list built from the directories scanned so far; a TU is
+ready once its quoted includes all resolve in it (`complete=true` releases the rest with
+the final list). Also returns the `[compile]` fields and cache directory the staged build
+will use, so streamed compiles get the same cache keys.
+"""
+function resolve_unit_flags(args::Dict)
+    target_dir = get(args, "path", pwd())
+    sources = String.(get(args, "sources", String[]))
+    include_dirs = String.(get(args, "include_dirs", String[]))
+    complete = get(args, "complete", false)
+    force = get(args, "force", false)
+
+    try
+        config_path = joinpath(target_dir, "jmake.toml")
+        if isfile(config_path) && !force
+            config = ConfigurationManager.load_config(config_path)
+            compile = config.compile
+            cache_dir = joinpath(target_dir, get(config.cache, "directory", BuildCache.default_cache_dir(target_dir)))
+        else
+            # What generate_config will write for a new project
+            compile = ConfigurationManager.default_compile_section()
+            cache_dir = joinpath(target_dir, ".jmake_cache")
+        end
+
+        forced = BuildCache.forced_includes_from_flags(String[get(compile, "flags", String[])...])
+        units = Dict{String,Any}[]
+        pending = String[]
+        for source in sources
+            dirs = BuildCache.unit_include_dirs(source, include_dirs; forced=forced, strict=!complete)
+            if dirs === nothing && complete
+                dirs = include_dirs
+            end
+
+            if dirs === nothing
+                push!(pending, source)
+            else
+                push!(units, Dict("source" => source, "include_dirs" => dirs))
+            end
+        end
+
+        return Dict(
+            :success => true,
+            :units => units,
+            :pending => pending,
+            :compile => unit_compile_fields(compile),
+            :cache_dir => cache_dir
+        )
+
+    catch e
+        return Dict(
+            :success => false,
+            :error => string(e),
+            :pending => sources
+        )
+    end
+end
+
 """
 Clear configuration cache
 """
@@ -434,13 +504,16 @@ function main()
     println("  • validate_config(config='jmake.toml')")
     println("  • update_config(config, section, data)")
     println("  • get_config_section(config, section)")
+    println("  • resolve_unit_flags(path, sources, include_dirs, complete=false) - streamed builds")
     println("  • cache_stats()")
     println("  • clear_cache()")
     println()
     println("Ready to accept setup requests...")
     println("="^70)
 
-    # Start the daemon server
+    # Typed RPC listener for other daemons, then DaemonMode for the CLI
+    DaemonRPC.start_service(PORT, [create_structure, generate_config, validate_config, update_config,
+                                   get_config_section, resolve_unit_flags, cache_stats, clear_cache])
     serve(PORT)
 end
 
@@ -3,24 +3,73 @@
 File Watcher Daemon Server - Monitors source files and triggers reactive builds
 
 Start with: julia watcher_daemon.jl
-Port: 3003
+Port: 3006 (RPC 3106)
+
+Changes arrive as OS notifications (inotify/FSEvents/ReadDirectoryChangesW via FileWatching),
+one monitor per directory. Bursts (editor save storms, `git checkout`) are coalesced into a
+single batch once the tree has been quiet for `debounce` seconds, and each batch is pushed
+to the subscribed daemons (orchestrator by default). Nothing is polled.
+Deliveries run in the background, in order per subscriber, each bounded by
+JMAKE_WATCH_NOTIFY_TIMEOUT seconds (default 600).
 """
 
 using DaemonMode
+using FileWatching
 using JMake
 
-const PORT = 3003
-const WATCH_INTERVALS = Dict{String, Float64}()  # path => interval in seconds
-const FILE_MTIMES = Dict{String, Float64}()      # path => last modified time
+const PORT = 3006
+
+# Default subscriber: the orchestrator rebuilds from each pushed batch
+const DEFAULT_SUBSCRIBERS = [Dict("port" => DaemonRPC.SERVICE_PORTS["orchestrator"], "function" => "on_file_changes")]
+
+# Upper bound on how long a continuous storm can delay a batch, in debounce periods
+const MAX_DEBOUNCE_PERIODS = 10
+
+# Batches kept for clients that still ask with check_changes
+const BATCH_HISTORY = 100
+
+# Seconds a subscriber may take to handle one batch (a rebuild) before it is given up on
+const NOTIFY_TIMEOUT = parse(Float64, get(ENV, "JMAKE_WATCH_NOTIFY_TIMEOUT", "600"))
+
+"""
+State of one watched tree
+"""
+mutable struct WatchSession
+    path::String
+    patterns::Vector{String}
+    debounce::Float64
+    subscribers::Vector{Dict}
+    watched_dirs::Set{String}
+    file_mtimes::Dict{String,Float64}    # path => last modified time
+    pending::Dict{String,String}         # path => "new" / "modified" / "deleted"
+    first_event::Float64
+    last_event::Float64
+    batches::Vector{Dict{Symbol,Any}}
+    sequence::Int
+    running::Bool
+    lock::ReentrantLock
+    wakeup::Threads.Condition
+    deliveries::Dict{Tuple{Int,String},Task}  # (port, function) => latest batch delivery
+end
+
+function WatchSession(path::String, patterns::Vector{String}, debounce::Float64, subscribers::Vector{Dict})
+    lock = ReentrantLock()
+    return WatchSession(path, patterns, debounce, subscribers, Set{String}(),
+                        Dict{String,Float64}(), Dict{String,String}(), 0.0, 0.0,
+                        Dict{Symbol,Any}[], 0, true, lock, Threads.Condition(lock),
+                        Dict{Tuple{Int,String},Task}())
+end
+
+const WATCH_SESSIONS = Dict{String, WatchSession}()  # path => session
 
 """
 Start watching a directory/file
 """
 function start_watch(args::Dict)
-    path = get(args, "path", "")
-    interval = get(args, "interval", 1.0)
-    patterns = get(args, "patterns", ["*.cpp", "*.h", "*.jl"])
-    on_change = get(args, "on_change", "rebuild")
+    path = abspath(get(args, "path", ""))
+    debounce = Float64(get(args, "debounce", get(args, "interval", 0.3)))
+    patterns = String.(get(args, "patterns", ["*.cpp", "*.h", "*.jl"]))
+    subscribers = Dict[get(args, "notify", DEFAULT_SUBSCRIBERS)...]
 
     println("[WATCHER DAEMON] Starting watch on: $path")
 
@@ -32,20 +81,29 @@ function start_watch(args::Dict)
             )
         end
 
-        # Initialize watch
-        WATCH_INTERVALS[path] = interval
+        haskey(WATCH_SESSIONS, path) && stop_watch(Dict("path" => path))
+
+        session = WatchSession(path, patterns, debounce, subscribers)
+        WATCH_SESSIONS[path] = session
 
-        # Get initial file states
-        files = collect_files(path, patterns)
-        for file in files
-            FILE_MTIMES[file] = mtime(file)
+        # One snapshot to classify later events as new/modified; never walked again
+        for file in collect_files(path, patterns)
+            session.file_mtimes[file] = mtime(file)
         end
 
+        for dir in (isdir(path) ? collect_dirs(path) : [dirname(path)])
+            watch_directory!(session, dir)
+        end
+
+        @async flush_loop(session)
+
         return Dict(
             :success => true,
             :watching => path,
-            :files_count => length(files),
-            :interval => interval
+            :files_count => length(session.file_mtimes),
+            :directories => length(session.watched_dirs),
+            :debounce => debounce,
+            :subscribers => session.subscribers
         )
 
     catch e
@@ -57,55 +115,207 @@ function start_watch(args::Dict)
 end
 
 """
-Check for file changes
+Return change batches pushed since `since` (sequence number). No filesystem access:
+batches are produced by the notification monitors.
 """
 function check_changes(args::Dict)
-    path = get(args, "path", "")
-    patterns = get(args, "patterns", ["*.cpp", "*.h", "*.jl"])
+    path = abspath(get(args, "path", ""))
+    since = get(args, "since", 0)
 
-    try
-        changes = []
-        files = collect_files(path, patterns)
-
-        for file in files
-            current_mtime = mtime(file)
-            last_mtime = get(FILE_MTIMES, file, 0.0)
-
-            if current_mtime > last_mtime
-                push!(changes, Dict(
-                    :file => file,
-                    :type => haskey(FILE_MTIMES, file) ? "modified" : "new",
-                    :mtime => current_mtime
-                ))
-                FILE_MTIMES[file] = current_mtime
+    session = get(WATCH_SESSIONS, path, nothing)
+    if isnothing(session)
+        return Dict(:success => false, :error => "Not watching: $path")
+    end
+
+    lock(session.lock) do
+        batches = filter(b -> b[:sequence] > since, session.batches)
+        changes = vcat(Any[], [b[:changes] for b in batches]...)
+        return Dict(
+            :success => true,
+            :changes => changes,
+            :count => length(changes),
+            :sequence => session.sequence
+        )
+    end
+end
+
+# ============================================================================
+# NOTIFICATIONS
+# ============================================================================
+
+"""
+Start a monitor task for one directory (no-op if already watched)
+"""
+function watch_directory!(session::WatchSession, dir::String)
+    added = lock(session.lock) do
+        dir in session.watched_dirs && return false
+        push!(session.watched_dirs, dir)
+        true
+    end
+    added || return
+
+    @async begin
+        try
+            while session.running && isdir(dir)
+                (filename, event) = watch_folder(dir)
+                session.running || break
+                if isempty(filename)
+                    # Queue overflow or platform without names: re-check this directory only
+                    rescan_directory!(session, dir)
+                else
+                    handle_event!(session, joinpath(dir, filename))
+                end
+            end
+        catch e
+            session.running && println("[WATCHER DAEMON] Monitor for $dir stopped: $e")
+        finally
+            unwatch_folder(dir)
+            lock(() -> delete!(session.watched_dirs, dir), session.lock)
+        end
+    end
+end
+
+"""
+Record one notification; new directories get their own monitors
+"""
+function handle_event!(session::WatchSession, path::String)
+    if isdir(path)
+        already_watched = lock(() -> path in session.watched_dirs, session.lock)
+        if !already_watched && !startswith(basename(path), ".")
+            # Subdirectories are reached through the rescan
+            watch_directory!(session, path)
+            rescan_directory!(session, path)
+        end
+        return
+    end
+
+    matches_patterns(basename(path), session.patterns) || return
+
+    lock(session.lock) do
+        known = haskey(session.file_mtimes, path)
+        if isfile(path)
+            current = mtime(path)
+            known && session.file_mtimes[path] == current && return
+            session.file_mtimes[path] = current
+            record_change!(session, path, known ? "modified" : "new")
+        elseif known
+            delete!(session.file_mtimes, path)
+            record_change!(session, path, "deleted")
+        end
+    end
+end
+
+"""
+Compare one directory's matching files against the snapshot
+"""
+function rescan_directory!(session::WatchSession, dir::String)
+    isdir(dir) || return
+    for name in readdir(dir)
+        handle_event!(session, joinpath(dir, name))
+    end
+
+    gone = lock(session.lock) do
+        [f for f in keys(session.file_mtimes) if dirname(f) == dir && !isfile(f)]
+    end
+    foreach(f -> handle_event!(session, f), gone)
+end
+
+"""
+Add a change to the pending batch (caller holds the session lock)
+"""
+function record_change!(session::WatchSession, path::String, kind::String)
+    now_t = time()
+    isempty(session.pending) && (session.first_event = now_t)
+    session.last_event = now_t
+
+    # A file created and modified within one batch is still new
+    previous = get(session.pending, path, "")
+    session.pending[path] = (previous == "new" && kind == "modified") ? "new" : kind
+    notify(session.wakeup)
+end
+
+# ============================================================================
+# DEBOUNCED DISPATCH
+# ============================================================================
+
+"""
+Wait for a quiet period after the first change, then push the coalesced batch.
+A storm that never pauses is flushed after MAX_DEBOUNCE_PERIODS debounce periods.
+"""
+function flush_loop(session::WatchSession)
+    while session.running
+        lock(session.lock) do
+            while session.running && isempty(session.pending)
+                wait(session.wakeup)
             end
         end
+        session.running || break
 
-        # Check for deleted files
-        for (file, _) in FILE_MTIMES
-            if !isfile(file)
-                push!(changes, Dict(
-                    :file => file,
-                    :type => "deleted"
-                ))
-                delete!(FILE_MTIMES, file)
+        while true
+            sleep(session.debounce)
+            ready = lock(session.lock) do
+                now_t = time()
+                now_t - session.last_event >= session.debounce ||
+                    now_t - session.first_event >= MAX_DEBOUNCE_PERIODS * session.debounce
             end
+            ready && break
         end
 
-        return Dict(
-            :success => true,
-            :changes => changes,
-            :count => length(changes)
-        )
+        batch = lock(session.lock) do
+            changes = [Dict(:file => file, :type => kind) for (file, kind) in session.pending]
+            empty!(session.pending)
+            session.sequence += 1
+            entry = Dict{Symbol,Any}(:sequence => session.sequence, :changes => changes, :time => time())
+            push!(session.batches, entry)
+            length(session.batches) > BATCH_HISTORY && popfirst!(session.batches)
+            return entry
+        end
 
-    catch e
-        return Dict(
-            :success => false,
-            :error => string(e)
-        )
+        dispatch_batch(session, batch)
     end
 end
 
+"""
+Push a batch to every subscriber without waiting for it. Each subscriber gets its
+batches in order, one at a time; a slow, failing or hung one (bounded by
+NOTIFY_TIMEOUT) holds up neither the others nor the flush loop.
+"""
+function dispatch_batch(session::WatchSession, batch::Dict{Symbol,Any})
+    println("[WATCHER DAEMON] 🔔 Batch $(batch[:sequence]): $(length(batch[:changes])) change(s) in $(session.path)")
+
+    payload = Dict(
+        "path" => session.path,
+        "sequence" => batch[:sequence],
+        "changes" => [Dict("file" => c[:file], "type" => c[:type]) for c in batch[:changes]]
+    )
+
+    for subscriber in session.subscribers
+        port = get(subscriber, "port", 0)
+        func = get(subscriber, "function", "on_file_changes")
+        lock(session.lock) do
+            previous = get(session.deliveries, (port, func), nothing)
+            session.deliveries[(port, func)] = errormonitor(@async begin
+                isnothing(previous) || try wait(previous) catch end
+                result = DaemonRPC.call(port, func, payload; timeout=NOTIFY_TIMEOUT)
+                if result isa Dict && get(result, :success, true) == false
+                    println("[WATCHER DAEMON] ⚠️  Could not notify port $port ($func) of batch $(batch[:sequence]): $(result[:error])")
+                end
+            end)
+        end
+    end
+end
+
+# ============================================================================
+# HELPERS
+# ============================================================================
+
+"""
+Simple pattern matching (*.ext)
+"""
+function matches_patterns(filename::String, patterns::Vector{String})
+    return any(pattern -> pattern == "*" || endswith(filename, pattern[2:end]), patterns)
+end
+
 """
 Collect files matching patterns
 """
@@ -117,13 +327,10 @@ function collect_files(path::String, patterns::Vector)
     end
 
     for (root, dirs, filenames) in walkdir(path)
+        filter!(d -> !startswith(d, "."), dirs)
         for filename in filenames
-            for pattern in patterns
-                # Simple pattern matching (*.ext)
-                if pattern == "*" || endswith(filename, pattern[2:end])
-                    push!(files, joinpath(root, filename))
-                    break
-                end
+            if matches_patterns(filename, String.(patterns))
+                push!(files, joinpath(root, filename))
             end
         end
     end
@@ -131,18 +338,38 @@ function collect_files(path::String, patterns::Vector)
     return files
 end
 
+"""
+Collect a directory and its non-hidden subdirectories
+"""
+function collect_dirs(path::String)
+    dirs = String[]
+    for (root, subdirs, _) in walkdir(path)
+        filter!(d -> !startswith(d, "."), subdirs)
+        push!(dirs, root)
+    end
+    return dirs
+end
+
 """
 Stop watching a path
 """
 function stop_watch(args::Dict)
-    path = get(args, "path", "")
+    path = abspath(get(args, "path", ""))
 
-    if haskey(WATCH_INTERVALS, path)
-        delete!(WATCH_INTERVALS, path)
-        return Dict(:success => true, :stopped => path)
-    else
+    session = pop!(WATCH_SESSIONS, path, nothing)
+    if isnothing(session)
         return Dict(:success => false, :error => "Not watching: $path")
     end
+
+    lock(session.lock) do
+        session.running = false
+        notify(session.wakeup)
+    end
+    for dir in collect(session.watched_dirs)
+        unwatch_folder(dir)
+    end
+
+    return Dict(:success => true, :stopped => path)
 end
 
 """
@@ -153,10 +380,16 @@ function main()
     println("JMake File Watcher Daemon Server")
     println("Port: $PORT")
     println("="^60)
+    println("Available Functions:")
+    println("  • start_watch(path, patterns, debounce=0.3, notify=[orchestrator])")
+    println("  • check_changes(path, since=0) - batches already pushed")
+    println("  • stop_watch(path)")
+    println()
     println("Ready to monitor file changes...")
     println()
 
-    # Start the daemon server
+    # Typed RPC listener for other daemons, then DaemonMode for the CLI
+    DaemonRPC.start_service(PORT, [start_watch, check_changes, stop_watch])
     serve(PORT)
 end
 
@@ -19,6 +19,7 @@ makedocs(
             "JuliaWrapItUp" => "JuliaWrapItUp.md",
             "ClangJLBridge" => "ClangJLBridge.md",
             "DaemonManager" => "DaemonManager.md",
+            "Tracing" => "Tracing.md",
         ]
     ],
     checkdocs = :none
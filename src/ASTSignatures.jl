@@ -0,0 +1,342 @@
+#!/usr/bin/env julia
+# ASTSignatures.jl - Streaming function-signature extraction from clang's JSON AST
+# Keeps only declarations located in the main file while clang's output is being read,
+# so transitively included standard headers are scanned once and never materialized
+# Signature tables are cached in the shared BuildCache store, keyed like the IR cache
+# Shared by LLVMake and Bridge_LLVM
+
+module ASTSignatures
+
+using JSON
+
+# Sibling module: JMake and LLVMake both include BuildCache before this file
+using ..BuildCache
+
+"""
+Single function parameter as written in the source
+"""
+struct ParamSignature
+    name::String
+    type::String
+end
+
+"""
+Compact signature of a main-file function declaration
+"""
+struct FunctionSignature
+    name::String
+    return_type::String
+    params::Vector{ParamSignature}
+end
+
+Base.:(==)(a::FunctionSignature, b::FunctionSignature) =
+    a.name == b.name && a.return_type == b.return_type && a.params == b.params
+Base.hash(sig::FunctionSignature, h::UInt) = hash(sig.params, hash(sig.return_type, hash(sig.name, h)))
+
+# ============================================================================
+# SIGNATURE EXTRACTION
+# ============================================================================
+
+"""
+    return_type_from_qualtype(qual_type::AbstractString) -> String
+
+Return type of a clang function `qualType` such as `"double (const double *, size_t)"`.
+Trailing `noexcept`/cv/ref qualifiers are dropped before the parameter list is stripped.
+"""
+function return_type_from_qualtype(qual_type::AbstractString)
+    qt = strip(qual_type)
+    while true
+        stripped = replace(qt, r"\s*(noexcept(\([^()]*\))?|const|volatile|&&|&)$" => "")
+        stripped == qt && break
+        qt = stripped
+    end
+
+    endswith(qt, ")") || return String(qt)
+
+    # Walk back to the parenthesis that opens the parameter list
+    depth = 0
+    for i in reverse(collect(eachindex(qt)))
+        c = qt[i]
+        if c == ')'
+            depth += 1
+        elseif c == '('
+            depth -= 1
+            if depth == 0
+                return String(strip(qt[1:prevind(qt, i)]))
+            end
+        end
+    end
+    return String(qt)
+end
+
+"""
+    signature_from_node(node::Dict) -> FunctionSignature
+"""
+function signature_from_node(node::Dict)
+    params = ParamSignature[]
+    for inner in get(node, "inner", [])
+        if isa(inner, Dict) && get(inner, "kind", "") == "ParmVarDecl"
+            push!(params, ParamSignature(get(inner, "name", ""),
+                                         get(get(inner, "type", Dict()), "qualType", "")))
+        end
+    end
+
+    qual_type = get(get(node, "type", Dict()), "qualType", "void ()")
+    return FunctionSignature(get(node, "name", ""), return_type_from_qualtype(qual_type), params)
+end
+
+"""
+    collect_signatures!(signatures::Vector{FunctionSignature}, node::Dict; definitions_only::Bool=true)
+
+Append every non-implicit `FunctionDecl` below `node` (namespaces and `extern "C"`
+blocks are descended into). With `definitions_only`, declarations without a body
+or parameters are skipped.
+"""
+function collect_signatures!(signatures::Vector{FunctionSignature}, node::Dict;
+                             definitions_only::Bool=true)
+    if get(node, "kind", "") == "FunctionDecl" && !get(node, "isImplicit", false) &&
+       (!definitions_only || haskey(node, "inner"))
+        push!(signatures, signature_from_node(node))
+    end
+
+    for child in get(node, "inner", [])
+        if isa(child, Dict)
+            collect_signatures!(signatures, child; definitions_only=definitions_only)
+        end
+    end
+    return signatures
+end
+
+"""
+    signatures_from_ast(ast::Dict; definitions_only::Bool=true) -> Vector{FunctionSignature}
+
+Extract signatures from an already parsed AST (no main-file filtering).
+"""
+function signatures_from_ast(ast::Dict; definitions_only::Bool=true)
+    return collect_signatures!(FunctionSignature[], ast; definitions_only=definitions_only)
+end
+
+# ============================================================================
+# STREAMING MAIN-FILE FILTER
+# ============================================================================
+
+const FILE_KEY_REGEX = r"^\"file\":\s*\"((?:[^\"\\]|\\.)*)\""
+
+# Depth of the top-level declarations: TranslationUnitDecl object, its "inner" array, the node
+const TOP_LEVEL_DEPTH = 3
+
+"""
+    bracket_delta(line::AbstractString) -> Int
+
+Net change in `{`/`[` nesting across one line of JSON, ignoring string contents.
+"""
+function bracket_delta(line::AbstractString)
+    delta = 0
+    in_string = false
+    escaped = false
+    for c in line
+        if in_string
+            if escaped
+                escaped = false
+            elseif c == '\\'
+                escaped = true
+            elseif c == '"'
+                in_string = false
+            end
+        elseif c == '"'
+            in_string = true
+        elseif c == '{' || c == '['
+            delta += 1
+        elseif c == '}' || c == ']'
+            delta -= 1
+        end
+    end
+    return delta
+end
+
+"""
+    scan_ast_stream(io::IO, main_file::String; definitions_only::Bool=true) -> Vector{FunctionSignature}
+
+Read clang's pretty-printed `-ast-dump=json` output line by line. Clang only prints a
+location's `"file"` when it differs from the previous location, so the current file is
+tracked across every node (including skipped ones); `includedFrom` entries are not
+locations and are ignored. A top-level declaration is classified once its own `loc` has
+been read (at its `"range"` key): header declarations are discarded without being
+buffered, main-file declarations are buffered and parsed on their own. Peak memory is
+bounded by the largest main-file declaration rather than by the whole translation unit.
+"""
+function scan_ast_stream(io::IO, main_file::String; definitions_only::Bool=true)
+    signatures = FunctionSignature[]
+    main_files = Set([main_file, abspath(main_file)])
+
+    depth = 0
+    current_file = ""
+    skip_next_file = false
+
+    in_node = false
+    keep = :unknown      # :unknown until the node's loc is read, then :keep or :skip
+    node_buffer = IOBuffer()
+
+    for line in eachline(io)
+        stripped = lstrip(line)
+
+        if startswith(stripped, "\"includedFrom\"")
+            skip_next_file = true
+        elseif startswith(stripped, "\"file\"")
+            m = match(FILE_KEY_REGEX, stripped)
+            if m !== nothing
+                if skip_next_file
+                    skip_next_file = false
+                else
+                    current_file = unescape_string(m.captures[1])
+                end
+            end
+        end
+
+        if in_node && keep == :unknown && depth == TOP_LEVEL_DEPTH && startswith(stripped, "\"range\"")
+            keep = current_file in main_files ? :keep : :skip
+            keep == :skip && take!(node_buffer)
+        end
+
+        before = depth
+        depth += bracket_delta(line)
+
+        if !in_node && before == TOP_LEVEL_DEPTH - 1 && depth >= TOP_LEVEL_DEPTH
+            in_node = true
+            keep = :unknown
+        end
+
+        if in_node && keep != :skip
+            println(node_buffer, line)
+        end
+
+        if in_node && depth < TOP_LEVEL_DEPTH
+            in_node = false
+            text = String(take!(node_buffer))
+            if keep == :keep || (keep == :unknown && current_file in main_files)
+                node = JSON.parse(rstrip(rstrip(text), ','))
+                if isa(node, Dict)
+                    collect_signatures!(signatures, node; definitions_only=definitions_only)
+                end
+            end
+        end
+    end
+
+    return signatures
+end
+
+"""
+    extract_main_file_signatures(clang_path::String, flags::Vector{String}, source::String;
+                                 definitions_only::Bool=true, env=nothing) -> Vector{FunctionSignature}
+
+Run `clang -Xclang -ast-dump=json -fsyntax-only` on `source` and stream its output
+through `scan_ast_stream`. Errors if clang exits with a non-zero status.
+`env` (a `"KEY=value"` vector) replaces the process environment of clang.
+"""
+function extract_main_file_signatures(clang_path::String, flags::Vector{String}, source::String;
+                                      definitions_only::Bool=true, env=nothing)
+    clang = `$clang_path -Xclang -ast-dump=json -fsyntax-only $flags $source`
+    cmd = pipeline(isnothing(env) ? clang : setenv(clang, env), stderr=devnull)
+    process = open(cmd, "r")
+    signatures = try
+        scan_ast_stream(process, source; definitions_only=definitions_only)
+    finally
+        close(process)
+    end
+
+    if !success(process)
+        error("clang AST dump failed for $source (exit code $(process.exitcode))")
+    end
+    return signatures
+end
+
+# ============================================================================
+# SIGNATURE CACHE
+# ============================================================================
+
+# Bump when the stored table layout or the extraction rules change
+const SIGNATURE_FORMAT_VERSION = "1"
+
+"""
+    save_signatures(path::String, signatures::Vector{FunctionSignature})
+"""
+function save_signatures(path::String, signatures::Vector{FunctionSignature})
+    table = Dict(
+        "version" => SIGNATURE_FORMAT_VERSION,
+        "signatures" => [Dict(
+            "name" => sig.name,
+            "return_type" => sig.return_type,
+            "params" => [Dict("name" => p.name, "type" => p.type) for p in sig.params]
+        ) for sig in signatures]
+    )
+    open(path, "w") do io
+        JSON.print(io, table)
+    end
+end
+
+"""
+    load_signatures(path::String) -> Vector{FunctionSignature}
+
+Errors if the table was written by a different `SIGNATURE_FORMAT_VERSION`.
+"""
+function load_signatures(path::String)
+    table = JSON.parsefile(path)
+    if get(table, "version", "") != SIGNATURE_FORMAT_VERSION
+        error("signature table format $(get(table, "version", "?")) != $SIGNATURE_FORMAT_VERSION")
+    end
+
+    return FunctionSignature[
+        FunctionSignature(sig["name"], sig["return_type"],
+                          ParamSignature[ParamSignature(p["name"], p["type"]) for p in sig["params"]])
+        for sig in table["signatures"]
+    ]
+end
+
+"""
+    cached_main_file_signatures(cache::Union{ArtifactCache,Nothing}, clang_path::String,
+                                flags::Vector{String}, source::String;
+                                definitions_only::Bool=true, env=nothing) -> Vector{FunctionSignature}
+
+Main-file signature table for `source`, served from the artifact cache when the source,
+its header closure, the flags and the toolchain are unchanged, so a no-op rebuild never
+starts the clang frontend. On a miss clang runs once and the table is stored.
+With `cache === nothing` this is `extract_main_file_signatures`.
+"""
+function cached_main_file_signatures(cache::Union{ArtifactCache,Nothing}, clang_path::String,
+                                     flags::Vector{String}, source::String;
+                                     definitions_only::Bool=true, env=nothing)
+    if cache === nothing || !isfile(source)
+        return extract_main_file_signatures(clang_path, flags, source; definitions_only=definitions_only, env=env)
+    end
+
+    key_flags = String["-Xclang", "-ast-dump=json", "-fsyntax-only", flags...]
+    key = cache_key(source, key_flags; toolchain=toolchain_version(clang_path))
+    ext = definitions_only ? ".sig.json" : ".decl.sig.json"
+
+    hit = lookup(cache, key, ext)
+    if hit !== nothing
+        try
+            return load_signatures(hit)
+        catch e
+            @warn "Discarding unreadable signature table $hit: $e"
+        end
+    end
+
+    signatures = extract_main_file_signatures(clang_path, flags, source; definitions_only=definitions_only, env=env)
+
+    tmp = tempname()
+    try
+        save_signatures(tmp, signatures)
+        store!(cache, key, ext, tmp)
+    finally
+        rm(tmp, force=true)
+    end
+    return signatures
+end
+
+# Exports
+export ParamSignature, FunctionSignature,
+       signatures_from_ast, scan_ast_stream, extract_main_file_signatures,
+       cached_main_file_signatures
+
+end # module ASTSignatures
@@ -6,6 +6,12 @@
 module ASTWalker
 
 using JSON
+using SHA
+
+include("BinaryReader.jl")
+using .BinaryReader
+
+include("Tracing.jl")
 
 """
 Dependency information for a source file
@@ -44,20 +50,24 @@ function extract_includes_simple(filepath::String)
         return String[]
     end
 
-    includes = String[]
-
     try
-        content = read(filepath, String)
-
-        # Match #include "..." and #include <...>
-        regex = r"^\s*#\s*include\s+[<\"]([^>\"]+)[>\"]"m
-        for m in eachmatch(regex, content)
-            push!(includes, m.captures[1])
-        end
+        return includes_from_content(read(filepath, String))
     catch e
         @warn "Failed to read file: $filepath" exception=e
+        return String[]
     end
+end
 
+"""
+    includes_from_content(content::AbstractString) -> Vector{String}
+
+Direct `#include "..."` and `#include <...>` targets of already loaded source text.
+"""
+function includes_from_content(content::AbstractString)
+    includes = String[]
+    for m in eachmatch(r"^\s*#\s*include\s+[<\"]([^>\"]+)[>\"]"m, content)
+        push!(includes, m.captures[1])
+    end
     return unique(includes)
 end
 
@@ -128,10 +138,18 @@ end
 """
     extract_symbols_nm(filepath::String, nm_path::String) -> (Vector{String}, Vector{String})
 
-Extract defined and used symbols from compiled object file using nm.
-Returns (defined_symbols, undefined_symbols).
+Extract defined and used symbols from compiled object file.
+Returns (defined_symbols, undefined_symbols), demangled.
+Reads the symbol table in-process; `nm_path` is only run for formats BinaryReader doesn't know.
 """
 function extract_symbols_nm(filepath::String, nm_path::String)
+    image = read_binary(filepath)
+    if image.format != :unknown
+        defined = [demangle(s.name) for s in image.symbols if s.defined && s.kind != :other]
+        undefined = [demangle(s.name) for s in image.symbols if !s.defined]
+        return (unique(defined), unique(undefined))
+    end
+
     defined = String[]
     undefined = String[]
 
@@ -193,6 +211,9 @@ function parse_source_structure(filepath::String)
     try
         content = read(filepath, String)
 
+        # Direct includes from the same read
+        deps.includes = includes_from_content(content)
+
         # Extract namespaces
         for m in eachmatch(r"namespace\s+(\w+)", content)
             push!(deps.namespaces, m.captures[1])
@@ -225,9 +246,6 @@ function parse_source_structure(filepath::String)
         @warn "Failed to parse source structure: $filepath" exception=e
     end
 
-    # Get includes
-    deps.includes = extract_includes_simple(filepath)
-
     return deps
 end
 
@@ -257,56 +275,195 @@ function resolve_include_path(include_str::String, source_file::String, include_
     return ""
 end
 
+# ============================================================================
+# DEPFILE GRAPH
+# ============================================================================
+
+# Bump when the persisted depfile graph layout changes
+const DEPFILE_GRAPH_VERSION = 1
+
+"""
+    parse_depfile(depfile::String) -> Vector{String}
+
+Prerequisites of a Makefile-style depfile written by `clang -MMD -MF`, as absolute
+paths in order (the source itself first). Handles line continuations and escaped
+spaces. Returns an empty vector if the file is missing or unreadable.
+"""
+function parse_depfile(depfile::String)
+    isfile(depfile) || return String[]
+
+    content = try
+        read(depfile, String)
+    catch
+        return String[]
+    end
+
+    content = replace(content, r"\\\r?\n" => " ")
+
+    # Target ends at the first colon followed by whitespace (keeps C:\ paths intact)
+    sep = findfirst(r":(\s|$)", content)
+    sep === nothing && return String[]
+    body = content[last(sep):end]
+
+    prerequisites = String[]
+    token = IOBuffer()
+    chars = collect(body)
+    i = 1
+    while i <= length(chars)
+        c = chars[i]
+        if c == '\\' && i < length(chars) && chars[i+1] == ' '
+            write(token, ' ')
+            i += 1
+        elseif c == '$' && i < length(chars) && chars[i+1] == '$'
+            write(token, '$')
+            i += 1
+        elseif isspace(c)
+            position(token) > 0 && push!(prerequisites, abspath(String(take!(token))))
+        else
+            write(token, c)
+        end
+        i += 1
+    end
+    position(token) > 0 && push!(prerequisites, abspath(String(take!(token))))
+
+    return unique(prerequisites)
+end
+
+"""
+    depfile_graph_path(project_root::String, cache_dir::String) -> String
+
+Store of the depfile graph of the project at `project_root`. A cache directory can be
+shared between projects (`JMAKE_CACHE_DIR`), so each project root has its own file.
+"""
+function depfile_graph_path(project_root::String, cache_dir::String)
+    project = bytes2hex(sha1(abspath(project_root)))[1:16]
+    return joinpath(cache_dir, "depgraph", "$project.json")
+end
+
+"""
+    load_depfile_graph(path::String) -> Dict{String,Vector{String}}
+
+Persisted `source => headers` map harvested from compiler depfiles.
+A missing or incompatible store yields an empty graph.
+"""
+function load_depfile_graph(path::String)
+    graph = Dict{String,Vector{String}}()
+    isfile(path) || return graph
+
+    try
+        data = JSON.parsefile(path)
+        if get(data, "version", 0) == DEPFILE_GRAPH_VERSION
+            for (source, headers) in data["sources"]
+                graph[source] = String.(headers)
+            end
+        end
+    catch e
+        @warn "Ignoring unreadable depfile graph $path: $e"
+        empty!(graph)
+    end
+
+    return graph
+end
+
+"""
+    save_depfile_graph(path::String, graph::Dict{String,Vector{String}})
+"""
+function save_depfile_graph(path::String, graph::Dict{String,Vector{String}})
+    mkpath(dirname(path))
+    tmp = "$path.tmp.$(getpid()).$(rand(UInt64))"
+    open(tmp, "w") do io
+        JSON.print(io, Dict("version" => DEPFILE_GRAPH_VERSION, "sources" => graph))
+    end
+    mv(tmp, path, force=true)
+end
+
+"""
+    record_depfiles!(path::String, depfiles::Vector{Pair{String,String}}) -> Dict{String,Vector{String}}
+
+Merge `source => depfile` results of a compile run into the store at `path`.
+Only the given sources are touched; entries of untouched files are kept as they are.
+"""
+function record_depfiles!(path::String, depfiles::Vector{Pair{String,String}})
+    graph = load_depfile_graph(path)
+    updated = false
+
+    for (source, depfile) in depfiles
+        prerequisites = parse_depfile(depfile)
+        isempty(prerequisites) && continue
+        source_path = abspath(source)
+        graph[source_path] = filter(p -> p != source_path, prerequisites)
+        updated = true
+    end
+
+    updated && save_depfile_graph(path, graph)
+    return graph
+end
+
 """
     build_dependency_graph(files::Vector{String}, include_dirs::Vector{String};
-                          use_clang::Bool=true, clang_path::String="") -> DependencyGraph
+                          depfile_graph::Dict{String,Vector{String}}=Dict{String,Vector{String}}(),
+                          use_clang::Bool=false, clang_path::String="") -> DependencyGraph
 
 Build complete dependency graph for source files.
 
+Include edges come from `depfile_graph` (headers harvested from the `-MMD -MF` depfiles
+written during `compile_to_ir`, see `load_depfile_graph`) for every file it covers, so
+untouched files are never preprocessed again. Files it does not cover fall back to the
+regex include scan, or to a `clang -E -H` pass with `use_clang`. Files are analyzed in
+parallel across threads.
+
 # Arguments
 - `files`: List of source files to analyze
 - `include_dirs`: Include search paths
-- `use_clang`: Use clang for detailed parsing (requires clang_path)
+- `depfile_graph`: `source => headers` map from compiler depfiles
+- `use_clang`: Preprocess files missing from `depfile_graph` with clang (requires clang_path)
 - `clang_path`: Path to clang++ executable
 
 # Returns
 - `DependencyGraph`: Complete dependency information
 """
 function build_dependency_graph(files::Vector{String}, include_dirs::Vector{String};
-                                use_clang::Bool=true, clang_path::String="")
+                                depfile_graph::Dict{String,Vector{String}}=Dict{String,Vector{String}}(),
+                                use_clang::Bool=false, clang_path::String="")
+    started = time_ns()
     println("🔍 Building dependency graph for $(length(files)) files...")
 
-    file_deps = Dict{String,FileDependencies}()
+    analyzed = Vector{FileDependencies}(undef, length(files))
+    from_depfiles = Threads.Atomic{Int}(0)
+    preprocess = use_clang && !isempty(clang_path) && isfile(clang_path)
 
     # Analyze each file
-    for (i, filepath) in enumerate(files)
-        if i % 10 == 0 || i == length(files)
-            println("   Progress: $i/$(length(files))")
-        end
-
-        abs_path = abspath(filepath)
-
-        # Choose parsing method
-        if use_clang && !isempty(clang_path) && isfile(clang_path)
-            deps = extract_includes_clang(filepath, clang_path, include_dirs)
-            # Enhance with structure parsing
-            struct_info = parse_source_structure(filepath)
-            deps.namespaces = struct_info.namespaces
-            deps.classes = struct_info.classes
-            deps.functions = struct_info.functions
+    Threads.@threads :dynamic for i in eachindex(files)
+        filepath = files[i]
+        harvested = get(depfile_graph, abspath(filepath), nothing)
+        Tracing.count_cache!("depfile_graph", harvested !== nothing)
+
+        # One read of the file for structure and direct includes
+        deps = parse_source_structure(filepath)
+
+        if harvested !== nothing
+            append!(deps.resolved_includes, harvested)
+            Threads.atomic_add!(from_depfiles, 1)
+        elseif preprocess
+            clang_deps = extract_includes_clang(filepath, clang_path, include_dirs)
+            append!(deps.resolved_includes, abspath.(clang_deps.resolved_includes))
+            append!(deps.parse_errors, clang_deps.parse_errors)
         else
-            deps = parse_source_structure(filepath)
-        end
-
-        # Resolve include paths
-        for inc in deps.includes
-            resolved = resolve_include_path(inc, filepath, include_dirs)
-            if !isempty(resolved)
-                push!(deps.resolved_includes, resolved)
+            # Cold start: resolve the regex-extracted direct includes
+            for inc in deps.includes
+                resolved = resolve_include_path(inc, filepath, include_dirs)
+                if !isempty(resolved)
+                    push!(deps.resolved_includes, resolved)
+                end
             end
         end
 
-        file_deps[abs_path] = deps
+        analyzed[i] = deps
+    end
+
+    file_deps = Dict{String,FileDependencies}()
+    for (filepath, deps) in zip(files, analyzed)
+        file_deps[abspath(filepath)] = deps
     end
 
     # Build include graph
@@ -317,7 +474,7 @@ function build_dependency_graph(files::Vector{String}, include_dirs::Vector{Stri
         include_graph[file] = unique(deps.resolved_includes)
 
         # Build reverse graph
-        for included in deps.resolved_includes
+        for included in include_graph[file]
             if !haskey(reverse_graph, included)
                 reverse_graph[included] = String[]
             end
@@ -326,12 +483,13 @@ function build_dependency_graph(files::Vector{String}, include_dirs::Vector{Stri
     end
 
     # Topological sort for compilation order
-    compilation_order = topological_sort(include_graph)
+    compilation_order = Tracing.span(() -> topological_sort(include_graph), "topological_sort")
 
     println("   ✅ Dependency graph built:")
-    println("      Files analyzed: $(length(file_deps))")
-    println("      Include relationships: $(sum(length(v) for v in values(include_graph)))")
+    println("      Files analyzed: $(length(file_deps)) ($(from_depfiles[]) from depfiles)")
+    println("      Include relationships: $(sum(length(v) for v in values(include_graph); init=0))")
 
+    Tracing.record_span!("dependency_graph", started, time_ns(); files=length(files), from_depfiles=from_depfiles[])
     return DependencyGraph(
         file_deps,
         include_graph,
@@ -482,6 +640,7 @@ export FileDependencies, DependencyGraph,
        extract_includes_simple, extract_includes_clang,
        parse_source_structure,
        resolve_include_path,
+       parse_depfile, depfile_graph_path, load_depfile_graph, save_depfile_graph, record_depfiles!,
        export_dependency_graph_json,
        print_dependency_summary
 
@@ -0,0 +1,485 @@
+#!/usr/bin/env julia
+# BinaryReader.jl - In-process ELF / Mach-O / ar reader for symbol tables and library dependencies
+# Memory-maps each binary and pulls its symbol table (dynamic first), needed libraries and
+# architecture in one pass, replacing nm/objdump/ldd/otool/file spawns
+# Results are cached by file content hash (in memory, optionally on disk); many binaries are
+# read in parallel
+# Self-contained (stdlib + SHA, and Tracing.jl next to it) so JuliaWrapItUp and ASTWalker
+# can include it directly
+
+module BinaryReader
+
+using Mmap
+using SHA
+using Serialization
+
+include("Tracing.jl")
+
+# Bump when the parsed representation changes (invalidates on-disk results)
+const READER_FORMAT_VERSION = "1"
+
+"""
+One entry of a symbol table
+"""
+struct BinarySymbol
+    name::String       # as stored (mangled; Mach-O leading underscore removed)
+    kind::Symbol       # :function, :data or :other
+    binding::Symbol    # :global, :weak or :local
+    defined::Bool
+    hidden::Bool       # hidden/internal visibility: not callable from outside
+    size::UInt64
+end
+
+"""
+Parsed binary: format, kind, architecture, symbols and direct library dependencies
+"""
+struct BinaryImage
+    path::String
+    format::Symbol     # :elf, :macho, :archive or :unknown
+    kind::Symbol       # :shared_lib, :executable, :object_file, :static_lib or :unknown
+    arch::String
+    symbols::Vector{BinarySymbol}
+    needed::Vector{String}   # DT_NEEDED / LC_LOAD_DYLIB, in load order
+    soname::String           # DT_SONAME / LC_ID_DYLIB
+    hash::String
+end
+
+unknown_image(path::String, hash::String="") =
+    BinaryImage(path, :unknown, :unknown, "unknown", BinarySymbol[], String[], "", hash)
+
+# ============================================================================
+# BYTE ACCESS
+# ============================================================================
+
+"""
+Unsigned integer of type `T` at 0-based `offset`
+"""
+@inline function load(::Type{T}, data::AbstractVector{UInt8}, offset::Integer, little::Bool) where {T<:Unsigned}
+    v = zero(T)
+    if little
+        for i in sizeof(T):-1:1
+            v = (v << 8) | T(data[offset + i])
+        end
+    else
+        for i in 1:sizeof(T)
+            v = (v << 8) | T(data[offset + i])
+        end
+    end
+    return v
+end
+
+"""
+NUL-terminated string at 0-based `offset`
+"""
+function cstring(data::AbstractVector{UInt8}, offset::Integer)
+    start = offset + 1
+    (start < 1 || start > length(data)) && return ""
+    stop = findnext(==(0x00), data, start)
+    return String(data[start:(isnothing(stop) ? length(data) : stop - 1)])
+end
+
+# ============================================================================
+# ELF
+# ============================================================================
+
+const ELF_MACHINES = Dict{UInt16,String}(
+    0x0003 => "i386", 0x0028 => "arm", 0x003E => "x86_64", 0x00B7 => "aarch64",
+    0x0014 => "ppc", 0x0015 => "ppc64", 0x00F3 => "riscv", 0x0016 => "s390x"
+)
+
+const SHT_SYMTAB = 2
+const SHT_DYNAMIC = 6
+const SHT_DYNSYM = 11
+const DT_NEEDED = 1
+const DT_SONAME = 14
+
+"""
+Parse an ELF image; prefers `.dynsym` (exported surface) and falls back to `.symtab`
+"""
+function read_elf(data::AbstractVector{UInt8}, path::String, hash::String)
+    is64 = data[5] == 0x02
+    little = data[6] == 0x01
+    u16(o) = Int(load(UInt16, data, o, little))
+    u32(o) = Int(load(UInt32, data, o, little))
+    word(o) = is64 ? Int(load(UInt64, data, o, little)) : u32(o)
+
+    e_type = u16(16)
+    arch = get(ELF_MACHINES, UInt16(u16(18)), "unknown")
+    shoff = word(is64 ? 0x28 : 0x20)
+    shentsize = u16(is64 ? 0x3A : 0x2E)
+    shnum = u16(is64 ? 0x3C : 0x30)
+
+    sections = [begin
+        base = shoff + i * shentsize
+        (type=u32(base + 4),
+         offset=word(base + (is64 ? 24 : 16)),
+         size=word(base + (is64 ? 32 : 20)),
+         link=u32(base + (is64 ? 40 : 24)))
+    end for i in 0:(shnum - 1)]
+
+    # Symbols
+    table = something(findfirst(s -> s.type == SHT_DYNSYM, sections),
+                      findfirst(s -> s.type == SHT_SYMTAB, sections), 0)
+    symbols = BinarySymbol[]
+    if table != 0
+        sec = sections[table]
+        strtab = sections[sec.link + 1].offset
+        entsize = is64 ? 24 : 16
+        for i in 1:(div(sec.size, entsize) - 1)   # entry 0 is the null symbol
+            base = sec.offset + i * entsize
+            name_off = u32(base)
+            info = data[base + (is64 ? 5 : 13)]
+            other = data[base + (is64 ? 6 : 14)]
+            shndx = u16(base + (is64 ? 6 : 14))
+            size = is64 ? load(UInt64, data, base + 16, little) : UInt64(load(UInt32, data, base + 8, little))
+
+            type = info & 0x0f
+            kind = type in (0x02, 0x0a) ? :function : type in (0x01, 0x05, 0x06) ? :data : :other
+            bind = info >> 4
+            binding = bind == 0 ? :local : bind == 2 ? :weak : :global
+
+            name = cstring(data, strtab + name_off)
+            isempty(name) && continue
+            push!(symbols, BinarySymbol(name, kind, binding, shndx != 0, (other & 0x03) in (0x01, 0x02), size))
+        end
+    end
+
+    # Dependencies
+    needed = String[]
+    soname = ""
+    dynamic = findfirst(s -> s.type == SHT_DYNAMIC, sections)
+    if dynamic !== nothing
+        sec = sections[dynamic]
+        strtab = sections[sec.link + 1].offset
+        entsize = is64 ? 16 : 8
+        for i in 0:(div(sec.size, entsize) - 1)
+            base = sec.offset + i * entsize
+            tag = word(base)
+            tag == 0 && break
+            value = word(base + div(entsize, 2))
+            if tag == DT_NEEDED
+                push!(needed, cstring(data, strtab + value))
+            elseif tag == DT_SONAME
+                soname = cstring(data, strtab + value)
+            end
+        end
+    end
+
+    # ET_DYN covers PIE executables too: shared objects carry a SONAME or have no PT_INTERP
+    phoff = word(is64 ? 0x20 : 0x1C)
+    phentsize = u16(is64 ? 0x36 : 0x2A)
+    phnum = u16(is64 ? 0x38 : 0x2C)
+    has_interp = any(i -> u32(phoff + i * phentsize) == 3, 0:(phnum - 1))
+    kind = e_type == 1 ? :object_file :
+           e_type == 2 ? :executable :
+           e_type == 3 ? ((isempty(soname) && has_interp) ? :executable : :shared_lib) : :unknown
+
+    return BinaryImage(path, :elf, kind, arch, symbols, needed, soname, hash)
+end
+
+# ============================================================================
+# MACH-O
+# ============================================================================
+
+const MACHO_CPUS = Dict{UInt32,String}(
+    0x00000007 => "i386", 0x01000007 => "x86_64", 0x0000000C => "arm", 0x0100000C => "arm64",
+    0x01000012 => "ppc64"
+)
+
+const LC_SEGMENT = 0x1
+const LC_SYMTAB = 0x2
+const LC_LOAD_DYLIB = 0xC
+const LC_ID_DYLIB = 0xD
+const LC_SEGMENT_64 = 0x19
+const LC_LOAD_WEAK_DYLIB = 0x80000018
+const LC_REEXPORT_DYLIB = 0x8000001F
+const LC_LAZY_LOAD_DYLIB = 0x20
+
+"""
+Parse a thin Mach-O image starting at `start` (non-zero inside fat binaries)
+"""
+function read_macho(data::AbstractVector{UInt8}, path::String, hash::String; start::Int=0)
+    is64 = data[start + 1] == 0xcf
+    u32(o) = Int(load(UInt32, data, start + o, true))
+
+    arch = get(MACHO_CPUS, UInt32(u32(4)), "unknown")
+    filetype = u32(12)
+    ncmds = u32(16)
+
+    text_sections = Set{Int}()   # 1-based section ordinals holding code
+    section_count = 0
+    symtab = nothing
+    needed = String[]
+    soname = ""
+
+    offset = is64 ? 32 : 28
+    for _ in 1:ncmds
+        cmd = UInt32(u32(offset))
+        cmdsize = u32(offset + 4)
+        if cmd == LC_SEGMENT_64 || cmd == LC_SEGMENT
+            nsects = u32(offset + (cmd == LC_SEGMENT_64 ? 64 : 48))
+            first_section = offset + (cmd == LC_SEGMENT_64 ? 72 : 56)
+            section_size = cmd == LC_SEGMENT_64 ? 80 : 68
+            for i in 0:(nsects - 1)
+                section_count += 1
+                base = start + first_section + i * section_size
+                flags = u32(first_section + i * section_size + (cmd == LC_SEGMENT_64 ? 64 : 56))
+                if cstring(data[base+1:base+16], 0) == "__text" || flags & 0x80000000 != 0
+                    push!(text_sections, section_count)
+                end
+            end
+        elseif cmd == LC_SYMTAB
+            symtab = (symoff=u32(offset + 8), nsyms=u32(offset + 12), stroff=u32(offset + 16))
+        elseif cmd in (LC_LOAD_DYLIB, LC_LOAD_WEAK_DYLIB, LC_REEXPORT_DYLIB, LC_LAZY_LOAD_DYLIB)
+            push!(needed, cstring(data, start + offset + u32(offset + 8)))
+        elseif cmd == LC_ID_DYLIB
+            soname = cstring(data, start + offset + u32(offset + 8))
+        end
+        offset += cmdsize
+    end
+
+    symbols = BinarySymbol[]
+    if symtab !== nothing
+        entsize = is64 ? 16 : 12
+        for i in 0:(symtab.nsyms - 1)
+            base = symtab.symoff + i * entsize
+            n_type = data[start + base + 5]
+            n_type & 0xe0 != 0 && continue   # debugger (stab) entry
+            n_sect = Int(data[start + base + 6])
+
+            name = cstring(data, start + symtab.stroff + u32(base))
+            isempty(name) && continue
+            startswith(name, "_") && (name = name[2:end])   # C names carry a leading underscore
+
+            defined = n_type & 0x0e == 0x0e
+            kind = !defined ? :other : n_sect in text_sections ? :function : :data
+            binding = n_type & 0x01 == 0 ? :local : (load(UInt16, data, start + base + 6, true) & 0x0080 != 0 ? :weak : :global)
+            hidden = n_type & 0x10 != 0   # private extern
+            push!(symbols, BinarySymbol(name, kind, binding, defined, hidden, UInt64(0)))
+        end
+    end
+
+    kind = filetype == 1 ? :object_file : filetype == 2 ? :executable :
+           filetype in (6, 8) ? :shared_lib : :unknown
+    return BinaryImage(path, :macho, kind, arch, symbols, needed, soname, hash)
+end
+
+"""
+Pick the slice of a fat (universal) Mach-O matching this machine, else the first one
+"""
+function read_fat_macho(data::AbstractVector{UInt8}, path::String, hash::String)
+    nfat = Int(load(UInt32, data, 4, false))
+    host = string(Sys.ARCH) == "aarch64" ? "arm64" : string(Sys.ARCH)
+    slices = [(cpu=get(MACHO_CPUS, load(UInt32, data, 8 + 20i, false), "unknown"),
+               offset=Int(load(UInt32, data, 8 + 20i + 8, false))) for i in 0:(nfat - 1)]
+    isempty(slices) && return unknown_image(path, hash)
+    slice = something(findfirst(s -> s.cpu == host, slices), 1)
+    return read_macho(data, path, hash; start=slices[slice].offset)
+end
+
+# ============================================================================
+# STATIC ARCHIVES
+# ============================================================================
+
+"""
+Parse a `!<arch>` static library: the union of its members' symbol tables
+(GNU `//` long names and BSD `#1/len` names)
+"""
+function read_archive(data::AbstractVector{UInt8}, path::String, hash::String)
+    symbols = BinarySymbol[]
+    arch = "unknown"
+    offset = 8
+    while offset + 60 <= length(data)
+        name = strip(String(data[offset+1:offset+16]))
+        size = parse(Int, strip(String(data[offset+49:offset+58])))
+        body = offset + 60
+
+        member_start = body
+        member_size = size
+        if startswith(name, "#1/")
+            name_len = parse(Int, name[4:end])
+            member_start += name_len
+            member_size -= name_len
+        end
+
+        # Skip the symbol index and the long-name table
+        if !(name in ("/", "//", "/SYM64/", "__.SYMDEF", "__.SYMDEF SORTED")) && member_size > 16
+            member = view(data, member_start+1:member_start+member_size)
+            image = parse_image(member, path, hash)
+            if image.format != :unknown
+                append!(symbols, image.symbols)
+                arch == "unknown" && (arch = image.arch)
+            end
+        end
+
+        offset = body + size + (size % 2)   # members are 2-byte aligned
+    end
+    return BinaryImage(path, :archive, :static_lib, arch, symbols, String[], "", hash)
+end
+
+# ============================================================================
+# ENTRY POINTS
+# ============================================================================
+
+"""
+Dispatch on the magic bytes
+"""
+function parse_image(data::AbstractVector{UInt8}, path::String, hash::String)
+    length(data) < 16 && return unknown_image(path, hash)
+    magic = (data[1], data[2], data[3], data[4])
+
+    if magic == (0x7f, UInt8('E'), UInt8('L'), UInt8('F'))
+        return read_elf(data, path, hash)
+    elseif magic in ((0xcf, 0xfa, 0xed, 0xfe), (0xce, 0xfa, 0xed, 0xfe))
+        return read_macho(data, path, hash)
+    elseif magic == (0xca, 0xfe, 0xba, 0xbe) && load(UInt32, data, 4, false) < 64
+        # 0xcafebabe is also Java's magic; fat headers have few architectures
+        return read_fat_macho(data, path, hash)
+    elseif length(data) >= 8 && data[1:8] == codeunits("!<arch>\n")
+        return read_archive(data, path, hash)
+    end
+    return unknown_image(path, hash)
+end
+
+# Parsed images: content hash => image, plus (path, mtime, size) => hash so an unchanged file
+# is not even re-hashed
+const IMAGE_CACHE = Dict{String,BinaryImage}()
+const STAT_CACHE = Dict{Tuple{String,Float64,Int64},String}()
+const CACHE_LOCK = ReentrantLock()
+
+"""
+    read_binary(path::String; cache_dir=nothing) -> BinaryImage
+
+Memory-map `path` and parse its symbols, dependencies and architecture. Results are
+cached by the SHA-256 of the file content, in memory and, with `cache_dir`, on disk.
+Unreadable or malformed files give an image with format `:unknown`.
+"""
+function read_binary(path::String; cache_dir::Union{String,Nothing}=nothing)
+    isfile(path) || return unknown_image(path)
+    stat_key = (abspath(path), mtime(path), filesize(path))
+
+    cached = lock(CACHE_LOCK) do
+        hash = get(STAT_CACHE, stat_key, nothing)
+        hash === nothing ? nothing : get(IMAGE_CACHE, hash, nothing)
+    end
+    Tracing.count_cache!("binary_image", cached !== nothing) && return with_path(cached, path)
+
+    stat_key[3] < 16 && return unknown_image(path)
+    image = open(path) do io
+        data = Mmap.mmap(io, Vector{UInt8}, stat_key[3])
+        try
+            hash = bytes2hex(sha256(data))
+            from_disk = load_cached(cache_dir, hash)
+            cache_dir === nothing || Tracing.count_cache!("binary_image_disk", from_disk !== nothing)
+            from_disk === nothing || return with_path(from_disk, path)
+            parsed = try
+                Tracing.span(() -> parse_image(data, path, hash), "parse_binary"; file=path)
+            catch e
+                @debug "Malformed binary $path: $e"
+                unknown_image(path, hash)
+            end
+            store_cached(cache_dir, parsed)
+            return parsed
+        finally
+            # Unmap now rather than at the next GC: large scans map thousands of files
+            finalize(data)
+        end
+    end
+
+    lock(CACHE_LOCK) do
+        STAT_CACHE[stat_key] = image.hash
+        IMAGE_CACHE[image.hash] = image
+    end
+    return image
+end
+
+"""
+    read_binaries(paths::Vector{String}; cache_dir=nothing) -> Vector{BinaryImage}
+
+`read_binary` over many files on all threads, in the order of `paths`.
+"""
+function read_binaries(paths::Vector{String}; cache_dir::Union{String,Nothing}=nothing)
+    images = Vector{BinaryImage}(undef, length(paths))
+    Threads.@threads for i in eachindex(paths)
+        images[i] = read_binary(paths[i]; cache_dir=cache_dir)
+    end
+    return images
+end
+
+# Identical files reached through different paths share one parsed image
+with_path(image::BinaryImage, path::String) = image.path == path ? image :
+    BinaryImage(path, image.format, image.kind, image.arch, image.symbols, image.needed, image.soname, image.hash)
+
+cache_file(cache_dir::String, hash::String) =
+    joinpath(cache_dir, "binaries", hash[1:2], "$(hash)-v$(READER_FORMAT_VERSION).jls")
+
+function load_cached(cache_dir::Union{String,Nothing}, hash::String)
+    cache_dir === nothing && return nothing
+    file = cache_file(cache_dir, hash)
+    isfile(file) || return nothing
+    try
+        image = deserialize(file)
+        return image isa BinaryImage ? image : nothing
+    catch
+        return nothing
+    end
+end
+
+function store_cached(cache_dir::Union{String,Nothing}, image::BinaryImage)
+    (cache_dir === nothing || isempty(image.hash)) && return
+    file = cache_file(cache_dir, image.hash)
+    mkpath(dirname(file))
+    tmp = "$file.tmp.$(getpid()).$(rand(UInt64))"
+    serialize(tmp, image)
+    mv(tmp, file, force=true)
+end
+
+"""
+    exported_symbols(image::BinaryImage) -> Vector{BinarySymbol}
+
+Defined, non-hidden global and weak functions and data: what `nm -D --defined-only` lists.
+"""
+exported_symbols(image::BinaryImage) =
+    [s for s in image.symbols if s.defined && !s.hidden && s.binding != :local && s.kind != :other]
+
+# ============================================================================
+# DEMANGLING
+# ============================================================================
+
+# __cxa_demangle of the C++ runtime Julia already has loaded (C_NULL when absent)
+const DEMANGLER = Ref{Ptr{Cvoid}}(C_NULL)
+const DEMANGLER_LOOKED_UP = Ref(false)
+
+function demangler()
+    if !DEMANGLER_LOOKED_UP[]
+        DEMANGLER[] = try
+            cglobal(:__cxa_demangle)
+        catch
+            C_NULL
+        end
+        DEMANGLER_LOOKED_UP[] = true
+    end
+    return DEMANGLER[]
+end
+
+"""
+    demangle(name::String) -> String
+
+Itanium C++ demangling in-process (no `c++filt`); other names are returned unchanged.
+"""
+function demangle(name::String)
+    startswith(name, "_Z") || return name
+    fn = demangler()
+    fn == C_NULL && return name
+
+    status = Ref{Cint}(0)
+    buffer = ccall(fn, Ptr{Cchar}, (Cstring, Ptr{Cchar}, Ptr{Csize_t}, Ref{Cint}), name, C_NULL, C_NULL, status)
+    status[] == 0 && buffer != C_NULL || return name
+    demangled = unsafe_string(buffer)
+    Libc.free(buffer)
+    return demangled
+end
+
+export BinarySymbol, BinaryImage, read_binary, read_binaries, exported_symbols, demangle
+
+end # module BinaryReader
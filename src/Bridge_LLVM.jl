@@ -95,7 +95,7 @@ mutable struct BridgeCompilerConfig
             get(workflow, "stages", String[]),
             get(workflow, "parallel", true),
             get(cache, "enabled", true),
-            get(cache, "directory", ".bridge_cache"),
+            get(cache, "directory", BuildCache.default_cache_dir(".")),
             get(binding, "style", "auto")  # "auto", "clangjl", "basic"
         )
 
@@ -187,96 +187,39 @@ function walk_dependencies(config::BridgeCompilerConfig, entry_file::String)
 end
 
 """
-Parse C++ AST using clang via BuildBridge
+Parse C++ AST using clang
+The JSON dump is streamed and only declarations from `cpp_file` itself are kept;
+unchanged files are served from the shared signature cache
 """
 function parse_ast_bridge(config::BridgeCompilerConfig, cpp_file::String)
     println("🔍 Parsing AST: $(basename(cpp_file))")
 
-    # Build command
+    # Build flags
     includes = ["-I$dir" for dir in config.include_dirs]
-    flags = config.compile_flags
-
-    cmd_args = vcat(
-        ["-Xclang", "-ast-dump=json", "-fsyntax-only"],
-        flags,
-        includes,
-        [cpp_file]
-    )
-
-    (output, exitcode) = BuildBridge.execute("clang++", cmd_args)
-
-    if exitcode != 0
-        @warn "  ❌ AST parsing failed: $output"
-        return nothing
-    end
+    flags = String[vcat(config.compile_flags, includes)...]
+    clang = get(config.tools, "clang++", "clang++")
+    cache = config.cache_enabled ? BuildCache.ArtifactCache(joinpath(config.project_root, config.cache_dir)) : nothing
 
     try
-        ast = JSON.parse(output)
-        functions = extract_functions_from_ast(ast)
+        functions = cached_main_file_signatures(cache, clang, flags, cpp_file; definitions_only=false)
         println("  ✅ Found $(length(functions)) functions")
         return functions
     catch e
-        @warn "  ❌ Failed to parse AST JSON: $e"
+        @warn "  ❌ AST parsing failed: $e"
         return nothing
     end
 end
 
 """
-Extract function declarations from AST
+Extract function declarations from an already parsed AST
 """
 function extract_functions_from_ast(ast::Dict)
-    functions = []
-
-    function visit_node(node::Dict)
-        if get(node, "kind", "") == "FunctionDecl"
-            if get(node, "isImplicit", false)
-                return
-            end
-
-            func_info = Dict{String,Any}(
-                "name" => get(node, "name", ""),
-                "return_type" => get(get(node, "type", Dict()), "qualType", "void"),
-                "params" => []
-            )
-
-            # Extract parameters
-            if haskey(node, "inner")
-                for inner in node["inner"]
-                    if get(inner, "kind", "") == "ParmVarDecl"
-                        param = Dict(
-                            "name" => get(inner, "name", ""),
-                            "type" => get(get(inner, "type", Dict()), "qualType", "")
-                        )
-                        push!(func_info["params"], param)
-                    end
-                end
-            end
-
-            push!(functions, func_info)
-        end
-
-        if haskey(node, "inner")
-            for child in node["inner"]
-                if isa(child, Dict)
-                    visit_node(child)
-                end
-            end
-        end
-    end
-
-    if haskey(ast, "inner")
-        for node in ast["inner"]
-            if isa(node, Dict)
-                visit_node(node)
-            end
-        end
-    end
-
-    return functions
+    return signatures_from_ast(ast; definitions_only=false)
 end
 
 """
 Compile C++ to LLVM IR via BuildBridge
+Unchanged translation units are served from the shared content-addressed cache
 """
 function compile_to_ir(config::BridgeCompilerConfig, cpp_files::Vector{String})
     println("🔧 Compiling to LLVM IR...")
@@ -284,32 +227,38 @@ function compile_to_ir(config::BridgeCompilerConfig, cpp_files::Vector{String})
     mkpath(config.build_dir)
     ir_files = String[]
 
+    # Build flags (identical for every file)
+    includes = ["-I$dir" for dir in config.include_dirs]
+    defines = ["-D$k=$v" for (k, v) in config.defines]
+    ir_flags = String[vcat(["-S", "-emit-llvm"], config.compile_flags, includes, defines)...]
+
+    cache = config.cache_enabled ? BuildCache.ArtifactCache(joinpath(config.project_root, config.cache_dir)) : nothing
+    toolchain = isnothing(cache) ? "" : BuildCache.toolchain_version("clang++")
+
     for cpp_file in cpp_files
-        base = basename(cpp_file)
-        ir_file = joinpath(config.build_dir, "$base.ll")
-
-        # Build command
-        includes = ["-I$dir" for dir in config.include_dirs]
-        defines = ["-D$k=$v" for (k, v) in config.defines]
-
-        cmd_args = vcat(
-            ["-S", "-emit-llvm"],
-            config.compile_flags,
-            includes,
-            defines,
-            ["-o", ir_file, cpp_file]
-        )
+        ir_file = BuildCache.output_path(config.build_dir, cpp_file, ".ll")
+
+        key = (isnothing(cache) || !isfile(cpp_file)) ? "" : BuildCache.cache_key(cpp_file, ir_flags; toolchain=toolchain)
+        if !isempty(key) && BuildCache.fetch!(cache, key, ".ll", ir_file)
+            push!(ir_files, ir_file)
+            println("  ⚡ $(basename(cpp_file)) (cached)")
+            continue
+        end
+
+        cmd_args = vcat(ir_flags, ["-o", ir_file, cpp_file])
 
         (output, exitcode) = BuildBridge.execute("clang++", cmd_args)
 
-        if isfile(ir_file)
+        if exitcode == 0 && isfile(ir_file)
             push!(ir_files, ir_file)
+            isempty(key) || BuildCache.store!(cache, key, ".ll", ir_file)
             println("  ✅ $(basename(cpp_file)) → $(basename(ir_file))")
         else
             @warn "  ❌ Failed: $cpp_file\n$output"
         end
     end
 
+    isnothing(cache) || BuildCache.flush!(cache)
     println("  📊 Generated $(length(ir_files)) IR files")
     return ir_files
 end
@@ -424,7 +373,20 @@ Extract symbols from binary via BuildBridge
 function extract_symbols(config::BridgeCompilerConfig, binary_path::String)
     println("🔍 Extracting symbols...")
 
-    # Try nm first
+    # Read the dynamic symbol table in-process
+    image = JuliaWrapItUp.read_binary(binary_path)
+    if image.format != :unknown
+        symbols = Dict{String,Any}[Dict(
+            "name" => sym.name,
+            "type" => "function",
+            "visibility" => "global"
+        ) for sym in JuliaWrapItUp.exported_symbols(image) if sym.kind == :function]
+
+        println("  ✅ Found $(length(symbols)) symbols")
+        return symbols
+    end
+
+    # Fall back to nm for formats the reader doesn't handle
     if haskey(config.tools, "nm")
         (output, exitcode) = BuildBridge.execute("nm", ["-DC", binary_path])
 
@@ -493,6 +455,7 @@ function generate_julia_bindings(config::BridgeCompilerConfig, lib_path::String,
         """)
 
         # Generate wrappers for each symbol
+        uses_arrays = false
         for sym in symbols
             name = sym["name"]
 
@@ -505,7 +468,7 @@ function generate_julia_bindings(config::BridgeCompilerConfig, lib_path::String,
             sig = nothing
             if !isempty(functions)
                 for func in functions
-                    if get(func, "name", "") == name
+                    if func.name == name
                         sig = func
                         break
                     end
@@ -513,10 +476,10 @@ function generate_julia_bindings(config::BridgeCompilerConfig, lib_path::String,
             end
 
             # Generate wrapper
-            if !isnothing(sig) && haskey(sig, "return_type") && haskey(sig, "parameters")
+            if !isnothing(sig)
                 # We have type information!
-                ret_type = julia_type_from_cpp(sig["return_type"])
-                params = sig["parameters"]
+                ret_type = julia_type_from_cpp(sig.return_type)
+                params = sig.params
 
                 # Build parameter list
                 param_names = String[]
@@ -524,8 +487,8 @@ function generate_julia_bindings(config::BridgeCompilerConfig, lib_path::String,
                 ccall_types = String[]
 
                 for (i, param) in enumerate(params)
-                    param_name = get(param, "name", "arg$i")
-                    cpp_type = get(param, "type", "void*")
+                    param_name = isempty(param.name) ? "arg$i" : param.name
+                    cpp_type = isempty(param.type) ? "void*" : param.type
                     jl_type = julia_type_from_cpp(cpp_type)
 
                     push!(param_names, param_name)
@@ -535,7 +498,7 @@ function generate_julia_bindings(config::BridgeCompilerConfig, lib_path::String,
 
                 # Generate function with types
                 params_str = join(param_types, ", ")
-                ccall_types_str = join(ccall_types, ", ")
+                ccall_types_str = join(ccall_types, ", ") * (isempty(ccall_types) ? "" : ",")
                 args_str = join(param_names, ", ")
 
                 write(f, """
@@ -549,6 +512,15 @@ function generate_julia_bindings(config::BridgeCompilerConfig, lib_path::String,
                 end
 
                 """)
+
+                # (T*, length) groups also get array methods: one ccall per array, no copies
+                plan = JuliaWrapItUp.array_parameters(param_names, [isempty(p.type) ? "void*" : p.type for p in params],
+                                                      t -> julia_type_from_cpp(String(t)))
+                if !isnothing(plan)
+                    write(f, JuliaWrapItUp.generate_array_methods(name, name, plan, ret_type, "(:$name, LIB_PATH)"))
+                    write(f, "\n")
+                    uses_arrays = true
+                end
             else
                 # No type info - generate generic wrapper with comment
                 write(f, """
@@ -559,6 +531,8 @@ function generate_julia_bindings(config::BridgeCompilerConfig, lib_path::String,
             end
         end
 
+        uses_arrays && write(f, JuliaWrapItUp.generate_array_helpers())
+
         # Export only valid Julia identifiers (no special characters)
         # Valid Julia identifier: starts with letter/underscore, contains only alphanumeric/underscore
         is_valid_identifier(name) = !isempty(name) && match(r"^[a-zA-Z_][a-zA-Z0-9_!]*$", name) !== nothing
@@ -682,7 +656,7 @@ function compile_project(config::BridgeCompilerConfig)
     end
 
     # Stage 3: Parse AST
-    all_functions = []
+    all_functions = FunctionSignature[]
     if "parse_ast" in config.stages
         println("\n🔍 Parsing AST for all files...")
         for cpp in cpp_files
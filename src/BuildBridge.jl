@@ -10,26 +10,103 @@ using Pkg
 # Load required modules
 include("ErrorLearning.jl")
 include("LLVMEnvironment.jl")
+include("Tracing.jl")
+
+# JMake's DaemonRPC (one client pool and service table per process); a standalone
+# include of this file brings its own copy
+if isdefined(parentmodule(@__MODULE__), :DaemonRPC)
+    using ..DaemonRPC
+elseif isdefined(parentmodule(parentmodule(@__MODULE__)), :DaemonRPC)  # JMake.LLVMake.BuildBridge
+    using ...DaemonRPC
+else
+    include("DaemonRPC.jl")
+end
 using .ErrorLearning
 using .LLVMEnvironment
 using SQLite
 
-# Global ErrorDB instance (lazy initialization)
-const GLOBAL_ERROR_DB = Ref{Union{SQLite.DB,Nothing}}(nothing)
-
 """
-Get or initialize the global error database
+Get or initialize the error database (the lookup connection of this process's store)
 """
 function get_error_db(db_path::String="jmake_errors.db")
-    if GLOBAL_ERROR_DB[] === nothing
-        # Ensure directory exists
-        db_dir = dirname(abspath(db_path))
-        if !isempty(db_dir) && !isdir(db_dir)
-            mkpath(db_dir)
+    return ErrorLearning.open_store(db_path).db
+end
+
+# ============================================================================
+# ERROR REPORTING
+# ============================================================================
+
+# Whether the error-handler daemon answered, rechecked after ERROR_DAEMON_RECHECK seconds
+const ERROR_DAEMON_STATE = Ref((checked=0.0, up=false))
+const ERROR_DAEMON_RECHECK = 30.0
+const ERROR_DAEMON_PROBING = Threads.Atomic{Bool}(false)
+
+"""
+Last known availability of the error-handler daemon. A stale answer starts a ping in
+the background and is returned as is, so a failing compile never waits on the probe.
+"""
+function error_daemon_up()
+    get(ENV, "JMAKE_ERROR_DAEMON", "1") == "0" && return false
+    state = ERROR_DAEMON_STATE[]
+    if time() - state.checked > ERROR_DAEMON_RECHECK && !Threads.atomic_xchg!(ERROR_DAEMON_PROBING, true)
+        errormonitor(@async try
+            up = DaemonRPC.ping(DaemonRPC.SERVICE_PORTS["error"]; timeout=0.5)
+            ERROR_DAEMON_STATE[] = (checked=time(), up=up)
+        finally
+            ERROR_DAEMON_PROBING[] = false
+        end)
+    end
+    return state.up
+end
+
+"""
+    report_error(db_path, command, output; project_path="", file_path="", suggest=true)
+        -> (handle, pattern_name, description, suggestions)
+
+Record a failure from the compile path without waiting for the database write.
+Goes to the error-handler daemon when it runs (it owns the database), else to this
+process's background writer. `handle` is passed to `report_fix`.
+"""
+function report_error(db_path::String, command::String, output::String;
+                      project_path::String="", file_path::String="", suggest::Bool=true)
+    if error_daemon_up()
+        result = DaemonRPC.call("error", :report_error, Dict(
+            "db_path" => abspath(db_path), "command" => command, "output" => output,
+            "project_path" => project_path, "file_path" => file_path, "suggest" => suggest
+        ); timeout=10.0)
+        if result isa AbstractDict && get(result, :success, false)
+            return (result[:ticket], result[:pattern], result[:description], result[:suggestions])
         end
-        GLOBAL_ERROR_DB[] = ErrorLearning.init_db(db_path)
+        ERROR_DAEMON_STATE[] = (checked=time(), up=false)
+    end
+
+    store = ErrorLearning.open_store(db_path)
+    suggestions = suggest ? ErrorLearning.suggest_fixes(store, output; project_path=project_path) : []
+    (pending, pattern_name, description) = ErrorLearning.record_error!(
+        store, command, output; project_path=project_path, file_path=file_path)
+    return (pending, pattern_name, description, suggestions)
+end
+
+"""
+    report_fix(db_path, handle, description, action, fix_type, success)
+
+Record a fix attempt for a failure returned by `report_error` (queued, like the error).
+"""
+function report_fix(db_path::String, handle, description::String, action::String,
+                    fix_type::String, success::Bool)
+    if handle isa ErrorLearning.PendingError
+        ErrorLearning.record_fix!(ErrorLearning.open_store(db_path), handle, description, action, fix_type, success)
+        return
+    end
+
+    # Daemon ticket
+    result = DaemonRPC.call("error", :record_fix, Dict(
+        "db_path" => abspath(db_path), "ticket" => handle, "description" => description,
+        "action" => action, "type" => fix_type, "success" => success
+    ); timeout=10.0)
+    if !(result isa AbstractDict && get(result, :success, false))
+        @debug "Could not record fix with the error daemon: $(get(result, :error, result))"
     end
-    return GLOBAL_ERROR_DB[]
 end
 
 # ============================================================================
@@ -38,54 +115,41 @@ end
 
 """
 Execute command and capture output (stdout + stderr combined)
-Uses LLVMEnvironment if the command is an LLVM tool
+Uses LLVMEnvironment if the command is an LLVM tool: the toolchain environment is
+attached to the command itself, so concurrent calls never touch the global ENV
 """
 function run_command(cmd::Cmd; capture_output::Bool=true, use_llvm_env::Bool=true)
-    # Wrapper function that executes with LLVM environment
-    execute_fn = if use_llvm_env
-        () -> _run_command_impl(cmd, capture_output)
-    else
-        () -> _run_command_impl(cmd, capture_output)
-    end
-
-    # Execute with LLVM environment if requested
     if use_llvm_env
-        try
-            return LLVMEnvironment.with_llvm_env(execute_fn)
+        cmd = try
+            LLVMEnvironment.llvm_cmd(cmd)
         catch
             # Fallback to direct execution if LLVM env fails
-            return _run_command_impl(cmd, capture_output)
+            cmd
         end
-    else
-        return execute_fn()
     end
+    return _run_command_impl(cmd, capture_output)
 end
 
 """
 Internal command execution implementation
+A failing command's output comes from the same run (it is not started twice). While
+tracing, the spawn (fork/exec until the process exists) and the run until exit are
+recorded as separate spans.
 """
 function _run_command_impl(cmd::Cmd, capture_output::Bool)
+    io = IOBuffer()
     try
-        if capture_output
-            io = IOBuffer()
-            pipeline(cmd, stdout=io, stderr=io) |> run
-            return (String(take!(io)), 0)
-        else
-            run(cmd)
-            return ("", 0)
-        end
+        started = time_ns()
+        process = capture_output ? run(pipeline(cmd, stdout=io, stderr=io); wait=false) : run(cmd; wait=false)
+        spawned = time_ns()
+        ok = success(process)
+
+        tool = basename(first(cmd.exec))
+        Tracing.record_span!("spawn", started, spawned; cat="process", tool=tool)
+        Tracing.record_span!(tool, spawned, time_ns(); cat="process", exitcode=process.exitcode)
+        return (String(take!(io)), ok ? 0 : 1)
     catch e
-        if isa(e, ProcessFailedException)
-            # Get the error output
-            io = IOBuffer()
-            try
-                pipeline(cmd, stdout=io, stderr=io) |> run
-            catch
-            end
-            return (String(take!(io)), 1)
-        else
-            return ("Error: $e", 1)
-        end
+        return ("Error: $e", 1)
     end
 end
 
@@ -241,7 +305,6 @@ function compile_with_learning(command::String, args::Vector{String};
                                db_path::String="jmake_errors.db",
                                project_path::String="",
                                config_modifier::Union{Function,Nothing}=nothing)
-    db = get_error_db(db_path)
     cmd_string = "$command $(join(args, " "))"
     error_id = nothing
 
@@ -251,26 +314,23 @@ function compile_with_learning(command::String, args::Vector{String};
         if exitcode == 0
             # Record successful fix if this was a retry
             if !isnothing(error_id) && attempt > 1
-                ErrorLearning.record_fix(db, error_id,
+                report_fix(db_path, error_id,
                     "Retry successful after $(attempt-1) attempts",
                     "retry", "automatic", true)
             end
             return (output, exitcode, attempt, String[])
         end
 
-        # Compilation failed - record error
-        (error_id, pattern_name, description) = ErrorLearning.record_error(
-            db, cmd_string, output, project_path=project_path)
+        # Compilation failed - record error (queued) and get fix suggestions
+        (error_id, pattern_name, description, suggested_fixes) = report_error(
+            db_path, cmd_string, output, project_path=project_path)
 
         println("❌ Compilation Error (attempt $attempt/$max_retries)")
         println("   Pattern: $pattern_name - $description")
 
-        # Get fix suggestions
-        suggested_fixes = ErrorLearning.suggest_fixes(db, output, project_path=project_path)
-
         if isempty(suggested_fixes)
             # Record that we found no fixes
-            ErrorLearning.record_fix(db, error_id, "No automatic fix available",
+            report_fix(db_path, error_id, "No automatic fix available",
                 "none", "manual", false)
 
             # Fallback to basic pattern matching
@@ -289,7 +349,7 @@ function compile_with_learning(command::String, args::Vector{String};
                 success = config_modifier(best_fix)
 
                 # Record fix attempt
-                ErrorLearning.record_fix(db, error_id,
+                report_fix(db_path, error_id,
                     best_fix["description"],
                     best_fix["action"],
                     best_fix["type"],
@@ -303,7 +363,7 @@ function compile_with_learning(command::String, args::Vector{String};
                 end
             catch e
                 println("   ❌ Error applying fix: $e")
-                ErrorLearning.record_fix(db, error_id, best_fix["description"],
+                report_fix(db_path, error_id, best_fix["description"],
                     best_fix["action"], best_fix["type"], false)
             end
         end
@@ -328,16 +388,16 @@ end
 Export error log to Obsidian-friendly markdown
 """
 function export_error_log(db_path::String="jmake_errors.db", output_path::String="error_log.md")
-    db = get_error_db(db_path)
-    ErrorLearning.export_to_markdown(db, output_path)
+    store = ErrorLearning.open_store(db_path)
+    ErrorLearning.flush!(store)
+    ErrorLearning.export_to_markdown(store.db, output_path)
 end
 
 """
 Get error statistics
 """
 function get_error_stats(db_path::String="jmake_errors.db")
-    db = get_error_db(db_path)
-    return ErrorLearning.get_error_stats(db)
+    return ErrorLearning.get_error_stats(ErrorLearning.open_store(db_path))
 end
 
 # ============================================================================
@@ -417,6 +477,8 @@ export
 
     # Error learning & database
     get_error_db,
+    report_error,
+    report_fix,
     export_error_log,
     get_error_stats,
 
@@ -0,0 +1,686 @@
+#!/usr/bin/env julia
+# BuildCache.jl - Content-addressed on-disk artifact cache
+# Keys build artifacts on source bytes, resolved header closure, full flag vector and toolchain version
+# Shared by LLVMake, Bridge_LLVM and the compilation daemon (persists across processes and restarts)
+# Optionally backed by a remote store (HTTP or shared filesystem): read-through, write-back
+
+module BuildCache
+
+using SHA
+using Downloads
+
+include("Tracing.jl")
+
+# Bump when the key derivation or on-disk layout changes
+const CACHE_FORMAT_VERSION = "1"
+
+# ============================================================================
+# REMOTE STORES
+# ============================================================================
+
+"""
+Artifact store shared between machines (CI runners, developer hosts), consulted on
+local misses. Keys already cover the toolchain version, so hosts with a different
+LLVM never see each other's artifacts.
+"""
+abstract type RemoteStore end
+
+"""
+Store on a shared filesystem (NFS, SMB, a mounted bucket), same layout as the local cache
+"""
+struct FileStore <: RemoteStore
+    root::String
+end
+
+"""
+Store behind an HTTP server: `GET`/`PUT <url>/<key[1:2]>/<key><ext>` (bazel-remote,
+nginx with WebDAV, ...). `JMAKE_REMOTE_CACHE_TOKEN` is sent as a bearer token.
+"""
+struct HTTPStore <: RemoteStore
+    url::String
+    headers::Vector{Pair{String,String}}
+    timeout::Float64
+end
+
+"""
+    remote_store(spec::AbstractString) -> Union{RemoteStore,Nothing}
+
+`http(s)://...` gives an `HTTPStore`, any other path a `FileStore`, `""` no remote.
+"""
+function remote_store(spec::AbstractString)
+    isempty(spec) && return nothing
+    if startswith(spec, "http://") || startswith(spec, "https://")
+        token = get(ENV, "JMAKE_REMOTE_CACHE_TOKEN", "")
+        headers = isempty(token) ? Pair{String,String}[] : ["Authorization" => "Bearer $token"]
+        timeout = parse(Float64, get(ENV, "JMAKE_REMOTE_CACHE_TIMEOUT", "10"))
+        return HTTPStore(String(rstrip(spec, '/')), headers, timeout)
+    end
+    return FileStore(abspath(expanduser(spec)))
+end
+
+"""
+Remote store from `JMAKE_REMOTE_CACHE`, the default for every `ArtifactCache`
+"""
+default_remote() = remote_store(get(ENV, "JMAKE_REMOTE_CACHE", ""))
+
+remote_path(store::FileStore, key::String, ext::String) = joinpath(store.root, "objects", key[1:2], key * ext)
+remote_url(store::HTTPStore, key::String, ext::String) = "$(store.url)/$(key[1:2])/$key$ext"
+
+remote_label(store::FileStore) = store.root
+remote_label(store::HTTPStore) = store.url
+
+"""
+    remote_get(store::RemoteStore, key::String, ext::String, dest::String) -> Bool
+
+Download an artifact to `dest`. False on a miss; failures are misses too.
+"""
+function remote_get(store::FileStore, key::String, ext::String, dest::String)
+    src = remote_path(store, key, ext)
+    isfile(src) || return false
+    cp(src, dest, force=true)
+    return true
+end
+
+function remote_get(store::HTTPStore, key::String, ext::String, dest::String)
+    try
+        Downloads.download(remote_url(store, key, ext), dest; headers=store.headers, timeout=store.timeout)
+        return true
+    catch e
+        if !(e isa Downloads.RequestError && e.response.status == 404)
+            @debug "Remote cache GET failed for $key$ext: $e"
+        end
+        rm(dest, force=true)
+        return false
+    end
+end
+
+"""
+    remote_put(store::RemoteStore, key::String, ext::String, file::String) -> Bool
+"""
+function remote_put(store::FileStore, key::String, ext::String, file::String)
+    path = remote_path(store, key, ext)
+    isfile(path) && return true
+    mkpath(dirname(path))
+    tmp = "$path.tmp.$(gethostname()).$(getpid()).$(rand(UInt64))"
+    cp(file, tmp, force=true)
+    mv(tmp, path, force=true)
+    return true
+end
+
+function remote_put(store::HTTPStore, key::String, ext::String, file::String)
+    response = open(file) do io
+        Downloads.request(remote_url(store, key, ext); method="PUT", input=io,
+                          headers=store.headers, timeout=store.timeout, throw=false)
+    end
+    return response isa Downloads.Response && 200 <= response.status < 300
+end
+
+# ============================================================================
+# LOCAL STORE
+# ============================================================================
+
+"""
+On-disk content-addressed artifact store.
+Artifacts live at `root/objects/<key[1:2]>/<key><ext>` and are written atomically,
+so several processes (CLI, daemon workers) can share one cache directory.
+With a `remote`, local misses are read through from it and stores are written back
+to it in the background (`flush!` waits for pending uploads).
+"""
+struct ArtifactCache
+    root::String
+    remote::Union{RemoteStore,Nothing}
+    hits::Threads.Atomic{Int}
+    misses::Threads.Atomic{Int}
+    stores::Threads.Atomic{Int}
+    remote_hits::Threads.Atomic{Int}
+    uploads::Vector{Task}
+    lock::ReentrantLock
+end
+
+function ArtifactCache(root::String; remote::Union{RemoteStore,Nothing}=default_remote())
+    return ArtifactCache(abspath(root), remote, Threads.Atomic{Int}(0), Threads.Atomic{Int}(0),
+                         Threads.Atomic{Int}(0), Threads.Atomic{Int}(0), Task[], ReentrantLock())
+end
+
+"""
+    default_cache_dir(project_root::String) -> String
+
+Cache directory for a project. `JMAKE_CACHE_DIR` overrides the project-local
+`.jmake_cache` so that several checkouts or branches can share one store.
+"""
+function default_cache_dir(project_root::String)
+    return get(ENV, "JMAKE_CACHE_DIR", joinpath(project_root, ".jmake_cache"))
+end
+
+"""
+    project_cache_dir(project_root::String, cache::AbstractDict=Dict()) -> String
+
+Cache directory named by a project's `[cache]` table: `directory` (relative to the
+project root) when set, else `default_cache_dir`.
+"""
+function project_cache_dir(project_root::String, cache::AbstractDict=Dict{String,Any}())
+    haskey(cache, "directory") && return joinpath(project_root, cache["directory"])
+    return default_cache_dir(project_root)
+end
+
+# ============================================================================
+# HEADER CLOSURE
+# ============================================================================
+
+const INCLUDE_REGEX = r"^\s*#\s*include\s*([<\"])([^>\"]+)[>\"]"m
+
+"""
+    include_dirs_from_flags(flags::Vector{String}) -> Vector{String}
+
+Collect header search paths (`-I`, `-isystem`, `-iquote`) from a compiler flag vector.
+"""
+function include_dirs_from_flags(flags::Vector{String})
+    dirs = String[]
+    i = 1
+    while i <= length(flags)
+        flag = flags[i]
+        for prefix in ("-isystem", "-iquote", "-I")
+            if flag == prefix && i < length(flags)
+                push!(dirs, flags[i+1])
+                i += 1
+                break
+            elseif startswith(flag, prefix) && length(flag) > length(prefix)
+                push!(dirs, flag[length(prefix)+1:end])
+                break
+            end
+        end
+        i += 1
+    end
+    return dirs
+end
+
+"""
+    forced_includes_from_flags(flags::Vector{String}) -> Vector{String}
+
+Collect headers injected with `-include <file>`.
+"""
+function forced_includes_from_flags(flags::Vector{String})
+    forced = String[]
+    for i in 1:length(flags)-1
+        if flags[i] == "-include"
+            push!(forced, flags[i+1])
+        end
+    end
+    return forced
+end
+
+"""
+    resolve_header_closure(source::String, include_dirs::Vector{String};
+                           forced::Vector{String}=String[]) -> Vector{String}
+
+Transitively resolve the project headers reachable from `source`.
+Quoted includes are searched next to the including file first, then in `include_dirs`;
+angle includes only in `include_dirs`. Headers that cannot be resolved (system and
+toolchain headers) are left out - they are covered by the toolchain version in the key.
+Returns sorted absolute paths.
+"""
+function resolve_header_closure(source::String, include_dirs::Vector{String};
+                                forced::Vector{String}=String[])
+    closure = Set{String}()
+    queue = String[abspath(source)]
+
+    for f in forced
+        if isfile(f)
+            path = abspath(f)
+            push!(closure, path)
+            push!(queue, path)
+        end
+    end
+
+    while !isempty(queue)
+        current = pop!(queue)
+        content = try
+            read(current, String)
+        catch
+            continue
+        end
+
+        for m in eachmatch(INCLUDE_REGEX, content)
+            quoted = m.captures[1] == "\""
+            name = m.captures[2]
+            candidates = quoted ? vcat([dirname(current)], include_dirs) : include_dirs
+
+            for dir in candidates
+                candidate = joinpath(dir, name)
+                if isfile(candidate)
+                    resolved = abspath(candidate)
+                    if !(resolved in closure)
+                        push!(closure, resolved)
+                        push!(queue, resolved)
+                    end
+                    break
+                end
+            end
+        end
+    end
+
+    return sort!(collect(closure))
+end
+
+# Include forms the regex scan cannot follow
+const UNTRACKED_INCLUDE_REGEX = r"^\s*#\s*(include_next\b|include\s+[A-Za-z_])|__has_include"m
+
+"""
+    unit_include_dirs(source::String, include_dirs::Vector{String};
+                      forced::Vector{String}=String[], strict::Bool=false) -> Union{Vector{String},Nothing}
+
+The entries of `include_dirs` (order kept) that supply a header of `source`'s closure,
+i.e. the `-I` flags the TU needs. Every include resolves to the same file with this
+subset, and the TU's flags (and cache key) stop changing when unrelated header
+directories appear. Returns `nothing` when the include lines can't decide it (macro
+includes, `#include_next`, `__has_include`) or, with `strict`, while a quoted include
+does not resolve yet (a partial directory list during a streamed scan).
+"""
+function unit_include_dirs(source::String, include_dirs::Vector{String};
+                           forced::Vector{String}=String[], strict::Bool=false)
+    used = Set{String}()
+    visited = Set{String}()
+    queue = String[abspath(source); [abspath(f) for f in forced if isfile(f)]]
+
+    while !isempty(queue)
+        current = pop!(queue)
+        current in visited && continue
+        push!(visited, current)
+
+        content = try
+            read(current, String)
+        catch
+            continue
+        end
+        occursin(UNTRACKED_INCLUDE_REGEX, content) && return nothing
+
+        for m in eachmatch(INCLUDE_REGEX, content)
+            quoted = m.captures[1] == "\""
+            name = m.captures[2]
+
+            local_candidate = joinpath(dirname(current), name)
+            if quoted && isfile(local_candidate)
+                push!(queue, abspath(local_candidate))
+                continue
+            end
+
+            index = findfirst(dir -> isfile(joinpath(dir, name)), include_dirs)
+            if index !== nothing
+                push!(used, include_dirs[index])
+                push!(queue, abspath(joinpath(include_dirs[index], name)))
+            elseif quoted && strict
+                return nothing
+            end
+        end
+    end
+
+    return filter(in(used), include_dirs)
+end
+
+# ============================================================================
+# TOOLCHAIN FINGERPRINT
+# ============================================================================
+
+const TOOLCHAIN_VERSIONS = Dict{String,Tuple{Float64,String}}()  # tool path => (mtime, version)
+const TOOLCHAIN_LOCK = ReentrantLock()
+
+"""
+    toolchain_version(tool::String) -> String
+
+`<tool> --version` output, memoized per binary path and mtime so a process spawns
+it at most once per toolchain. The `InstalledDir:` line is dropped: it only says
+where this host keeps the binary, and keys must match across hosts sharing a remote store.
+"""
+function toolchain_version(tool::String)
+    path = isfile(tool) ? abspath(tool) : something(Sys.which(tool), tool)
+    current_mtime = isfile(path) ? mtime(path) : 0.0
+
+    lock(TOOLCHAIN_LOCK) do
+        cached = get(TOOLCHAIN_VERSIONS, path, nothing)
+        if Tracing.count_cache!("toolchain_version", cached !== nothing && cached[1] == current_mtime)
+            return cached[2]
+        end
+
+        version = try
+            host_independent_version(read(`$path --version`, String))
+        catch
+            "unknown"
+        end
+        TOOLCHAIN_VERSIONS[path] = (current_mtime, version)
+        return version
+    end
+end
+
+host_independent_version(output::AbstractString) =
+    String(strip(join(filter(l -> !startswith(l, "InstalledDir:"), split(output, '\n')), '\n')))
+
+"""
+    remember_toolchain_version!(tool::String, version_output::String)
+
+Seed `toolchain_version` with `--version` output read elsewhere (the persisted toolchain
+manifest), so the tool is not started for it.
+"""
+function remember_toolchain_version!(tool::String, version_output::String)
+    path = isfile(tool) ? abspath(tool) : something(Sys.which(tool), tool)
+    lock(TOOLCHAIN_LOCK) do
+        TOOLCHAIN_VERSIONS[path] = (isfile(path) ? mtime(path) : 0.0, host_independent_version(version_output))
+    end
+end
+
+# ============================================================================
+# KEYS AND ARTIFACTS
+# ============================================================================
+
+"""
+    cache_key(source::String, flags::Vector{String}; toolchain::String="") -> String
+
+SHA-256 over the source bytes, every header in its resolved closure, the full flag
+vector (order preserved) and the toolchain version string. Pass every flag that
+affects the output, including `-S -emit-llvm` style output-kind flags, but not `-o`.
+"""
+function cache_key(source::String, flags::Vector{String}; toolchain::String="")
+    ctx = SHA.SHA256_CTX()
+    separator = UInt8[0x00]
+
+    SHA.update!(ctx, codeunits("jmake-cache-v$CACHE_FORMAT_VERSION"))
+    SHA.update!(ctx, separator)
+    SHA.update!(ctx, codeunits(toolchain))
+    SHA.update!(ctx, separator)
+
+    for flag in flags
+        SHA.update!(ctx, codeunits(flag))
+        SHA.update!(ctx, separator)
+    end
+
+    SHA.update!(ctx, read(source))
+
+    headers = resolve_header_closure(source, include_dirs_from_flags(flags);
+                                     forced=forced_includes_from_flags(flags))
+    for header in headers
+        SHA.update!(ctx, separator)
+        SHA.update!(ctx, read(header))
+    end
+
+    return bytes2hex(SHA.digest!(ctx))
+end
+
+"""
+    artifact_path(cache::ArtifactCache, key::String, ext::String) -> String
+
+Location of an artifact in the store (the file may not exist yet).
+"""
+function artifact_path(cache::ArtifactCache, key::String, ext::String)
+    return joinpath(cache.root, "objects", key[1:2], key * ext)
+end
+
+"""
+    lookup(cache::ArtifactCache, key::String, ext::String) -> Union{String,Nothing}
+
+Return the cached artifact path on a hit, `nothing` on a miss. A local miss is
+read through from the remote store, which leaves the artifact in the local one.
+"""
+function lookup(cache::ArtifactCache, key::String, ext::String)
+    path = artifact_path(cache, key, ext)
+    if Tracing.count_cache!("artifact$ext", isfile(path))
+        Threads.atomic_add!(cache.hits, 1)
+        return path
+    end
+    if cache.remote !== nothing &&
+       Tracing.count_cache!("remote$ext", Tracing.span(() -> pull!(cache, key, ext), "remote_get"; cat="cache"))
+        Threads.atomic_add!(cache.hits, 1)
+        Threads.atomic_add!(cache.remote_hits, 1)
+        return path
+    end
+    Threads.atomic_add!(cache.misses, 1)
+    return nothing
+end
+
+function pull!(cache::ArtifactCache, key::String, ext::String)
+    path = artifact_path(cache, key, ext)
+    mkpath(dirname(path))
+    tmp = "$path.tmp.$(getpid()).$(rand(UInt64))"
+    try
+        if remote_get(cache.remote, key, ext, tmp) && filesize(tmp) > 0
+            mv(tmp, path, force=true)
+            return true
+        end
+    catch e
+        @debug "Remote cache read failed for $key$ext: $e"
+    end
+    rm(tmp, force=true)
+    return false
+end
+
+"""
+    fetch!(cache::ArtifactCache, key::String, ext::String, dest::String) -> Bool
+
+Copy a cached artifact to `dest`. Returns false on a miss.
+"""
+function fetch!(cache::ArtifactCache, key::String, ext::String, dest::String)
+    path = lookup(cache, key, ext)
+    path === nothing && return false
+    mkpath(dirname(dest))
+    cp(path, dest, force=true)
+    return true
+end
+
+"""
+    store!(cache::ArtifactCache, key::String, ext::String, file::String) -> String
+
+Copy `file` into the store under `key`. The write goes through a temporary file and
+a rename so concurrent readers never observe a partial artifact.
+"""
+function store!(cache::ArtifactCache, key::String, ext::String, file::String)
+    path = artifact_path(cache, key, ext)
+    mkpath(dirname(path))
+    tmp = "$path.tmp.$(getpid()).$(rand(UInt64))"
+    cp(file, tmp, force=true)
+    mv(tmp, path, force=true)
+    Threads.atomic_add!(cache.stores, 1)
+    publish!(cache, key, ext)
+    return path
+end
+
+"""
+    publish!(cache::ArtifactCache, key::String, ext::String)
+
+Upload a stored artifact to the remote store in the background (no-op without one).
+Upload failures only cost other hosts a miss, so they are logged and dropped.
+"""
+function publish!(cache::ArtifactCache, key::String, ext::String)
+    cache.remote === nothing && return nothing
+    path = artifact_path(cache, key, ext)
+    task = Threads.@spawn try
+        remote_put(cache.remote, key, ext, path) || @warn "Remote cache rejected $key$ext"
+    catch e
+        @warn "Remote cache upload failed for $key$ext: $e"
+    end
+    lock(cache.lock) do
+        filter!(!istaskdone, cache.uploads)
+        push!(cache.uploads, task)
+    end
+    return nothing
+end
+
+"""
+    flush!(cache::ArtifactCache)
+
+Wait for pending remote uploads (call before a short-lived process exits).
+"""
+function flush!(cache::ArtifactCache)
+    pending = lock(() -> copy(cache.uploads), cache.lock)
+    foreach(wait, pending)
+    return nothing
+end
+
+"""
+    output_path(build_dir::String, source::String, ext::String) -> String
+
+Per-source output path in `build_dir`. A short digest of the absolute source path is
+part of the name so `a/util.cpp` and `b/util.cpp` never overwrite each other.
+"""
+function output_path(build_dir::String, source::String, ext::String)
+    tag = bytes2hex(SHA.sha1(abspath(source)))[1:8]
+    return joinpath(build_dir, "$(basename(source)).$tag$ext")
+end
+
+"""
+    cache_stats(cache::ArtifactCache) -> Dict{String,Any}
+"""
+function cache_stats(cache::ArtifactCache)
+    return Dict{String,Any}(
+        "root" => cache.root,
+        "remote" => cache.remote === nothing ? "" : remote_label(cache.remote),
+        "hits" => cache.hits[],
+        "remote_hits" => cache.remote_hits[],
+        "misses" => cache.misses[],
+        "stores" => cache.stores[]
+    )
+end
+
+"""
+    clear!(cache::ArtifactCache)
+
+Remove every stored artifact.
+"""
+function clear!(cache::ArtifactCache)
+    objects = joinpath(cache.root, "objects")
+    if isdir(objects)
+        rm(objects, recursive=true, force=true)
+    end
+end
+
+# ============================================================================
+# PRECOMPILED HEADERS
+# ============================================================================
+
+# Fragments that only work inside the header including them (X-macro lists, template
+# bodies), and the sources that unity batches and their depfiles list
+const PCH_SKIP_EXTENSIONS = (".def", ".inc", ".inl", ".ipp", ".tcc", ".pch", ".c", ".cc", ".cpp", ".cxx")
+
+"""
+    hot_headers(include_graph::Dict{String,Vector{String}}; threshold::Real=0.5,
+                min_units::Int=2, exclude_dir::String="") -> Vector{String}
+
+Members of a precompiled header for the TUs of `include_graph` (TU => headers): the
+headers included by at least `threshold` of the TUs and by at least `min_units`, most
+widely included first. Only headers that no other member includes are kept, so
+internal headers (`bits/...`, `*intrin.h`) come in through their public header, in its
+order. Fragments (`.def`, `.inc`, `.inl`, ...), source files (unity batch members)
+and anything under `exclude_dir` (the umbrella and PCH files, which compile depfiles
+list too) are left out.
+"""
+function hot_headers(include_graph::Dict{String,Vector{String}}; threshold::Real=0.5,
+                     min_units::Int=2, exclude_dir::String="")
+    counts = Dict{String,Int}()
+    for headers in values(include_graph), header in unique(headers)
+        counts[header] = get(counts, header, 0) + 1
+    end
+
+    needed = max(min_units, ceil(Int, threshold * length(include_graph)))
+    prefix = isempty(exclude_dir) ? "" : rstrip(abspath(exclude_dir), '/') * "/"
+    hot = [header for (header, n) in counts
+           if n >= needed && isfile(header) &&
+              !any(ext -> endswith(header, ext), PCH_SKIP_EXTENSIONS) &&
+              (isempty(prefix) || !startswith(header, prefix))]
+
+    # Include names written in the members; a member matching one of another header is internal
+    included = Set{Tuple{String,String}}()  # (including header, include name)
+    for header in hot
+        content = try
+            read(header, String)
+        catch
+            continue
+        end
+        for m in eachmatch(INCLUDE_REGEX, content)
+            push!(included, (header, m.captures[2]))
+        end
+    end
+    roots = filter(hot) do header
+        !any(((parent, name),) -> parent != header && endswith(header, "/" * name), included)
+    end
+
+    return sort!(roots, by=header -> (-counts[header], header))
+end
+
+"""
+    write_pch_umbrella(path::String, headers::Vector{String}) -> String
+
+Write the umbrella header that includes every PCH member by absolute path. The file is
+only rewritten when the member list changes, so its mtime stays stable across builds.
+"""
+function write_pch_umbrella(path::String, headers::Vector{String})
+    content = "// Generated by JMake: precompiled header members\n" *
+              join(["#include \"$(abspath(header))\"\n" for header in headers])
+    if !isfile(path) || read(path, String) != content
+        mkpath(dirname(path))
+        write(path, content)
+    end
+    return path
+end
+
+"""
+    pch_path(umbrella::String, key::String) -> String
+    pch_umbrella(pch::String) -> String
+
+PCH file of an umbrella header for a cache key (`<name>-<key[1:16]>.pch` next to
+`<name>.h`), and back. The key in the name makes every flag vector that carries the
+PCH change with its contents, so TU keys are invalidated with it.
+"""
+pch_path(umbrella::String, key::String) = "$(splitext(umbrella)[1])-$(key[1:16]).pch"
+pch_umbrella(pch::String) = replace(pch, r"-[0-9a-f]{16}\.pch$" => ".h")
+
+"""
+    pch_flags(pch::Union{String,Nothing}) -> Vector{String}
+
+Flags a TU is compiled with to use `pch` (none for `nothing`). Input headers are checked
+by content, so a PCH pulled from the cache stays valid even though its headers' mtimes
+differ from the build that produced it.
+"""
+pch_flags(::Nothing) = String[]
+pch_flags(pch::String) = ["-fpch-validate-input-files-content", "-include-pch", pch]
+
+"""
+    precompile_header!(build::Function, cache::Union{ArtifactCache,Nothing}, umbrella::String,
+                       flags::Vector{String}; toolchain::String="") -> Union{String,Nothing}
+
+Content-addressed PCH of `umbrella` compiled with `flags` (which start with
+`-x c++-header`). The key covers the umbrella, the closure of its member headers, the
+flags and the toolchain, like a TU key. The PCH already next to the umbrella is reused,
+then the artifact cache is consulted; only then `build(args)` runs the compiler and
+returns `(output, exitcode)`. Older PCH files of the umbrella are removed. Returns the
+PCH path, or `nothing` when the build fails (TUs then compile without it).
+"""
+function precompile_header!(build::Function, cache::Union{ArtifactCache,Nothing}, umbrella::String,
+                            flags::Vector{String}; toolchain::String="")
+    key = cache_key(umbrella, flags; toolchain=toolchain)
+    pch = pch_path(umbrella, key)
+
+    found = isfile(pch) || (!isnothing(cache) && fetch!(cache, key, ".pch", pch))
+    if !Tracing.count_cache!("pch", found)
+        args = [flags..., "-fpch-validate-input-files-content", umbrella, "-o", pch]
+        output, exitcode = Tracing.span(() -> build(args), "precompile_header"; umbrella=umbrella)
+        if exitcode != 0
+            rm(pch, force=true)
+            @warn "Precompiled header $(basename(umbrella)) failed, compiling without it:\n$output"
+            return nothing
+        end
+        isnothing(cache) || store!(cache, key, ".pch", pch)
+    end
+
+    stem = basename(splitext(umbrella)[1])
+    for file in readdir(dirname(umbrella))
+        if endswith(file, ".pch") && file != basename(pch) && pch_umbrella(file) == "$stem.h"
+            rm(joinpath(dirname(umbrella), file), force=true)
+        end
+    end
+    return pch
+end
+
+# Exports
+export ArtifactCache, RemoteStore, FileStore, HTTPStore, remote_store, default_cache_dir, project_cache_dir,
+       resolve_header_closure, unit_include_dirs, toolchain_version, remember_toolchain_version!,
+       cache_key, artifact_path, lookup, store!, output_path,
+       hot_headers, write_pch_umbrella, pch_flags, precompile_header!
+
+end # module BuildCache
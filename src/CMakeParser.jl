@@ -1,10 +1,19 @@
 #!/usr/bin/env julia
 # CMakeParser.jl - Parse CMakeLists.txt without running CMake
 # Extract build configuration data and normalize it for JMake
+# `add_subdirectory` trees are walked with independent subtrees parsed in parallel; the
+# command list of each file is cached by content hash (in memory, optionally on disk)
 
 module CMakeParser
 
 using TOML
+using SHA
+using Serialization
+
+include("Tracing.jl")
+
+# Bump when the cached command representation changes (invalidates on-disk entries)
+const PARSER_FORMAT_VERSION = "1"
 
 # ============================================================================
 # DATA STRUCTURES
@@ -48,44 +57,24 @@ Example: add_library(mylib SHARED foo.cpp bar.cpp)
 """
 function tokenize_line(line::AbstractString)
     tokens = String[]
-    current = ""
+    current = IOBuffer()
     in_quotes = false
-    in_parens = false
+    flush_token!() = position(current) > 0 && push!(tokens, String(take!(current)))
 
     for char in line
         if char == '"'
             in_quotes = !in_quotes
-            if !in_quotes && !isempty(current)
-                push!(tokens, current)
-                current = ""
-            end
-        elseif char == '(' && !in_quotes
-            if !isempty(current)
-                push!(tokens, current)
-                current = ""
-            end
-            push!(tokens, "(")
-            in_parens = true
-        elseif char == ')' && !in_quotes
-            if !isempty(current)
-                push!(tokens, current)
-                current = ""
-            end
-            push!(tokens, ")")
-            in_parens = false
+            in_quotes || flush_token!()
+        elseif (char == '(' || char == ')') && !in_quotes
+            flush_token!()
+            push!(tokens, string(char))
         elseif isspace(char) && !in_quotes
-            if !isempty(current)
-                push!(tokens, current)
-                current = ""
-            end
+            flush_token!()
         else
-            current *= char
+            print(current, char)
         end
     end
-
-    if !isempty(current)
-        push!(tokens, current)
-    end
+    flush_token!()
 
     return tokens
 end
@@ -125,53 +114,197 @@ end
 
 """
 Parse a CMakeLists.txt file with multi-line command support
+With `recursive`, `add_subdirectory` lists are parsed too (see `parse_cmake_tree`)
+"""
+function parse_cmake_file(filepath::String; recursive::Bool=true,
+                          cache_dir::Union{String,Nothing}=nothing,
+                          variables::AbstractDict=Dict{String,String}())
+    return parse_cmake_tree(filepath; recursive=recursive, cache_dir=cache_dir, variables=variables)[1]
+end
+
+"""
+One parse of a list tree: where it started, and how many lists were read or served from cache
 """
-function parse_cmake_file(filepath::String)
+struct ParseContext
+    top_dir::String
+    recursive::Bool
+    cache_dir::Union{String,Nothing}
+    lists::Threads.Atomic{Int}
+    reparsed::Threads.Atomic{Int}
+end
+
+"""
+    parse_cmake_tree(filepath; recursive=true, cache_dir=nothing, variables=Dict()) -> (CMakeProject, stats)
+
+Parse a CMakeLists.txt and, with `recursive`, every list reached through `add_subdirectory`.
+Each subdirectory starts from a copy of its parent's variables at the `add_subdirectory`
+call, as in CMake, so subtrees are independent and parse in parallel tasks. Targets of
+the whole tree end up in one project; `target_*` commands for targets defined in
+another directory are applied once that directory is merged. `stats` counts the lists
+read and how many had to be tokenized (the others came from the command cache).
+"""
+function parse_cmake_tree(filepath::String; recursive::Bool=true,
+                          cache_dir::Union{String,Nothing}=nothing,
+                          variables::AbstractDict=Dict{String,String}())
     if !isfile(filepath)
         error("CMakeLists.txt not found: $filepath")
     end
 
     # Get absolute path of the CMakeLists.txt directory
     root_dir = dirname(abspath(filepath))
-    project = CMakeProject(
-        "",  # project_name
-        "",  # cmake_minimum_required
-        root_dir,
-        Dict{String,CMakeTarget}(),
-        Dict{String,String}(),
-        String[],
-        String[]
-    )
+    scope = Dict{String,String}(string(k) => string(v) for (k, v) in variables)
+    scope["CMAKE_SOURCE_DIR"] = root_dir
+    scope["PROJECT_SOURCE_DIR"] = root_dir
 
-    lines = readlines(filepath)
+    context = ParseContext(root_dir, recursive, cache_dir, Threads.Atomic{Int}(0), Threads.Atomic{Int}(0))
+    project, _ = Tracing.span(() -> parse_directory(abspath(filepath), scope, context), "parse_cmake";
+                              file=filepath)
 
-    # Preprocess: merge multi-line commands
-    merged_lines = merge_multiline_commands(lines)
+    return project, (lists=context.lists[], reparsed=context.reparsed[])
+end
 
-    # Process each command
-    for line in merged_lines
-        # Remove comments (but preserve # inside strings)
-        line = remove_comments(line)
-        line = strip(String(line))
+"""
+Parse one list file in `scope` (which it then owns), its subdirectories in parallel.
+Returns the subtree's project and the `target_*` commands whose target it does not define.
+"""
+function parse_directory(list_file::String, scope::Dict{String,String}, context::ParseContext)
+    dir = dirname(list_file)
+    scope["CMAKE_CURRENT_SOURCE_DIR"] = dir
+    scope["CMAKE_CURRENT_LIST_DIR"] = dir
+    project = CMakeProject("", "", dir, Dict{String,CMakeTarget}(), scope, String[], String[])
 
-        # Skip empty lines
-        if isempty(line)
-            continue
+    children = Task[]
+    deferred = Tuple{String,Vector{String},String}[]  # (command, args, directory)
+    for (command, raw_args) in read_commands(list_file, context)
+        args = expand_arguments(raw_args, scope)
+
+        if command == "add_subdirectory" && context.recursive && !isempty(args)
+            sub_dir = resolve_path(args[1], dir)
+            push!(project.subdirectories, relpath(sub_dir, context.top_dir))
+            sub_list = joinpath(sub_dir, "CMakeLists.txt")
+            if isfile(sub_list)
+                snapshot = copy(scope)
+                push!(children, Threads.@spawn parse_directory(sub_list, snapshot, context))
+            else
+                @warn "add_subdirectory($(args[1])): no CMakeLists.txt in $sub_dir"
+            end
+        elseif startswith(command, "target_") && !isempty(args) && !haskey(project.targets, args[1])
+            push!(deferred, (command, args, dir))
+        else
+            process_cmake_command!(project, command, args, dir)
         end
+    end
 
-        # Tokenize and parse
-        tokens = tokenize_line(line)
-        if isempty(tokens)
-            continue
+    # Children merge in add_subdirectory order, so the result does not depend on timing
+    for child in children
+        (subtree, pending) = fetch(child)
+        merge_subtree!(project, subtree)
+        append!(deferred, pending)
+    end
+
+    unresolved = Tuple{String,Vector{String},String}[]
+    for (command, args, from_dir) in deferred
+        if haskey(project.targets, args[1])
+            process_cmake_command!(project, command, args, from_dir)
+        else
+            push!(unresolved, (command, args, from_dir))
+        end
+    end
+    return project, unresolved
+end
+
+"""
+Add a subdirectory's targets, subdirectories and packages to its parent's project
+"""
+function merge_subtree!(project::CMakeProject, subtree::CMakeProject)
+    for (name, target) in subtree.targets
+        if haskey(project.targets, name)
+            @warn "Target $name defined in more than one directory; keeping the first"
+        else
+            project.targets[name] = target
         end
+    end
+    append!(project.subdirectories, subtree.subdirectories)
+    for package in subtree.find_packages
+        package in project.find_packages || push!(project.find_packages, package)
+    end
+end
+
+# ============================================================================
+# COMMAND CACHE
+# ============================================================================
+
+# Commands of a list file (lowercased name, unexpanded arguments); content hash => commands
+const Command = Tuple{String,Vector{String}}
+const COMMAND_CACHE = Dict{String,Vector{Command}}()
+const CACHE_LOCK = ReentrantLock()
+
+"""
+    read_commands(list_file, context) -> Vector{Command}
+
+Tokenized commands of one list file, cached by the SHA-256 of its content in memory
+and, with a `cache_dir`, on disk. Arguments are stored unexpanded, so an entry is
+valid whatever scope the file is evaluated in.
+"""
+function read_commands(list_file::String, context::ParseContext)
+    Threads.atomic_add!(context.lists, 1)
+    content = read(list_file, String)
+    hash = bytes2hex(sha256(content))
+
+    cached = lock(() -> get(COMMAND_CACHE, hash, nothing), CACHE_LOCK)
+    if cached === nothing
+        cached = load_cached(context.cache_dir, hash)
+    end
+    Tracing.count_cache!("cmake_lists", cached !== nothing) && return cached
+
+    Threads.atomic_add!(context.reparsed, 1)
+    commands = tokenize_commands(content)
+    store_cached(context.cache_dir, hash, commands)
+    lock(() -> COMMAND_CACHE[hash] = commands, CACHE_LOCK)
+    return commands
+end
+
+"""
+Merge, strip comments from, tokenize and split a list file into commands
+"""
+function tokenize_commands(content::AbstractString)
+    commands = Command[]
+    for line in merge_multiline_commands(readlines(IOBuffer(content)))
+        # Remove comments (but preserve # inside strings)
+        line = strip(remove_comments(line))
+        isempty(line) && continue
+
+        tokens = tokenize_line(line)
+        isempty(tokens) && continue
 
         (command, args) = parse_command(tokens)
+        isempty(command) || push!(commands, (command, args))
+    end
+    return commands
+end
+
+cache_file(cache_dir::String, hash::String) =
+    joinpath(cache_dir, "cmake", hash[1:2], "$(hash)-v$(PARSER_FORMAT_VERSION).jls")
 
-        # Process command
-        process_cmake_command!(project, command, args, root_dir)
+function load_cached(cache_dir::Union{String,Nothing}, hash::String)
+    cache_dir === nothing && return nothing
+    file = cache_file(cache_dir, hash)
+    isfile(file) || return nothing
+    try
+        commands = deserialize(file)
+        return commands isa Vector{Command} ? commands : nothing
+    catch
+        return nothing
     end
+end
 
-    return project
+function store_cached(cache_dir::Union{String,Nothing}, hash::String, commands::Vector{Command})
+    cache_dir === nothing && return
+    file = cache_file(cache_dir, hash)
+    mkpath(dirname(file))
+    tmp = "$file.tmp.$(getpid()).$(rand(UInt64))"
+    serialize(tmp, commands)
+    mv(tmp, file, force=true)
 end
 
 """
@@ -203,9 +336,9 @@ function merge_multiline_commands(lines::Vector{String})
             end
         end
 
-        # Accumulate the line
+        # Accumulate the line; comments go now, or they would swallow the rest of the command
         if in_command || has_continuation
-            current_command *= " " * strip(line)
+            current_command *= " " * strip(line_cleaned)
         else
             if !isempty(strip(line))
                 push!(merged, strip(line))
@@ -231,27 +364,27 @@ end
 """
 Remove comments from a line, but preserve # inside strings
 """
-function remove_comments(line::String)
-    result = ""
+function remove_comments(line::AbstractString)
+    result = IOBuffer()
     in_string = false
     escape_next = false
 
-    for (i, char) in enumerate(line)
+    for char in line
         if escape_next
-            result *= char
+            print(result, char)
             escape_next = false
             continue
         end
 
         if char == '\\'
             escape_next = true
-            result *= char
+            print(result, char)
             continue
         end
 
         if char == '"'
             in_string = !in_string
-            result *= char
+            print(result, char)
             continue
         end
 
@@ -260,10 +393,10 @@ function remove_comments(line::String)
             break
         end
 
-        result *= char
+        print(result, char)
     end
 
-    return result
+    return String(take!(result))
 end
 
 """
@@ -274,6 +407,9 @@ function process_cmake_command!(project::CMakeProject, command::String, args::Ve
         # project(MyProject)
         if !isempty(args)
             project.project_name = args[1]
+            project.variables["PROJECT_NAME"] = args[1]
+            project.variables["PROJECT_SOURCE_DIR"] = root_dir
+            project.variables["$(args[1])_SOURCE_DIR"] = root_dir
         end
 
     elseif command == "cmake_minimum_required"
@@ -284,11 +420,35 @@ function process_cmake_command!(project::CMakeProject, command::String, args::Ve
         end
 
     elseif command == "set"
-        # set(VAR_NAME value)
+        # set(VAR_NAME value...) - several values make a ;-separated list, like CMake
+        # PARENT_SCOPE is not applied: subdirectories are evaluated independently
+        if length(args) >= 2 && !("PARENT_SCOPE" in args)
+            cache_idx = findfirst(==("CACHE"), args)
+            values = args[2:something(cache_idx, length(args) + 1) - 1]
+            if cache_idx === nothing
+                project.variables[args[1]] = join(values, ";")
+            else
+                # Cache entries never override a normal variable
+                get!(project.variables, args[1], join(values, ";"))
+            end
+        elseif length(args) == 1
+            delete!(project.variables, args[1])
+        end
+
+    elseif command == "unset"
+        isempty(args) || delete!(project.variables, args[1])
+
+    elseif command == "option"
+        # option(NAME "help" ON)
         if length(args) >= 2
-            var_name = args[1]
-            var_value = join(args[2:end], " ")
-            project.variables[var_name] = var_value
+            get!(project.variables, args[1], length(args) >= 3 ? args[3] : "OFF")
+        end
+
+    elseif command == "list"
+        # list(APPEND VAR values...)
+        if length(args) >= 3 && args[1] == "APPEND"
+            previous = get(project.variables, args[2], "")
+            project.variables[args[2]] = join(filter(!isempty, [previous; args[3:end]]), ";")
         end
 
     elseif command == "add_library"
@@ -567,15 +727,85 @@ function resolve_path(path::String, root_dir::String)
 end
 
 """
-Substitute CMake variables in a string
+Substitute CMake variables in a string (`${VAR}`, `$(VAR)`, `$ENV{VAR}` in one pass);
+unknown references are left as written
 """
 function substitute_variables(str::String, variables::Dict{String,String})
-    result = str
-    for (var, value) in variables
-        result = replace(result, "\${$var}" => value)
-        result = replace(result, "\$($var)" => value)
+    return expand_variables(str, variables; keep_unknown=true)
+end
+
+"""
+    expand_variables(str, variables; keep_unknown=false) -> String
+
+Expand `${VAR}`, `$ENV{VAR}` and `$(VAR)` in a single left-to-right pass over `str`,
+so the cost does not depend on how many variables are defined. Nested references
+(`${lib_${arch}}`) expand inside out. Unknown names become "" as in CMake, or stay as
+written with `keep_unknown`.
+"""
+function expand_variables(str::AbstractString, variables::AbstractDict; keep_unknown::Bool=false)
+    occursin('$', str) || return String(str)
+    out = IOBuffer()
+    i = firstindex(str)
+
+    while i <= ncodeunits(str)
+        c = str[i]
+        rest = SubString(str, i)
+        opener = c != '$' ? "" :
+                 startswith(rest, "\${") ? "\${" :
+                 startswith(rest, "\$ENV{") ? "\$ENV{" :
+                 startswith(rest, "\$(") ? "\$(" : ""
+        if isempty(opener)
+            print(out, c)
+            i = nextind(str, i)
+            continue
+        end
+
+        # Matching close, counting nested brackets of the same kind
+        open_char, close_char = last(opener) == '{' ? ('{', '}') : ('(', ')')
+        start = i + ncodeunits(opener)
+        depth = 1
+        j = start
+        while j <= ncodeunits(str)
+            str[j] == open_char && (depth += 1)
+            str[j] == close_char && (depth -= 1)
+            depth == 0 && break
+            j = nextind(str, j)
+        end
+        if depth != 0
+            print(out, rest)  # Unterminated reference: keep the text
+            break
+        end
+
+        name = expand_variables(SubString(str, start, prevind(str, j)), variables; keep_unknown=keep_unknown)
+        value = opener == "\$ENV{" ? get(ENV, name, nothing) : get(variables, name, nothing)
+        if value !== nothing
+            print(out, value)
+        elseif keep_unknown
+            print(out, SubString(str, i, j))
+        end
+        i = nextind(str, j)
+    end
+
+    return String(take!(out))
+end
+
+"""
+Expand variable references in command arguments. An argument that referenced a variable
+is split as a CMake list (on `;`), and empty elements are dropped, so `${SOURCES}` becomes
+one argument per source
+"""
+function expand_arguments(args::Vector{String}, variables::AbstractDict)
+    expanded = String[]
+    for arg in args
+        if occursin('$', arg)
+            for element in split(expand_variables(arg, variables), ';')
+                isempty(element) || push!(expanded, String(element))
+            end
+        else
+            push!(expanded, arg)
+        end
     end
-    return result
+    return expanded
 end
 
 # ============================================================================
@@ -721,6 +951,7 @@ export
 
     # Parsing
     parse_cmake_file,
+    parse_cmake_tree,
 
     # Conversion
     to_jmake_config,
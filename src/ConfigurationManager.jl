@@ -2,11 +2,13 @@
 # ConfigurationManager.jl - Unified TOML configuration management for JMake
 # Single source of truth for all build stages and component data flow
 # All modules read/write through this manager to ensure consistency
+# Bulky machine-generated stage data lives in a binary sidecar (jmake.index), not the TOML
 
 module ConfigurationManager
 
 using TOML
 using Dates
+using Mmap
 
 """
 Build stage definitions
@@ -25,6 +27,10 @@ const BUILD_STAGES = [
 
 """
 Configuration structure with stage-specific data
+
+Stage sections loaded by `load_config` are `IndexedSection`s: their bulky fields are
+decoded from `jmake.index` on first access. Any `AbstractDict{String,Any}` works as a
+stage section.
 """
 mutable struct JMakeConfig
     # Metadata
@@ -37,28 +43,28 @@ mutable struct JMakeConfig
     project_root::String
 
     # Stage: Discovery
-    discovery::Dict{String,Any}
+    discovery::AbstractDict{String,Any}
 
     # Stage: Reorganize
-    reorganize::Dict{String,Any}
+    reorganize::AbstractDict{String,Any}
 
     # Stage: Compile
-    compile::Dict{String,Any}
+    compile::AbstractDict{String,Any}
 
     # Stage: Link
-    link::Dict{String,Any}
+    link::AbstractDict{String,Any}
 
     # Stage: Binary
-    binary::Dict{String,Any}
+    binary::AbstractDict{String,Any}
 
     # Stage: Symbols
-    symbols::Dict{String,Any}
+    symbols::AbstractDict{String,Any}
 
     # Stage: Wrap
-    wrap::Dict{String,Any}
+    wrap::AbstractDict{String,Any}
 
     # Stage: Test
-    test::Dict{String,Any}
+    test::AbstractDict{String,Any}
 
     # LLVM toolchain settings
     llvm::Dict{String,Any}
@@ -76,11 +82,330 @@ mutable struct JMakeConfig
     raw_data::Dict{String,Any}
 end
 
+# Sidecar layout: magic, version, entry table, then one blob per entry
+const INDEX_MAGIC = Vector{UInt8}("JMKINDEX")
+const INDEX_FORMAT_VERSION = UInt32(1)
+
+# Stage fields holding more values than this (file lists, graphs, symbol tables) are indexed
+const INLINE_LIMIT = 64
+
+# Value tags of an index blob
+const TAG_NOTHING = 0x00
+const TAG_FALSE = 0x01
+const TAG_TRUE = 0x02
+const TAG_INT = 0x03
+const TAG_FLOAT = 0x04
+const TAG_STRING = 0x05
+const TAG_VECTOR = 0x06
+const TAG_STRINGS = 0x07
+const TAG_DICT = 0x08
+
+"""
+Memory-mapped `jmake.index`: entry name ("section.field") => (offset, length) of its blob
+"""
+struct ConfigIndex
+    path::String
+    data::Vector{UInt8}
+    entries::Dict{String,Tuple{Int,Int}}
+end
+
+"""
+Stage section backed by the index: `values` holds the TOML fields and every field read
+or assigned since loading, `pending` the indexed fields that were not decoded yet
+"""
+mutable struct IndexedSection <: AbstractDict{String,Any}
+    name::String
+    values::Dict{String,Any}
+    index::Union{ConfigIndex,Nothing}
+    pending::Set{String}
+end
+
+"""
+    index_path(config_file::String) -> String
+
+Binary sidecar of a configuration file: `jmake.toml` => `jmake.index`.
+"""
+index_path(config_file::String) = splitext(config_file)[1] * ".index"
+
+"""
+    IndexedSection(name, toml_values, index) -> IndexedSection
+
+Section `name` with its TOML fields, and the fields `index` holds for it. A field in
+both comes from the TOML, so hand edits win over the index.
+"""
+function IndexedSection(name::String, toml_values::AbstractDict, index::Union{ConfigIndex,Nothing})
+    values = Dict{String,Any}(toml_values)
+    pending = Set{String}()
+    if !isnothing(index)
+        prefix = "$name."
+        for entry in keys(index.entries)
+            startswith(entry, prefix) || continue
+            field = entry[ncodeunits(prefix)+1:end]
+            haskey(values, field) || push!(pending, field)
+        end
+    end
+    return IndexedSection(name, values, index, pending)
+end
+
+function load_field!(section::IndexedSection, field::String)
+    value = read_entry(section.index, "$(section.name).$field")
+    delete!(section.pending, field)
+    section.values[field] = value
+    return value
+end
+
+Base.length(section::IndexedSection) = length(section.values) + length(section.pending)
+Base.haskey(section::IndexedSection, field) = haskey(section.values, field) || field in section.pending
+
+function Base.get(section::IndexedSection, field, default)
+    haskey(section.values, field) && return section.values[field]
+    field in section.pending || return default
+    return load_field!(section, field)
+end
+
+Base.get(default::Base.Callable, section::IndexedSection, field) =
+    haskey(section, field) ? section[field] : default()
+
+function Base.getindex(section::IndexedSection, field)
+    haskey(section, field) || throw(KeyError(field))
+    return get(section, field, nothing)
+end
+
+function Base.setindex!(section::IndexedSection, value, field)
+    delete!(section.pending, field)
+    section.values[field] = value
+    return section
+end
+
+function Base.delete!(section::IndexedSection, field)
+    delete!(section.pending, field)
+    delete!(section.values, field)
+    return section
+end
+
+# Iterating needs every value, so the pending fields are decoded first
+function Base.iterate(section::IndexedSection, state...)
+    foreach(field -> load_field!(section, field), collect(section.pending))
+    return iterate(section.values, state...)
+end
+
+@inline function load_le(::Type{T}, data::AbstractVector{UInt8}, offset::Integer) where {T<:Unsigned}
+    v = zero(T)
+    for i in sizeof(T):-1:1
+        v = (v << 8) | T(data[offset + i])
+    end
+    return v
+end
+
+"""
+    open_index(path::String) -> Union{ConfigIndex,Nothing}
+
+Map an index and read its entry table; blobs are decoded only by `read_entry`. A
+missing file gives `nothing`, as does another format version or a damaged file (with
+a warning: the data is regenerated by the stage that wrote it).
+"""
+function open_index(path::String)
+    (isfile(path) && filesize(path) >= 16) || return nothing
+    data = Mmap.mmap(path)
+    try
+        if data[1:8] != INDEX_MAGIC || load_le(UInt32, data, 8) != INDEX_FORMAT_VERSION
+            @warn "Ignoring $path: not a version $INDEX_FORMAT_VERSION config index"
+            return nothing
+        end
+        entries = Dict{String,Tuple{Int,Int}}()
+        pos = 16
+        for _ in 1:load_le(UInt32, data, 12)
+            len = Int(load_le(UInt32, data, pos))
+            name = String(data[pos+5:pos+4+len])
+            pos += 4 + len
+            offset, size = Int(load_le(UInt64, data, pos)), Int(load_le(UInt64, data, pos + 8))
+            offset + size <= length(data) || error("entry $name out of bounds")
+            entries[name] = (offset, size)
+            pos += 16
+        end
+        return ConfigIndex(path, data, entries)
+    catch e
+        e isa BoundsError || e isa ErrorException || rethrow()
+        @warn "Ignoring damaged config index $path: $e"
+        return nothing
+    end
+end
+
+"""
+    read_entry(index::ConfigIndex, name::String)
+
+Decode one entry of the index.
+"""
+function read_entry(index::ConfigIndex, name::String)
+    offset, _ = index.entries[name]
+    return decode_blob(index.data, offset)
+end
+
+"""
+Raw bytes of an entry, copied into a new index without decoding
+"""
+function entry_bytes(index::ConfigIndex, name::String)
+    offset, size = index.entries[name]
+    return index.data[offset+1:offset+size]
+end
+
+"""
+    write_index(path::String, blobs::AbstractDict{String,Vector{UInt8}})
+
+Write an index of encoded entries (see `encode_entry`); replaced atomically, so maps of
+the previous file stay valid. Without entries the file is removed.
+"""
+function write_index(path::String, blobs::AbstractDict{String,Vector{UInt8}})
+    if isempty(blobs)
+        rm(path, force=true)
+        return
+    end
+
+    names = sort!(collect(keys(blobs)))
+    header = IOBuffer()
+    write(header, INDEX_MAGIC, htol(INDEX_FORMAT_VERSION), htol(UInt32(length(names))))
+    table_size = sum(name -> 20 + ncodeunits(name), names)
+    offset = 16 + table_size
+    for name in names
+        write(header, htol(UInt32(ncodeunits(name))), name, htol(UInt64(offset)), htol(UInt64(length(blobs[name]))))
+        offset += length(blobs[name])
+    end
+
+    mkpath(dirname(abspath(path)))
+    staged = "$path.tmp.$(getpid()).$(rand(UInt64))"
+    open(staged, "w") do io
+        write(io, take!(header))
+        foreach(name -> write(io, blobs[name]), names)
+    end
+    mv(staged, path, force=true)
+    return
+end
+
+"""
+    encode_entry(value) -> Vector{UInt8}
+
+Encode a TOML-like value (strings, numbers, booleans, vectors and string-keyed dicts;
+anything else is stored as its string) as an index blob. Strings are stored once, in a
+table in front of the value, so repeated paths in file lists and graphs cost 4 bytes.
+"""
+function encode_entry(value)
+    strings = Dict{String,UInt32}()
+    body = IOBuffer()
+    encode_value!(body, strings, value)
+
+    blob = IOBuffer()
+    write(blob, htol(UInt32(length(strings))))
+    for (s, _) in sort!(collect(strings), by=last)
+        write(blob, htol(UInt32(ncodeunits(s))), s)
+    end
+    write(blob, take!(body))
+    return take!(blob)
+end
+
+intern!(strings::Dict{String,UInt32}, s) = get!(strings, String(s), UInt32(length(strings)))
+
+function encode_value!(io::IO, strings::Dict{String,UInt32}, value)
+    if isnothing(value)
+        write(io, TAG_NOTHING)
+    elseif value isa Bool
+        write(io, value ? TAG_TRUE : TAG_FALSE)
+    elseif value isa Integer
+        write(io, TAG_INT, htol(Int64(value)))
+    elseif value isa AbstractFloat
+        write(io, TAG_FLOAT, htol(Float64(value)))
+    elseif value isa AbstractDict
+        write(io, TAG_DICT, htol(UInt32(length(value))))
+        for (k, v) in value
+            write(io, htol(intern!(strings, string(k))))
+            encode_value!(io, strings, v)
+        end
+    elseif value isa Union{AbstractVector,AbstractSet,Tuple}
+        if !isempty(value) && all(v -> v isa AbstractString, value)
+            write(io, TAG_STRINGS, htol(UInt32(length(value))))
+            foreach(s -> write(io, htol(intern!(strings, s))), value)
+        else
+            write(io, TAG_VECTOR, htol(UInt32(length(value))))
+            foreach(v -> encode_value!(io, strings, v), value)
+        end
+    else
+        write(io, TAG_STRING, htol(intern!(strings, string(value))))
+    end
+end
+
+function decode_blob(data::AbstractVector{UInt8}, offset::Int)
+    n = Int(load_le(UInt32, data, offset))
+    strings = Vector{String}(undef, n)
+    pos = offset + 4
+    for i in 1:n
+        len = Int(load_le(UInt32, data, pos))
+        strings[i] = String(data[pos+5:pos+4+len])
+        pos += 4 + len
+    end
+    value, _ = decode_value(data, pos, strings)
+    return value
+end
+
+# Returns the value at 0-based `pos` and the position after it
+function decode_value(data::AbstractVector{UInt8}, pos::Int, strings::Vector{String})
+    tag = data[pos+1]
+    pos += 1
+    string_at(p) = strings[load_le(UInt32, data, p) + 1]
+
+    if tag == TAG_NOTHING
+        return nothing, pos
+    elseif tag == TAG_FALSE || tag == TAG_TRUE
+        return tag == TAG_TRUE, pos
+    elseif tag == TAG_INT
+        return reinterpret(Int64, load_le(UInt64, data, pos)), pos + 8
+    elseif tag == TAG_FLOAT
+        return reinterpret(Float64, load_le(UInt64, data, pos)), pos + 8
+    elseif tag == TAG_STRING
+        return string_at(pos), pos + 4
+    elseif tag == TAG_STRINGS
+        n = Int(load_le(UInt32, data, pos))
+        return String[string_at(pos + 4i) for i in 1:n], pos + 4 + 4n
+    elseif tag == TAG_VECTOR
+        n = Int(load_le(UInt32, data, pos))
+        pos += 4
+        items = Vector{Any}(undef, n)
+        for i in 1:n
+            items[i], pos = decode_value(data, pos, strings)
+        end
+        return items, pos
+    elseif tag == TAG_DICT
+        n = Int(load_le(UInt32, data, pos))
+        pos += 4
+        dict = Dict{String,Any}()
+        for _ in 1:n
+            key = string_at(pos)
+            dict[key], pos = decode_value(data, pos + 4, strings)
+        end
+        return dict, pos
+    end
+    error("unknown value tag $tag at byte $(pos - 1)")
+end
+
+"""
+Whether a stage field belongs in the index: a vector or dict holding more than
+`INLINE_LIMIT` values, nested ones included
+"""
+bulky(value) = value isa Union{AbstractDict,AbstractVector} && value_budget(value, INLINE_LIMIT) < 0
+
+function value_budget(value, budget::Int)
+    value isa Union{AbstractDict,AbstractVector} || return budget
+    for item in (value isa AbstractDict ? values(value) : value)
+        budget = value_budget(item, budget - 1)
+        budget < 0 && return budget
+    end
+    return budget
+end
+
 """
     load_config(config_file::String="jmake.toml") -> JMakeConfig
 
 Load JMake configuration from TOML file.
-Creates default if not exists.
+Creates default if not exists. The stage sections keep the fields stored in
+`jmake.index` undecoded until they are first read.
 """
 function load_config(config_file::String="jmake.toml")
     if !isfile(config_file)
@@ -89,17 +414,19 @@ function load_config(config_file::String="jmake.toml")
     end
 
     data = TOML.parsefile(config_file)
+    index = open_index(index_path(config_file))
+    stage(name) = IndexedSection(name, get(data, name, Dict()), index)
 
     # Extract sections with defaults
     project = get(data, "project", Dict())
-    discovery = get(data, "discovery", Dict())
-    reorganize = get(data, "reorganize", Dict())
-    compile = get(data, "compile", Dict())
-    link = get(data, "link", Dict())
-    binary = get(data, "binary", Dict())
-    symbols = get(data, "symbols", Dict())
-    wrap = get(data, "wrap", Dict())
-    test_section = get(data, "test", Dict())
+    discovery = stage("discovery")
+    reorganize = stage("reorganize")
+    compile = stage("compile")
+    link = stage("link")
+    binary = stage("binary")
+    symbols = stage("symbols")
+    wrap = stage("wrap")
+    test_section = stage("test")
     llvm = get(data, "llvm", Dict())
     target = get(data, "target", Dict())
     workflow = get(data, "workflow", Dict())
@@ -137,6 +464,9 @@ end
 
 Save configuration back to TOML file.
 All component data flows back through this function.
+
+Bulky stage fields (see `INLINE_LIMIT`) go to `jmake.index` instead of the TOML.
+Indexed fields that were never read since loading are copied over without decoding.
 """
 function save_config(config::JMakeConfig)
     # Build TOML structure
@@ -152,30 +482,26 @@ function save_config(config::JMakeConfig)
         "root" => config.project_root
     )
 
-    # Stage-specific sections (only save non-empty)
-    if !isempty(config.discovery)
-        data["discovery"] = config.discovery
-    end
-    if !isempty(config.reorganize)
-        data["reorganize"] = config.reorganize
-    end
-    if !isempty(config.compile)
-        data["compile"] = config.compile
-    end
-    if !isempty(config.link)
-        data["link"] = config.link
-    end
-    if !isempty(config.binary)
-        data["binary"] = config.binary
-    end
-    if !isempty(config.symbols)
-        data["symbols"] = config.symbols
-    end
-    if !isempty(config.wrap)
-        data["wrap"] = config.wrap
-    end
-    if !isempty(config.test)
-        data["test"] = config.test
+    # Stage-specific sections (only save non-empty); bulky fields go to the index
+    blobs = Dict{String,Vector{UInt8}}()
+    for stage in BUILD_STAGES
+        name = string(stage)
+        section = get_stage_config(config, stage)
+        inline = Dict{String,Any}()
+        if section isa IndexedSection
+            for field in section.pending
+                blobs["$name.$field"] = entry_bytes(section.index, "$name.$field")
+            end
+            section = section.values
+        end
+        for (field, value) in section
+            if bulky(value)
+                blobs["$name.$field"] = encode_entry(value)
+            else
+                inline[field] = value
+            end
+        end
+        isempty(inline) || (data[name] = inline)
     end
 
     # System sections
@@ -192,7 +518,8 @@ function save_config(config::JMakeConfig)
         data["cache"] = config.cache
     end
 
-    # Write to file
+    # Write to file (the index first: the TOML's mtime marks a complete save)
+    write_index(index_path(config.config_file), blobs)
     open(config.config_file, "w") do io
         TOML.print(io, data)
     end
@@ -200,6 +527,27 @@ function save_config(config::JMakeConfig)
     config.last_modified = now()
 end
 
+"""
+    default_compile_section() -> Dict{String,Any}
+
+`[compile]` section of a new configuration. Also used to plan compiles (streamed
+builds) before `jmake.toml` has been written.
+"""
+function default_compile_section()
+    return Dict{String,Any}(
+        "enabled" => true,
+        "output_dir" => "build/ir",
+        "flags" => ["-std=c++17", "-fPIC"],
+        "include_dirs" => String[],  # Populated by discovery
+        "defines" => Dict{String,String}(),
+        "emit_ir" => false,  # Also dump linked modules as .ll (debugging)
+        "emit_bc" => true,   # Bitcode pipeline; false keeps textual .ll at every stage
+        "pch" => false,      # Precompile the headers most TUs include (compile_parallel)
+        "pch_threshold" => 0.5,
+        "parallel" => true
+    )
+end
+
 """
     create_default_config(config_file::String) -> JMakeConfig
 
@@ -243,16 +591,7 @@ function create_default_config(config_file::String)
             )
         ),
         # Compile stage
-        Dict{String,Any}(
-            "enabled" => true,
-            "output_dir" => "build/ir",
-            "flags" => ["-std=c++17", "-fPIC"],
-            "include_dirs" => String[],  # Populated by discovery
-            "defines" => Dict{String,String}(),
-            "emit_ir" => true,
-            "emit_bc" => false,
-            "parallel" => true
-        ),
+        default_compile_section(),
         # Link stage
         Dict{String,Any}(
             "enabled" => true,
@@ -540,8 +879,8 @@ function print_config_summary(config::JMakeConfig)
 end
 
 # Exports
-export JMakeConfig, BUILD_STAGES,
-       load_config, save_config, create_default_config,
+export JMakeConfig, BUILD_STAGES, IndexedSection,
+       load_config, save_config, create_default_config, index_path,
        update_discovery_data, update_compile_data, update_link_data,
        update_binary_data, update_symbols_data, update_wrap_data,
        get_stage_config, is_stage_enabled,
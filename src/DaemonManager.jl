@@ -16,6 +16,9 @@ module DaemonManager
 using Distributed
 using Sockets
 
+# Sibling module: JMake includes DaemonRPC before this file
+using ..DaemonRPC
+
 # Optional DaemonMode support
 const DAEMONMODE_AVAILABLE = Ref(false)
 
@@ -347,16 +350,9 @@ end
 """
     call_daemon(system::DaemonSystem, daemon::String, func::String, args::Dict)
 
-Call a function on a specific daemon (requires DaemonMode integration).
+Call a function on a specific daemon over DaemonRPC.
 """
 function call_daemon(system::DaemonSystem, daemon::String, func::String, args::Dict)
-    if !DAEMONMODE_AVAILABLE[]
-        return Dict(
-            :success => false,
-            :error => "DaemonMode not available. Install it with: Pkg.add(url=\"https://github.com/dmolina/DaemonMode.jl\")"
-        )
-    end
-
     if !haskey(system.daemons, daemon)
         return Dict(
             :success => false,
@@ -373,23 +369,12 @@ function call_daemon(system::DaemonSystem, daemon::String, func::String, args::D
         )
     end
 
-    try
-        # Build expression
-        expr = Meta.parse("$func($args)")
-
-        # Call daemon via DaemonMode
-        result = @eval DaemonMode.runexpr($expr, port=$(info.port))
-
-        return result
-
-    catch e
-        return Dict(
-            :success => false,
-            :error => "Daemon call failed: $e",
-            :daemon => daemon,
-            :port => info.port
-        )
+    # Typed RPC on the daemon's listener (port + RPC_PORT_OFFSET); failures come back as Dicts
+    result = DaemonRPC.call(info.port, func, args)
+    if result isa Dict && get(result, :success, true) == false
+        result[:daemon] = daemon
     end
+    return result
 end
 
 """
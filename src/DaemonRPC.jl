@@ -0,0 +1,748 @@
+#!/usr/bin/env julia
+# DaemonRPC.jl - Typed request/response protocol for daemon-to-daemon calls
+# Length-prefixed frames over persistent, multiplexed TCP connections, with progress
+# events streamed back before the final response. Frames carry no JMake types, so
+# every copy of this file (JMake's, the CLI's own include) speaks to every other
+# Services registered in the calling process are invoked directly (no socket, no copy)
+# Services other hosts call use a separate data-only, token-checked listener (serve_remote)
+# Self-contained (stdlib only, plus Tracing.jl next to it) so lightweight clients can
+# include it without JMake
+
+module DaemonRPC
+
+using Sockets
+using Serialization
+
+include("Tracing.jl")
+
+# Service ports (DaemonMode `runexpr` keeps working on these for CLI use)
+const SERVICE_PORTS = Dict(
+    "discovery" => 3001,
+    "setup" => 3002,
+    "compilation" => 3003,
+    "orchestrator" => 3004,
+    "error" => 3005,
+    "watcher" => 3006,
+    "build" => 3007
+)
+
+# The RPC listener of a service sits at its service port + this offset
+const RPC_PORT_OFFSET = 100
+
+# Bump when the frame layout or message types change
+const PROTOCOL_VERSION = UInt8(2)
+
+# Frames larger than this are treated as a corrupt stream
+const MAX_FRAME_BYTES = 1 << 30
+
+# Connections kept per service; requests are multiplexed on each one
+const MAX_CONNECTIONS_PER_SERVICE = 4
+
+"""
+Call of `func(args)` on a service
+"""
+struct Request
+    id::UInt64
+    func::Symbol
+    args::Dict{String,Any}
+end
+
+"""
+Final result of a request; `error` is set when the call did not run or threw
+"""
+struct Response
+    id::UInt64
+    result::Any
+    error::Union{String,Nothing}
+end
+
+"""
+Intermediate event emitted by a handler through `progress`
+"""
+struct Progress
+    id::UInt64
+    event::Dict{String,Any}
+end
+
+# ============================================================================
+# FRAMING
+# ============================================================================
+
+# Frame kinds
+const FRAME_REQUEST = 0x01
+const FRAME_RESPONSE = 0x02
+const FRAME_PROGRESS = 0x03
+
+"""
+Frame whose body could not be decoded (or of an unknown kind); `id` is still known
+"""
+struct InvalidFrame
+    kind::UInt8
+    id::UInt64
+    reason::String
+end
+
+"""
+    write_frame(io::IO, message::Union{Request,Response,Progress})
+
+One frame: protocol version byte, little-endian UInt32 length, then the frame kind
+byte, the little-endian UInt64 request id and the serialized body. The body holds
+only the message fields, never the `Request`/`Response`/`Progress` types themselves:
+those differ between separately included copies of this module.
+"""
+function write_frame(io::IO, message::Union{Request,Response,Progress})
+    buffer = IOBuffer()
+    serialize(buffer, frame_body(message))
+    payload = take!(buffer)
+
+    frame = IOBuffer(sizehint=length(payload) + 14)
+    write(frame, PROTOCOL_VERSION, htol(UInt32(length(payload) + 9)), frame_kind(message),
+          htol(message.id), payload)
+    write(io, take!(frame))
+    return nothing
+end
+
+frame_kind(::Request) = FRAME_REQUEST
+frame_kind(::Response) = FRAME_RESPONSE
+frame_kind(::Progress) = FRAME_PROGRESS
+
+frame_body(r::Request) = (r.func, r.args)
+frame_body(r::Response) = (r.result, r.error)
+frame_body(p::Progress) = p.event
+
+"""
+    read_frame(io::IO) -> Union{Request,Response,Progress,InvalidFrame}
+
+A frame whose body does not decode (e.g. it names a type this process lacks) is
+returned as `InvalidFrame`, so the reader can still answer or fail that request.
+"""
+function read_frame(io::IO)
+    version = read(io, UInt8)
+    version == PROTOCOL_VERSION || error("RPC protocol $version != $PROTOCOL_VERSION")
+
+    len = ltoh(read(io, UInt32))
+    9 <= len <= MAX_FRAME_BYTES || error("RPC frame of $len bytes out of bounds")
+    kind = read(io, UInt8)
+    id = ltoh(read(io, UInt64))
+    payload = read(io, len - 9)
+    length(payload) == len - 9 || throw(EOFError())
+
+    body = try
+        deserialize(IOBuffer(payload))
+    catch e
+        return InvalidFrame(kind, id, "Cannot decode RPC frame: $(sprint(showerror, e))")
+    end
+
+    if kind == FRAME_REQUEST && body isa Tuple{Symbol,Dict{String,Any}}
+        return Request(id, body...)
+    elseif kind == FRAME_RESPONSE && body isa Tuple{Any,Union{String,Nothing}}
+        return Response(id, body...)
+    elseif kind == FRAME_PROGRESS && body isa Dict{String,Any}
+        return Progress(id, body)
+    end
+    return InvalidFrame(kind, id, "Malformed RPC frame of kind $kind")
+end
+
+# ============================================================================
+# SERVICES
+# ============================================================================
+
+# Handlers of services living in this process: service port => func => handler
+const LOCAL_SERVICES = Dict{Int,Dict{Symbol,Function}}()
+const LOCAL_LOCK = ReentrantLock()
+
+"""
+    register_service(port::Int, handlers) -> Dict{Symbol,Function}
+
+Make `handlers` (functions, or `name => function` pairs) callable in-process for
+`port`. Calls to that port from this process skip the socket entirely.
+Every service also answers `:ping` and `:trace` (see `trace_request`).
+"""
+function register_service(port::Int, handlers)
+    table = handler_table(handlers)
+    lock(() -> LOCAL_SERVICES[port] = table, LOCAL_LOCK)
+    return table
+end
+
+function handler_table(handlers)
+    table = Dict{Symbol,Function}(:ping => _ -> :pong, :trace => trace_request)
+    for h in handlers
+        if h isa Pair
+            table[Symbol(h.first)] = h.second
+        else
+            table[nameof(h)] = h
+        end
+    end
+    return table
+end
+
+"""
+    serve_rpc(port::Int, handlers; host=ip"127.0.0.1") -> Sockets.TCPServer
+
+Listen on `port + RPC_PORT_OFFSET` and serve `handlers` without blocking. Each
+request runs in its own task, so one connection carries many concurrent calls.
+"""
+function serve_rpc(port::Int, handlers; host=ip"127.0.0.1")
+    table = handlers isa Dict{Symbol,Function} ? handlers : handler_table(handlers)
+    server = listen(host, port + RPC_PORT_OFFSET)
+
+    @async while isopen(server)
+        socket = try
+            accept(server)
+        catch
+            break
+        end
+        @async serve_connection(socket, table)
+    end
+    return server
+end
+
+"""
+    start_service(port::Int, handlers; host=ip"127.0.0.1") -> Sockets.TCPServer
+
+`register_service` plus `serve_rpc`: what a daemon calls before DaemonMode's `serve`.
+"""
+function start_service(port::Int, handlers; host=ip"127.0.0.1")
+    table = register_service(port, handlers)
+    server = serve_rpc(port, table; host=host)
+    println("[RPC] Listening on $(host):$(port + RPC_PORT_OFFSET) ($(length(table)) functions)")
+    return server
+end
+
+function serve_connection(socket::TCPSocket, table::Dict{Symbol,Function})
+    write_lock = ReentrantLock()
+    send(message) = lock(() -> write_frame(socket, message), write_lock)
+
+    try
+        while isopen(socket)
+            request = read_frame(socket)
+            if request isa Request
+                @async send(handle_request(table, request, send))
+            else
+                # Answer instead of dropping it, so the caller does not wait forever
+                reason = request isa InvalidFrame ? request.reason : "Unexpected RPC frame: $(typeof(request))"
+                send(Response(request.id, nothing, reason))
+            end
+        end
+    catch e
+        e isa EOFError || e isa Base.IOError || println("[RPC] Connection error: $e")
+    finally
+        close(socket)
+    end
+end
+
+"""
+Run one request against a handler table; progress events go through `emit`
+"""
+function handle_request(table::Dict{Symbol,Function}, request::Request, emit::Function)
+    handler = get(table, request.func, nothing)
+    if handler === nothing
+        return Response(request.id, nothing, "Unknown function: $(request.func)")
+    end
+
+    try
+        result = with_progress(event -> emit(Progress(request.id, event))) do
+            Tracing.span(() -> handler(request.args), "serve:$(request.func)"; cat="rpc")
+        end
+        return Response(request.id, result, nothing)
+    catch e
+        return Response(request.id, nothing, sprint(showerror, e, catch_backtrace()))
+    end
+end
+
+"""
+    trace_request(args) -> Dict
+
+Built-in `:trace` handler: `"enable" => true/false` switches span recording in the
+service process, `"path"` writes the Chrome trace there, and `"reset" => true` then
+drops what was recorded. Returns the cache counters (as they were before a reset).
+"""
+function trace_request(args::AbstractDict)
+    enable = get(args, "enable", nothing)
+    enable === nothing || (enable ? Tracing.enable!() : Tracing.disable!())
+
+    path = get(args, "path", "")
+    isempty(path) || Tracing.write_trace(path)
+    counters = Tracing.counters()
+    get(args, "reset", false) && Tracing.reset!()
+    return Dict(:success => true, :enabled => Tracing.enabled(), :path => path,
+                :counters => Dict(cache => Dict("hits" => h, "misses" => m) for (cache, (h, m)) in counters))
+end
+
+# ============================================================================
+# PROGRESS
+# ============================================================================
+
+"""
+    with_progress(f, sink::Function)
+
+Run `f` with `sink` receiving every `progress` event emitted from this task.
+"""
+function with_progress(f::Function, sink::Function)
+    return task_local_storage(f, :jmake_rpc_progress, sink)
+end
+
+"""
+    progress(event::AbstractDict)
+
+Stream an event to the caller of the current request. A no-op outside an RPC call
+(e.g. under DaemonMode `runexpr`), so handlers can emit unconditionally.
+"""
+function progress(event::AbstractDict)
+    sink = get(task_local_storage(), :jmake_rpc_progress, nothing)
+    sink === nothing && return nothing
+    try
+        sink(Dict{String,Any}(string(k) => v for (k, v) in event))
+    catch e
+        @debug "Dropped progress event: $e"
+    end
+    return nothing
+end
+
+# ============================================================================
+# CLIENT
+# ============================================================================
+
+"""
+Persistent client connection; one reader task routes frames to the waiting calls
+"""
+mutable struct Connection
+    socket::TCPSocket
+    write_lock::ReentrantLock
+    lock::ReentrantLock
+    inboxes::Dict{UInt64,Channel{Any}}
+end
+
+const CONNECTIONS = Dict{Tuple{String,Int},Vector{Connection}}()  # (host, port) => pool
+const POOL_LOCK = ReentrantLock()
+const NEXT_ID = Threads.Atomic{UInt64}(1)
+
+function open_connection(host::String, port::Int)
+    socket = connect(host, port + RPC_PORT_OFFSET)
+    Sockets.nagle(socket, false)
+    conn = Connection(socket, ReentrantLock(), ReentrantLock(), Dict{UInt64,Channel{Any}}())
+
+    @async try
+        while isopen(socket)
+            message = read_frame(socket)
+            message isa InvalidFrame && (message = Response(message.id, nothing, message.reason))
+            inbox = lock(() -> get(conn.inboxes, message.id, nothing), conn.lock)
+            inbox === nothing || put!(inbox, message)
+        end
+    catch
+    finally
+        drop_connection!(host, port, conn)
+    end
+    return conn
+end
+
+"""
+Fail every call waiting on a broken connection and remove it from the pool
+"""
+function drop_connection!(host::String, port::Int, conn::Connection)
+    close(conn.socket)
+    lock(POOL_LOCK) do
+        pool = get(CONNECTIONS, (host, port), Connection[])
+        filter!(c -> c !== conn, pool)
+    end
+    lock(conn.lock) do
+        for (id, inbox) in conn.inboxes
+            put!(inbox, Response(id, nothing, "Connection to port $port closed"))
+        end
+    end
+end
+
+"""
+Least-loaded pooled connection; a new one is opened while all are busy and the pool has room
+"""
+function checkout(host::String, port::Int)
+    lock(POOL_LOCK) do
+        pool = get!(CONNECTIONS, (host, port), Connection[])
+        filter!(c -> isopen(c.socket), pool)
+
+        load(c) = lock(() -> length(c.inboxes), c.lock)
+        best = isempty(pool) ? nothing : argmin(load, pool)
+        if best === nothing || (load(best) > 0 && length(pool) < MAX_CONNECTIONS_PER_SERVICE)
+            best = open_connection(host, port)
+            push!(pool, best)
+        end
+        return best
+    end
+end
+
+"""
+    call(port::Int, func, args::AbstractDict=Dict(); host="127.0.0.1",
+         timeout::Real=Inf, on_progress::Union{Function,Nothing}=nothing)
+
+Call `func(args)` on the service at `port` and return its result. Services registered
+in this process are called directly. Progress events are passed to `on_progress` as
+they arrive. Transport failures, timeouts and handler exceptions come back as
+`Dict(:success => false, :error => ...)`, like a failing handler would report them.
+"""
+function call(port::Int, func, args::AbstractDict=Dict{String,Any}(); host::String="127.0.0.1",
+              timeout::Real=Inf, on_progress::Union{Function,Nothing}=nothing)
+    Tracing.enabled() || return call_service(port, func, args, host, timeout, on_progress)
+    return Tracing.span(() -> call_service(port, func, args, host, timeout, on_progress), "rpc:$func";
+                        cat="rpc", port=port)
+end
+
+function call_service(port::Int, func, args::AbstractDict, host::String, timeout::Real,
+                      on_progress::Union{Function,Nothing})
+    request_args = Dict{String,Any}(string(k) => v for (k, v) in args)
+    func = Symbol(func)
+
+    handlers = lock(() -> get(LOCAL_SERVICES, port, nothing), LOCAL_LOCK)
+    if handlers !== nothing
+        return call_local(handlers, func, request_args, on_progress)
+    end
+
+    conn = try
+        checkout(host, port)
+    catch e
+        return Dict(:success => false, :error => "Cannot reach service on port $port: $e", :port => port)
+    end
+
+    id = Threads.atomic_add!(NEXT_ID, UInt64(1))
+    inbox = Channel{Any}(Inf)
+    lock(() -> conn.inboxes[id] = inbox, conn.lock)
+
+    timer = isfinite(timeout) ?
+        Timer(_ -> put!(inbox, Response(id, nothing, "Timed out after $(timeout)s")), timeout) : nothing
+
+    try
+        lock(() -> write_frame(conn.socket, Request(id, func, request_args)), conn.write_lock)
+
+        while true
+            message = take!(inbox)
+            if message isa Progress
+                on_progress === nothing || on_progress(message.event)
+            elseif message isa Response
+                message.error === nothing && return message.result
+                return Dict(:success => false, :error => message.error, :port => port)
+            end
+        end
+    catch e
+        drop_connection!(host, port, conn)
+        return Dict(:success => false, :error => "RPC to port $port failed: $e", :port => port)
+    finally
+        timer === nothing || close(timer)
+        lock(() -> delete!(conn.inboxes, id), conn.lock)
+    end
+end
+
+"""
+    call(service::String, func, args::AbstractDict=Dict(); kwargs...)
+
+Same as `call(SERVICE_PORTS[service], func, args)`.
+"""
+function call(service::String, func, args::AbstractDict=Dict{String,Any}(); kwargs...)
+    port = get(SERVICE_PORTS, service, 0)
+    port == 0 && return Dict(:success => false, :error => "Unknown daemon: $service")
+    return call(port, func, args; kwargs...)
+end
+
+function call_local(handlers::Dict{Symbol,Function}, func::Symbol, args::Dict{String,Any},
+                    on_progress::Union{Function,Nothing})
+    handler = get(handlers, func, nothing)
+    handler === nothing && return Dict(:success => false, :error => "Unknown function: $func")
+
+    try
+        return on_progress === nothing ? handler(args) : with_progress(() -> handler(args), on_progress)
+    catch e
+        return Dict(:success => false, :error => sprint(showerror, e, catch_backtrace()))
+    end
+end
+
+"""
+    ping(port::Int; host="127.0.0.1", timeout::Real=2.0) -> Bool
+
+True when the service answers (every service handles `:ping`).
+"""
+function ping(port::Int; host::String="127.0.0.1", timeout::Real=2.0)
+    result = call(port, :ping; host=host, timeout=timeout)
+    return result === :pong
+end
+
+"""
+    close_connections()
+
+Close every pooled client connection.
+"""
+function close_connections()
+    pools = lock(() -> collect(values(CONNECTIONS)), POOL_LOCK)
+    for pool in pools, conn in copy(pool)
+        close(conn.socket)
+    end
+    lock(() -> empty!(CONNECTIONS), POOL_LOCK)
+end
+
+# ============================================================================
+# REMOTE SERVICES
+# ============================================================================
+# The listener above is for daemons on the same host: frames are Serialization
+# payloads, which can run code when deserialized. A service that other hosts may call
+# uses this one instead: data-only frames (no types, no closures) and a shared-secret
+# token checked before anything else in the frame is decoded.
+
+# The remote listener of a service sits at its service port + this offset
+const REMOTE_PORT_OFFSET = 200
+
+# Bump when the remote frame layout or value encoding changes
+const REMOTE_PROTOCOL_VERSION = UInt8(1)
+
+# Bounds for frames and values from unauthenticated peers
+const MAX_REMOTE_FRAME_BYTES = 1 << 28
+const MAX_VALUE_DEPTH = 32
+
+# Value tags of the data-only encoding
+const VALUE_NOTHING = 0x00
+const VALUE_FALSE = 0x01
+const VALUE_TRUE = 0x02
+const VALUE_INT = 0x03
+const VALUE_FLOAT = 0x04
+const VALUE_STRING = 0x05
+const VALUE_SYMBOL = 0x06
+const VALUE_BYTES = 0x07
+const VALUE_VECTOR = 0x08
+const VALUE_DICT = 0x09
+
+"""
+    encode_value(io::IO, value)
+
+Write `value` as nothing, Bool, Int64, Float64, String, Symbol, bytes, vector or dict
+of those. Anything else is sent as its `string` form.
+"""
+function encode_value(io::IO, value)
+    if value === nothing
+        write(io, VALUE_NOTHING)
+    elseif value isa Bool
+        write(io, value ? VALUE_TRUE : VALUE_FALSE)
+    elseif value isa Integer
+        write(io, VALUE_INT, htol(Int64(value)))
+    elseif value isa AbstractFloat
+        write(io, VALUE_FLOAT, htol(Float64(value)))
+    elseif value isa Symbol
+        encode_text(io, VALUE_SYMBOL, String(value))
+    elseif value isa AbstractString
+        encode_text(io, VALUE_STRING, String(value))
+    elseif value isa AbstractVector{UInt8}
+        write(io, VALUE_BYTES, htol(UInt32(length(value))), value)
+    elseif value isa AbstractVector || value isa Tuple
+        write(io, VALUE_VECTOR, htol(UInt32(length(value))))
+        foreach(v -> encode_value(io, v), value)
+    elseif value isa AbstractDict
+        write(io, VALUE_DICT, htol(UInt32(length(value))))
+        for (k, v) in value
+            encode_value(io, k isa Symbol ? k : string(k))
+            encode_value(io, v)
+        end
+    else
+        encode_text(io, VALUE_STRING, string(value))
+    end
+    return nothing
+end
+
+encode_text(io::IO, tag::UInt8, text::String) = write(io, tag, htol(UInt32(ncodeunits(text))), text)
+
+"""
+    decode_value(io::IO, depth::Int=0)
+
+Read one value written by `encode_value`. Unknown tags, truncated input and nesting
+deeper than `MAX_VALUE_DEPTH` are errors.
+"""
+function decode_value(io::IO, depth::Int=0)
+    depth <= MAX_VALUE_DEPTH || error("RPC value nested deeper than $MAX_VALUE_DEPTH")
+    tag = read(io, UInt8)
+    tag == VALUE_NOTHING && return nothing
+    tag == VALUE_FALSE && return false
+    tag == VALUE_TRUE && return true
+    tag == VALUE_INT && return ltoh(read(io, Int64))
+    tag == VALUE_FLOAT && return ltoh(read(io, Float64))
+    tag == VALUE_STRING && return String(read_exactly(io))
+    tag == VALUE_SYMBOL && return Symbol(String(read_exactly(io)))
+    tag == VALUE_BYTES && return read_exactly(io)
+    if tag == VALUE_VECTOR
+        n = ltoh(read(io, UInt32))
+        n <= bytesavailable(io) || error("RPC vector of $n items exceeds frame")
+        return Any[decode_value(io, depth + 1) for _ in 1:n]
+    elseif tag == VALUE_DICT
+        n = ltoh(read(io, UInt32))
+        n <= bytesavailable(io) || error("RPC dict of $n entries exceeds frame")
+        dict = Dict{Any,Any}()
+        for _ in 1:n
+            key = decode_value(io, depth + 1)
+            key isa Union{String,Symbol} || error("RPC dict key of type $(typeof(key))")
+            dict[key] = decode_value(io, depth + 1)
+        end
+        # Requests carry String keys, handler results Symbol keys
+        all(k -> k isa String, keys(dict)) && return Dict{String,Any}(dict)
+        all(k -> k isa Symbol, keys(dict)) && return Dict{Symbol,Any}(dict)
+        return dict
+    end
+    error("Unknown RPC value tag $tag")
+end
+
+function read_exactly(io::IO)
+    n = ltoh(read(io, UInt32))
+    n <= bytesavailable(io) || error("RPC value of $n bytes exceeds frame")
+    return read(io, n)
+end
+
+"""
+    write_remote_frame(io::IO, token::String, message::AbstractDict)
+
+One remote frame: protocol version byte, little-endian UInt32 payload length, then the
+token and the message as data-only values.
+"""
+function write_remote_frame(io::IO, token::String, message::AbstractDict)
+    payload = IOBuffer()
+    encode_value(payload, token)
+    encode_value(payload, message)
+    bytes = take!(payload)
+
+    frame = IOBuffer(sizehint=length(bytes) + 5)
+    write(frame, REMOTE_PROTOCOL_VERSION, htol(UInt32(length(bytes))), bytes)
+    write(io, take!(frame))
+    return nothing
+end
+
+"""
+    read_remote_frame(io::IO) -> (token, payload::IOBuffer)
+
+The token is decoded; the rest of the frame stays undecoded until the caller has
+checked it.
+"""
+function read_remote_frame(io::IO)
+    version = read(io, UInt8)
+    version == REMOTE_PROTOCOL_VERSION || error("Remote RPC protocol $version != $REMOTE_PROTOCOL_VERSION")
+
+    len = ltoh(read(io, UInt32))
+    len <= MAX_REMOTE_FRAME_BYTES || error("Remote RPC frame of $len bytes exceeds limit")
+    payload = IOBuffer(read(io, len))
+    token = decode_value(payload, MAX_VALUE_DEPTH)
+    token isa String || error("Remote RPC frame without token")
+    return token, payload
+end
+
+"""
+Compare tokens in time independent of where they differ
+"""
+function token_matches(given::String, expected::String)
+    a, b = codeunits(given), codeunits(expected)
+    length(a) == length(b) || return false
+    diff = 0x00
+    for i in eachindex(a, b)
+        diff |= a[i] ⊻ b[i]
+    end
+    return diff == 0x00
+end
+
+"""
+    serve_remote(port::Int, handlers; token::String, host=ip"0.0.0.0") -> Sockets.TCPServer
+
+Listen on `port + REMOTE_PORT_OFFSET` for calls from other hosts. Only `handlers` (and
+`:ping`) are served, only to callers presenting `token`; a wrong token closes the
+connection. Refuses to start without a token.
+"""
+function serve_remote(port::Int, handlers; token::String, host=ip"0.0.0.0")
+    isempty(token) && error("A remote service needs a shared token")
+    table = Dict{Symbol,Function}(:ping => _ -> :pong)
+    for h in handlers
+        h isa Pair ? (table[Symbol(h.first)] = h.second) : (table[nameof(h)] = h)
+    end
+    server = listen(host, port + REMOTE_PORT_OFFSET)
+
+    @async while isopen(server)
+        socket = try
+            accept(server)
+        catch
+            break
+        end
+        @async serve_remote_connection(socket, table, token)
+    end
+    println("[RPC] Remote listener on $(host):$(port + REMOTE_PORT_OFFSET) ($(length(table)) functions)")
+    return server
+end
+
+function serve_remote_connection(socket::TCPSocket, table::Dict{Symbol,Function}, token::String)
+    write_lock = ReentrantLock()
+    send(message) = lock(() -> write_remote_frame(socket, "", message), write_lock)
+
+    try
+        while isopen(socket)
+            given, payload = read_remote_frame(socket)
+            if !token_matches(given, token)
+                send(Dict("id" => 0, "result" => nothing, "error" => "Invalid token"))
+                break
+            end
+            message = decode_value(payload)
+            message isa Dict{String,Any} || break
+            id = get(message, "id", 0)
+            func = get(message, "func", "")
+            args = get(message, "args", Dict{String,Any}())
+            (id isa Int64 && func isa String && args isa Dict{String,Any}) || break
+            @async send(remote_response(table, id, Symbol(func), args))
+        end
+    catch e
+        e isa EOFError || e isa Base.IOError || println("[RPC] Remote connection error: $e")
+    finally
+        close(socket)
+    end
+end
+
+function remote_response(table::Dict{Symbol,Function}, id::Int64, func::Symbol, args::Dict{String,Any})
+    handler = get(table, func, nothing)
+    handler === nothing && return Dict("id" => id, "result" => nothing, "error" => "Unknown function: $func")
+    try
+        result = Tracing.span(() -> handler(args), "serve:$func"; cat="rpc")
+        return Dict("id" => id, "result" => result, "error" => nothing)
+    catch e
+        # The stack trace stays on this host
+        return Dict("id" => id, "result" => nothing, "error" => sprint(showerror, e))
+    end
+end
+
+"""
+    call_remote(host::String, port::Int, func, args::AbstractDict=Dict(); token::String,
+                timeout::Real=60.0)
+
+Call `func(args)` on the remote service of `port` at `host`. Arguments and results
+must be data (see `encode_value`). Failures come back as
+`Dict(:success => false, :error => ...)`, as with `call`.
+"""
+function call_remote(host::String, port::Int, func, args::AbstractDict=Dict{String,Any}();
+                     token::String, timeout::Real=60.0)
+    return Tracing.span("rpc:$func"; cat="rpc", port=port, host=host) do
+        socket = try
+            connect(host, port + REMOTE_PORT_OFFSET)
+        catch e
+            return Dict(:success => false, :error => "Cannot reach $host:$port: $e", :port => port)
+        end
+        Sockets.nagle(socket, false)
+        timed_out = Ref(false)
+        timer = Timer(_ -> (timed_out[] = true; close(socket)), timeout)
+        try
+            request = Dict{String,Any}("id" => 1, "func" => string(func),
+                                       "args" => Dict{String,Any}(string(k) => v for (k, v) in args))
+            write_remote_frame(socket, token, request)
+            _, payload = read_remote_frame(socket)
+            response = decode_value(payload)
+            response isa Dict{String,Any} || error("malformed response")
+            error_message = get(response, "error", nothing)
+            error_message === nothing && return response["result"]
+            return Dict(:success => false, :error => String(error_message), :port => port)
+        catch e
+            reason = timed_out[] ? "Timed out after $(timeout)s" : "$e"
+            return Dict(:success => false, :error => "Remote RPC to $host:$port failed: $reason", :port => port)
+        finally
+            close(timer)
+            close(socket)
+        end
+    end
+end
+
+# Exports (call/progress/ping stay qualified: DaemonRPC.call(...))
+export SERVICE_PORTS, RPC_PORT_OFFSET, REMOTE_PORT_OFFSET,
+       start_service, register_service, serve_rpc, serve_remote
+
+end # module DaemonRPC
@@ -6,15 +6,20 @@
 module Discovery
 
 using Dates
+using JSON
+using TOML
 
 # Import sibling modules
 include("LLVMEnvironment.jl")
 include("ConfigurationManager.jl")
 include("ASTWalker.jl")
+include("BuildCache.jl")
+include("Tracing.jl")
 
 using .LLVMEnvironment
 using .ConfigurationManager
 using .ASTWalker
+using .BuildCache
 
 # Use LLVMEnvironment to get correct LLVM path
 function get_jmake_llvm_root()
@@ -94,12 +99,12 @@ function discover(target_dir::String=pwd(); force::Bool=false)
 
     # Stage 1: Scan files
     println("📂 Stage 1: Scanning files...")
-    scan_results = scan_all_files(target_dir)
+    scan_results = Tracing.span(() -> scan_all_files(target_dir), "discover:scan")
     print_scan_summary(scan_results)
 
     # Stage 2: Detect binaries
     println("\n🔍 Stage 2: Detecting binaries...")
-    binaries = detect_all_binaries(target_dir, scan_results)
+    binaries = Tracing.span(() -> detect_all_binaries(target_dir, scan_results), "discover:binaries")
     print_binary_summary(binaries)
 
     # Stage 3: Build include directories
@@ -109,11 +114,13 @@ function discover(target_dir::String=pwd(); force::Bool=false)
 
     # Stage 4: Walk AST dependencies
     println("\n🌳 Stage 4: Walking AST dependencies...")
-    dep_graph = walk_dependencies(target_dir, scan_results, include_dirs)
+    dep_graph = Tracing.span(() -> walk_dependencies(target_dir, scan_results, include_dirs), "discover:dependencies")
 
     # Stage 5: Generate configuration
     println("\n📝 Stage 5: Generating jmake.toml...")
-    config = generate_config(target_dir, scan_results, binaries, include_dirs, dep_graph)
+    config = Tracing.span("discover:config") do
+        generate_config(target_dir, scan_results, binaries, include_dirs, dep_graph)
+    end
     ConfigurationManager.save_config(config)
 
     println("\n✅ Discovery complete!")
@@ -134,101 +141,297 @@ function check_marker(target_dir::String)
     return isfile(marker_path)
 end
 
+# ============================================================================
+# FILE SCAN
+# ============================================================================
+
+# Directories never descended into
+const SKIP_DIRS = Set(["build", ".git", ".cache", "node_modules", ".jmake_cache"])
+
+# Bytes of a .h file inspected when deciding between C and C++
+const HEADER_SNIFF_BYTES = 16 * 1024
+
+# Bump when the scan index layout or the classification rules change
+const SCAN_INDEX_VERSION = 1
+
+const CPP_HEADER_REGEX = r"\bclass\s+\w+|\bnamespace\s+\w+|\btemplate\s*<|::\w+|\bvirtual\s+|\boverride\b|\bconstexpr\b"
+
+const ELF_MAGIC = UInt8[0x7f, 0x45, 0x4c, 0x46]
+
+"""
+Cached classification of one file
+"""
+struct ScanEntry
+    name::String
+    category::Symbol    # ScanResults field the file belongs to
+    mtime::Float64
+end
+
+"""
+Cached listing of one directory, valid while the directory mtime is unchanged
+"""
+struct DirIndex
+    mtime::Float64
+    subdirs::Vector{String}
+    files::Vector{ScanEntry}
+end
+
 """
-    scan_all_files(root_dir::String) -> ScanResults
+    scan_all_files(root_dir::String; use_index::Bool=true,
+                   on_directory::Union{Function,Nothing}=nothing) -> ScanResults
 
 Scan directory and categorize all files by type.
+
+Directories are listed in parallel, one breadth-first level at a time, across
+`Threads.nthreads()` threads. The listing is persisted in `.jmake_cache/scan_index.json`;
+on a rescan a directory whose mtime is unchanged is not re-listed, only its
+content-sniffed files (`.h` and extensionless) are re-checked when their own mtime moved.
+Results are in the same top-down order as `walkdir`.
+
+`on_directory(rel_dir, listing::DirIndex)` is called for each directory as soon as its
+level has been listed, so consumers can start on a file before the walk has finished.
 """
-function scan_all_files(root_dir::String)
-    cpp_sources = String[]
-    cpp_headers = String[]
-    c_sources = String[]
-    c_headers = String[]
-    binaries = String[]
-    static_libs = String[]
-    shared_libs = String[]
-    julia_files = String[]
-    config_files = String[]
-    docs = String[]
-    other = String[]
+function scan_all_files(root_dir::String; use_index::Bool=true,
+                        on_directory::Union{Function,Nothing}=nothing)
+    index_path = joinpath(root_dir, ".jmake_cache", "scan_index.json")
+    old_index = use_index ? load_scan_index(index_path, root_dir) : Dict{String,DirIndex}()
+
+    new_index = Dict{String,DirIndex}()
+    frontier = [""]
+    changed = false
+
+    while !isempty(frontier)
+        listings = Vector{Tuple{DirIndex,Bool}}(undef, length(frontier))
+        Threads.@threads :dynamic for i in eachindex(frontier)
+            listings[i] = scan_directory(root_dir, frontier[i], get(old_index, frontier[i], nothing))
+        end
+
+        next_frontier = String[]
+        for (rel_dir, (listing, rescanned)) in zip(frontier, listings)
+            new_index[rel_dir] = listing
+            changed |= rescanned
+            on_directory === nothing || on_directory(rel_dir, listing)
+            for sub in listing.subdirs
+                push!(next_frontier, isempty(rel_dir) ? sub : joinpath(rel_dir, sub))
+            end
+        end
+        frontier = next_frontier
+    end
+    changed |= length(new_index) != length(old_index)
+
+    if use_index && changed
+        save_scan_index(index_path, root_dir, new_index)
+    end
+
+    return assemble_scan_results(new_index)
+end
+
+"""
+    scan_directory(root_dir::String, rel_dir::String, cached::Union{DirIndex,Nothing}) -> (DirIndex, Bool)
+
+List and classify one directory. The flag is true if anything was re-read from disk.
+"""
+function scan_directory(root_dir::String, rel_dir::String, cached::Union{DirIndex,Nothing})
+    dir_path = joinpath(root_dir, rel_dir)
+    dir_mtime = mtime(dir_path)
+
+    cached_files = cached === nothing ? Dict{String,ScanEntry}() :
+                   Dict(entry.name => entry for entry in cached.files)
+
+    # Unchanged directory: no readdir, refresh content-sniffed entries only
+    if Tracing.count_cache!("scan_index", cached !== nothing && cached.mtime == dir_mtime)
+        refreshed = false
+        files = map(cached.files) do entry
+            needs_sniff(entry.name) || return entry
+            path = joinpath(dir_path, entry.name)
+            st = stat(path)
+            mtime(st) == entry.mtime && return entry
+            refreshed = true
+            return ScanEntry(entry.name, classify_file(entry.name, path, st), mtime(st))
+        end
+        return (DirIndex(dir_mtime, cached.subdirs, files), refreshed)
+    end
+
+    names = try
+        readdir(dir_path)
+    catch e
+        @warn "Cannot list $dir_path: $e"
+        return (DirIndex(dir_mtime, String[], ScanEntry[]), true)
+    end
+
+    subdirs = String[]
+    files = ScanEntry[]
+    for name in names
+        path = joinpath(dir_path, name)
+        st = stat(path)
+
+        if isdir(st)
+            # Like walkdir: symlinked directories are not followed
+            if !(name in SKIP_DIRS) && !islink(path)
+                push!(subdirs, name)
+            end
+            continue
+        end
+
+        previous = get(cached_files, name, nothing)
+        if previous !== nothing && previous.mtime == mtime(st)
+            push!(files, previous)
+        else
+            push!(files, ScanEntry(name, classify_file(name, path, st), mtime(st)))
+        end
+    end
+
+    return (DirIndex(dir_mtime, subdirs, files), true)
+end
+
+"""
+    needs_sniff(name::String) -> Bool
+
+Whether the category of a file depends on its contents rather than its name.
+"""
+function needs_sniff(name::String)
+    ext = lowercase(splitext(name)[2])
+    return ext == ".h" || ext == ""
+end
+
+"""
+    classify_file(name::String, path::String, st::Base.Filesystem.StatStruct) -> Symbol
+
+`ScanResults` field a file belongs to.
+"""
+function classify_file(name::String, path::String, st::Base.Filesystem.StatStruct)
+    ext = lowercase(splitext(name)[2])
+
+    if ext in (".cpp", ".cc", ".cxx", ".c++")
+        return :cpp_sources
+    elseif ext in (".hpp", ".hxx", ".h++", ".hh")
+        return :cpp_headers
+    elseif ext == ".h"
+        # Detect C vs C++ header by content
+        return is_cpp_header(path) ? :cpp_headers : :c_headers
+    elseif ext == ".c"
+        return :c_sources
+    elseif ext == ".so" || contains(name, ".so.")
+        return :shared_libs
+    elseif ext == ".a"
+        return :static_libs
+    elseif ext == ".jl"
+        return :julia_files
+    elseif ext in (".toml", ".json", ".yaml", ".yml", ".xml")
+        return :config_files
+    elseif ext in (".md", ".txt", ".rst", ".org", ".pdf")
+        return :docs
+    elseif ext == "" && is_binary(path, st)
+        return :binaries
+    else
+        return :other
+    end
+end
 
+"""
+    assemble_scan_results(index::Dict{String,DirIndex}) -> ScanResults
+
+Flatten a directory index into `ScanResults`, visiting directories top-down
+(files of a directory before its subdirectories) like `walkdir`.
+"""
+function assemble_scan_results(index::Dict{String,DirIndex})
+    categories = Dict{Symbol,Vector{String}}(
+        field => String[] for field in fieldnames(ScanResults) if field != :total_files
+    )
     total = 0
 
-    for (root, dirs, files_list) in walkdir(root_dir)
-        # Skip build/cache directories
-        filter!(d -> !in(d, ["build", ".git", ".cache", "node_modules", ".jmake_cache"]), dirs)
+    stack = [""]
+    while !isempty(stack)
+        rel_dir = pop!(stack)
+        listing = get(index, rel_dir, nothing)
+        listing === nothing && continue
 
-        for file in files_list
+        for entry in listing.files
             total += 1
-            filepath = joinpath(root, file)
-            relpath_file = relpath(filepath, root_dir)
-            ext = lowercase(splitext(file)[2])
-
-            # Categorize by extension and type
-            if ext in [".cpp", ".cc", ".cxx", ".c++"]
-                push!(cpp_sources, relpath_file)
-            elseif ext in [".hpp", ".hxx", ".h++", ".hh"]
-                push!(cpp_headers, relpath_file)
-            elseif ext == ".h"
-                # Detect C vs C++ header by content
-                if is_cpp_header(filepath)
-                    push!(cpp_headers, relpath_file)
-                else
-                    push!(c_headers, relpath_file)
-                end
-            elseif ext == ".c"
-                push!(c_sources, relpath_file)
-            elseif ext == ".so" || contains(file, ".so.")
-                push!(shared_libs, relpath_file)
-            elseif ext == ".a"
-                push!(static_libs, relpath_file)
-            elseif ext == ".jl"
-                push!(julia_files, relpath_file)
-            elseif ext in [".toml", ".json", ".yaml", ".yml", ".xml"]
-                push!(config_files, relpath_file)
-            elseif ext in [".md", ".txt", ".rst", ".org", ".pdf"]
-                push!(docs, relpath_file)
-            elseif ext == "" && is_binary(filepath)
-                push!(binaries, relpath_file)
-            else
-                push!(other, relpath_file)
-            end
+            push!(categories[entry.category], isempty(rel_dir) ? entry.name : joinpath(rel_dir, entry.name))
+        end
+        for sub in Iterators.reverse(listing.subdirs)
+            push!(stack, isempty(rel_dir) ? sub : joinpath(rel_dir, sub))
         end
     end
 
     return ScanResults(
-        cpp_sources, cpp_headers, c_sources, c_headers,
-        binaries, static_libs, shared_libs,
-        julia_files, config_files, docs, other,
+        categories[:cpp_sources], categories[:cpp_headers], categories[:c_sources], categories[:c_headers],
+        categories[:binaries], categories[:static_libs], categories[:shared_libs],
+        categories[:julia_files], categories[:config_files], categories[:docs], categories[:other],
         total
     )
 end
 
 """
-    is_cpp_header(filepath::String) -> Bool
+    load_scan_index(index_path::String, root_dir::String) -> Dict{String,DirIndex}
 
-Detect if .h file is C++ by scanning content.
+Read a persisted scan index. A missing, unreadable or foreign index yields an empty one.
 """
-function is_cpp_header(filepath::String)
+function load_scan_index(index_path::String, root_dir::String)
+    index = Dict{String,DirIndex}()
+    isfile(index_path) || return index
+
+    try
+        data = JSON.parsefile(index_path)
+        if get(data, "version", 0) != SCAN_INDEX_VERSION || get(data, "root", "") != abspath(root_dir)
+            return index
+        end
+
+        for (rel_dir, dir) in data["dirs"]
+            files = ScanEntry[ScanEntry(f[1], Symbol(f[2]), Float64(f[3])) for f in dir["files"]]
+            index[rel_dir] = DirIndex(Float64(dir["mtime"]), String.(dir["subdirs"]), files)
+        end
+    catch e
+        @warn "Ignoring unreadable scan index $index_path: $e"
+        empty!(index)
+    end
+
+    return index
+end
+
+"""
+    save_scan_index(index_path::String, root_dir::String, index::Dict{String,DirIndex})
+"""
+function save_scan_index(index_path::String, root_dir::String, index::Dict{String,DirIndex})
+    data = Dict(
+        "version" => SCAN_INDEX_VERSION,
+        "root" => abspath(root_dir),
+        "dirs" => Dict(rel_dir => Dict(
+            "mtime" => listing.mtime,
+            "subdirs" => listing.subdirs,
+            "files" => [[entry.name, String(entry.category), entry.mtime] for entry in listing.files]
+        ) for (rel_dir, listing) in index)
+    )
+
+    mkpath(dirname(index_path))
+    tmp = "$index_path.tmp.$(getpid()).$(rand(UInt64))"
+    open(tmp, "w") do io
+        JSON.print(io, data)
+    end
+    mv(tmp, index_path, force=true)
+end
+
+"""
+    is_cpp_header(filepath::String; limit::Int=HEADER_SNIFF_BYTES) -> Bool
+
+Detect if .h file is C++ by scanning the first `limit` bytes of its content.
+"""
+function is_cpp_header(filepath::String; limit::Int=HEADER_SNIFF_BYTES)
     if !isfile(filepath)
         return false
     end
 
     try
-        content = read(filepath, String)
-        # C++ indicators
-        cpp_indicators = [
-            r"\bclass\s+\w+",
-            r"\bnamespace\s+\w+",
-            r"\btemplate\s*<",
-            r"::\w+",
-            r"\bstd::",
-            r"\bvirtual\s+",
-            r"\boverride\b",
-            r"\bconstexpr\b"
-        ]
-
-        return any(pattern -> occursin(pattern, content), cpp_indicators)
+        bytes = open(io -> read(io, limit), filepath)
+
+        # Cut a truncated prefix back to a line boundary so it stays valid UTF-8
+        if length(bytes) == limit
+            last_newline = findlast(==(UInt8('\n')), bytes)
+            last_newline !== nothing && resize!(bytes, last_newline)
+        end
+
+        return occursin(CPP_HEADER_REGEX, String(bytes))
     catch
         return false
     end
@@ -237,33 +440,34 @@ end
 """
     is_binary(filepath::String) -> Bool
 
-Check if file is binary executable (ELF magic).
+Check if file is binary executable (executable bit or ELF magic), without spawning processes.
 """
 function is_binary(filepath::String)
-    if !isfile(filepath)
+    st = try
+        stat(filepath)
+    catch
         return false
     end
+    return is_binary(filepath, st)
+end
 
-    try
-        # Check executable bit
-        if Sys.isunix()
-            try
-                run(`test -x $filepath`)
-                return true
-            catch
-            end
-        end
+function is_binary(filepath::String, st::Base.Filesystem.StatStruct)
+    if !isfile(st)
+        return false
+    end
 
-        # Check ELF magic bytes
-        magic = read(filepath, 4)
-        if length(magic) >= 4 && magic[1:4] == UInt8[0x7f, 0x45, 0x4c, 0x46]
-            return true
-        end
+    # Check executable bit
+    if Sys.isunix() && (filemode(st) & 0o111) != 0
+        return true
+    end
+
+    # Check ELF magic bytes
+    try
+        magic = open(io -> read(io, 4), filepath)
+        return magic == ELF_MAGIC
     catch
         return false
     end
-
-    return false
 end
 
 """
@@ -322,11 +526,21 @@ end
 Build list of include directories from discovered headers.
 """
 function build_include_dirs(root_dir::String, scan::ScanResults)
+    return build_include_dirs(root_dir, [dirname(h) for h in vcat(scan.cpp_headers, scan.c_headers)])
+end
+
+"""
+    build_include_dirs(root_dir::String, header_dirs::Vector{String}) -> Vector{String}
+
+Include directories from the (root-relative) directories holding headers, plus the
+root, `include/` and `src/`. Sorted, so the list built from part of a streamed scan is
+a sorted subset of the final one.
+"""
+function build_include_dirs(root_dir::String, header_dirs::Vector{String})
     include_dirs = Set{String}()
 
     # Add directories containing headers
-    for header in vcat(scan.cpp_headers, scan.c_headers)
-        header_dir = dirname(header)
+    for header_dir in header_dirs
         if !isempty(header_dir) && header_dir != "."
             push!(include_dirs, abspath(joinpath(root_dir, header_dir)))
         end
@@ -351,7 +565,8 @@ end
 """
     walk_dependencies(root_dir::String, scan::ScanResults, include_dirs::Vector{String}) -> Union{DependencyGraph,Nothing}
 
-Walk AST dependencies using clang from LLVMEnvironment.
+Walk include dependencies. Files already compiled by LLVMake take their edges from the
+depfile graph (`depfile_graph_file`); the rest use the regex include scan.
 """
 function walk_dependencies(root_dir::String, scan::ScanResults, include_dirs::Vector{String})
     # Get all source files
@@ -367,20 +582,14 @@ function walk_dependencies(root_dir::String, scan::ScanResults, include_dirs::Ve
         return nothing
     end
 
-    # Get clang from LLVM environment
-    clang_path = LLVMEnvironment.get_tool("clang++")
-
-    if isempty(clang_path)
-        @warn "Clang not found in LLVM environment, skipping AST walk"
-        return nothing
-    end
+    # Edges harvested from compile-time depfiles (empty before the first compile)
+    depfile_graph = ASTWalker.load_depfile_graph(depfile_graph_file(root_dir))
 
     # Build dependency graph
     dep_graph = ASTWalker.build_dependency_graph(
         all_sources,
         include_dirs,
-        use_clang=true,
-        clang_path=clang_path
+        depfile_graph=depfile_graph
     )
 
     # Print summary
@@ -394,6 +603,18 @@ function walk_dependencies(root_dir::String, scan::ScanResults, include_dirs::Ve
     return dep_graph
 end
 
+"""
+    depfile_graph_file(root_dir::String) -> String
+
+Depfile graph LLVMake keeps for the project at `root_dir`, in the cache directory its
+`jmake.toml` names (`[cache] directory`, else `JMAKE_CACHE_DIR` or `.jmake_cache`).
+"""
+function depfile_graph_file(root_dir::String)
+    config_path = joinpath(root_dir, "jmake.toml")
+    cache = isfile(config_path) ? get(TOML.parsefile(config_path), "cache", Dict()) : Dict()
+    return ASTWalker.depfile_graph_path(root_dir, BuildCache.project_cache_dir(root_dir, cache))
+end
+
 """
     generate_config(root_dir, scan, binaries, include_dirs, dep_graph) -> JMakeConfig
 
@@ -441,7 +662,7 @@ function generate_config(root_dir::String, scan::ScanResults, binaries::Vector{B
             "output_dir" => "build/ir",
             "flags" => ["-std=c++17", "-fPIC", "-O2"],
             "parallel" => true,
-            "emit_ir" => true
+            "emit_bc" => true
         ),
         # Link stage
         Dict{String,Any}(
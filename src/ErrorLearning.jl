@@ -1,6 +1,8 @@
 #!/usr/bin/env julia
 # ErrorLearning.jl - Compilation error pattern learning and fix suggestions
 # Stores errors and successful fixes in SQLite database for future reference
+# Errors are indexed by a normalized fingerprint and an FTS5 term index; writes from the
+# compile path go through a background batched writer (ErrorStore)
 
 module ErrorLearning
 
@@ -8,6 +10,9 @@ using SQLite
 using DBInterface
 using DataFrames
 using Dates
+using SHA
+
+include("Tracing.jl")
 
 # ============================================================================
 # DATABASE SCHEMA
@@ -19,6 +24,11 @@ Initialize or connect to the error learning database
 function init_db(db_path::String="jmake_errors.db")
     db = SQLite.DB(db_path)
 
+    # WAL lets the background writer commit while other connections read
+    DBInterface.execute(db, "PRAGMA journal_mode=WAL")
+    DBInterface.execute(db, "PRAGMA synchronous=NORMAL")
+    DBInterface.execute(db, "PRAGMA busy_timeout=5000")
+
     # Create errors table
     DBInterface.execute(db, """
         CREATE TABLE IF NOT EXISTS compilation_errors (
@@ -28,7 +38,8 @@ function init_db(db_path::String="jmake_errors.db")
             error_output TEXT NOT NULL,
             error_pattern TEXT,
             project_path TEXT,
-            file_path TEXT
+            file_path TEXT,
+            fingerprint TEXT
         )
     """)
 
@@ -46,15 +57,114 @@ function init_db(db_path::String="jmake_errors.db")
         )
     """)
 
+    # Databases from before fingerprints get the column (filled in by backfill_index below)
+    columns = DataFrame(DBInterface.execute(db, "PRAGMA table_info(compilation_errors)")).name
+    if !("fingerprint" in columns)
+        DBInterface.execute(db, "ALTER TABLE compilation_errors ADD COLUMN fingerprint TEXT")
+    end
+
     # Create pattern index for faster lookups
     DBInterface.execute(db, """
         CREATE INDEX IF NOT EXISTS idx_error_pattern
         ON compilation_errors(error_pattern)
     """)
+    DBInterface.execute(db, """
+        CREATE INDEX IF NOT EXISTS idx_error_fingerprint
+        ON compilation_errors(fingerprint)
+    """)
+    DBInterface.execute(db, """
+        CREATE INDEX IF NOT EXISTS idx_fix_error
+        ON error_fixes(error_id, success)
+    """)
+
+    # Term index over normalized messages (rowid = error id). Builds without FTS5 fall back
+    # to a bounded LIKE scan in find_similar_errors.
+    try
+        DBInterface.execute(db, """
+            CREATE VIRTUAL TABLE IF NOT EXISTS error_search
+            USING fts5(terms, content='')
+        """)
+    catch e
+        @debug "FTS5 unavailable, similarity search falls back to LIKE" exception=e
+    end
+
+    backfill_index(db)
 
     return db
 end
 
+"""
+True when the database has the FTS5 `error_search` index
+"""
+function has_search_index(db::SQLite.DB)
+    state = db_state(db)
+    if isnothing(state.fts)
+        tables = DataFrame(DBInterface.execute(db,
+            "SELECT name FROM sqlite_master WHERE type = 'table' AND name = 'error_search'"))
+        state.fts = size(tables, 1) > 0
+    end
+    return state.fts
+end
+
+"""
+Fingerprint and index errors recorded before fingerprints existed, in batches
+"""
+function backfill_index(db::SQLite.DB; batch::Int=5000)
+    while true
+        rows = DataFrame(DBInterface.execute(db, """
+            SELECT id, error_output FROM compilation_errors
+            WHERE fingerprint IS NULL
+            LIMIT ?
+        """, [batch]))
+        size(rows, 1) == 0 && return
+
+        SQLite.transaction(db) do
+            for row in eachrow(rows)
+                normalized = normalize_error(row.error_output)
+                DBInterface.execute(statement(db, "UPDATE compilation_errors SET fingerprint = ? WHERE id = ?"),
+                                    [fingerprint_of(normalized), row.id])
+                index_terms(db, row.id, normalized)
+            end
+        end
+    end
+end
+
+# ============================================================================
+# PREPARED STATEMENTS
+# ============================================================================
+
+"""
+Per-connection state: prepared statements (prepared once, reused for every call),
+whether the FTS index exists, and a lock serializing use of the connection
+"""
+mutable struct DBState
+    statements::Dict{String,SQLite.Stmt}
+    fts::Union{Bool,Nothing}
+    lock::ReentrantLock
+end
+
+const DB_STATES = WeakKeyDict{SQLite.DB,DBState}()
+const DB_STATES_LOCK = ReentrantLock()
+
+db_state(db::SQLite.DB) = lock(DB_STATES_LOCK) do
+    get!(() -> DBState(Dict{String,SQLite.Stmt}(), nothing, ReentrantLock()), DB_STATES, db)
+end
+
+"""
+Prepared statement for `sql` on `db`, compiled on first use
+"""
+function statement(db::SQLite.DB, sql::String)
+    state = db_state(db)
+    return lock(state.lock) do
+        get!(() -> DBInterface.prepare(db, sql), state.statements, sql)
+    end
+end
+
+"""
+Run `f()` holding the connection lock of `db` (SQLite connections are not shared across threads)
+"""
+with_db(f::Function, db::SQLite.DB) = lock(f, db_state(db).lock)
+
 # ============================================================================
 # ERROR PATTERN DETECTION
 # ============================================================================
@@ -112,6 +222,62 @@ function extract_file_path(error_output::String)
     return ""
 end
 
+# ============================================================================
+# FINGERPRINTS
+# ============================================================================
+
+"""
+    normalize_error(error_output::String) -> String
+
+The diagnostic lines of a compiler output with locations, directories, numbers and
+addresses removed, so the same error from another file, line or checkout normalizes
+to the same text.
+"""
+function normalize_error(error_output::String)
+    lines = [l for l in split(error_output, '\n') if occursin(r"error|undefined reference|cannot find"i, l)]
+    isempty(lines) && (lines = first(split(strip(error_output), '\n'), 3))
+
+    normalized = String[]
+    for line in first(lines, 8)
+        line = replace(line, r"^\S*?:\d+(:\d+)?:\s*" => "")      # file:line:col: prefix
+        line = replace(line, r"(/[^\s:'\"`/]+)+/" => "")          # directories (basenames stay)
+        line = replace(line, r"0x[0-9a-fA-F]+" => "0x")
+        line = replace(line, r"\b\d+\b" => "N")
+        push!(normalized, strip(replace(line, r"\s+" => " ")))
+    end
+    return join(unique(normalized), "\n")
+end
+
+fingerprint_of(normalized::String) = bytes2hex(sha1(normalized))
+
+"""
+    error_fingerprint(error_output::String) -> String
+
+SHA-1 of the normalized error; equal for recurrences of the same error.
+"""
+error_fingerprint(error_output::String) = fingerprint_of(normalize_error(error_output))
+
+"""
+Add an error's normalized text to the FTS index
+"""
+function index_terms(db::SQLite.DB, error_id::Integer, normalized::String)
+    has_search_index(db) || return
+    DBInterface.execute(statement(db, "INSERT INTO error_search(rowid, terms) VALUES (?, ?)"),
+                        [error_id, normalized])
+end
+
+"""
+FTS5 query matching any distinctive term of an error (bm25 ranks the matches)
+"""
+function search_query(error_output::String; max_terms::Int=24)
+    text = normalize_error(error_output)
+    terms = unique([m.match for m in eachmatch(r"[A-Za-z_][A-Za-z0-9_]{2,}", text)])
+    keywords = filter(k -> occursin(r"\w", k), extract_error_keywords(error_output))
+    terms = first(union(keywords, terms), max_terms)
+    isempty(terms) && return ""
+    return join(["\"$(replace(t, "\"" => "\"\""))\"" for t in terms], " OR ")
+end
+
 # ============================================================================
 # ERROR RECORDING
 # ============================================================================
@@ -120,7 +286,8 @@ end
 Record a compilation error in the database
 """
 function record_error(db::SQLite.DB, command::String, error_output::String;
-                     project_path::String="", file_path::String="")
+                     project_path::String="", file_path::String="",
+                     timestamp::String=string(now()))
     (pattern_name, description, captures) = detect_error_pattern(error_output)
 
     # Extract file path if not provided
@@ -128,17 +295,21 @@ function record_error(db::SQLite.DB, command::String, error_output::String;
         file_path = extract_file_path(error_output)
     end
 
-    timestamp = string(now())
+    normalized = normalize_error(error_output)
 
-    DBInterface.execute(db, """
-        INSERT INTO compilation_errors
-        (timestamp, command, error_output, error_pattern, project_path, file_path)
-        VALUES (?, ?, ?, ?, ?, ?)
-    """, [timestamp, command, error_output, pattern_name, project_path, file_path])
+    error_id = with_db(db) do
+        DBInterface.execute(statement(db, """
+            INSERT INTO compilation_errors
+            (timestamp, command, error_output, error_pattern, project_path, file_path, fingerprint)
+            VALUES (?, ?, ?, ?, ?, ?, ?)
+        """), [timestamp, command, error_output, pattern_name, project_path, file_path,
+               fingerprint_of(normalized)])
 
-    # Get the inserted row ID
-    result = DataFrame(DBInterface.execute(db, "SELECT last_insert_rowid() as id"))
-    error_id = result.id[1]
+        # Get the inserted row ID
+        id = Int(SQLite.last_insert_rowid(db))
+        index_terms(db, id, normalized)
+        id
+    end
 
     return (error_id, pattern_name, description)
 end
@@ -147,15 +318,213 @@ end
 Record a fix attempt for an error
 """
 function record_fix(db::SQLite.DB, error_id::Int, fix_description::String,
-                   fix_action::String, fix_type::String, success::Bool)
-    timestamp = string(now())
+                   fix_action::String, fix_type::String, success::Bool;
+                   timestamp::String=string(now()))
     success_int = success ? 1 : 0
 
-    DBInterface.execute(db, """
-        INSERT INTO error_fixes
-        (error_id, timestamp, fix_description, fix_action, fix_type, success)
-        VALUES (?, ?, ?, ?, ?, ?)
-    """, [error_id, timestamp, fix_description, fix_action, fix_type, success_int])
+    with_db(db) do
+        DBInterface.execute(statement(db, """
+            INSERT INTO error_fixes
+            (error_id, timestamp, fix_description, fix_action, fix_type, success)
+            VALUES (?, ?, ?, ?, ?, ?)
+        """), [error_id, timestamp, fix_description, fix_action, fix_type, success_int])
+    end
+end
+
+# ============================================================================
+# BACKGROUND WRITER
+# ============================================================================
+
+"""
+An error queued for the background writer. `id` is 0 until the row is committed;
+`done` is notified then (also on a failed write, with `id` left at 0).
+"""
+mutable struct PendingError
+    id::Int
+    done::Base.Event
+end
+
+PendingError() = PendingError(0, Base.Event())
+
+"""
+    committed_id(pending::PendingError) -> Int
+
+Row id of a queued error, waiting for the writer to commit it (0 if the write failed).
+"""
+committed_id(pending::PendingError) = (wait(pending.done); pending.id)
+committed_id(id::Integer) = Int(id)
+
+struct QueuedError
+    pending::PendingError
+    command::String
+    error_output::String
+    project_path::String
+    file_path::String
+    timestamp::String
+end
+
+struct QueuedFix
+    error::Union{Int,PendingError}
+    description::String
+    action::String
+    fix_type::String
+    success::Bool
+    timestamp::String
+end
+
+"""
+    ErrorStore(db_path::String; batch_size=256)
+
+One process's access to an error database: a connection for lookups and a background
+task that owns a second connection and commits queued errors and fixes in batched
+transactions, so recording never waits on SQLite. The error-handler daemon holds one per
+database; `open_store` returns the shared in-process one.
+"""
+mutable struct ErrorStore
+    path::String
+    db::SQLite.DB                 # lookups (suggest_fixes, stats)
+    queue::Channel{Any}
+    writer::Task
+    batch_size::Int
+    written::Threads.Atomic{Int}
+end
+
+function ErrorStore(db_path::String; batch_size::Int=256)
+    mkpath(dirname(abspath(db_path)))
+    db = init_db(db_path)
+    queue = Channel{Any}(Inf)
+    written = Threads.Atomic{Int}(0)
+    writer_db = init_db(db_path)
+    writer = Threads.@spawn write_batches(writer_db, queue, batch_size, written)
+    return ErrorStore(db_path, db, queue, writer, batch_size, written)
+end
+
+"""
+Writer loop: take everything queued (up to `batch_size`) and commit it in one transaction
+"""
+function write_batches(db::SQLite.DB, queue::Channel{Any}, batch_size::Int, written::Threads.Atomic{Int})
+    for item in queue
+        batch = Any[item]
+        while isready(queue) && length(batch) < batch_size
+            push!(batch, take!(queue))
+        end
+
+        try
+            Tracing.span("sqlite_batch"; cat="sqlite", entries=length(batch)) do
+                SQLite.transaction(db) do
+                    for entry in batch
+                        write_entry(db, entry)
+                    end
+                end
+            end
+            Threads.atomic_add!(written, count(e -> e isa Union{QueuedError,QueuedFix}, batch))
+        catch e
+            @warn "Failed to write $(length(batch)) error records" exception=e
+            for entry in batch
+                entry isa QueuedError && (entry.pending.id = 0)
+            end
+        end
+
+        for entry in batch
+            entry isa QueuedError && notify(entry.pending.done)
+            entry isa Base.Event && notify(entry)
+        end
+    end
+    DBInterface.close!(db)
+end
+
+write_entry(db::SQLite.DB, entry::Base.Event) = nothing
+
+function write_entry(db::SQLite.DB, entry::QueuedError)
+    (entry.pending.id, _, _) = record_error(db, entry.command, entry.error_output;
+                                            project_path=entry.project_path, file_path=entry.file_path,
+                                            timestamp=entry.timestamp)
+end
+
+function write_entry(db::SQLite.DB, entry::QueuedFix)
+    # Fixes are queued after their error, so it is already written (earlier in this batch or before)
+    id = entry.error isa PendingError ? entry.error.id : entry.error
+    id == 0 && return
+    record_fix(db, id, entry.description, entry.action, entry.fix_type, entry.success;
+               timestamp=entry.timestamp)
+end
+
+"""
+    record_error!(store::ErrorStore, command, error_output; project_path="", file_path="")
+        -> (PendingError, pattern_name, description)
+
+Queue an error for the background writer and return at once. Pattern detection runs
+here; the database write does not.
+"""
+function record_error!(store::ErrorStore, command::String, error_output::String;
+                       project_path::String="", file_path::String="")
+    (pattern_name, description, _) = detect_error_pattern(error_output)
+    pending = PendingError()
+    put!(store.queue, QueuedError(pending, command, error_output, project_path, file_path, string(now())))
+    return (pending, pattern_name, description)
+end
+
+"""
+    record_fix!(store::ErrorStore, error, fix_description, fix_action, fix_type, success)
+
+Queue a fix attempt for an error id or a still-queued `PendingError`.
+"""
+function record_fix!(store::ErrorStore, error::Union{Int,PendingError}, fix_description::String,
+                     fix_action::String, fix_type::String, success::Bool)
+    put!(store.queue, QueuedFix(error, fix_description, fix_action, fix_type, success, string(now())))
+    return nothing
+end
+
+"""
+    flush!(store::ErrorStore)
+
+Wait until everything queued so far is committed.
+"""
+function flush!(store::ErrorStore)
+    isopen(store.queue) || return
+    marker = Base.Event()
+    put!(store.queue, marker)
+    wait(marker)
+end
+
+function Base.close(store::ErrorStore)
+    isopen(store.queue) || return
+    close(store.queue)
+    wait(store.writer)
+end
+
+suggest_fixes(store::ErrorStore, error_output::String; kwargs...) = suggest_fixes(store.db, error_output; kwargs...)
+get_error_stats(store::ErrorStore) = (flush!(store); get_error_stats(store.db))
+
+# One store per database file in this process
+const STORES = Dict{String,ErrorStore}()
+const STORES_LOCK = ReentrantLock()
+
+"""
+    open_store(db_path::String) -> ErrorStore
+
+The process-wide store of a database file, opened on first use.
+"""
+function open_store(db_path::String="jmake_errors.db")
+    key = abspath(db_path)
+    lock(STORES_LOCK) do
+        store = get(STORES, key, nothing)
+        (store === nothing || !isopen(store.queue)) && (store = STORES[key] = ErrorStore(key))
+        store
+    end
+end
+
+"""
+Commit and close every open store (runs at exit so queued errors are not lost)
+"""
+function close_stores()
+    stores = lock(() -> collect(values(STORES)), STORES_LOCK)
+    foreach(close, stores)
+    lock(() -> empty!(STORES), STORES_LOCK)
+end
+
+function __init__()
+    atexit(close_stores)
 end
 
 # ============================================================================
@@ -163,42 +532,65 @@ end
 # ============================================================================
 
 """
-Find similar errors in the database
+Find similar errors in the database: same fingerprint first, then the same pattern,
+then the best-ranked FTS matches on the error's terms
 """
 function find_similar_errors(db::SQLite.DB, error_pattern::String,
                             error_output::String; limit::Int=5)
-    # First try exact pattern match
-    result = DataFrame(DBInterface.execute(db, """
-        SELECT DISTINCT e.id, e.error_output, e.error_pattern, e.command
-        FROM compilation_errors e
-        WHERE e.error_pattern = ?
-        LIMIT ?
-    """, [error_pattern, limit]))
+    with_db(db) do
+        # Recurrences of this exact error (indexed)
+        result = DataFrame(DBInterface.execute(statement(db, """
+            SELECT e.id, e.error_output, e.error_pattern, e.command
+            FROM compilation_errors e
+            WHERE e.fingerprint = ?
+            ORDER BY e.id DESC
+            LIMIT ?
+        """), [error_fingerprint(error_output), limit]))
 
-    if size(result, 1) > 0
-        return result
-    end
+        size(result, 1) > 0 && return result
+
+        # Same known pattern (indexed); "unknown" would match unrelated errors
+        if error_pattern != "unknown"
+            result = DataFrame(DBInterface.execute(statement(db, """
+                SELECT e.id, e.error_output, e.error_pattern, e.command
+                FROM compilation_errors e
+                WHERE e.error_pattern = ?
+                ORDER BY e.id DESC
+                LIMIT ?
+            """), [error_pattern, limit]))
 
-    # Fallback: fuzzy text search (simple substring match)
-    # Extract key error terms
-    error_terms = extract_error_keywords(error_output)
+            size(result, 1) > 0 && return result
+        end
+
+        # Fallback: term search over normalized messages
+        query = search_query(error_output)
+        isempty(query) && return nothing
+
+        if has_search_index(db)
+            return DataFrame(DBInterface.execute(statement(db, """
+                SELECT e.id, e.error_output, e.error_pattern, e.command
+                FROM error_search s
+                JOIN compilation_errors e ON e.id = s.rowid
+                WHERE error_search MATCH ?
+                ORDER BY bm25(error_search)
+                LIMIT ?
+            """), [query, limit]))
+        end
 
-    if !isempty(error_terms)
-        # Build a LIKE query for each term
+        # No FTS5: substring match limited to the most recent errors
+        error_terms = extract_error_keywords(error_output)
+        isempty(error_terms) && return nothing
         conditions = join(["error_output LIKE ?" for _ in error_terms], " OR ")
         patterns = ["%$term%" for term in error_terms]
 
-        result = DataFrame(DBInterface.execute(db, """
-            SELECT DISTINCT e.id, e.error_output, e.error_pattern, e.command
+        return DataFrame(DBInterface.execute(db, """
+            SELECT e.id, e.error_output, e.error_pattern, e.command
             FROM compilation_errors e
-            WHERE $conditions
+            WHERE e.id > (SELECT COALESCE(MAX(id), 0) - 10000 FROM compilation_errors) AND ($conditions)
+            ORDER BY e.id DESC
             LIMIT ?
         """, [patterns..., limit]))
-
-        return result
     end
-
-    return nothing
 end
 
 """
@@ -230,15 +622,18 @@ function get_successful_fixes(db::SQLite.DB, error_ids::Vector{Int})
 
     placeholders = join(["?" for _ in error_ids], ",")
 
-    result = DataFrame(DBInterface.execute(db, """
-        SELECT f.error_id, f.fix_description, f.fix_action, f.fix_type,
-               COUNT(*) as usage_count,
-               SUM(f.success) as success_count
-        FROM error_fixes f
-        WHERE f.error_id IN ($placeholders) AND f.success = 1
-        GROUP BY f.fix_description, f.fix_action, f.fix_type
-        ORDER BY success_count DESC, usage_count DESC
-    """, error_ids))
+    # At most `limit` ids come in, so the statement is one of a handful and worth keeping
+    result = with_db(db) do
+        DataFrame(DBInterface.execute(statement(db, """
+            SELECT f.error_id, f.fix_description, f.fix_action, f.fix_type,
+                   COUNT(*) as usage_count,
+                   SUM(f.success) as success_count
+            FROM error_fixes f
+            WHERE f.error_id IN ($placeholders) AND f.success = 1
+            GROUP BY f.fix_description, f.fix_action, f.fix_type
+            ORDER BY success_count DESC, usage_count DESC
+        """), error_ids))
+    end
 
     return result
 end
@@ -252,14 +647,15 @@ function suggest_fixes(db::SQLite.DB, error_output::String;
     (pattern_name, description, captures) = detect_error_pattern(error_output)
 
     # Find similar errors
-    similar_errors = find_similar_errors(db, pattern_name, error_output)
+    similar_errors = Tracing.span(() -> find_similar_errors(db, pattern_name, error_output),
+                                  "error_lookup"; cat="sqlite", pattern=pattern_name)
 
     if isnothing(similar_errors) || size(similar_errors, 1) == 0
         return generate_default_suggestions(pattern_name, captures)
     end
 
     # Get error IDs
-    error_ids = similar_errors.id
+    error_ids = Vector{Int}(similar_errors.id)
 
     # Get successful fixes
     fixes = get_successful_fixes(db, error_ids)
@@ -403,7 +799,7 @@ function export_to_markdown(db::SQLite.DB, output_path::String="error_log.md")
         FROM compilation_errors e
         LEFT JOIN error_fixes f ON e.id = f.error_id
         GROUP BY e.id
-        ORDER BY e.timestamp DESC
+        ORDER BY e.id DESC
         LIMIT 20
     """))
 
@@ -449,6 +845,16 @@ export
     record_error,
     record_fix,
     detect_error_pattern,
+    normalize_error,
+    error_fingerprint,
+
+    # Background writer
+    ErrorStore,
+    PendingError,
+    open_store,
+    record_error!,
+    record_fix!,
+    committed_id,
 
     # Fix suggestions
     suggest_fixes,
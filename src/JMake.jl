@@ -8,11 +8,15 @@ module JMake
 const VERSION = v"0.1.0"
 
 # Load all submodules in the correct order
+include("Tracing.jl")  # Spans and cache counters (JMAKE_TRACE); every module below has its own copy
+include("DaemonRPC.jl")  # Typed daemon-to-daemon protocol; BuildBridge and DaemonManager use this one
 include("LLVMEnvironment.jl")  # Load LLVM environment first for toolchain isolation
 include("ConfigurationManager.jl")  # Configuration management
 include("ASTWalker.jl")  # AST dependency analysis
 include("Discovery.jl")  # Discovery pipeline
 include("ErrorLearning.jl")  # Error learning system
+include("BuildCache.jl")  # Content-addressed artifact cache
+include("ASTSignatures.jl")  # Streaming main-file signature extraction
 include("BuildBridge.jl")
 include("CMakeParser.jl")
 include("LLVMake.jl")
@@ -26,11 +30,15 @@ using .ConfigurationManager
 using .ASTWalker
 using .Discovery
 using .ErrorLearning
+using .BuildCache
+using .ASTSignatures
 using .BuildBridge
 using .CMakeParser
 using .LLVMake
 using .JuliaWrapItUp
+using .JuliaWrapItUp: BinaryReader  # In-process ELF/Mach-O reader (nested in JuliaWrapItUp)
 using .ClangJLBridge
+using .DaemonRPC
 using .DaemonManager
 
 # Load Bridge_LLVM helper functions after modules are available
@@ -38,7 +46,7 @@ using .DaemonManager
 include("Bridge_LLVM.jl")
 
 # Export submodules themselves
-export LLVMEnvironment, ConfigurationManager, ASTWalker, Discovery, ErrorLearning, BuildBridge, CMakeParser, LLVMake, JuliaWrapItUp, ClangJLBridge, DaemonManager
+export Tracing, LLVMEnvironment, ConfigurationManager, ASTWalker, Discovery, ErrorLearning, BuildCache, ASTSignatures, BuildBridge, CMakeParser, LLVMake, JuliaWrapItUp, ClangJLBridge, DaemonRPC, DaemonManager, BinaryReader
 
 # Export key types from LLVMake
 export LLVMJuliaCompiler, CompilerConfig, TargetConfig
@@ -66,7 +74,7 @@ export start_daemons, stop_daemons, daemon_status, ensure_daemons
 export discover
 
 # Export LLVM environment functions
-export get_toolchain, verify_toolchain, print_toolchain_info, with_llvm_env
+export get_toolchain, verify_toolchain, print_toolchain_info, with_llvm_env, llvm_cmd
 
 # Export key functions from LLVMake
 export compile_project
@@ -220,6 +228,9 @@ end
     import_cmake(cmake_file::String="CMakeLists.txt"; target::String="", output::String="jmake.toml")
 
 Import a CMake project and generate jmake.toml configuration.
+The whole `add_subdirectory` tree is read; tokenized lists are cached by content hash in
+`.jmake_cache/cmake` next to the top-level CMakeLists.txt, so a re-import only reparses
+the lists that changed.
 
 # Arguments
 - `cmake_file::String`: Path to CMakeLists.txt file
@@ -238,10 +249,12 @@ JMake.import_cmake("opencv/CMakeLists.txt", target="opencv_core")
 function import_cmake(cmake_file::String="CMakeLists.txt"; target::String="", output::String="jmake.toml")
     println("📦 Importing CMake project: $cmake_file")
 
-    # Parse CMakeLists.txt
-    cmake_project = CMakeParser.parse_cmake_file(cmake_file)
+    # Parse CMakeLists.txt and its subdirectories
+    cache_dir = joinpath(dirname(abspath(cmake_file)), ".jmake_cache")
+    cmake_project, stats = CMakeParser.parse_cmake_tree(cmake_file; cache_dir=cache_dir)
 
     println("✅ Found CMake project: $(cmake_project.project_name)")
+    println("   Lists: $(stats.lists) ($(stats.reparsed) parsed, $(stats.lists - stats.reparsed) cached)")
     println("   Targets: $(join(keys(cmake_project.targets), ", "))")
 
     # Determine target
@@ -389,6 +402,10 @@ function help()
       JMake.info()                   Show JMake information
       JMake.help()                   Show this help
 
+    Profiling:
+      JMAKE_TRACE=build.json         Record spans, write a Chrome/Perfetto trace at exit
+      JMake.Tracing.print_summary()  Per-stage times and cache hit rates so far
+
     Configuration Files:
       jmake.toml                     Main project configuration
       wrapper_config.toml            Binary wrapping configuration
@@ -5,7 +5,8 @@ JobQueue.jl - TOML-driven job execution system for JMake daemons
 This is the conductor that:
 1. Reads job definitions from TOML
 2. Resolves dependencies (DAG)
-3. Dispatches to daemons via DaemonMode
+3. Dispatches ready jobs to daemons concurrently via DaemonMode,
+   longest critical path first
 4. Tracks state in ConfigurationManager
 5. Persists progress to disk
 
@@ -22,6 +23,8 @@ using DaemonMode
 include("ConfigurationManager.jl")
 using .ConfigurationManager
 
+include("Tracing.jl")
+
 export Job, JobQueueManager, load_jobs, execute_job_queue, job_status
 
 # Job structure
@@ -40,14 +43,24 @@ mutable struct Job
     error::Union{String,Nothing}
     started_at::Union{DateTime,Nothing}
     completed_at::Union{DateTime,Nothing}
+    wall_time::Union{Float64,Nothing}  # Seconds from dispatch to completion
 end
 
+# Concurrent jobs when neither the job file nor the caller sets a limit
+const DEFAULT_MAX_WORKERS = 4
+
+# Critical-path weight of a job that has never run
+const DEFAULT_JOB_WEIGHT = 1.0
+
 # Job queue manager
 mutable struct JobQueueManager
     jobs::Dict{String,Job}
     config::ConfigurationManager.JMakeConfig
     job_file::String
     state_file::String
+    max_workers::Int
+    lock::ReentrantLock  # Guards config and state writes from concurrent jobs
+    unsaved::Dict{String,Tuple{String,String,Any}}  # Job id => (section, field, value) not yet on disk
 end
 
 """
@@ -56,10 +69,11 @@ Load jobs from TOML file
 function load_jobs(job_file::String, config::ConfigurationManager.JMakeConfig)
     job_toml = TOML.parsefile(job_file)
     jobs = Dict{String,Job}()
+    max_workers = max(1, get(get(job_toml, "job_queue", Dict()), "max_workers", DEFAULT_MAX_WORKERS))
 
     if !haskey(job_toml, "jobs")
         @warn "No jobs defined in $job_file"
-        return JobQueueManager(jobs, config, job_file, "")
+        return JobQueueManager(jobs, config, job_file, "", max_workers, ReentrantLock(), Dict{String,Tuple{String,String,Any}}())
     end
 
     for job_def in job_toml["jobs"]
@@ -77,6 +91,7 @@ function load_jobs(job_file::String, config::ConfigurationManager.JMakeConfig)
             nothing,
             nothing,
             nothing,
+            nothing,
             nothing
         )
         jobs[job.id] = job
@@ -84,7 +99,7 @@ function load_jobs(job_file::String, config::ConfigurationManager.JMakeConfig)
 
     state_file = joinpath(dirname(config.config_file), ".jmake_cache", "job_state.toml")
 
-    JobQueueManager(jobs, config, job_file, state_file)
+    JobQueueManager(jobs, config, job_file, state_file, max_workers, ReentrantLock(), Dict{String,Tuple{String,String,Any}}())
 end
 
 """
@@ -141,59 +156,43 @@ function execute_job(job::Job, manager::JobQueueManager)
 
     job.status = :running
     job.started_at = now()
+    start_time = time()
 
     try
         # Resolve template variables
         args = resolve_templates(job.args, manager.config)
 
-        # Build daemon command that writes to ConfigurationManager
-        # Daemons write results to config, so we just need to trigger execution
+        # Build daemon command
         args_str = string(Dict(args))
         cmd_call = "$(job.callback)($(args_str))"
 
-        # Wrap command to import JMake and save to config
+        # Wrap command to import JMake; the daemon hands its result back through a
+        # one-entry index file, and the queue batches the config writes
+        result_file = job_result_path(manager, job)
+        rm(result_file, force=true)
+
         cmd = """
         push!(LOAD_PATH, "/home/grim/.julia/julia/JMake/src")
         include("/home/grim/.julia/julia/JMake/src/ConfigurationManager.jl")
         using .ConfigurationManager
 
-        # Load config
-        config = ConfigurationManager.load_config("$(manager.config.config_file)")
-
         # Execute daemon function
         result = $cmd_call
 
-        # Write result to config if daemon didn't already
         if result isa Dict && haskey(result, :success) && result[:success]
-            section_parts = split("$(job.target_section)", ".")
-            if length(section_parts) == 2
-                section = section_parts[1]
-                field = section_parts[2]
-
-                value = if haskey(result, :results)
-                    result[:results]
-                elseif haskey(result, :tools)
-                    result[:tools]
-                elseif haskey(result, :output)
-                    result[:output]
-                elseif haskey(result, :created_dirs)
-                    first(result[:created_dirs], "build/ir")
-                else
-                    result
-                end
-
-                if section == "discovery"
-                    config.discovery[field] = value
-                elseif section == "compile"
-                    config.compile[field] = value
-                elseif section == "llvm"
-                    config.llvm[field] = value
-                elseif section == "binary"
-                    config.binary[field] = value
-                end
-
-                ConfigurationManager.save_config(config)
+            value = if haskey(result, :results)
+                result[:results]
+            elseif haskey(result, :tools)
+                result[:tools]
+            elseif haskey(result, :output)
+                result[:output]
+            elseif haskey(result, :created_dirs)
+                first(result[:created_dirs], "build/ir")
+            else
+                result
             end
+            ConfigurationManager.write_index("$result_file",
+                Dict("value" => ConfigurationManager.encode_entry(value)))
         end
 
         result
@@ -201,54 +200,34 @@ function execute_job(job::Job, manager::JobQueueManager)
 
         println("  Executing daemon job...")
 
-        # Call daemon via DaemonMode (fire and forget - daemon handles persistence)
+        # Call daemon via DaemonMode (fire and forget)
         runexpr(cmd, port=job.port)
 
-        # Reload config to see what daemon wrote
+        # Pick up the result the daemon wrote
         sleep(0.5)  # Give daemon time to write
-        updated_config = ConfigurationManager.load_config(manager.config.config_file)
-
-        # Check if target section was populated
-        section_parts = split(job.target_section, ".")
-        if length(section_parts) == 2
-            section_name = section_parts[1]
-            field_name = section_parts[2]
-
-            section_dict = if section_name == "discovery"
-                updated_config.discovery
-            elseif section_name == "compile"
-                updated_config.compile
-            elseif section_name == "llvm"
-                updated_config.llvm
-            elseif section_name == "binary"
-                updated_config.binary
-            else
-                Dict()
-            end
-
-            if haskey(section_dict, field_name) && !isempty(get(section_dict, field_name, ""))
-                job.status = :completed
-                job.result = section_dict[field_name]
-                job.completed_at = now()
+        index = ConfigurationManager.open_index(result_file)
+        value = isnothing(index) ? nothing : ConfigurationManager.read_entry(index, "value")
 
-                # Update our config reference
-                manager.config = updated_config
+        if length(split(job.target_section, ".")) != 2
+            job.status = :failed
+            job.error = "Invalid target section format"
+            job.completed_at = now()
+            println("  ❌ Failed: $(job.error)")
+        elseif populated(value)
+            store_result!(manager, job, value)
+            job.status = :completed
+            job.result = value
+            job.completed_at = now()
 
-                println("  ✅ Completed in $(job.completed_at - job.started_at)")
-                println("  💾 Result written to: $(job.target_section)")
-            else
-                job.status = :failed
-                job.error = "Daemon executed but target section not populated"
-                job.completed_at = now()
-                println("  ❌ Failed: $(job.error)")
-            end
+            println("  ✅ [$(job.id)] Completed in $(round(time() - start_time, digits=2))s")
+            println("  💾 Result recorded for: $(job.target_section)")
         else
             job.status = :failed
-            job.error = "Invalid target section format"
+            job.error = "Daemon executed but target section not populated"
             job.completed_at = now()
             println("  ❌ Failed: $(job.error)")
         end
-
+        rm(result_file, force=true)
     catch e
         job.status = :failed
         job.error = string(e)
@@ -260,24 +239,16 @@ function execute_job(job::Job, manager::JobQueueManager)
         end
     end
 
+    job.wall_time = time() - start_time
+
     # Save state
-    save_state(manager)
+    lock(() -> save_state(manager), manager.lock)
 end
 
 """
-Write job result to ConfigurationManager
+Write job result to ConfigurationManager (in memory; see `store_result!`)
 """
 function write_result_to_config!(manager::JobQueueManager, job::Job, result::Dict)
-    section_path = split(job.target_section, ".")
-
-    if length(section_path) != 2
-        @warn "Invalid target section: $(job.target_section)"
-        return
-    end
-
-    section = section_path[1]
-    field = section_path[2]
-
     # Determine what to write
     value = if haskey(result, :results)
         result[:results]
@@ -289,95 +260,263 @@ function write_result_to_config!(manager::JobQueueManager, job::Job, result::Dic
         result
     end
 
-    # Write to appropriate section
+    store_result!(manager, job, value)
+end
+
+"""
+Set a job's `target_section` field in the manager's config. Nothing is written to disk:
+`flush_config!` saves once for every result recorded since the last save.
+"""
+function store_result!(manager::JobQueueManager, job::Job, value)
+    section_path = split(job.target_section, ".")
+
+    if length(section_path) != 2
+        @warn "Invalid target section: $(job.target_section)"
+        return
+    end
+
+    section = String(section_path[1])
+    field = String(section_path[2])
+
+    lock(manager.lock) do
+        if set_field!(manager.config, section, field, value)
+            manager.unsaved[job.id] = (section, field, value)
+        else
+            @warn "Unknown target section: $(job.target_section)"
+        end
+    end
+end
+
+"""
+Write to appropriate section; false for a section jobs do not write
+"""
+function set_field!(config::ConfigurationManager.JMakeConfig, section::String, field::String, value)
     if section == "discovery"
-        manager.config.discovery[field] = value
+        config.discovery[field] = value
     elseif section == "compile"
-        manager.config.compile[field] = value
+        config.compile[field] = value
     elseif section == "link"
-        manager.config.link[field] = value
+        config.link[field] = value
     elseif section == "binary"
-        manager.config.binary[field] = value
+        config.binary[field] = value
     elseif section == "llvm"
-        manager.config.llvm[field] = value
+        config.llvm[field] = value
+    else
+        return false
     end
+    return true
+end
 
-    # Save config
-    ConfigurationManager.save_config(manager.config)
-
-    println("  💾 Saved to: $(job.target_section)")
+"""
+Save the results recorded since the last save in one config write. They are applied
+to a fresh load of the file, so whatever daemons wrote there meanwhile is kept; the
+indexed fields nobody touched are copied without decoding. Returns whether it saved.
+"""
+function flush_config!(manager::JobQueueManager)
+    lock(manager.lock) do
+        isempty(manager.unsaved) && return false
+        config = ConfigurationManager.load_config(manager.config.config_file)
+        for (section, field, value) in values(manager.unsaved)
+            set_field!(config, section, field, value)
+        end
+        ConfigurationManager.save_config(config)
+        println("  💾 Saved $(length(manager.unsaved)) job results to $(config.config_file)")
+        manager.config = config
+        empty!(manager.unsaved)
+        return true
+    end
 end
 
+"""
+File a daemon writes its job result to (a one-entry config index)
+"""
+job_result_path(manager::JobQueueManager, job::Job) =
+    joinpath(dirname(abspath(manager.config.config_file)), ".jmake_cache", "job_results", "$(job.id).index")
+
+"""
+Whether a job result counts as having populated its target section
+"""
+populated(value) = !isnothing(value) && !(value isa Union{AbstractString,AbstractDict,AbstractVector} && isempty(value))
+
 """
 Execute job queue with dependency resolution
+
+Every job whose `depends_on` set has completed is dispatched as soon as a worker slot
+is free (at most `max_workers` at once, default `[job_queue] max_workers`). Ready jobs
+are started longest critical path first, then by `priority`. A failed job fails only
+its downstream jobs; independent branches keep running.
+
+Results are collected in memory and the config is saved once at the end of the run.
+The only earlier saves happen before dispatching a job whose dependencies have unsaved
+results, because daemons read `jmake.toml` themselves.
 """
-function execute_job_queue(manager::JobQueueManager)
+function execute_job_queue(manager::JobQueueManager; max_workers::Int=manager.max_workers)
     println("="^70)
-    println("JMake Job Queue - Executing $(length(manager.jobs)) jobs")
+    println("JMake Job Queue - Executing $(length(manager.jobs)) jobs ($max_workers workers)")
     println("="^70)
 
-    # Topological sort by dependencies
-    sorted_jobs = topological_sort(manager)
+    dependents = job_dependents(manager)
+    weights = previous_wall_times(manager)
+    ranks = critical_path_lengths(manager, dependents, weights)
 
-    println("\nExecution order ($(length(sorted_jobs)) jobs):")
-    for (i, job) in enumerate(sorted_jobs)
+    # Every job is (re)run; a status carried over from the job file must not block its dependents
+    for job in values(manager.jobs)
+        job.status = :pending
+        job.error = nothing
+    end
+
+    # Jobs with missing dependencies or inside a cycle can never become ready
+    for job in values(manager.jobs)
+        missing_deps = filter(dep -> !haskey(manager.jobs, dep), job.depends_on)
+        isempty(missing_deps) || fail_job!(job, "Unknown dependency: $(join(missing_deps, ", "))")
+    end
+    for job in collect(values(manager.jobs))
+        job.status == :failed && fail_downstream!(manager, dependents, job.id)
+    end
+    for job in values(manager.jobs)
+        job.status == :pending && !haskey(ranks, job.id) && fail_job!(job, "Dependency cycle")
+    end
+
+    println("\nExecution plan (critical path, priority):")
+    for job in sort(collect(values(manager.jobs)), by = j -> schedule_key(j, ranks), rev=true)
+        job.status == :failed && continue
         deps_str = isempty(job.depends_on) ? "none" : join(job.depends_on, ", ")
-        println("  $i. $(job.id) (depends on: $deps_str)")
+        println("  • $(job.id) ($(round(ranks[job.id], digits=2)), $(job.priority)) depends on: $deps_str")
     end
 
-    # Execute in order
-    for job in sorted_jobs
-        # Check dependencies
-        deps_ready = all(manager.jobs[dep_id].status == :completed for dep_id in job.depends_on)
+    remaining = Dict(job.id => length(job.depends_on) for job in values(manager.jobs))
+    ready = [job for job in values(manager.jobs) if job.status != :failed && remaining[job.id] == 0]
+    finished = Channel{String}(Inf)
+    running = 0
+    queue_start = time()
 
-        if !deps_ready
-            println("\n[SKIP] $(job.id) - dependencies not ready")
-            job.status = :failed
-            job.error = "Dependency failed"
-            continue
-        end
+    try
+        while true
+            # Fill free worker slots, most urgent first
+            sort!(ready, by = j -> schedule_key(j, ranks))
+            while running < max_workers && !isempty(ready)
+                job = pop!(ready)
+                any(dep -> haskey(manager.unsaved, dep), job.depends_on) && flush_config!(manager)
+                running += 1
+                @async begin
+                    try
+                        Tracing.span(() -> execute_job(job, manager), "job:$(job.id)"; cat="job",
+                                     daemon=job.daemon, callback=job.callback)
+                    finally
+                        put!(finished, job.id)
+                    end
+                end
+            end
+
+            running == 0 && break
+
+            job = manager.jobs[take!(finished)]
+            running -= 1
 
-        # Execute job
-        execute_job(job, manager)
+            if job.status == :completed
+                for dependent in get(dependents, job.id, String[])
+                    remaining[dependent] -= 1
+                    next = manager.jobs[dependent]
+                    if remaining[dependent] == 0 && next.status == :pending
+                        push!(ready, next)
+                    end
+                end
+            else
+                job.status == :failed || fail_job!(job, "Job did not complete")
+                fail_downstream!(manager, dependents, job.id)
+            end
+        end
+    finally
+        # One config save for the whole run, also when it is interrupted
+        flush_config!(manager)
     end
 
+    lock(() -> save_state(manager), manager.lock)
+
     # Print summary
-    print_summary(manager)
+    print_summary(manager; elapsed=time() - queue_start)
 end
 
 """
-Topological sort for dependency resolution
+Scheduling order of a ready job: critical-path length, then priority
 """
-function topological_sort(manager::JobQueueManager)
-    sorted = Job[]
-    visited = Set{String}()
+schedule_key(job::Job, ranks::Dict{String,Float64}) = (get(ranks, job.id, 0.0), job.priority)
 
-    function visit(job_id::String)
-        if job_id in visited
-            return
-        end
+"""
+Map each job id to the ids of the jobs that depend on it
+"""
+function job_dependents(manager::JobQueueManager)
+    dependents = Dict{String,Vector{String}}()
+    for job in values(manager.jobs), dep in job.depends_on
+        push!(get!(dependents, dep, String[]), job.id)
+    end
+    return dependents
+end
 
-        job = manager.jobs[job_id]
+"""
+Wall times recorded by the previous run, used as critical-path weights
+"""
+function previous_wall_times(manager::JobQueueManager)
+    weights = Dict{String,Float64}()
+    isfile(manager.state_file) || return weights
 
-        # Visit dependencies first
-        for dep_id in job.depends_on
-            if haskey(manager.jobs, dep_id)
-                visit(dep_id)
-            end
+    try
+        for entry in get(TOML.parsefile(manager.state_file), "jobs", [])
+            haskey(entry, "wall_time") && (weights[entry["id"]] = Float64(entry["wall_time"]))
         end
-
-        push!(visited, job_id)
-        push!(sorted, job)
+    catch e
+        @warn "Ignoring unreadable job state $(manager.state_file): $e"
     end
+    return weights
+end
 
-    # Sort by priority first
-    priority_order = sort(collect(values(manager.jobs)), by = j -> -j.priority)
+"""
+Length of the longest weighted path from each job to the end of the DAG (its own
+weight included). Jobs on a cycle or behind an unknown dependency get no entry.
+"""
+function critical_path_lengths(manager::JobQueueManager, dependents::Dict{String,Vector{String}},
+                               weights::Dict{String,Float64})
+    # Kahn's algorithm gives a topological order; an unknown dependency never counts down,
+    # so jobs on or behind a cycle or a missing job are left out
+    indegree = Dict(job.id => length(job.depends_on) for job in values(manager.jobs))
+    order = String[id for (id, n) in indegree if n == 0]
+    i = 1
+    while i <= length(order)
+        for dependent in get(dependents, order[i], String[])
+            indegree[dependent] -= 1
+            indegree[dependent] == 0 && push!(order, dependent)
+        end
+        i += 1
+    end
 
-    for job in priority_order
-        visit(job.id)
+    ranks = Dict{String,Float64}()
+    for id in Iterators.reverse(order)
+        downstream = [ranks[d] for d in get(dependents, id, String[]) if haskey(ranks, d)]
+        ranks[id] = get(weights, id, DEFAULT_JOB_WEIGHT) + (isempty(downstream) ? 0.0 : maximum(downstream))
     end
+    return ranks
+end
+
+"""
+Mark a job failed without running it
+"""
+function fail_job!(job::Job, reason::String)
+    job.status = :failed
+    job.error = reason
+    job.completed_at = now()
+end
 
-    return sorted
+"""
+Fail every job downstream of `job_id` that has not started
+"""
+function fail_downstream!(manager::JobQueueManager, dependents::Dict{String,Vector{String}}, job_id::String)
+    for dependent in get(dependents, job_id, String[])
+        job = manager.jobs[dependent]
+        job.status == :pending || continue
+        println("\n[SKIP] $(job.id) - dependency $job_id failed")
+        fail_job!(job, "Dependency failed: $job_id")
+        fail_downstream!(manager, dependents, dependent)
+    end
 end
 
 """
@@ -404,6 +543,9 @@ function save_state(manager::JobQueueManager)
                 if !isnothing(job.completed_at)
                     job_dict["completed_at"] = string(job.completed_at)
                 end
+                if !isnothing(job.wall_time)
+                    job_dict["wall_time"] = job.wall_time
+                end
                 # Note: result is not serialized to avoid complex types
 
                 job_dict
@@ -418,9 +560,9 @@ function save_state(manager::JobQueueManager)
 end
 
 """
-Print job execution summary
+Print job execution summary; with `elapsed`, also per-job wall times and the overlap achieved
 """
-function print_summary(manager::JobQueueManager)
+function print_summary(manager::JobQueueManager; elapsed::Union{Float64,Nothing}=nothing)
     println("\n" * "="^70)
     println("Job Queue Summary")
     println("="^70)
@@ -434,6 +576,17 @@ function print_summary(manager::JobQueueManager)
     println("❌ Failed: $failed")
     println("⏳ Pending: $pending")
 
+    timed = sort([j for j in values(manager.jobs) if !isnothing(j.wall_time)], by = j -> -j.wall_time)
+    if !isnothing(elapsed) && !isempty(timed)
+        println("\nWall time:")
+        for job in timed
+            println("  • $(job.id): $(round(job.wall_time, digits=2))s")
+        end
+        busy = sum(j.wall_time for j in timed)
+        println("Queue: $(round(elapsed, digits=2))s for $(round(busy, digits=2))s of jobs " *
+                "($(round(busy / max(elapsed, eps()), digits=2))x overlap)")
+    end
+
     if failed > 0
         println("\nFailed jobs:")
         for job in values(manager.jobs)
@@ -457,7 +610,8 @@ function job_status(manager::JobQueueManager, job_id::String)
             "status" => string(job.status),
             "type" => string(job.type),
             "result" => job.result,
-            "error" => job.error
+            "error" => job.error,
+            "wall_time" => job.wall_time
         )
     else
         return Dict("error" => "Job not found: $job_id")
@@ -10,6 +10,9 @@ using JSON
 using TOML
 using Dates
 
+include("BinaryReader.jl")
+using .BinaryReader
+
 """
 Configuration for binary wrapper generation
 """
@@ -22,11 +25,14 @@ struct WrapperConfig
 
     # Wrapper settings
     wrapper_style::Symbol          # :basic, :advanced, :introspective
-    symbol_detection::Symbol       # :nm, :objdump, :libclang, :all
+    symbol_detection::Symbol       # :native, :nm, :objdump, :libclang, :all
     demangle_cpp::Bool
     generate_tests::Bool
     generate_docs::Bool
     safety_checks::Bool
+    call_mode::Symbol              # :cached (dlsym once in __init__), :dynamic (ccall by name),
+                                   # :lazy (dlopen/dlsym on first call, wrappers in on-demand shards)
+    shard_size::Int                # Wrapped names per shard file in :lazy mode
 
     # Type inference
     use_headers::Bool
@@ -103,6 +109,8 @@ function load_wrapper_config(config_file::String)::WrapperConfig
     generate_tests = get(wrapper, "generate_tests", true)
     generate_docs = get(wrapper, "generate_docs", true)
     safety_checks = get(wrapper, "safety_checks", true)
+    call_mode = Symbol(get(wrapper, "call_mode", "cached"))
+    shard_size = get(wrapper, "shard_size", 256)
 
     type_inference = get(data, "type_inference", Dict())
     use_headers = get(type_inference, "use_headers", true)
@@ -116,7 +124,7 @@ function load_wrapper_config(config_file::String)::WrapperConfig
     return WrapperConfig(
         project_root, binary_dirs, output_dir, header_dirs,
         wrapper_style, symbol_detection, demangle_cpp, generate_tests,
-        generate_docs, safety_checks, use_headers, header_parser,
+        generate_docs, safety_checks, call_mode, shard_size, use_headers, header_parser,
         type_hints, stage1_metadata, inherit_mappings
     )
 end
@@ -151,7 +159,7 @@ function create_wrapper_config_from_stage1()::WrapperConfig
 
     return WrapperConfig(
         project_root, binary_dirs, output_dir, header_dirs,
-        :advanced, :all, true, true, true, true,
+        :advanced, :all, true, true, true, true, :cached, 256,
         true, "", Dict{String,String}(),
         stage1_metadata, true
     )
@@ -166,7 +174,7 @@ function create_default_wrapper_config()::WrapperConfig
         [".", "lib", "bin", "build"],
         "julia_wrappers",
         ["include"],
-        :advanced, :all, true, true, true, true,
+        :advanced, :all, true, true, true, true, :cached, 256,
         false, "", Dict{String,String}(),
         nothing, false
     )
@@ -189,7 +197,9 @@ function save_wrapper_config(config::WrapperConfig, config_file::String)
             "demangle_cpp" => config.demangle_cpp,
             "generate_tests" => config.generate_tests,
             "generate_docs" => config.generate_docs,
-            "safety_checks" => config.safety_checks
+            "safety_checks" => config.safety_checks,
+            "call_mode" => string(config.call_mode),
+            "shard_size" => config.shard_size
         ),
         "type_inference" => Dict(
             "use_headers" => config.use_headers,
@@ -301,6 +311,7 @@ function scan_binaries(wrapper::BinaryWrapper)
 
         println("  📁 Scanning: $dir")
 
+        candidates = Tuple{String,Symbol}[]
         for (root, dirs, files) in walkdir(dir)
             # Skip hidden directories
             filter!(d -> !startswith(d, "."), dirs)
@@ -310,14 +321,18 @@ function scan_binaries(wrapper::BinaryWrapper)
 
                 # Determine binary type
                 binary_type = identify_binary_type(file_path)
+                binary_type != :unknown && push!(candidates, (file_path, binary_type))
+            end
+        end
 
-                if binary_type != :unknown
-                    info = analyze_binary(wrapper, file_path, binary_type)
-                    if !isnothing(info)
-                        push!(binaries, info)
-                        println("    ✓ Found: $(info.name) ($(info.type))")
-                    end
-                end
+        # Parse every candidate on all threads up front; analysis below hits the reader's cache
+        read_binaries(first.(candidates))
+
+        for (file_path, binary_type) in candidates
+            info = analyze_binary(wrapper, file_path, binary_type)
+            if !isnothing(info)
+                push!(binaries, info)
+                println("    ✓ Found: $(info.name) ($(info.type))")
             end
         end
     end
@@ -344,16 +359,11 @@ function identify_binary_type(file_path::String)::Symbol
         return :static_lib
     elseif ext == ".o"
         return :object_file
-    elseif ext == ""
-        # Check if executable
-        try
-            # Use file command to check
-            result = read(`file $file_path`, String)
-            if contains(result, "executable") || contains(result, "shared object")
-                return isexecutable(file_path) ? :executable : :shared_lib
-            end
-        catch
-            return :unknown
+    elseif ext == "" || occursin(r"\.so\.[0-9.]+$", lowercase(file_path))
+        # Versioned or extensionless: decide from the headers
+        image = read_binary(file_path)
+        if image.kind in (:executable, :shared_lib)
+            return image.kind
         end
     end
 
@@ -364,16 +374,11 @@ end
 Check if file is executable
 """
 function isexecutable(path::String)
-    try
-        if Sys.isunix()
-            run(`test -x $path`)
-            return true
-        else
-            # Windows: check for .exe extension
-            return endswith(lowercase(path), ".exe")
-        end
-    catch
-        return false
+    if Sys.isunix()
+        return isfile(path) && uperm(path) & 0x01 != 0
+    else
+        # Windows: check for .exe extension
+        return endswith(lowercase(path), ".exe")
     end
 end
 
@@ -414,6 +419,9 @@ end
 Get binary architecture
 """
 function get_binary_architecture(file_path::String)::String
+    image = read_binary(file_path)
+    image.format != :unknown && return image.arch
+
     try
         result = read(`file $file_path`, String)
 
@@ -449,13 +457,20 @@ function extract_symbols(wrapper::BinaryWrapper, file_path::String, binary_type:
     methods = Symbol[]
 
     if wrapper.config.symbol_detection == :all
-        methods = [:nm, :objdump, :libclang]
+        methods = [:native, :libclang]
     else
         methods = [wrapper.config.symbol_detection]
     end
 
+    # Formats the in-process reader doesn't parse still go through the external tools
+    if :native in methods && read_binary(file_path).format == :unknown
+        methods = [:nm, :objdump, filter(!=(:native), methods)...]
+    end
+
     for method in methods
-        if method == :nm
+        if method == :native
+            append!(symbols, extract_symbols_native(wrapper, file_path))
+        elseif method == :nm
             append!(symbols, extract_symbols_nm(wrapper, file_path))
         elseif method == :objdump
             append!(symbols, extract_symbols_objdump(wrapper, file_path))
@@ -475,6 +490,30 @@ function extract_symbols(wrapper::BinaryWrapper, file_path::String, binary_type:
     return symbols
 end
 
+"""
+Extract exported symbols with the in-process reader (what `nm -D --defined-only` lists)
+"""
+function extract_symbols_native(wrapper::BinaryWrapper, file_path::String)::Vector{Dict{String,Any}}
+    symbols = Dict{String,Any}[]
+
+    for sym in exported_symbols(read_binary(file_path))
+        display_name = wrapper.config.demangle_cpp ? demangle(sym.name) : sym.name
+        parsed = parse_symbol_signature(display_name)
+
+        push!(symbols, Dict{String,Any}(
+            "name" => parsed["base_name"],
+            "mangled" => sym.name,
+            "type" => sym.kind == :function ? "function" : "data",
+            "visibility" => sym.binding == :weak ? "weak" : "global",
+            "signature" => parsed["signature"],
+            "return_type" => parsed["return_type"],
+            "parameters" => parsed["parameters"]
+        ))
+    end
+
+    return symbols
+end
+
 """
 Extract symbols using nm
 """
@@ -670,6 +709,10 @@ function get_binary_dependencies(file_path::String, binary_type::Symbol)::Vector
     deps = String[]
 
     if binary_type in [:shared_lib, :executable]
+        # Direct DT_NEEDED / LC_LOAD_DYLIB entries, without running the loader
+        image = read_binary(file_path)
+        image.format != :unknown && return copy(image.needed)
+
         try
             if Sys.islinux()
                 result = read(`ldd $file_path`, String)
@@ -720,6 +763,11 @@ Generate advanced wrapper with type inference
 function generate_advanced_wrapper(wrapper::BinaryWrapper, binary::BinaryInfo)::String
     module_name = generate_module_name(binary.name)
 
+    # With cached calls every symbol gets a pointer slot filled once by __init__
+    cached = wrapper.config.call_mode == :cached
+    slots = cached ? pointer_slots(binary.symbols) : Dict{String,String}()
+    resolve_call = cached ? "\n        _resolve_symbols()" : ""
+
     content = """
     # Advanced Julia wrapper for $(binary.name)
     # Generated on $(Dates.format(now(), "yyyy-mm-dd HH:MM:SS"))
@@ -738,7 +786,7 @@ function generate_advanced_wrapper(wrapper::BinaryWrapper, binary::BinaryInfo)::
     function __init__()
         try
             _lib_handle[] = Libdl.dlopen(_lib_path, Libdl.RTLD_LAZY | Libdl.RTLD_GLOBAL)
-            @debug "Loaded $(binary.name) from $_lib_path"
+            @debug "Loaded $(binary.name) from \$_lib_path"$resolve_call
         catch e
             push!(_load_errors, string(e))
             @debug "Failed to load $(binary.name): \$e"
@@ -768,8 +816,13 @@ function generate_advanced_wrapper(wrapper::BinaryWrapper, binary::BinaryInfo)::
 
     """
 
-    # Add safety check macro if enabled
-    if wrapper.config.safety_checks
+    # Pointer slots and their resolver (called from __init__)
+    if cached
+        content *= generate_pointer_slots(binary, slots, wrapper.config.safety_checks)
+    end
+
+    # Add safety check macro if enabled (cached calls check their slot instead)
+    if wrapper.config.safety_checks && !cached
         content *= """
         # Safety check macro
         macro check_loaded()
@@ -785,22 +838,27 @@ function generate_advanced_wrapper(wrapper::BinaryWrapper, binary::BinaryInfo)::
 
     # Generate function wrappers
     functions_generated = 0
+    uses_arrays = false
     for symbol in binary.symbols
         if symbol["type"] == "function"
-            func_wrapper = generate_function_wrapper(wrapper, symbol, binary.name)
+            func_wrapper = generate_function_wrapper(wrapper, symbol, binary.name;
+                                                     slot=get(slots, link_name(symbol), nothing))
             if !isnothing(func_wrapper)
                 content *= func_wrapper
                 content *= "\n"
                 functions_generated += 1
+                uses_arrays |= !isnothing(symbol_array_parameters(wrapper, symbol))
             end
         end
     end
+    uses_arrays && (content *= generate_array_helpers())
 
     # Generate data accessors
     data_generated = 0
     for symbol in binary.symbols
         if symbol["type"] == "data"
-            data_wrapper = generate_data_wrapper(wrapper, symbol, binary.name)
+            data_wrapper = generate_data_wrapper(wrapper, symbol, binary.name;
+                                                 slot=get(slots, link_name(symbol), nothing))
             if !isnothing(data_wrapper)
                 content *= data_wrapper
                 content *= "\n"
@@ -854,10 +912,312 @@ function generate_advanced_wrapper(wrapper::BinaryWrapper, binary::BinaryInfo)::
     return content
 end
 
+"""
+Generate a lazily loaded wrapper: a small module of forwarding stubs and a shard index,
+plus shard files holding the actual wrappers, each included the first time one of its
+names is called. The library is opened and each symbol resolved on first use, so loading
+the module costs the same whatever the size of the wrapped surface.
+Returns the module source and the shard sources (written to `<module>/shard_NNN.jl`).
+"""
+function generate_lazy_wrapper(wrapper::BinaryWrapper, binary::BinaryInfo)::Tuple{String,Vector{String}}
+    module_name = generate_module_name(binary.name)
+    slots = pointer_slots(binary.symbols)
+
+    # Group symbols by the name they define, so every method of a name lives in one shard
+    groups = Dict{String,Vector{Dict{String,Any}}}()
+    names = String[]
+    for symbol in binary.symbols
+        haskey(slots, link_name(symbol)) || continue
+        julia_name = make_julia_identifier(symbol["name"])
+        symbol["type"] == "data" && (julia_name = "get_$julia_name")
+        haskey(groups, julia_name) || (push!(names, julia_name); groups[julia_name] = Dict{String,Any}[])
+        push!(groups[julia_name], symbol)
+    end
+
+    chunks = collect(Iterators.partition(names, max(wrapper.config.shard_size, 1)))
+    shard_index = Dict(name => i for (i, chunk) in enumerate(chunks) for name in chunk)
+
+    # Shards
+    shards = String[]
+    functions_generated = 0
+    data_generated = 0
+    uses_arrays = false
+    for (index, chunk) in enumerate(chunks)
+        body = ""
+        shard_arrays = false
+        emitted = Set{String}()
+        for name in chunk, symbol in groups[name]
+            link_name(symbol) in emitted && continue
+            push!(emitted, link_name(symbol))
+            slot = slots[link_name(symbol)]
+
+            code = if symbol["type"] == "function"
+                shard_arrays |= !isnothing(symbol_array_parameters(wrapper, symbol))
+                functions_generated += 1
+                generate_function_wrapper(wrapper, symbol, binary.name; slot=slot)
+            else
+                data_generated += 1
+                generate_data_wrapper(wrapper, symbol, binary.name; slot=slot)
+            end
+            body *= "const $slot = Ref{Ptr{Cvoid}}(C_NULL)\n\n" * code * "\n"
+        end
+        uses_arrays |= shard_arrays
+
+        imports = shard_arrays ? ".._resolve!, .._c_input, .._c_output" : ".._resolve!"
+        push!(shards, """
+        # Shard $index of $(length(chunks)) of the lazy wrapper for $(binary.name)
+        # Included by $module_name the first time one of its names is called
+
+        module Shard$(lpad(index, 3, '0'))
+
+        import $imports
+
+        """ * body * "end # module\n")
+    end
+
+    content = """
+    # Lazy Julia wrapper for $(binary.name)
+    # Generated on $(Dates.format(now(), "yyyy-mm-dd HH:MM:SS"))
+    # Binary type: $(binary.type)
+    # Architecture: $(binary.arch)
+    # Wrappers: $(length(names)) names in $(length(chunks)) shards under $module_name/
+
+    module $module_name
+
+    using Libdl
+
+    # Library management: opened by the first call, never at load time
+    const _lib_path = raw"$(binary.path)"
+    const _lib_handle = Ref{Ptr{Nothing}}(C_NULL)
+    const _load_errors = String[]
+    const _load_lock = ReentrantLock()
+
+    # Shards, included on demand
+    const _shard_dir = joinpath(@__DIR__, "$module_name")
+    const _shards = Vector{Union{Module,Nothing}}(nothing, $(length(chunks)))
+
+    function __init__()
+        _lib_handle[] = C_NULL
+        fill!(_shards, nothing)
+    end
+
+    function _library()
+        handle = _lib_handle[]
+        handle != C_NULL && return handle
+        lock(_load_lock) do
+            if _lib_handle[] == C_NULL
+                try
+                    _lib_handle[] = Libdl.dlopen(_lib_path, Libdl.RTLD_LAZY | Libdl.RTLD_GLOBAL)
+                    @debug "Loaded $(binary.name) from \$_lib_path"
+                catch e
+                    push!(_load_errors, string(e))
+                    error("Library $(binary.name) could not be loaded: \$e")
+                end
+            end
+            return _lib_handle[]
+        end
+    end
+
+    # Fill a pointer slot on the first call through it
+    @noinline function _resolve!(slot::Base.RefValue{Ptr{Cvoid}}, name::Symbol)
+        ptr = Libdl.dlsym(_library(), name; throw_error=false)
+        isnothing(ptr) && error("Symbol \$name not found in $(binary.name)")
+        slot[] = ptr
+        return false
+    end
+
+    function _shard(index::Int)
+        shard = _shards[index]
+        shard === nothing || return shard
+        lock(_load_lock) do
+            if _shards[index] === nothing
+                file = joinpath(_shard_dir, "shard_" * lpad(index, 3, '0') * ".jl")
+                _shards[index] = Base.include(@__MODULE__, file)
+            end
+            return _shards[index]
+        end
+    end
+
+    \"\"\"
+        is_loaded()
+
+    Check if the library can be loaded (opens it on the first call).
+    \"\"\"
+    is_loaded() = try
+        _library() != C_NULL
+    catch
+        false
+    end
+
+    \"\"\"
+        get_load_errors()
+
+    Get any errors that occurred during library loading.
+    \"\"\"
+    get_load_errors() = copy(_load_errors)
+
+    \"\"\"
+        get_lib_path()
+
+    Get the path to the underlying binary.
+    \"\"\"
+    get_lib_path() = _lib_path
+
+    # Shard defining each name
+    const _shard_index = Dict{Symbol,Int}(
+    $(join(["    $(repr(Symbol(name))) => $(shard_index[name]),\n" for name in names]))
+    )
+
+    \"\"\"
+        load_function(name::Symbol)
+
+    The wrapper behind a name, including its shard if needed. Fetch it once outside
+    a hot loop to call it without going through the forwarding stub.
+    \"\"\"
+    load_function(name::Symbol) = getfield(_shard(_shard_index[name]), name)
+
+    # Forwarding stubs: include the defining shard, then call into it
+    """
+    for name in names
+        content *= "$name(args...; kwargs...) = Base.invokelatest(getfield(_shard($(shard_index[name])), :$name), args...; kwargs...)\n"
+    end
+    content *= "\n"
+
+    uses_arrays && (content *= generate_array_helpers())
+
+    content *= """
+    \"\"\"
+        library_info()
+
+    Get information about the wrapped library.
+    \"\"\"
+    function library_info()
+        return Dict(
+            :name => "$(binary.name)",
+            :path => _lib_path,
+            :loaded => is_loaded(),
+            :type => :$(binary.type),
+            :arch => "$(binary.arch)",
+            :functions => $functions_generated,
+            :data => $data_generated,
+            :dependencies => $(repr(binary.dependencies)),
+            :shards => length(_shards),
+            :shards_loaded => count(!isnothing, _shards)
+        )
+    end
+
+    # Exports
+    export $(join(unique(["is_loaded", "get_load_errors", "get_lib_path", "library_info", "load_function", names...]), ", "))
+
+    end # module
+    """
+
+    return content, shards
+end
+
+"""
+Write the shard files of a lazy wrapper to `<output_dir>/<module_name>/`, replacing old ones
+"""
+function write_shards(output_dir::String, module_name::String, shards::Vector{String})
+    shard_dir = joinpath(output_dir, module_name)
+    rm(shard_dir; force=true, recursive=true)
+    mkpath(shard_dir)
+    for (index, shard) in enumerate(shards)
+        write(joinpath(shard_dir, "shard_$(lpad(index, 3, '0')).jl"), shard)
+    end
+end
+
+"""
+Pointer slot of every wrappable symbol, keyed by its `link_name`: overloads share a
+base name but each gets its own slot (unique even when two symbols map to the same
+Julia identifier)
+"""
+function pointer_slots(symbols::Vector{Dict{String,Any}})::Dict{String,String}
+    slots = Dict{String,String}()
+    taken = Set{String}()
+    for symbol in symbols
+        symbol["type"] in ("function", "data") || continue
+        key = link_name(symbol)
+        haskey(slots, key) && continue
+        julia_name = make_julia_identifier(symbol["name"])
+        isempty(julia_name) && continue
+
+        base = (symbol["type"] == "function" ? "_fptr_" : "_dptr_") * julia_name
+        slot = base
+        n = 1
+        while slot in taken
+            n += 1
+            slot = "$(base)_$n"
+        end
+        push!(taken, slot)
+        slots[key] = slot
+    end
+    return slots
+end
+
+"""
+Name to `dlsym`: the raw (mangled) linker name when the reader provided it
+"""
+function link_name(symbol::Dict{String,Any})::String
+    mangled = get(symbol, "mangled", "")
+    return occursin(r"^[A-Za-z_$.][A-Za-z0-9_$.@]*$", mangled) ? mangled : symbol["name"]
+end
+
+"""
+Guard line for a wrapper calling through `slot`: a `CHECK_CALLS` test in cached modules,
+resolution on first call in lazy ones
+"""
+function slot_check(wrapper::BinaryWrapper, slot::String, symbol::Dict{String,Any})::String
+    if wrapper.config.call_mode == :lazy
+        return "$slot[] == C_NULL && _resolve!($slot, $(repr(Symbol(link_name(symbol)))))"
+    end
+    return "CHECK_CALLS && $slot[] == C_NULL && _unresolved($(repr(Symbol(symbol["name"]))))"
+end
+
+"""
+Pointer slots, their resolver and the call check of a cached-call wrapper module.
+`dlsym` runs once per symbol in `__init__`; wrappers `ccall` the slot's pointer, so
+a call costs one load and an indirect call, like a hand-written `ccall`.
+"""
+function generate_pointer_slots(binary::BinaryInfo, slots::Dict{String,String}, safety_checks::Bool)::String
+    names = sort(collect(keys(slots)))  # link names
+
+    content = """
+    # Entry points, resolved once by __init__ (C_NULL until then or when missing)
+    """
+    for name in names
+        content *= "const $(slots[name]) = Ref{Ptr{Cvoid}}(C_NULL)\n"
+    end
+
+    content *= """
+
+    const _symbol_slots = Pair{Base.RefValue{Ptr{Cvoid}},Symbol}[
+    $(join(["    $(slots[name]) => $(repr(Symbol(name))),\n" for name in names]))]
+
+    function _resolve_symbols()
+        for (slot, name) in _symbol_slots
+            ptr = Libdl.dlsym(_lib_handle[], name; throw_error=false)
+            slot[] = something(ptr, C_NULL)
+            isnothing(ptr) && push!(_load_errors, "Symbol not found: \$name")
+        end
+    end
+
+    # Check each call against an unresolved slot; set to false to drop the branch
+    const CHECK_CALLS = $safety_checks
+
+    @noinline _unresolved(name::Symbol) =
+        error("Symbol \$name of $(binary.name) is not loaded. Check get_load_errors() for details.")
+
+    """
+    return content
+end
+
 """
 Generate function wrapper with type inference
+With a pointer `slot` (cached calls) the wrapper calls the pointer resolved in `__init__`
 """
-function generate_function_wrapper(wrapper::BinaryWrapper, symbol::Dict{String,Any}, lib_name::String)::Union{String,Nothing}
+function generate_function_wrapper(wrapper::BinaryWrapper, symbol::Dict{String,Any}, lib_name::String;
+                                   slot::Union{String,Nothing}=nothing)::Union{String,Nothing}
     func_name = symbol["name"]
     julia_name = make_julia_identifier(func_name)
 
@@ -892,13 +1252,16 @@ function generate_function_wrapper(wrapper::BinaryWrapper, symbol::Dict{String,A
     function $julia_name($(join(["$n::$t" for (n, t) in zip(param_names, param_types)], ", ")))
     """
 
-    if wrapper.config.safety_checks
+    if !isnothing(slot)
+        wrapper_content *= "    $(slot_check(wrapper, slot, symbol))\n"
+    elseif wrapper.config.safety_checks
         wrapper_content *= "    @check_loaded()\n"
     end
 
+    target = isnothing(slot) ? "($(repr(Symbol(link_name(symbol)))), _lib_handle[])" : "$slot[]"
     wrapper_content *= """
         return ccall(
-            (:$func_name, _lib_handle[]),
+            $target,
             $return_type,
             ($(join(param_types, ", "))$(isempty(param_types) ? "" : ",")),
             $(join(param_names, ", "))
@@ -906,13 +1269,209 @@ function generate_function_wrapper(wrapper::BinaryWrapper, symbol::Dict{String,A
     end
     """
 
+    # Array methods for (T*, length) parameter groups: one ccall per array, no copies
+    plan = symbol_array_parameters(wrapper, symbol)
+    if !isnothing(plan)
+        check = !isnothing(slot) ? slot_check(wrapper, slot, symbol) :
+                wrapper.config.safety_checks ? "@check_loaded()" : ""
+        wrapper_content *= "\n" * generate_array_methods(julia_name, func_name, plan, return_type, target; check=check)
+    end
+
     return wrapper_content
 end
 
+# Element types a `T*` parameter can take as an array
+const ARRAY_ELEMENT_TYPES = Set([
+    "Cdouble", "Cfloat", "Cchar", "Cuchar", "Cshort", "Cushort", "Cint", "Cuint",
+    "Clong", "Culong", "Clonglong", "Culonglong", "Csize_t", "Cssize_t", "Bool",
+    "Int8", "UInt8", "Int16", "UInt16", "Int32", "UInt32", "Int64", "UInt64"
+])
+
+# Integer types accepted as the length of an array parameter
+const LENGTH_TYPES = Set([
+    "Cint", "Cuint", "Clong", "Culong", "Clonglong", "Culonglong", "Csize_t", "Cssize_t",
+    "Cptrdiff_t", "Int32", "UInt32", "Int64", "UInt64"
+])
+
+# Parameter names that read as an element count
+const LENGTH_NAME_REGEX = r"^(n|len|length|size|count|num|nelems?|n_?elements|n_?items|\w+_(len|length|size|count|n))$"i
+
+# C++ types that make an unnamed parameter a length: size_t/ptrdiff_t, and size_t as it
+# demangles ("unsigned long" on LP64, "unsigned long long" on LLP64)
+const POSITIONAL_LENGTH_TYPES = Set([
+    "size_t", "std::size_t", "ssize_t", "ptrdiff_t", "std::ptrdiff_t",
+    "unsigned long", "unsigned long long"
+])
+
+"""
+    array_parameters(names, cpp_types, julia_type::Function) -> Union{Vector{NamedTuple},Nothing}
+
+Pair `T*` parameters with the integer parameter giving their length, e.g.
+`(const double* a, const double* b, int size)`. Each entry has `kind` (`:array`,
+`:length` or `:scalar`), `name`, `jl_type`, and for arrays `element`, `output`
+(non-const pointee, written by the callee) and `length_index`. A pointer binds to
+the first length after it, else the last one before it. Unnamed parameters (`argN`,
+from demangled symbols) count as lengths only when of a `POSITIONAL_LENGTH_TYPES`
+type, so an `int` flag or mode is never taken for one. `nothing` when the signature
+has no array or no length.
+"""
+function array_parameters(names::Vector{String}, cpp_types::Vector{String}, julia_type::Function)
+    n = length(names)
+    pointees = Vector{Any}(nothing, n)
+    lengths = Int[]
+
+    for i in 1:n
+        cpp = strip(replace(cpp_types[i], r"\s+" => " "))
+        m = match(r"^(const )?([A-Za-z_][\w ]*?)( const)? ?\*$", cpp)
+        if m !== nothing
+            element = julia_type(String(m[2]))
+            if element in ARRAY_ELEMENT_TYPES && !(element == "Cchar" && m[1] !== nothing)
+                pointees[i] = (element=element, output=(m[1] === nothing && m[3] === nothing))
+            end
+        elseif julia_type(String(cpp)) in LENGTH_TYPES &&
+               (occursin(LENGTH_NAME_REGEX, names[i]) ||
+                (occursin(r"^arg\d+$", names[i]) && cpp in POSITIONAL_LENGTH_TYPES))
+            push!(lengths, i)
+        end
+    end
+
+    array_indices = findall(!isnothing, pointees)
+    (isempty(array_indices) || isempty(lengths)) && return nothing
+
+    bound = Dict{Int,Int}()
+    for i in array_indices
+        after = findfirst(>(i), lengths)
+        bound[i] = after !== nothing ? lengths[after] : lengths[findlast(<(i), lengths)]
+    end
+    used_lengths = Set(values(bound))
+
+    return [begin
+        if haskey(bound, i)
+            (kind=:array, name=names[i], jl_type="Ptr{$(pointees[i].element)}",
+             element=pointees[i].element, output=pointees[i].output, length_index=bound[i])
+        elseif i in used_lengths
+            (kind=:length, name=names[i], jl_type=julia_type(cpp_types[i]), element="", output=false, length_index=0)
+        else
+            (kind=:scalar, name=names[i], jl_type=julia_type(cpp_types[i]), element="", output=false, length_index=0)
+        end
+    end for i in 1:n]
+end
+
+"""
+Array plan of a binary symbol (parameter names as in its generated wrapper)
+"""
+function symbol_array_parameters(wrapper::BinaryWrapper, symbol::Dict{String,Any})
+    params = symbol["parameters"]
+    names = [isempty(p["name"]) ? "arg$i" : make_julia_identifier(p["name"]) for (i, p) in enumerate(params)]
+    cpp_types = String[something(p["type"], "") for p in params]
+    return array_parameters(names, cpp_types, t -> infer_julia_type(wrapper, t))
+end
+
+"""
+    generate_array_methods(julia_name, c_name, plan, return_type, target; check="") -> String
+
+Methods taking arrays for every `:array` parameter of `plan`: lengths come from the
+arrays, data pointers are passed under `GC.@preserve` without copying (inputs that
+are not contiguous are copied once), so a whole array costs one `ccall`. A `void`
+function with a single output array also gets a method that allocates and returns it.
+`target` is the `ccall` callee (pointer slot or `(:name, lib)`); `check` an optional
+first statement. The module needs `generate_array_helpers()`.
+"""
+function generate_array_methods(julia_name::String, c_name::String, plan::Vector, return_type::String,
+                                target::String; check::String="")::String
+    arrays = [p for p in plan if p.kind == :array]
+    array_arg(p) = p.kind == :array ? "$(p.name)::AbstractArray{$(p.element)}" : "$(p.name)::$(p.jl_type)"
+    method_args = [array_arg(p) for p in plan if p.kind != :length]
+
+    body = String[]
+    isempty(check) || push!(body, check)
+    for (index, p) in enumerate(plan)
+        p.kind == :length || continue
+        sized = [a for a in arrays if a.length_index == index]
+        push!(body, "$(p.name) = Base.length($(sized[1].name))")
+        for other in sized[2:end]
+            push!(body, "Base.length($(other.name)) == $(p.name) || throw(DimensionMismatch(" *
+                        "\"$(other.name) has length \$(Base.length($(other.name))), expected \$($(p.name))\"))")
+        end
+    end
+    for a in arrays
+        push!(body, a.output ? "$(a.name) = _c_output($(a.name), :$(a.name))" : "$(a.name) = _c_input($(a.name))")
+    end
+
+    outputs = [a for a in arrays if a.output]
+    returned = (return_type == "Cvoid" && length(outputs) == 1) ? outputs[1].name : "_result"
+    ccall_types = join([p.jl_type for p in plan], ", ") * ","
+    ccall_args = join([p.kind == :array ? "Base.pointer($(p.name))" : p.name for p in plan], ", ")
+
+    content = """
+    """
+        $julia_name($(join([p.name for p in plan if p.kind != :length], ", ")))
+
+    Array method of `$c_name`: lengths are taken from the arrays and the data is passed
+    without copying, one call for the whole array.$(returned == "_result" ? "" : " Returns `$returned`.")
+    """
+    function $julia_name($(join(method_args, ", ")))
+    $(join(["    " * line for line in body], "\n"))
+        _result = GC.@preserve $(join([a.name for a in arrays], " ")) ccall(
+            $target,
+            $return_type,
+            ($ccall_types),
+            $ccall_args
+        )
+        return $returned
+    end
+    """
+
+    # Allocating form: the output takes the shape of an input of the same length
+    if returned != "_result"
+        output = outputs[1]
+        source = findfirst(a -> !a.output && a.length_index == output.length_index, arrays)
+        if !isnothing(source)
+            alloc_args = [array_arg(p) for p in plan if p.kind != :length && p.name != output.name]
+            call_args = [p.name for p in plan if p.kind != :length]
+            content *= """
+
+            """
+                $julia_name($(join([p.name for p in plan if p.kind != :length && p.name != output.name], ", ")))
+
+            Allocating method of `$c_name`: returns a new `$(output.name)`.
+            """
+            function $julia_name($(join(alloc_args, ", ")))
+                $(output.name) = Array{$(output.element)}(undef, Base.size($(arrays[source].name)))
+                return $julia_name($(join(call_args, ", ")))
+            end
+            """
+        end
+    end
+
+    return content
+end
+
+"""
+Helpers used by array methods: contiguous arrays go to C as they are
+"""
+function generate_array_helpers()::String
+    return """
+    # Arrays handed to C: contiguous ones as they are, other inputs copied once
+    _iscontiguous(a::DenseArray) = true
+    _iscontiguous(a::StridedArray) = strides(a) == Base.size_to_strides(1, size(a)...)
+    _iscontiguous(a::AbstractArray) = false
+
+    _c_input(a::AbstractArray) = _iscontiguous(a) ? a : collect(a)
+
+    function _c_output(a::AbstractArray, name::Symbol)
+        _iscontiguous(a) || throw(ArgumentError("\$name is written in place and must be a contiguous array"))
+        return a
+    end
+
+    """
+end
+
 """
 Generate data wrapper
 """
-function generate_data_wrapper(wrapper::BinaryWrapper, symbol::Dict{String,Any}, lib_name::String)::Union{String,Nothing}
+function generate_data_wrapper(wrapper::BinaryWrapper, symbol::Dict{String,Any}, lib_name::String;
+                               slot::Union{String,Nothing}=nothing)::Union{String,Nothing}
     data_name = symbol["name"]
     julia_name = make_julia_identifier(data_name)
 
@@ -930,12 +1489,15 @@ function generate_data_wrapper(wrapper::BinaryWrapper, symbol::Dict{String,Any},
     function get_$julia_name()
     """
 
-    if wrapper.config.safety_checks
+    if !isnothing(slot)
+        wrapper_content *= "    $(slot_check(wrapper, slot, symbol))\n"
+    elseif wrapper.config.safety_checks
         wrapper_content *= "    @check_loaded()\n"
     end
 
+    address = isnothing(slot) ? "cglobal(($(repr(Symbol(link_name(symbol)))), _lib_handle[]), Ptr{Cvoid})" : "Ptr{Ptr{Cvoid}}($slot[])"
     wrapper_content *= """
-        ptr = cglobal((:$data_name, _lib_handle[]), Ptr{Cvoid})
+        ptr = $address
         # Note: You may need to adjust the type based on the actual data type
         return unsafe_load(ptr)
     end
@@ -1237,14 +1799,15 @@ function generate_main_module(wrapper::BinaryWrapper, module_names::Vector{Strin
         """
     end
 
+    # Lazy wrappers stay unopened (and precompilable) until first use
+    show_status = wrapper.config.call_mode == :lazy ? "" : "# Show status on load\nstatus()\n"
+
     content *= """
     end
 
     export status
 
-    # Show status on load
-    status()
-
+    $show_status
     end # module
     """
 
@@ -1301,8 +1864,14 @@ function generate_wrappers(wrapper::BinaryWrapper; specific_binary::Union{String
         println("   Symbols: $(length(binary.symbols))")
 
         # Generate wrapper
-        wrapper_content = generate_wrapper(wrapper, binary)
         module_name = generate_module_name(binary.name)
+        if wrapper.config.call_mode == :lazy
+            wrapper_content, shards = generate_lazy_wrapper(wrapper, binary)
+            write_shards(wrapper.config.output_dir, module_name, shards)
+            println("   📦 Shards: $(length(shards))")
+        else
+            wrapper_content = generate_wrapper(wrapper, binary)
+        end
 
         # Write wrapper file
         wrapper_file = joinpath(wrapper.config.output_dir, "$module_name.jl")
@@ -1447,6 +2016,8 @@ function main()
             config.generate_tests,
             config.generate_docs,
             config.safety_checks,
+            config.call_mode,
+            config.shard_size,
             config.use_headers,
             config.header_parser,
             config.type_hints,
@@ -6,6 +6,10 @@
 module LLVMEnvironment
 
 using Pkg
+using TOML
+using SHA
+
+include("Tracing.jl")
 
 # Conditional import - will try to use LLVM_full_assert_jll if available
 const LLVM_JLL_AVAILABLE = Ref{Bool}(false)
@@ -339,6 +343,151 @@ function build_environment_vars(llvm_root::String, bin_dir::String, lib_dir::Str
     return env_vars
 end
 
+# ============================================================================
+# TOOLCHAIN MANIFEST
+# ============================================================================
+
+# Bump when the manifest layout or the discovery rules change
+const MANIFEST_VERSION = 1
+
+# Binaries whose mtime and size identify an installation (next to the bin/lib dir mtimes)
+const FINGERPRINT_TOOLS = ["llvm-config", "clang", "clang++", "opt", "llvm-link", "llc", "ld.lld"]
+
+# Manifest of the toolchain initialized last in this process: (file, contents)
+const ACTIVE_MANIFEST = Ref{Union{Tuple{String,Dict{String,Any}},Nothing}}(nothing)
+const MANIFEST_LOCK = ReentrantLock()
+
+"""
+    manifest_dir() -> String
+
+Directory of the persisted toolchain manifests (`JMAKE_TOOLCHAIN_CACHE`, or
+`~/.julia/jmake/toolchains`), shared by every process and daemon worker on the host.
+"""
+manifest_dir() = get(ENV, "JMAKE_TOOLCHAIN_CACHE", joinpath(first(DEPOT_PATH), "jmake", "toolchains"))
+
+"""
+    manifest_path(llvm_root::String, source::String) -> String
+"""
+manifest_path(llvm_root::String, source::String) =
+    joinpath(manifest_dir(), bytes2hex(sha1("$source:$(abspath(llvm_root))"))[1:16] * ".toml")
+
+"""
+    toolchain_fingerprint(llvm_root::String, bin_dir::String, lib_dir::String) -> String
+
+Hash of the installation root, the bin and lib directory mtimes and the mtime and size
+of the main binaries. Installing, removing or replacing a tool or library changes it;
+computing it only takes `stat` calls.
+"""
+function toolchain_fingerprint(llvm_root::String, bin_dir::String, lib_dir::String)
+    entries = ["manifest $MANIFEST_VERSION", "root $(abspath(llvm_root))"]
+    for path in [bin_dir, lib_dir, (joinpath(bin_dir, tool) for tool in FINGERPRINT_TOOLS)...]
+        st = stat(path)
+        push!(entries, "$path $(st.mtime) $(st.size)")
+    end
+    return bytes2hex(sha1(join(entries, '\n')))
+end
+
+"""
+    load_manifest(file::String, fingerprint::String) -> Union{Dict{String,Any},Nothing}
+
+Persisted discovery results, or `nothing` when missing, unreadable or stale.
+"""
+function load_manifest(file::String, fingerprint::String)
+    isfile(file) || return nothing
+    manifest = try
+        TOML.parsefile(file)
+    catch e
+        @warn "Ignoring unreadable toolchain manifest $file: $e"
+        return nothing
+    end
+    return get(manifest, "fingerprint", "") == fingerprint ? manifest : nothing
+end
+
+"""
+    save_manifest(file::String, manifest::Dict{String,Any})
+
+Write a manifest atomically, so concurrent writers and readers never see a partial file.
+"""
+function save_manifest(file::String, manifest::Dict{String,Any})
+    try
+        mkpath(dirname(file))
+        tmp = "$file.tmp.$(getpid()).$(rand(UInt64))"
+        open(io -> TOML.print(io, manifest; sorted=true), tmp, "w")
+        mv(tmp, file, force=true)
+    catch e
+        @warn "Could not write toolchain manifest $file: $e"
+    end
+end
+
+"""
+    tool_version(tool_path::String) -> String
+
+`<tool> --version` output. Served from the toolchain manifest while the binary's mtime
+and size are unchanged; otherwise the tool runs once and the manifest records the result.
+"""
+function tool_version(tool_path::String)
+    path = isfile(tool_path) ? abspath(tool_path) : something(Sys.which(tool_path), tool_path)
+    st = stat(path)
+    stamp = Dict{String,Any}("mtime" => st.mtime, "size" => st.size)
+
+    active = ACTIVE_MANIFEST[]
+    if active !== nothing
+        entry = lock(() -> get(get(active[2], "tool_versions", Dict()), path, nothing), MANIFEST_LOCK)
+        if entry !== nothing && entry["mtime"] == stamp["mtime"] && entry["size"] == stamp["size"]
+            Tracing.count_cache!("tool_version", true)
+            return entry["output"]
+        end
+    end
+    Tracing.count_cache!("tool_version", false)
+
+    output = try
+        read(`$path --version`, String)
+    catch
+        return "unknown"
+    end
+
+    if active !== nothing
+        lock(MANIFEST_LOCK) do
+            versions = get!(active[2], "tool_versions", Dict{String,Any}())
+            versions[path] = merge(stamp, Dict{String,Any}("output" => output))
+            save_manifest(active[1], active[2])
+        end
+    end
+    return output
+end
+
+"""
+    probe_toolchain(llvm_root::String, source::String, llvm_config::String) -> Dict{String,Any}
+
+Discover tools and libraries and query `llvm-config`, as a new manifest.
+"""
+function probe_toolchain(llvm_root::String, source::String, llvm_config::String)
+    println("   Tools: Auto-discovering")
+
+    version_str = "20.1.2jl"  # Default
+    if isfile(llvm_config)
+        try
+            version_str = String(strip(read(`$llvm_config --version`, String)))
+        catch
+            @warn "Could not query LLVM version, using default: $version_str"
+        end
+    end
+
+    (cxxflags, ldflags, libs) = query_llvm_config(llvm_config)
+    return Dict{String,Any}(
+        "version" => MANIFEST_VERSION,
+        "root" => abspath(llvm_root),
+        "source" => source,
+        "llvm_version" => version_str,
+        "tools" => discover_llvm_tools(llvm_root, source),
+        "libraries" => discover_llvm_libraries(llvm_root),
+        "cxxflags" => String.(cxxflags),
+        "ldflags" => String.(ldflags),
+        "libs" => String(libs),
+        "tool_versions" => Dict{String,Any}()
+    )
+end
+
 """
     init_toolchain(;isolated::Bool=true, config=nothing, source::Symbol=:auto) -> LLVMToolchain
 
@@ -392,19 +541,23 @@ function init_toolchain(; isolated::Bool=true, config=nothing, source::Symbol=:a
         end
     end
 
-    # Get version
+    # Discovery results persist across processes while the installation is unchanged
     llvm_config = joinpath(bin_dir, "llvm-config")
-    version_str = "20.1.2jl"  # Default
-
-    if isfile(llvm_config)
-        try
-            version_str = String(strip(read(`$llvm_config --version`, String)))
-        catch
-            @warn "Could not query LLVM version, using default: $version_str"
-        end
+    manifest_file = manifest_path(llvm_root, toolchain_source)
+    fingerprint = toolchain_fingerprint(llvm_root, bin_dir, lib_dir)
+    manifest = load_manifest(manifest_file, fingerprint)
+
+    if !Tracing.count_cache!("toolchain_manifest", manifest !== nothing)
+        manifest = Tracing.span(() -> probe_toolchain(llvm_root, toolchain_source, llvm_config), "probe_toolchain")
+        manifest["fingerprint"] = fingerprint
+        save_manifest(manifest_file, manifest)
+    else
+        println("   Manifest: $manifest_file")
     end
+    ACTIVE_MANIFEST[] = (manifest_file, manifest)
 
-    (major, minor, patch) = parse_llvm_version(String(version_str))
+    version_str = manifest["llvm_version"]
+    (major, minor, patch) = parse_llvm_version(version_str)
 
     println("   Version: $version_str (LLVM $major.$minor.$patch)")
 
@@ -414,9 +567,8 @@ function init_toolchain(; isolated::Bool=true, config=nothing, source::Symbol=:a
         println("   Tools: Reading from TOML")
         config.llvm["tools"]
     else
-        # Auto-discover and update TOML
-        println("   Tools: Auto-discovering")
-        discovered = discover_llvm_tools(llvm_root, toolchain_source)
+        # Auto-discovered (or from the manifest) and update TOML
+        discovered = Dict{String,String}(manifest["tools"])
         if config !== nothing
             config.llvm["tools"] = discovered
         end
@@ -431,12 +583,12 @@ function init_toolchain(; isolated::Bool=true, config=nothing, source::Symbol=:a
         end
     end
 
-    # Discover libraries
-    libraries = discover_llvm_libraries(llvm_root)
+    libraries = Dict{String,String}(manifest["libraries"])
     println("   Libraries: $(length(libraries)) discovered")
 
-    # Query llvm-config
-    (cxxflags, ldflags, libs) = query_llvm_config(llvm_config)
+    cxxflags = String.(manifest["cxxflags"])
+    ldflags = String.(manifest["ldflags"])
+    libs = manifest["libs"]
 
     # Build environment variables
     env_vars = build_environment_vars(llvm_root, bin_dir, lib_dir)
@@ -479,11 +631,53 @@ function get_toolchain()
     return GLOBAL_LLVM_TOOLCHAIN[]
 end
 
+# Toolchain environment merged over the process environment, built once per toolchain
+const TOOLCHAIN_ENV = Ref{Union{Tuple{LLVMToolchain,Vector{String}},Nothing}}(nothing)
+const TOOLCHAIN_ENV_LOCK = ReentrantLock()
+
+"""
+    llvm_env(toolchain::LLVMToolchain=get_toolchain()) -> Vector{String}
+
+`"KEY=value"` environment for processes run with the toolchain: the process environment
+as of the first request, with the toolchain's `env_vars` applied. It is computed once per
+toolchain and never written to `ENV`, so it can be shared by commands spawned from any task
+or thread. Set `TOOLCHAIN_ENV[] = nothing` to pick up later changes to `ENV`.
+"""
+function llvm_env(toolchain::LLVMToolchain=get_toolchain())
+    lock(TOOLCHAIN_ENV_LOCK) do
+        cached = TOOLCHAIN_ENV[]
+        if cached === nothing || cached[1] !== toolchain
+            env = merge(Dict{String,String}(ENV), toolchain.env_vars)
+            cached = (toolchain, sort!(["$key=$value" for (key, value) in env]))
+            TOOLCHAIN_ENV[] = cached
+        end
+        return cached[2]
+    end
+end
+
+"""
+    llvm_cmd(cmd::Cmd; toolchain::LLVMToolchain=get_toolchain()) -> Cmd
+
+`cmd` with the toolchain environment attached. A command without its own environment
+shares the precomputed `llvm_env` vector; one with an environment gets the toolchain
+variables added to it. The process-global `ENV` is not touched.
+
+# Example
+```julia
+run(llvm_cmd(`clang++ --version`))
+```
+"""
+function llvm_cmd(cmd::Cmd; toolchain::LLVMToolchain=get_toolchain())
+    cmd.env === nothing && return setenv(cmd, llvm_env(toolchain))
+    return addenv(cmd, toolchain.env_vars)
+end
+
 """
     with_llvm_env(f::Function)
 
 Execute function with LLVM environment variables set.
-Temporarily modifies ENV for the duration of the function call.
+Temporarily modifies ENV for the duration of the function call, so it must not be used
+while other tasks spawn processes; prefer `llvm_cmd` for individual commands.
 
 # Example
 ```julia
@@ -594,28 +788,26 @@ function run_tool(tool_name::String, args::Vector{String}; capture_output::Bool=
     end
 
     # Run with LLVM environment
-    return with_llvm_env() do
-        cmd = `$tool_path $args`
+    cmd = llvm_cmd(`$tool_path $args`)
 
-        try
-            if capture_output
+    try
+        if capture_output
+            output = read(cmd, String)
+            return (output, 0)
+        else
+            run(cmd)
+            return ("", 0)
+        end
+    catch e
+        if isa(e, ProcessFailedException)
+            try
                 output = read(cmd, String)
-                return (output, 0)
-            else
-                run(cmd)
-                return ("", 0)
-            end
-        catch e
-            if isa(e, ProcessFailedException)
-                try
-                    output = read(cmd, String)
-                    return (output, 1)
-                catch
-                    return ("Process failed: $e", 1)
-                end
-            else
-                return ("Error: $e", 1)
+                return (output, 1)
+            catch
+                return ("Process failed: $e", 1)
             end
+        else
+            return ("Error: $e", 1)
         end
     end
 end
@@ -739,6 +931,9 @@ export LLVMToolchain,
     get_toolchain,
     init_toolchain,
     with_llvm_env,
+    llvm_env,
+    llvm_cmd,
+    tool_version,
     get_tool,
     has_tool,
     get_library,
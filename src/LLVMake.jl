@@ -9,11 +9,27 @@ using Pkg
 using JSON
 using TOML
 using Dates
+using SHA
 
 # Load BuildBridge for error learning and command execution
 include("BuildBridge.jl")
 using .BuildBridge
 
+# Content-addressed IR cache shared with Bridge_LLVM and the compilation daemon
+include("BuildCache.jl")
+using .BuildCache
+
+# Streaming main-file signature extraction from clang's JSON AST
+include("ASTSignatures.jl")
+using .ASTSignatures
+
+# Include graph harvested from compile-time depfiles
+include("ASTWalker.jl")
+using .ASTWalker
+
+# Per-stage spans and cache counters (JMAKE_TRACE)
+include("Tracing.jl")
+
 """
 Configuration for LLVM compilation targets and options
 """
@@ -25,6 +41,7 @@ struct TargetConfig
     debug::Bool                 # Include debug symbols
     lto::Bool                   # Link-time optimization
     sanitizers::Vector{String}  # Address, thread, memory sanitizers
+    variants::Vector{String}    # Extra CPUs, each codegen'd from the same IR into its own library
 
     function TargetConfig(;
         triple::String="",
@@ -33,9 +50,10 @@ struct TargetConfig
         opt_level::String="O2",
         debug::Bool=false,
         lto::Bool=false,
-        sanitizers::Vector{String}=String[]
+        sanitizers::Vector{String}=String[],
+        variants::Vector{String}=String[]
     )
-        new(triple, cpu, features, opt_level, debug, lto, sanitizers)
+        new(triple, cpu, features, opt_level, debug, lto, sanitizers, unique(variants))
     end
 end
 
@@ -63,12 +81,31 @@ struct CompilerConfig
     libraries::Vector{String}
     defines::Dict{String,String}
     extra_flags::Vector{String}
+    jobs::Int                   # Concurrent clang/llvm processes
+    keep_going::Bool            # Keep compiling other TUs/components after a failure
+    emit_bitcode::Bool          # .bc through link, opt and codegen (false: textual .ll at every stage)
+    emit_text_ir::Bool          # Also dump each component's linked bitcode as .ll (debugging)
+    pch::Bool                   # Precompile each component's most widely included headers
+    pch_threshold::Float64      # Share of a component's TUs that must include a PCH member
+    unity::Bool                 # Compile each component as batches of concatenated TUs
+    unity_batch_size::Int       # Most TUs per unity batch
+    unity_batch_bytes::Int      # Most source bytes per unity batch
 
     # Binding generation
     binding_style::Symbol  # :simple, :advanced, :cxxwrap
     type_mappings::Dict{String,String}
     exclude_patterns::Vector{Regex}
     include_patterns::Vector{Regex}
+
+    # Artifact cache
+    cache_enabled::Bool
+    cache_dir::String
+    cache_remote::String   # shared store URL or path ("" = local only)
+
+    # Profile-guided optimization
+    pgo::Bool
+    pgo_training::String   # Julia script exercising the bindings (default: [test] stage's runtests.jl)
+    pgo_max_drift::Float64 # Share of changed inputs after which the profile is retrained
 end
 
 """
@@ -137,7 +174,8 @@ function load_config(config_file::String)::CompilerConfig
         opt_level=get(target_data, "opt_level", "O2"),
         debug=get(target_data, "debug", false),
         lto=get(target_data, "lto", false),
-        sanitizers=String[get(target_data, "sanitizers", String[])...]  # Convert to String[] to handle TOML empty arrays
+        sanitizers=String[get(target_data, "sanitizers", String[])...],  # Convert to String[] to handle TOML empty arrays
+        variants=String[get(target_data, "variants", String[])...]
     )
 
     # Parse compilation settings
@@ -147,6 +185,15 @@ function load_config(config_file::String)::CompilerConfig
     libraries = get(compile, "libraries", String[])
     defines = Dict(String(k) => String(v) for (k, v) in get(compile, "defines", Dict()))
     extra_flags = get(compile, "extra_flags", String[])
+    jobs = max(1, get(compile, "jobs", Sys.CPU_THREADS))
+    keep_going = get(compile, "keep_going", true)
+    emit_bitcode = get(compile, "emit_bc", true)
+    emit_text_ir = get(compile, "emit_ir", false)
+    pch = get(compile, "pch", false)
+    pch_threshold = Float64(get(compile, "pch_threshold", 0.5))
+    unity = get(compile, "unity", false)
+    unity_batch_size = max(1, get(compile, "unity_batch_size", 8))
+    unity_batch_bytes = 1024 * max(1, get(compile, "unity_batch_kb", 256))
 
     # Parse binding settings
     bindings = get(config_data, "bindings", Dict())
@@ -155,11 +202,27 @@ function load_config(config_file::String)::CompilerConfig
     exclude_patterns = [Regex(p) for p in get(bindings, "exclude_patterns", String[])]
     include_patterns = [Regex(p) for p in get(bindings, "include_patterns", String[])]
 
+    # Parse cache settings
+    cache = get(config_data, "cache", Dict())
+    cache_enabled = get(cache, "enabled", true)
+    cache_dir = BuildCache.project_cache_dir(project_root, cache)
+    cache_remote = get(cache, "remote", get(ENV, "JMAKE_REMOTE_CACHE", ""))
+
+    # Parse PGO settings (the training run defaults to the [test] stage)
+    pgo_data = get(config_data, "pgo", Dict())
+    test_dir = get(get(config_data, "test", Dict()), "test_dir", "test")
+    pgo = get(pgo_data, "enabled", false)
+    pgo_training = joinpath(project_root, get(pgo_data, "training", joinpath(test_dir, "runtests.jl")))
+    pgo_max_drift = Float64(get(pgo_data, "max_drift", 0.25))
+
     return CompilerConfig(
         project_root, source_dir, output_dir, build_dir,
         llvm_root, clang_path, llvm_config_path, llvm_link_path, opt_path,
-        target, include_dirs, lib_dirs, libraries, defines, extra_flags,
-        binding_style, type_mappings, exclude_patterns, include_patterns
+        target, include_dirs, lib_dirs, libraries, defines, extra_flags, jobs, keep_going,
+        emit_bitcode, emit_text_ir, pch, pch_threshold, unity, unity_batch_size, unity_batch_bytes,
+        binding_style, type_mappings, exclude_patterns, include_patterns,
+        cache_enabled, cache_dir, cache_remote,
+        pgo, pgo_training, pgo_max_drift
     )
 end
 
@@ -190,12 +253,22 @@ function create_default_config(config_file::String)
     debug = false            # Include debug symbols
     lto = false              # Link-time optimization
     sanitizers = []          # ["address", "thread", "memory"]
+    variants = []            # Extra CPU libraries picked at load time: ["haswell", "skylake-avx512"]
 
     [compile]
     include_dirs = ["include", "third_party/include"]
     lib_dirs = ["lib", "third_party/lib"]
     libraries = []           # External libraries to link
     extra_flags = []         # Additional compiler flags
+    # jobs = 16              # Concurrent compiler processes (default: core count)
+    keep_going = true        # Keep building other files/components after a failure
+    emit_bc = true           # Bitcode pipeline; false keeps textual .ll at every stage
+    emit_ir = false          # Also write each component's linked module as .ll (debugging)
+    pch = false              # Precompile headers included by most TUs of a component
+    pch_threshold = 0.5      # Share of the component's TUs that must include a header
+    unity = false            # Compile components as batches of concatenated TUs
+    unity_batch_size = 8     # Most TUs per batch
+    unity_batch_kb = 256     # Most source KiB per batch
 
     [compile.defines]
     # NDEBUG = "1"
@@ -212,6 +285,16 @@ function create_default_config(config_file::String)
     "std::vector<double>" = "Vector{Float64}"
     "std::vector<float>" = "Vector{Float32}"
     "std::vector<int>" = "Vector{Int32}"
+
+    [cache]
+    enabled = true           # Content-addressed IR cache
+    # directory = ".jmake_cache"  # Default; JMAKE_CACHE_DIR overrides
+    # remote = "https://cache.example.com/jmake"  # Shared store (URL or path); JMAKE_REMOTE_CACHE
+
+    [pgo]
+    enabled = false          # Instrument, train, then rebuild the libraries with the profile
+    # training = "test/runtests.jl"  # Julia script using the bindings (default: [test] test_dir)
+    max_drift = 0.25         # Retrain once this share of the profiled inputs changed
     """
 
     open(config_file, "w") do f
@@ -220,7 +303,7 @@ function create_default_config(config_file::String)
 end
 
 """
-Find a tool in system PATH or use provided path
+Find a tool in system PATH or use provided path (looked up in-process, nothing is spawned)
 """
 function find_tool(tool_name::String, provided_path::String="")
     if !isempty(provided_path) && isfile(provided_path)
@@ -231,20 +314,30 @@ function find_tool(tool_name::String, provided_path::String="")
     suffixes = ["", "-15", "-14", "-13", "-12", "-11"]
 
     for suffix in suffixes
-        tool = tool_name * suffix
-        try
-            result = strip(read(`which $tool`, String))
-            if !isempty(result) && isfile(result)
-                return result
-            end
-        catch
-            continue
+        result = Sys.which(tool_name * suffix)
+        if !isnothing(result) && isfile(result)
+            return result
         end
     end
 
     error("❌ Tool not found: $tool_name")
 end
 
+"""
+`--version` output of a build tool from the toolchain manifest (the tool runs only when
+the manifest does not know the binary yet); also seeds the artifact cache's toolchain key
+"""
+function compiler_version(tool::String)
+    try
+        BuildBridge.LLVMEnvironment.get_toolchain()
+    catch
+        # No managed toolchain: the version is still probed once and memoized
+    end
+    output = BuildBridge.LLVMEnvironment.tool_version(tool)
+    output == "unknown" || BuildCache.remember_toolchain_version!(tool, output)
+    return output
+end
+
 """
 Get compiler flags for the target configuration
 """
@@ -309,28 +402,82 @@ function get_compiler_flags(compiler::LLVMJuliaCompiler)
     return flags
 end
 
+"""
+Output-kind flags for per-TU IR: bitcode (`-c`) unless `emit_bc = false`. With CPU
+variants the LLVM passes are left to codegen, so each variant vectorizes for its own ISA.
+"""
+function ir_output_flags(compiler::LLVMJuliaCompiler)
+    flags = compiler.config.emit_bitcode ? ["-c", "-emit-llvm"] : ["-S", "-emit-llvm"]
+    isempty(compiler.config.target.variants) || append!(flags, ["-Xclang", "-disable-llvm-passes"])
+    return flags
+end
+
+"""
+File extension of the IR produced by the configured pipeline
+"""
+function ir_extension(compiler::LLVMJuliaCompiler)
+    return compiler.config.emit_bitcode ? ".bc" : ".ll"
+end
+
+# ============================================================================
+# JOB POOL
+# ============================================================================
+
+"""
+Toolchain environment for commands spawned by the build, or `nothing` without a toolchain
+"""
+function toolchain_env()
+    try
+        return BuildBridge.LLVMEnvironment.llvm_env()
+    catch
+        return nothing
+    end
+end
+
+"""
+Execute a build tool, holding a slot of `pool` (if given) for the lifetime of the process
+"""
+function run_build_tool(tool::String, args::Vector{String}; pool::Union{Base.Semaphore,Nothing}=nothing)
+    run_tool() = BuildBridge.execute(tool, args)
+    return isnothing(pool) ? run_tool() : Base.acquire(run_tool, pool)
+end
+
+"""
+Map `f` over `items` with at most `jobs` tasks in flight, preserving input order
+"""
+function parallel_map(f::Function, items::Vector, jobs::Int)
+    results = Vector{Any}(undef, length(items))
+    queue = Channel{Int}(length(items))
+    foreach(i -> put!(queue, i), eachindex(items))
+    close(queue)
+
+    @sync for _ in 1:clamp(jobs, 1, max(length(items), 1))
+        @async for i in queue
+            results[i] = f(items[i])
+        end
+    end
+
+    return results
+end
+
 """
 Parse C++ file using Clang AST
+Only declarations from `cpp_file` itself are kept; included headers are streamed past
 """
 function parse_cpp_ast(compiler::LLVMJuliaCompiler, cpp_file::String)
     println("🔍 Parsing AST: $cpp_file")
 
-    # Create temporary AST dump file
-    ast_file = joinpath(compiler.config.build_dir, "$(basename(cpp_file)).ast.json")
-    mkpath(dirname(ast_file))
-
     flags = get_compiler_flags(compiler)
+    cache = artifact_cache(compiler)
 
     try
-        # Generate AST dump
-        cmd = `$(compiler.config.clang_path) -Xclang -ast-dump=json -fsyntax-only $flags $cpp_file`
-        ast_json = read(cmd, String)
-
-        # Parse JSON AST
-        ast = JSON.parse(ast_json)
+        isnothing(cache) || compiler_version(compiler.config.clang_path)
 
-        # Extract function information
-        functions = extract_functions_from_ast(ast)
+        # Main-file function signatures, from the shared cache when nothing changed
+        functions = Tracing.span("signatures"; file=cpp_file) do
+            cached_main_file_signatures(cache, compiler.config.clang_path, flags, cpp_file;
+                                        env=toolchain_env())
+        end
 
         # Apply include/exclude patterns
         filtered_functions = filter_functions(functions, compiler.config)
@@ -344,60 +491,10 @@ function parse_cpp_ast(compiler::LLVMJuliaCompiler, cpp_file::String)
 end
 
 """
-Extract function information from Clang AST
+Extract function information from an already parsed Clang AST
 """
 function extract_functions_from_ast(ast::Dict)
-    functions = []
-
-    function visit_node(node::Dict)
-        if get(node, "kind", "") == "FunctionDecl"
-            # Skip if not a definition or is implicit
-            if get(node, "isImplicit", false) || !haskey(node, "inner")
-                return
-            end
-
-            func_info = Dict{String,Any}(
-                "name" => get(node, "name", ""),
-                "return_type" => get(get(node, "type", Dict()), "qualType", "void"),
-                "params" => []
-            )
-
-            # Extract parameters
-            if haskey(node, "inner")
-                for inner in node["inner"]
-                    if get(inner, "kind", "") == "ParmVarDecl"
-                        param = Dict(
-                            "name" => get(inner, "name", ""),
-                            "type" => get(get(inner, "type", Dict()), "qualType", "")
-                        )
-                        push!(func_info["params"], param)
-                    end
-                end
-            end
-
-            push!(functions, func_info)
-        end
-
-        # Recursively visit children
-        if haskey(node, "inner")
-            for child in node["inner"]
-                if isa(child, Dict)
-                    visit_node(child)
-                end
-            end
-        end
-    end
-
-    # Start traversal from root
-    if haskey(ast, "inner")
-        for node in ast["inner"]
-            if isa(node, Dict)
-                visit_node(node)
-            end
-        end
-    end
-
-    return functions
+    return signatures_from_ast(ast)
 end
 
 """
@@ -405,7 +502,7 @@ Simple C++ parsing fallback
 """
 function parse_cpp_simple(compiler::LLVMJuliaCompiler, cpp_file::String)
     content = read(cpp_file, String)
-    functions = []
+    functions = FunctionSignature[]
 
     # Enhanced regex for function detection
     func_pattern = r"(?:(?:static|inline|extern|virtual|constexpr)\s+)*([a-zA-Z_][\w:*&\s]*?)\s+([a-zA-Z_]\w*)\s*\(([^)]*)\)\s*(?:const)?\s*(?:noexcept)?\s*[{;]"m
@@ -422,7 +519,7 @@ function parse_cpp_simple(compiler::LLVMJuliaCompiler, cpp_file::String)
         end
 
         # Parse parameters
-        params = []
+        params = ParamSignature[]
         if !isempty(strip(params_str)) && strip(params_str) != "void"
             param_parts = split(params_str, ",")
             for param in param_parts
@@ -432,20 +529,14 @@ function parse_cpp_simple(compiler::LLVMJuliaCompiler, cpp_file::String)
                 if length(parts) >= 2
                     param_type = join(parts[1:end-1], " ")
                     param_name = parts[end]
-                    push!(params, Dict("type" => param_type, "name" => param_name))
+                    push!(params, ParamSignature(param_name, param_type))
                 elseif length(parts) == 1 && parts[1] != "void"
-                    push!(params, Dict("type" => parts[1], "name" => ""))
+                    push!(params, ParamSignature("", parts[1]))
                 end
             end
         end
 
-        func_info = Dict{String,Any}(
-            "name" => func_name,
-            "return_type" => return_type,
-            "params" => params
-        )
-
-        push!(functions, func_info)
+        push!(functions, FunctionSignature(func_name, return_type, params))
     end
 
     return functions
@@ -454,8 +545,8 @@ end
 """
 Filter functions based on include/exclude patterns
 """
-function filter_functions(functions::Vector, config::CompilerConfig)
-    filtered = []
+function filter_functions(functions::Vector{FunctionSignature}, config::CompilerConfig)
+    filtered = FunctionSignature[]
 
     # Default exclusions for production
     default_excludes = [
@@ -469,7 +560,7 @@ function filter_functions(functions::Vector, config::CompilerConfig)
     ]
 
     for func in functions
-        func_name = func["name"]
+        func_name = func.name
 
         # Skip empty names
         if isempty(func_name)
@@ -501,92 +592,201 @@ function filter_functions(functions::Vector, config::CompilerConfig)
 end
 
 """
-Compile C++ files to LLVM IR
+Compile C++ files to LLVM IR (`.bc` bitcode, or textual `.ll` with `emit_bc = false`)
+
+Translation units run concurrently, bounded by `pool` (default: `[compile] jobs` slots).
+Each one is looked up in the content-addressed cache first (key: source bytes + header
+closure + flags + clang version); only misses invoke clang. Failures are recorded and
+reported per file once all TUs have finished; with `keep_going=false` no new TU is
+started after the first failure. Every TU writes a `-MMD -MF` depfile (system headers left out), which updates the
+persisted include graph (`depfile_graph_path`) for the files of this run. A `pch` (see
+`build_pch`) is passed with `-include-pch`; its path carries its own key, so it is part
+of every TU key. With a `failures` dict, the command args and output of failed TUs are
+collected there instead of being reported (unity batches, see `compile_unity`).
 """
-function compile_to_ir(compiler::LLVMJuliaCompiler, cpp_files::Vector{String})
+function compile_to_ir(compiler::LLVMJuliaCompiler, cpp_files::Vector{String};
+                       pool::Union{Base.Semaphore,Nothing}=nothing,
+                       keep_going::Bool=compiler.config.keep_going,
+                       pch::Union{String,Nothing}=nothing,
+                       failures::Union{Dict{String,Tuple{Vector{String},String}},Nothing}=nothing)
     println("🔧 Compiling to LLVM IR...")
 
-    ir_files = String[]
     flags = get_compiler_flags(compiler)
-    db = BuildBridge.get_error_db(joinpath(compiler.config.build_dir, "jmake_errors.db"))
+    ir_flags = [ir_output_flags(compiler)..., flags..., BuildCache.pch_flags(pch)...]
+    ir_ext = ir_extension(compiler)
+    db_path = error_db_path(compiler)
+
+    cache = artifact_cache(compiler)
+    toolchain = ""
+    if !isnothing(cache)
+        compiler_version(compiler.config.clang_path)
+        toolchain = BuildCache.toolchain_version(compiler.config.clang_path)
+    end
+
+    pool = something(pool, Base.Semaphore(compiler.config.jobs))
+    failed = Ref(false)
 
-    for cpp_file in cpp_files
-        ir_file = joinpath(compiler.config.build_dir, "$(basename(cpp_file)).ll")
+    results = parallel_map(cpp_files, length(cpp_files)) do cpp_file
+        ir_file = BuildCache.output_path(compiler.config.build_dir, cpp_file, ir_ext)
         mkpath(dirname(ir_file))
 
-        # Build command args
-        args = ["-S", "-emit-llvm", flags..., "-o", ir_file, cpp_file]
+        depfile = ir_file * ".d"
 
-        # Execute with error learning
-        output, exitcode = BuildBridge.execute(compiler.config.clang_path, args)
+        key = (isnothing(cache) || !isfile(cpp_file)) ? "" : BuildCache.cache_key(cpp_file, ir_flags; toolchain=toolchain)
+        if !isempty(key) && BuildCache.fetch!(cache, key, ir_ext, ir_file)
+            BuildCache.fetch!(cache, key, ".d", depfile) || rm(depfile, force=true)
+            println("  ⚡ $(basename(cpp_file)) (cached)")
+            return (file=cpp_file, ir_file=ir_file, depfile=depfile, args=String[], output="", status=:cached)
+        end
 
-        if exitcode == 0
-            push!(ir_files, ir_file)
-            println("  ✓ $(basename(cpp_file)) → $(basename(ir_file))")
-        else
-            # Record error in database
-            (error_id, pattern_name, description) = BuildBridge.ErrorLearning.record_error(
-                db, "$(compiler.config.clang_path) $(join(args, " "))", output,
-                project_path=compiler.config.build_dir, file_path=cpp_file)
+        # Build command args (the depfile does not change the IR, so it stays out of the key)
+        args = [ir_flags..., "-MMD", "-MF", depfile, "-o", ir_file, cpp_file]
 
-            @error "Failed to compile $cpp_file: $pattern_name - $description"
-            println("Error output:\n$output")
+        # Execute (one pool slot per clang process)
+        outcome = Base.acquire(pool) do
+            (failed[] && !keep_going) ? nothing :
+                Tracing.span(() -> run_build_tool(compiler.config.clang_path, args), "compile_tu"; file=cpp_file)
+        end
 
-            # Get suggestions
-            suggestions = BuildBridge.ErrorLearning.suggest_fixes(db, output,
-                project_path=compiler.config.build_dir)
+        if isnothing(outcome)
+            return (file=cpp_file, ir_file=ir_file, depfile=depfile, args=args, output="", status=:skipped)
+        end
 
-            if !isempty(suggestions)
-                println("\n💡 Suggestions:")
-                for (i, sug) in enumerate(suggestions[1:min(3, length(suggestions))])
-                    println("  $i. $(sug["description"]) (confidence: $(round(sug["confidence"], digits=2)))")
-                end
+        output, exitcode = outcome
+
+        if exitcode == 0
+            if !isempty(key)
+                BuildCache.store!(cache, key, ir_ext, ir_file)
+                isfile(depfile) && BuildCache.store!(cache, key, ".d", depfile)
             end
+            println("  ✓ $(basename(cpp_file)) → $(basename(ir_file))")
+            return (file=cpp_file, ir_file=ir_file, depfile=depfile, args=args, output=output, status=:compiled)
+        end
+
+        failed[] = true
+        println("  ✗ $(basename(cpp_file))")
+        return (file=cpp_file, ir_file=ir_file, depfile=depfile, args=args, output=output, status=:failed)
+    end
+
+    ir_files = String[]
+    depfiles = Pair{String,String}[]
+    for result in results
+        if result.status in (:compiled, :cached)
+            push!(ir_files, result.ir_file)
+            push!(depfiles, result.file => result.depfile)
+        elseif result.status == :skipped
+            println("  ⏭  Skipped $(result.file) (earlier failure, keep_going=false)")
+        elseif !isnothing(failures)
+            failures[result.file] = (result.args, result.output)
+        else
+            report_compile_error(compiler, db_path, result.file, result.args, result.output)
         end
     end
 
+    # Keep the persisted include graph current for the TUs of this run only
+    ASTWalker.record_depfiles!(depfile_graph_path(compiler), depfiles)
+
+    # New artifacts reach the remote store before the CLI process can exit
+    isnothing(cache) || BuildCache.flush!(cache)
+
     return ir_files
 end
 
+"""
+Artifact cache of a compiler (`nothing` when caching is disabled), backed by the
+`[cache] remote` store when one is configured
+"""
+function artifact_cache(compiler::LLVMJuliaCompiler)
+    compiler.config.cache_enabled || return nothing
+    return BuildCache.ArtifactCache(compiler.config.cache_dir;
+                                    remote=BuildCache.remote_store(compiler.config.cache_remote))
+end
+
+"""
+Error-learning database of a compiler's build directory
+"""
+error_db_path(compiler::LLVMJuliaCompiler) = joinpath(compiler.config.build_dir, "jmake_errors.db")
+
+"""
+Location of the persisted include graph harvested from compile depfiles
+"""
+function depfile_graph_path(compiler::LLVMJuliaCompiler)
+    return ASTWalker.depfile_graph_path(compiler.config.project_root, compiler.config.cache_dir)
+end
+
+"""
+Record a failed TU compile in the error database and print its suggestions
+"""
+function report_compile_error(compiler::LLVMJuliaCompiler, db_path::String, cpp_file::String,
+                              args::Vector{String}, output::String)
+    # Queue the error for the database and get suggestions (indexed lookup, no write wait)
+    (_, pattern_name, description, suggestions) = BuildBridge.report_error(
+        db_path, "$(compiler.config.clang_path) $(join(args, " "))", output,
+        project_path=compiler.config.build_dir, file_path=cpp_file)
+
+    @error "Failed to compile $cpp_file: $pattern_name - $description"
+    println("Error output:\n$output")
+
+    if !isempty(suggestions)
+        println("\n💡 Suggestions:")
+        for (i, sug) in enumerate(suggestions[1:min(3, length(suggestions))])
+            println("  $i. $(sug["description"]) (confidence: $(round(sug["confidence"], digits=2)))")
+        end
+    end
+end
+
 """
 Optimize and link LLVM IR files
+
+In bitcode mode the TUs are linked into `<name>.linked.bc` and returned unoptimized:
+`compile_ir_to_shared_lib` runs the `-O` pipeline and codegen in the same clang process,
+so the module is parsed once after linking. With `emit_bc = false` the textual
+`llvm-link -S` / `opt -S` stages are kept.
 """
-function optimize_and_link_ir(compiler::LLVMJuliaCompiler, ir_files::Vector{String}, output_name::String)
+function optimize_and_link_ir(compiler::LLVMJuliaCompiler, ir_files::Vector{String}, output_name::String;
+                              pool::Union{Base.Semaphore,Nothing}=nothing)
     println("⚡ Optimizing and linking IR...")
-    db = BuildBridge.get_error_db(joinpath(compiler.config.build_dir, "jmake_errors.db"))
+    db_path = error_db_path(compiler)
+    bitcode = compiler.config.emit_bitcode
 
     # Link all IR files
-    linked_ir = joinpath(compiler.config.build_dir, "$output_name.linked.ll")
-    link_args = ["-S", "-o", linked_ir, ir_files...]
+    linked_ir = joinpath(compiler.config.build_dir, "$output_name.linked$(ir_extension(compiler))")
+    link_args = bitcode ? ["-o", linked_ir, ir_files...] : ["-S", "-o", linked_ir, ir_files...]
 
-    output, exitcode = BuildBridge.execute(compiler.config.llvm_link_path, link_args)
+    output, exitcode = run_build_tool(compiler.config.llvm_link_path, link_args; pool=pool)
 
     if exitcode == 0
         println("  ✓ Linked $(length(ir_files)) files")
     else
-        BuildBridge.ErrorLearning.record_error(
-            db, "$(compiler.config.llvm_link_path) $(join(link_args, " "))", output,
-            project_path=compiler.config.build_dir)
+        BuildBridge.report_error(
+            db_path, "$(compiler.config.llvm_link_path) $(join(link_args, " "))", output,
+            project_path=compiler.config.build_dir, suggest=false)
         @error "Failed to link IR files"
         println("Error output:\n$output")
         return nothing
     end
 
+    if bitcode
+        compiler.config.emit_text_ir && dump_text_ir(compiler, linked_ir; pool=pool)
+        println("  ✓ Optimization deferred to codegen (-$(compiler.config.target.opt_level))")
+        return linked_ir
+    end
+
     # Optimize if requested
     if compiler.config.target.opt_level != "O0"
         optimized_ir = joinpath(compiler.config.build_dir, "$output_name.opt.ll")
         opt_level = replace(compiler.config.target.opt_level, "O" => "")
         opt_args = ["-S", "-O$opt_level", "-o", optimized_ir, linked_ir]
 
-        output, exitcode = BuildBridge.execute(compiler.config.opt_path, opt_args)
+        output, exitcode = run_build_tool(compiler.config.opt_path, opt_args; pool=pool)
 
         if exitcode == 0
             println("  ✓ Optimized with -O$opt_level")
             return optimized_ir
         else
-            BuildBridge.ErrorLearning.record_error(
-                db, "$(compiler.config.opt_path) $(join(opt_args, " "))", output,
-                project_path=compiler.config.build_dir)
+            BuildBridge.report_error(
+                db_path, "$(compiler.config.opt_path) $(join(opt_args, " "))", output,
+                project_path=compiler.config.build_dir, suggest=false)
             @warn "Optimization failed, using unoptimized IR"
             println("Error output:\n$output")
         end
@@ -596,16 +796,48 @@ function optimize_and_link_ir(compiler::LLVMJuliaCompiler, ir_files::Vector{Stri
 end
 
 """
-Compile IR to shared library
+Path of `llvm-dis`: the one next to `llvm-link`, else the system's
+"""
+function llvm_dis_path(compiler::LLVMJuliaCompiler)
+    llvm_dis = joinpath(dirname(compiler.config.llvm_link_path), "llvm-dis")
+    return isfile(llvm_dis) ? llvm_dis : something(Sys.which("llvm-dis"), "llvm-dis")
+end
+
+"""
+Write a textual `.ll` next to a bitcode module with llvm-dis (`emit_ir = true`, debugging only)
+"""
+function dump_text_ir(compiler::LLVMJuliaCompiler, bitcode_file::String;
+                      pool::Union{Base.Semaphore,Nothing}=nothing)
+    text_file = splitext(bitcode_file)[1] * ".ll"
+    output, exitcode = run_build_tool(llvm_dis_path(compiler), ["-o", text_file, bitcode_file]; pool=pool)
+
+    if exitcode == 0
+        println("  📝 Text IR: $text_file")
+    else
+        @warn "Could not write text IR for $bitcode_file"
+        println("Error output:\n$output")
+    end
+end
+
 """
-function compile_ir_to_shared_lib(compiler::LLVMJuliaCompiler, ir_file::String, lib_name::String)
-    println("📦 Creating shared library...")
-    db = BuildBridge.get_error_db(joinpath(compiler.config.build_dir, "jmake_errors.db"))
+Compile IR to shared library
 
-    output_lib = joinpath(compiler.config.output_dir, "lib$lib_name.so")
+The target flags (including `-O<level>`) are passed along, so for a bitcode module clang
+optimizes, generates code and links in one invocation. `profile_flags` (PGO
+instrumentation or profile use, see `profile_flags`) only change this step. With a
+`cpu`, code is generated for that CPU instead into `lib<name>.<cpu>.so` (see `variant_flags`).
+"""
+function compile_ir_to_shared_lib(compiler::LLVMJuliaCompiler, ir_file::String, lib_name::String;
+                                  pool::Union{Base.Semaphore,Nothing}=nothing,
+                                  profile_flags::Vector{String}=String[],
+                                  cpu::String="")
+    println("📦 Creating shared library$(isempty(cpu) ? "" : " ($cpu)")...")
+    db_path = error_db_path(compiler)
+
+    output_lib = joinpath(compiler.config.output_dir, variant_library(lib_name, cpu))
     mkpath(dirname(output_lib))
 
-    flags = get_compiler_flags(compiler)
+    flags = isempty(cpu) ? get_compiler_flags(compiler) : variant_flags(compiler, cpu)
 
     # Add library directories and libraries
     link_flags = String[]
@@ -616,17 +848,17 @@ function compile_ir_to_shared_lib(compiler::LLVMJuliaCompiler, ir_file::String,
         push!(link_flags, "-l$lib")
     end
 
-    args = vcat(["-shared"], flags, link_flags, ["-o", output_lib, ir_file])
+    args = vcat(["-shared"], flags, profile_flags, link_flags, ["-o", output_lib, ir_file])
 
-    output, exitcode = BuildBridge.execute(compiler.config.clang_path, args)
+    output, exitcode = run_build_tool(compiler.config.clang_path, args; pool=pool)
 
     if exitcode == 0
         println("  ✓ Created: $output_lib")
         return output_lib
     else
-        BuildBridge.ErrorLearning.record_error(
-            db, "$(compiler.config.clang_path) $(join(args, " "))", output,
-            project_path=compiler.config.build_dir)
+        BuildBridge.report_error(
+            db_path, "$(compiler.config.clang_path) $(join(args, " "))", output,
+            project_path=compiler.config.build_dir, suggest=false)
         @error "Failed to create shared library"
         println("Error output:\n$output")
         return nothing
@@ -652,9 +884,13 @@ end
 
 """
 Generate simple Julia bindings
+
+With `[target] variants`, the module opens the library of its host's CPU in `__init__`
+(see `variant_loader`) and calls through function pointers resolved there.
 """
 function generate_simple_bindings(compiler::LLVMJuliaCompiler, lib_name::String, functions::Vector)
     module_name = titlecase(lib_name)
+    dispatch = !isempty(compiler.config.target.variants)
 
     content = """
     # Auto-generated Julia bindings for $lib_name
@@ -665,10 +901,20 @@ function generate_simple_bindings(compiler::LLVMJuliaCompiler, lib_name::String,
 
     using Libdl
 
-    # Load the compiled shared library
-    const _lib_path = joinpath(@__DIR__, "lib$lib_name.so")
-    const _lib_handle = Libdl.dlopen(_lib_path)
+    """
+
+    if dispatch
+        content *= variant_loader(compiler, lib_name, [func.name for func in functions])
+    else
+        content *= """
+        # Load the compiled shared library
+        const _lib_path = joinpath(@__DIR__, "lib$lib_name.so")
+        const _lib_handle = Libdl.dlopen(_lib_path)
 
+        """
+    end
+
+    content *= """
     # Type mappings
     const CppTypeMap = Dict{String, DataType}(
     """
@@ -709,9 +955,9 @@ function generate_simple_bindings(compiler::LLVMJuliaCompiler, lib_name::String,
 
     # Generate function wrappers
     for func in functions
-        func_name = func["name"]
-        return_type = func["return_type"]
-        params = func["params"]
+        func_name = func.name
+        return_type = func.return_type
+        params = func.params
 
         # Map return type
         julia_return_type = get(compiler.config.type_mappings, return_type,
@@ -723,8 +969,8 @@ function generate_simple_bindings(compiler::LLVMJuliaCompiler, lib_name::String,
         ccall_types = String[]
 
         for (i, param) in enumerate(params)
-            param_name = isempty(param["name"]) ? "arg$i" : param["name"]
-            param_type = param["type"]
+            param_name = isempty(param.name) ? "arg$i" : param.name
+            param_type = param.type
 
             # Clean parameter name
             param_name = replace(param_name, r"[^a-zA-Z0-9_]" => "_")
@@ -746,7 +992,7 @@ function generate_simple_bindings(compiler::LLVMJuliaCompiler, lib_name::String,
         \"\"\"
         function $func_name($(join(param_types, ", ")))
             ccall(
-                (:$func_name, _lib_handle),
+                $(dispatch ? "_fptr_$func_name[]" : "(:$func_name, _lib_handle)"),
                 $julia_return_type,
                 ($(join(ccall_types, ", "))$(isempty(ccall_types) ? "" : ",")),
                 $(join(param_names, ", "))
@@ -758,14 +1004,14 @@ function generate_simple_bindings(compiler::LLVMJuliaCompiler, lib_name::String,
 
     # Export functions
     content *= "\n# Exports\nexport "
-    content *= join([func["name"] for func in functions], ", ")
+    content *= join([func.name for func in functions], ", ")
     content *= "\n\n"
 
     # Cleanup function
     content *= """
     # Cleanup
     function __cleanup__()
-        Libdl.dlclose(_lib_handle)
+        Libdl.dlclose(_lib_handle$(dispatch ? "[]" : ""))
     end
 
     end # module
@@ -785,10 +1031,17 @@ end
 
 """
 Main compilation workflow
+With `incremental`, the plan from `plan_build` decides per component which TUs are
+recompiled and which libraries are relinked; `changed_files` (e.g. a watcher batch)
+are always re-checked. `incremental=false` rebuilds everything. With `[pgo] enabled`,
+the libraries are optimized with a training profile (see `update_profiles!`).
 """
 function compile_project(compiler::LLVMJuliaCompiler;
     specific_files::Vector{String}=String[],
-    components::Union{Vector{String},Nothing}=nothing)
+    components::Union{Vector{String},Nothing}=nothing,
+    changed_files::Vector{String}=String[],
+    incremental::Bool=true)
+    started = time_ns()
     println("🚀 JMake LLVMake - C++ to Julia Compiler")
     println("="^50)
     println("📁 Project: $(compiler.config.project_root)")
@@ -814,73 +1067,1022 @@ function compile_project(compiler::LLVMJuliaCompiler;
     # Group files by component
     file_groups = group_files_by_component(cpp_files, components)
 
-    # Process each component
-    generated_modules = String[]
+    # One pool bounds every clang/llvm process across all components
+    pool = Base.Semaphore(compiler.config.jobs)
+    println("⚙️  Jobs: $(compiler.config.jobs)")
 
-    for (component_name, files) in file_groups
-        println("\n🔧 Processing component: $component_name")
-        println("   Files: $(length(files))")
+    # Plan against the previous build: only affected TUs and components are rebuilt
+    state_file = build_state_path(compiler)
+    state = incremental ? load_build_state(state_file) : load_build_state("")
+    plans, include_graph = Tracing.span("plan_build"; files=length(cpp_files)) do
+        plan_build(compiler, file_groups, state; changed_files=changed_files)
+    end
+
+    for plan in plans
+        plan.rebuild || println("⏭  [$(plan.name)] Skipped: $(plan.reason)")
+    end
+
+    # PGO: libraries are linked with the cached profile, or instrumented for a training run
+    profile = compiler.config.pgo ? reusable_profile(compiler, include_graph, state["mtimes"]) : nothing
+    link_profile = compiler.config.pgo ? profile_flags(compiler, profile) : String[]
+
+    # Components produce independent libraries, so they all build concurrently;
+    # their TUs share the pool slots
+    to_build = filter(plan -> plan.rebuild, plans)
+    built = parallel_map(to_build, length(to_build)) do plan
+        println("🔁 [$(plan.name)] Rebuilding: $(plan.reason)")
+        previous = get(state["components"], plan.name, Dict())
+        Tracing.span("component"; name=plan.name, files=length(plan.files), affected=length(plan.affected)) do
+            build_component(compiler, plan.name, plan.files; pool=pool, affected=plan.affected,
+                            previous_signatures=get(previous, "signatures", ""), include_graph=include_graph,
+                            profile_flags=link_profile)
+        end
+    end
+
+    rebuilt = Set{String}()
+    for (plan, result) in zip(to_build, built)
+        isnothing(result) && continue
+        record_component!(state, plan, include_graph, result[2])
+        state["components"][plan.name]["profile"] = compiler.config.pgo ? profile_id(profile) : ""
+        push!(rebuilt, plan.name)
+    end
+
+    generated_modules = String[plan.name for plan in plans if !plan.rebuild || plan.name in rebuilt]
+
+    Tracing.span("pgo"; enabled=compiler.config.pgo) do
+        update_profiles!(compiler, state, generated_modules, rebuilt, profile, include_graph; pool=pool)
+    end
+    save_build_state(state_file, state)
 
-        # Parse all files to extract functions
-        all_functions = []
+    # Generate main module
+    if length(generated_modules) > 1
+        generate_main_module(compiler, generated_modules)
+    end
+
+    # Save compilation metadata
+    save_metadata(compiler, generated_modules)
+
+    println("\n🎉 Compilation complete!")
+    println("📁 Output: $(compiler.config.output_dir)")
+    println("📦 Modules: $(join(generated_modules, ", "))")
+
+    Tracing.record_span!("compile_project", started, time_ns();
+                         files=length(cpp_files), rebuilt=length(rebuilt), modules=length(generated_modules))
+    return generated_modules
+end
+
+"""
+Build one component: parse, compile TUs, link, create library, generate bindings.
+Only `affected` TUs are recompiled; the others reuse their IR from the build directory
+(with `[compile] unity`, the batches containing them, see `compile_unity`).
+Bindings are regenerated only when the exported signatures differ from `previous_signatures`
+(a `signature_digest`). With `[compile] pch`, the TUs use the component's precompiled
+header, picked from `include_graph` (TU => headers, as returned by `plan_build`).
+`profile_flags` go to the shared library step (PGO), for every `[target] variants` CPU too.
+Returns `(name, signature_digest)` on success, `nothing` if it was skipped or failed.
+"""
+function build_component(compiler::LLVMJuliaCompiler, component_name::String, files::Vector{String};
+                         pool::Base.Semaphore=Base.Semaphore(compiler.config.jobs),
+                         affected::Vector{String}=files,
+                         previous_signatures::String="",
+                         include_graph::Union{Dict{String,Vector{String}},Nothing}=nothing,
+                         profile_flags::Vector{String}=String[])
+    println("\n🔧 Processing component: $component_name")
+    println("   Files: $(length(files)) ($(length(affected)) to compile)")
+
+    # Parse all files to extract functions
+    all_functions = FunctionSignature[]
+    Tracing.span("parse_ast"; component=component_name) do
         for file in files
-            functions = parse_cpp_ast(compiler, file)
+            functions = Base.acquire(() -> parse_cpp_ast(compiler, file), pool)
             append!(all_functions, functions)
         end
+    end
 
-        # Remove duplicates
-        unique_functions = unique(f -> f["name"], all_functions)
-        println("   Functions: $(length(unique_functions))")
+    # Remove duplicates
+    unique_functions = unique(f -> f.name, all_functions)
+    println("   [$component_name] Functions: $(length(unique_functions))")
 
-        if isempty(unique_functions)
-            println("   ⚠️  No functions found, skipping...")
-            continue
+    if isempty(unique_functions)
+        println("   ⚠️  [$component_name] No functions found, skipping...")
+        return nothing
+    end
+
+    # Hot headers of the whole component, precompiled once for its TUs
+    pch = nothing
+    if compiler.config.pch && (compiler.config.unity || !isempty(affected))
+        graph = isnothing(include_graph) ? translation_unit_headers(compiler, files) : include_graph
+        pch = Tracing.span(() -> build_pch(compiler, component_name, files, graph; pool=pool),
+                           "pch"; component=component_name)
+    end
+
+    if compiler.config.unity
+        # Batches of concatenated TUs; only batches with an affected member are recompiled
+        ir_files = Tracing.span(() -> compile_unity(compiler, component_name, files, affected; pool=pool, pch=pch),
+                                "compile_ir"; component=component_name)
+        if isnothing(ir_files)
+            println("   ❌ [$component_name] Compilation failed")
+            return nothing
         end
+    else
+        # Compile affected TUs to IR
+        compiled = Tracing.span(() -> compile_to_ir(compiler, affected; pool=pool, pch=pch),
+                                "compile_ir"; component=component_name)
 
-        # Compile to IR
-        ir_files = compile_to_ir(compiler, files)
+        if length(compiled) < length(affected)
+            println("   ❌ [$component_name] Compilation failed ($(length(affected) - length(compiled)) of $(length(affected)) files)")
+            return nothing
+        end
 
-        if isempty(ir_files)
-            println("   ❌ Compilation failed")
-            continue
+        ir_files = [BuildCache.output_path(compiler.config.build_dir, file, ir_extension(compiler)) for file in files]
+    end
+
+    # Link and optimize
+    final_ir = Tracing.span(() -> optimize_and_link_ir(compiler, ir_files, component_name; pool=pool),
+                            "link_ir"; component=component_name)
+
+    if isnothing(final_ir)
+        println("   ❌ [$component_name] Linking failed")
+        return nothing
+    end
+
+    # Create shared library (and one per CPU variant)
+    lib_path = Tracing.span(() -> link_libraries(compiler, final_ir, component_name; pool=pool,
+                                                 profile_flags=profile_flags),
+                            "shared_lib"; component=component_name)
+
+    if isnothing(lib_path)
+        println("   ❌ [$component_name] Library creation failed")
+        return nothing
+    end
+
+    # Generate bindings
+    digest = signature_digest(unique_functions, compiler.config.target.variants)
+    bindings_file = joinpath(compiler.config.output_dir, "$component_name.jl")
+    if digest == previous_signatures && isfile(bindings_file)
+        println("   ⏭  [$component_name] Bindings skipped: exported signatures unchanged")
+    else
+        Tracing.span(() -> generate_julia_bindings(compiler, component_name, unique_functions),
+                     "bindings"; component=component_name)
+    end
+
+    println("   ✅ [$component_name] Component complete!")
+    return (component_name, digest)
+end
+
+# ============================================================================
+# PRECOMPILED HEADERS
+# ============================================================================
+
+"""
+Directory with the components' umbrella headers and PCH files
+"""
+pch_dir(compiler::LLVMJuliaCompiler) = joinpath(compiler.config.build_dir, "pch")
+
+"""
+Precompiled header of a component (`[compile] pch = true`): the headers included by at
+least `pch_threshold` of its TUs according to `include_graph` (`BuildCache.hot_headers`),
+built once with `-x c++-header` and exactly the flags of `get_compiler_flags`. The PCH is
+content-addressed like TU IR, so editing a member header yields a new one (and new TU
+keys). Returns its path, or `nothing` for components without hot headers or when the
+PCH fails to build.
+"""
+function build_pch(compiler::LLVMJuliaCompiler, component_name::String, files::Vector{String},
+                   include_graph::Dict{String,Vector{String}};
+                   pool::Union{Base.Semaphore,Nothing}=nothing)
+    length(files) < 2 && return nothing
+
+    dir = pch_dir(compiler)
+    graph = Dict(abspath(f) => get(include_graph, abspath(f), String[]) for f in files)
+    headers = BuildCache.hot_headers(graph; threshold=compiler.config.pch_threshold, exclude_dir=dir)
+    isempty(headers) && return nothing
+
+    umbrella = BuildCache.write_pch_umbrella(joinpath(dir, "$component_name.h"), headers)
+    flags = ["-x", "c++-header", get_compiler_flags(compiler)...]
+    compiler_version(compiler.config.clang_path)
+    toolchain = BuildCache.toolchain_version(compiler.config.clang_path)
+
+    pch = BuildCache.precompile_header!(artifact_cache(compiler), umbrella, flags; toolchain=toolchain) do args
+        run_build_tool(compiler.config.clang_path, args; pool=pool)
+    end
+    isnothing(pch) || println("   📦 [$component_name] PCH: $(length(headers)) headers → $(basename(pch))")
+    return pch
+end
+
+# ============================================================================
+# UNITY BUILDS
+# ============================================================================
+
+"""
+Directory with the generated unity sources and each component's isolated TUs
+"""
+unity_dir(compiler::LLVMJuliaCompiler) = joinpath(compiler.config.build_dir, "unity")
+
+# Declarations at the top level of a block (nested bodies reduced to `{}`)
+const LOCAL_TYPE_REGEX = r"\b(?:struct|class|union|enum(?:\s+class|\s+struct)?)\s+([A-Za-z_]\w*)[^;{}]*\{\}"
+const LOCAL_FUNCTION_REGEX = r"\b([A-Za-z_]\w*)\s*\([^;{}]*\)\s*(?:const\s*)?(?:noexcept\s*)?\{\}"
+const LOCAL_VARIABLE_REGEX = r"\b([A-Za-z_]\w*)\s*(?:\[[^\]]*\]\s*)?(?:=[^;]*|\{\})?;"
+const LOCAL_ALIAS_REGEX = r"\busing\s+([A-Za-z_]\w*)\s*="
+const CONTROL_KEYWORDS = Set(["if", "for", "while", "switch", "catch", "return", "sizeof"])
+
+"""
+Text of `block` outside any nested braces; each nested body is reduced to `{}`
+"""
+function top_level_text(block::AbstractString)
+    io = IOBuffer()
+    depth = 0
+    for c in block
+        if c == '{'
+            depth == 0 && write(io, '{')
+            depth += 1
+        elseif c == '}'
+            depth = max(depth - 1, 0)
+            depth == 0 && write(io, '}')
+        elseif depth == 0
+            write(io, c)
         end
+    end
+    return String(take!(io))
+end
 
-        # Link and optimize
-        final_ir = optimize_and_link_ir(compiler, ir_files, component_name)
+"""
+Names a TU defines at file scope with internal linkage (`static` definitions and
+anonymous-namespace members) plus the macros it leaves defined. Two TUs that share
+one clash when they are concatenated into one unity batch.
+"""
+function file_local_names(source::String)
+    names = Set{String}()
+    content = try
+        read(source, String)
+    catch
+        return names
+    end
+    content = replace(content, r"/\*.*?\*/"s => " ", r"//[^\n]*" => "", r"\"(?:\\.|[^\"\\\n])*\"" => "\"\"",
+                      r"'(?:\\.|[^'\\\n])'" => "''")
 
-        if isnothing(final_ir)
-            println("   ❌ Linking failed")
-            continue
+    # Macros are never scoped; only an #undef before the end of the file keeps them local
+    undefined = Set(m.captures[1] for m in eachmatch(r"^\s*#\s*undef\s+([A-Za-z_]\w*)"m, content))
+    for m in eachmatch(r"^\s*#\s*define\s+([A-Za-z_]\w*)"m, content)
+        m.captures[1] in undefined || push!(names, m.captures[1])
+    end
+    code = replace(content, r"^\s*#[^\n]*"m => "")
+
+    # Anonymous namespace members
+    for m in eachmatch(r"\bnamespace\s*\{", code)
+        start = m.offset + ncodeunits(m.match)
+        depth = 1
+        stop = start
+        while stop <= ncodeunits(code) && depth > 0
+            code[stop] == '{' && (depth += 1)
+            code[stop] == '}' && (depth -= 1)
+            stop = nextind(code, stop)
         end
+        block = top_level_text(code[start:prevind(code, stop, 2)])
+        for regex in (LOCAL_TYPE_REGEX, LOCAL_FUNCTION_REGEX, LOCAL_VARIABLE_REGEX, LOCAL_ALIAS_REGEX)
+            for d in eachmatch(regex, block)
+                d.captures[1] in CONTROL_KEYWORDS || push!(names, d.captures[1])
+            end
+        end
+    end
 
-        # Create shared library
-        lib_path = compile_ir_to_shared_lib(compiler, final_ir, component_name)
+    # File-scope statics
+    for statement in split(top_level_text(code), r"[;}]")
+        declaration = match(r"^\s*static\s+[^=(\[{]*?\b([A-Za-z_]\w*)\s*(?:[=(\[{]|$)", statement)
+        isnothing(declaration) || push!(names, declaration.captures[1])
+    end
+    return names
+end
 
-        if isnothing(lib_path)
-            println("   ❌ Library creation failed")
+"""
+Split a component's TUs into unity batches of at most `batch_size` files and
+`batch_bytes` source bytes, in path order. A batch also ends after a file whose
+path digest is a multiple of the batch size (content-defined boundaries: adding or
+removing a file only reshapes its own batch), and before a file whose `file_local_names`
+clash with the batch. `isolated` files always build alone.
+"""
+function unity_batches(files::Vector{String}, isolated::Set{String}=Set{String}();
+                       batch_size::Int=8, batch_bytes::Int=256 * 1024)
+    batches = Vector{String}[]
+    current = String[]
+    current_bytes = 0
+    current_names = Set{String}()
+
+    close_batch!() = if !isempty(current)
+        push!(batches, current)
+        current = String[]
+        current_bytes = 0
+        current_names = Set{String}()
+    end
+
+    for file in sort!(abspath.(files))
+        if file in isolated
+            push!(batches, [file])
             continue
         end
 
-        # Generate bindings
-        binding_file = generate_julia_bindings(compiler, component_name, unique_functions)
-        push!(generated_modules, component_name)
+        bytes = isfile(file) ? filesize(file) : 0
+        names = file_local_names(file)
+        if length(current) >= batch_size || current_bytes + bytes > batch_bytes ||
+           !isdisjoint(names, current_names)
+            close_batch!()
+        end
+        push!(current, file)
+        current_bytes += bytes
+        union!(current_names, names)
 
-        println("   ✅ Component complete!")
+        digest = sha1(file)
+        (UInt32(digest[1]) << 8 | digest[2]) % batch_size == 0 && close_batch!()
     end
+    close_batch!()
+    return batches
+end
 
-    # Generate main module
-    if length(generated_modules) > 1
-        generate_main_module(compiler, generated_modules)
+"""
+Source compiled for a batch: the file itself when it is alone, otherwise the generated
+unity source including its members by absolute path (only rewritten when they change)
+"""
+function unity_source(compiler::LLVMJuliaCompiler, component_name::String, batch::Vector{String})
+    length(batch) == 1 && return first(batch)
+    tag = bytes2hex(sha1(join(batch, "\n")))[1:12]
+    source = joinpath(unity_dir(compiler), "$component_name-$tag.cpp")
+    content = "// Generated by JMake: unity batch of $component_name\n" *
+              join(["#include \"$file\"\n" for file in batch])
+    if !isfile(source) || read(source, String) != content
+        mkpath(dirname(source))
+        write(source, content)
     end
+    return source
+end
 
-    # Save compilation metadata
-    save_metadata(compiler, generated_modules)
+isolated_path(compiler::LLVMJuliaCompiler, component_name::String) =
+    joinpath(unity_dir(compiler), "$component_name.isolated")
 
-    println("\n🎉 Compilation complete!")
-    println("📁 Output: $(compiler.config.output_dir)")
-    println("📦 Modules: $(join(generated_modules, ", "))")
+load_isolated(path::String) = isfile(path) ? Set(filter(!isempty, readlines(path))) : Set{String}()
 
-    return generated_modules
+"""
+Compile a component in unity mode and return the IR of all its batches (`nothing`
+after a real compile error).
+
+Batches with an `affected` member, or whose IR is gone, are compiled; the others
+reuse their IR. A failed batch is retried without the members its diagnostics name
+(or all of them if none is named). Those members are compiled alone first: an error
+there is reported as usual and fails the component, otherwise they are isolated. The
+isolated set is kept in `unity/<component>.isolated`, so later builds do not batch them
+again. Each member gets its batch's depfile, so a change to anything in the batch marks
+the whole batch affected.
+"""
+function compile_unity(compiler::LLVMJuliaCompiler, component_name::String, files::Vector{String},
+                       affected::Vector{String}; pool::Union{Base.Semaphore,Nothing}=nothing,
+                       pch::Union{String,Nothing}=nothing)
+    ir_ext = ir_extension(compiler)
+    isolated_file = isolated_path(compiler, component_name)
+    isolated = intersect!(load_isolated(isolated_file), Set(abspath.(files)))
+    needed = Set(abspath.(affected))
+
+    while true
+        batches = unity_batches(files, isolated; batch_size=compiler.config.unity_batch_size,
+                                batch_bytes=compiler.config.unity_batch_bytes)
+        sources = [unity_source(compiler, component_name, batch) for batch in batches]
+        ir_files = [BuildCache.output_path(compiler.config.build_dir, source, ir_ext) for source in sources]
+
+        stale = [i for i in eachindex(batches) if !isfile(ir_files[i]) || any(in(needed), batches[i])]
+        println("   [$component_name] Unity: $(length(batches)) batches for $(length(files)) files ($(length(stale)) to compile)")
+
+        failures = Dict{String,Tuple{Vector{String},String}}()
+        compile_to_ir(compiler, sources[stale]; pool=pool, pch=pch, failures=failures)
+
+        # Depfile of each batch stands for all of its members in the include graph
+        depfiles = [member => ir_files[i] * ".d" for i in stale for member in batches[i]
+                    if length(batches[i]) > 1 && !haskey(failures, sources[i])]
+        ASTWalker.record_depfiles!(depfile_graph_path(compiler), depfiles)
+
+        # Done unless a TU was skipped after an earlier failure (keep_going=false)
+        isempty(failures) && return all(isfile, ir_files) ? ir_files : nothing
+
+        culprits = String[]
+        for (i, source) in enumerate(sources)
+            haskey(failures, source) || continue
+            batch = batches[i]
+            args, output = failures[source]
+            if length(batch) == 1
+                # A lone TU failed on its own: that is a real error
+                report_compile_error(compiler, error_db_path(compiler), source, args, output)
+                return nothing
+            end
+            # The members the errors are in, else every member the diagnostics mention
+            named = filter(member -> occursin(Regex("^\\Q$member\\E:\\d+:\\d+: (?:fatal )?error", "m"), output), batch)
+            isempty(named) && (named = filter(member -> occursin(member, output), batch))
+            append!(culprits, isempty(named) ? batch : named)
+        end
+
+        alone = compile_to_ir(compiler, culprits; pool=pool, pch=pch)
+        length(alone) < length(culprits) && return nothing
+
+        union!(isolated, culprits)
+        mkpath(dirname(isolated_file))
+        write(isolated_file, join(sort!(collect(isolated)), "\n"))
+        println("   ⚠️  [$component_name] Unity: isolated $(join(basename.(culprits), ", ")) (breaks when combined)")
+        union!(needed, [member for i in eachindex(batches) if haskey(failures, sources[i]) for member in batches[i]])
+    end
+end
+
+# ============================================================================
+# PROFILE-GUIDED OPTIMIZATION
+# ============================================================================
+
+# Bump when the profile metadata layout changes
+const PGO_FORMAT_VERSION = 1
+
+"""
+Directory of the merged training profile and its metadata (kept with the artifact
+cache, so it survives `build/` being removed)
+"""
+pgo_dir(compiler::LLVMJuliaCompiler) = joinpath(compiler.config.cache_dir, "pgo")
+profile_data_path(compiler::LLVMJuliaCompiler) = joinpath(pgo_dir(compiler), "merged.profdata")
+profile_meta_path(compiler::LLVMJuliaCompiler) = joinpath(pgo_dir(compiler), "profile.json")
+
+"""
+Identity of a profile recorded per component in the build state ("" for none)
+"""
+profile_id(::Nothing) = ""
+profile_id(profile::String) = bytes2hex(sha256(read(profile)))
+
+"""
+Shared library step flags for PGO: IR instrumentation while there is no usable
+`profile`, otherwise `-fprofile-use` (functions whose code changed since training are
+compiled without profile data, which is not worth a warning)
+"""
+function profile_flags(compiler::LLVMJuliaCompiler, profile::Union{String,Nothing})
+    isnothing(profile) && return ["-fprofile-generate=$(joinpath(pgo_dir(compiler), "raw"))"]
+    return ["-fprofile-use=$profile", "-Wno-profile-instr-out-of-date", "-Wno-profile-instr-unprofiled"]
+end
+
+"""
+Digest of what a profile is only valid for: target flags and clang version
+"""
+function profile_flags_digest(compiler::LLVMJuliaCompiler)
+    compiler_version(compiler.config.clang_path)
+    toolchain = BuildCache.toolchain_version(compiler.config.clang_path)
+    return bytes2hex(sha256(join([toolchain; get_compiler_flags(compiler)], "\0")))
+end
+
+"""
+Digests of the inputs a profile was trained on: every TU and header of the include graph
+"""
+function profile_inputs(include_graph::Dict{String,Vector{String}}, mtimes::Dict{String,Any})
+    paths = union(keys(include_graph), values(include_graph)...)
+    return Dict(path => file_digest!(mtimes, path) for path in paths)
+end
+
+"""
+The cached profile if it still fits this build: same format, flags, toolchain and
+training script, and at most `[pgo] max_drift` of the profiled inputs (TUs and headers)
+changed, added or removed since training. `nothing` means a training run is needed.
+"""
+function reusable_profile(compiler::LLVMJuliaCompiler, include_graph::Dict{String,Vector{String}},
+                          mtimes::Dict{String,Any})
+    profile = profile_data_path(compiler)
+    meta_file = profile_meta_path(compiler)
+    (isfile(profile) && isfile(meta_file)) || return nothing
+
+    meta = try
+        JSON.parsefile(meta_file)
+    catch
+        return nothing
+    end
+    if get(meta, "version", 0) != PGO_FORMAT_VERSION || get(meta, "flags", "") != profile_flags_digest(compiler) ||
+       get(meta, "training", "") != file_digest!(mtimes, compiler.config.pgo_training)
+        println("🔥 PGO: profile was trained with other flags, toolchain or training script")
+        return nothing
+    end
+
+    trained = get(meta, "inputs", Dict())
+    current = profile_inputs(include_graph, mtimes)
+    all_inputs = union(keys(trained), keys(current))
+    drifted = count(path -> get(trained, path, "") != get(current, path, ""), all_inputs)
+    drift = isempty(all_inputs) ? 0.0 : drifted / length(all_inputs)
+    if Tracing.count_cache!("pgo_profile", drift <= compiler.config.pgo_max_drift)
+        println("🔥 PGO: reusing profile ($(round(100drift, digits=1))% of inputs changed since training)")
+        return profile
+    end
+    println("🔥 PGO: profile stale ($(round(100drift, digits=1))% of inputs changed), retraining")
+    return nothing
+end
+
+"""
+Path of `llvm-profdata`: the bundled toolchain's, else the one next to `llvm-link`,
+else the system's
+"""
+function profdata_tool(compiler::LLVMJuliaCompiler)
+    bundled = try
+        BuildBridge.LLVMEnvironment.get_tool("llvm-profdata")
+    catch
+        ""
+    end
+    isempty(bundled) || return bundled
+    sibling = joinpath(dirname(compiler.config.llvm_link_path), "llvm-profdata")
+    return isfile(sibling) ? sibling : find_tool("llvm-profdata")
+end
+
+"""
+Run the training script against the instrumented libraries and merge the raw
+profiles into `merged.profdata`. The script runs in a fresh Julia process from the
+project root, with `JMAKE_BINDINGS_DIR` pointing at the generated bindings. Returns
+the profile, or `nothing` when training or merging fails.
+"""
+function train_profile(compiler::LLVMJuliaCompiler, include_graph::Dict{String,Vector{String}},
+                       mtimes::Dict{String,Any})
+    script = compiler.config.pgo_training
+    if !isfile(script)
+        @warn "PGO: training script $script not found, libraries are built without a profile"
+        return nothing
+    end
+
+    raw_dir = joinpath(pgo_dir(compiler), "raw")
+    rm(raw_dir; recursive=true, force=true)
+    mkpath(raw_dir)
+
+    println("🏋️  PGO: training with $(relpath(script, compiler.config.project_root))")
+    env = merge(copy(ENV), Dict("LLVM_PROFILE_FILE" => joinpath(raw_dir, "%m-%p.profraw"),
+                                "JMAKE_BINDINGS_DIR" => compiler.config.output_dir))
+    cmd = setenv(`$(Base.julia_cmd()) --startup-file=no $script`, env; dir=compiler.config.project_root)
+    trained = Tracing.span(() -> success(pipeline(cmd; stdout=stdout, stderr=stderr)), "pgo_train")
+
+    raw_profiles = filter(f -> endswith(f, ".profraw"), readdir(raw_dir; join=true))
+    if !trained || isempty(raw_profiles)
+        @warn "PGO: training run $(trained ? "wrote no profiles" : "failed"), libraries are built without a profile"
+        return nothing
+    end
+
+    profile = profile_data_path(compiler)
+    merged = "$profile.tmp.$(getpid()).$(rand(UInt64))"
+    output, exitcode = run_build_tool(profdata_tool(compiler), ["merge", "-o", merged, raw_profiles...])
+    if exitcode != 0
+        rm(merged, force=true)
+        @warn "PGO: llvm-profdata merge failed, libraries are built without a profile:\n$output"
+        return nothing
+    end
+    mv(merged, profile, force=true)
+
+    open(profile_meta_path(compiler), "w") do io
+        JSON.print(io, Dict(
+            "version" => PGO_FORMAT_VERSION,
+            "flags" => profile_flags_digest(compiler),
+            "training" => file_digest!(mtimes, script),
+            "trained" => string(now()),
+            "inputs" => profile_inputs(include_graph, mtimes)
+        ), 2)
+    end
+    println("  ✓ Profile: $(length(raw_profiles)) runs merged → $(basename(profile))")
+    return profile
+end
+
+"""
+Module handed to codegen for a component (what `optimize_and_link_ir` returned)
+"""
+function linked_ir_path(compiler::LLVMJuliaCompiler, component_name::String)
+    linked = joinpath(compiler.config.build_dir, "$component_name.linked$(ir_extension(compiler))")
+    compiler.config.emit_bitcode && return linked
+    optimized = joinpath(compiler.config.build_dir, "$component_name.opt.ll")
+    return isfile(optimized) ? optimized : linked
+end
+
+"""
+Link components again from their linked IR with `flags`; TUs and IR linking are not
+repeated. Returns the components whose library was created.
+"""
+function relink_components(compiler::LLVMJuliaCompiler, names::Vector{String}, flags::Vector{String};
+                           pool::Union{Base.Semaphore,Nothing}=nothing)
+    linked = parallel_map(names, length(names)) do name
+        ir_file = linked_ir_path(compiler, name)
+        isfile(ir_file) || return false
+        return !isnothing(link_libraries(compiler, ir_file, name; pool=pool, profile_flags=flags))
+    end
+    return String[name for (name, ok) in zip(names, linked) if ok]
+end
+
+"""
+Bring every library in `names` in line with the profile after the component builds.
+
+Without a usable `profile`, the libraries that were not rebuilt are instrumented too.
+The training run then produces a profile and all libraries are linked again with it,
+or without one if training failed. With a reused profile, only the libraries linked
+against another profile are relinked. With PGO off, libraries still carrying a profile
+are linked plain again. The profile of each library is recorded in the build state.
+"""
+function update_profiles!(compiler::LLVMJuliaCompiler, state::Dict{String,Any}, names::Vector{String},
+                          rebuilt::Set{String}, profile::Union{String,Nothing},
+                          include_graph::Dict{String,Vector{String}};
+                          pool::Union{Base.Semaphore,Nothing}=nothing)
+    recorded(name) = get(get(state["components"], name, Dict()), "profile", "")
+
+    if !compiler.config.pgo
+        targets = filter(name -> !(name in rebuilt) && !isempty(recorded(name)), names)
+    elseif isnothing(profile)
+        println("\n🔥 PGO: instrumenting $(length(names)) libraries for training")
+        relink_components(compiler, filter(!in(rebuilt), names), profile_flags(compiler, nothing); pool=pool)
+        profile = train_profile(compiler, include_graph, state["mtimes"])
+        targets = names
+    else
+        targets = filter(name -> !(name in rebuilt) && recorded(name) != profile_id(profile), names)
+    end
+    isempty(targets) && return
+
+    println("\n🔥 PGO: linking $(length(targets)) libraries $(isnothing(profile) ? "without a profile" : "with the profile")")
+    id = compiler.config.pgo ? profile_id(profile) : ""
+    for name in relink_components(compiler, targets, isnothing(profile) ? String[] : profile_flags(compiler, profile); pool=pool)
+        haskey(state["components"], name) && (state["components"][name]["profile"] = id)
+    end
+end
+
+# ============================================================================
+# CPU VARIANTS
+# ============================================================================
+
+const CPUID = Base.BinaryPlatforms.CPUID
+
+# Function attributes that pin a module to the CPU of its frontend pass
+const TARGET_ATTRIBUTE = r" ?\"(?:target-cpu|target-features|tune-cpu)\"=\"[^\"]*\""
+
+# LLVM CPU names whose ISA `CPUID.ISAs_by_family` lists under another name
+const VARIANT_ISA_ALIASES = Dict(
+    "x86-64" => "x86_64",
+    "x86-64-v2" => "nehalem",
+    "x86-64-v3" => "haswell",
+    "x86-64-v4" => "skylake_avx512",
+)
+
+"""
+Library file of a component, or of one of its CPU variants
+"""
+variant_library(lib_name::String, cpu::String="") = isempty(cpu) ? "lib$lib_name.so" : "lib$lib_name.$cpu.so"
+
+"""
+Architecture the libraries are built for: the target triple's, else the host's
+"""
+function target_arch(compiler::LLVMJuliaCompiler)
+    triple = compiler.config.target.triple
+    return isempty(triple) ? string(Sys.ARCH) : String(first(split(triple, '-')))
+end
+
+"""
+Target flags for the codegen of one CPU variant: any `-mcpu`/`-march` is replaced by
+`cpu` (`-march` on x86, where it selects the ISA; `-mcpu` elsewhere)
+"""
+function variant_flags(compiler::LLVMJuliaCompiler, cpu::String)
+    flags = filter(f -> !startswith(f, "-mcpu=") && !startswith(f, "-march="), get_compiler_flags(compiler))
+    option = target_arch(compiler) in ("x86_64", "i686") ? "-march" : "-mcpu"
+    return [flags; "$option=$cpu"]
+end
+
+"""
+CPU-neutral text copy of a component's linked module, the codegen input of every
+variant: the `target-cpu`, `target-features` and `tune-cpu` attributes of the frontend
+pass are dropped, so each function is compiled for the CPU on the command line. The
+linked module is taken before `opt` (text pipeline), and the copy is only rewritten
+when the module is newer. Returns `nothing` if it could not be disassembled.
+"""
+function variant_ir(compiler::LLVMJuliaCompiler, component_name::String;
+                    pool::Union{Base.Semaphore,Nothing}=nothing)
+    linked = joinpath(compiler.config.build_dir, "$component_name.linked$(ir_extension(compiler))")
+    neutral = joinpath(compiler.config.build_dir, "$component_name.variants.ll")
+    isfile(linked) || return nothing
+    isfile(neutral) && mtime(neutral) >= mtime(linked) && return neutral
+
+    text = linked
+    if compiler.config.emit_bitcode
+        text = "$neutral.dis.$(getpid()).$(rand(UInt64))"
+        output, exitcode = run_build_tool(llvm_dis_path(compiler), ["-o", text, linked]; pool=pool)
+        if exitcode != 0
+            @warn "Could not disassemble $linked for the CPU variants"
+            println("Error output:\n$output")
+            return nothing
+        end
+    end
+
+    staged = "$neutral.tmp.$(getpid()).$(rand(UInt64))"
+    open(staged, "w") do io
+        for line in eachline(text; keep=true)
+            write(io, startswith(line, "attributes #") ? replace(line, TARGET_ATTRIBUTE => "") : line)
+        end
+    end
+    text == linked || rm(text, force=true)
+    mv(staged, neutral, force=true)
+    return neutral
+end
+
+"""
+Create a component's shared library from `ir_file`, and one per `[target] variants`
+CPU from `variant_ir`, generating code for all of them in parallel on the pool.
+Libraries of CPUs no longer listed are removed. Returns the default library, or
+`nothing` if any library failed.
+"""
+function link_libraries(compiler::LLVMJuliaCompiler, ir_file::String, component_name::String;
+                        pool::Union{Base.Semaphore,Nothing}=nothing,
+                        profile_flags::Vector{String}=String[])
+    cpus = compiler.config.target.variants
+    isempty(cpus) && return compile_ir_to_shared_lib(compiler, ir_file, component_name; pool=pool,
+                                                     profile_flags=profile_flags)
+
+    neutral = variant_ir(compiler, component_name; pool=pool)
+    isnothing(neutral) && return nothing
+
+    targets = ["", cpus...]
+    libraries = parallel_map(targets, length(targets)) do cpu
+        Tracing.span("variant"; component=component_name, cpu=isempty(cpu) ? compiler.config.target.cpu : cpu) do
+            compile_ir_to_shared_lib(compiler, isempty(cpu) ? ir_file : neutral, component_name;
+                                     pool=pool, profile_flags=profile_flags, cpu=cpu)
+        end
+    end
+    any(isnothing, libraries) && return nothing
+
+    current = Set(variant_library.(component_name, targets))
+    for file in readdir(compiler.config.output_dir)
+        if startswith(file, "lib$component_name.") && endswith(file, ".so") && !(file in current)
+            rm(joinpath(compiler.config.output_dir, file), force=true)
+        end
+    end
+    return first(libraries)
+end
+
+"""
+The CPU variants in the order the bindings try them, most capable ISA first: `(cpu, isa)`
+with `isa` the variant's entry in `CPUID.ISAs_by_family` for the target architecture.
+`isa` is "" when Julia does not list the CPU; such a variant is tried first, but only
+on a host of exactly that CPU (`Sys.CPU_NAME`).
+"""
+function variant_table(compiler::LLVMJuliaCompiler)
+    isas = Dict(get(CPUID.ISAs_by_family, target_arch(compiler), ()))
+    table = map(compiler.config.target.variants) do cpu
+        name = get(VARIANT_ISA_ALIASES, cpu, cpu)
+        haskey(isas, name) || (name = replace(name, '-' => '_'))
+        return (cpu, haskey(isas, name) ? name : "")
+    end
+    rank(entry) = isempty(entry[2]) ? typemax(Int) : length(isas[entry[2]].features)
+    return sort(table; by=rank, rev=true)
+end
+
+"""
+Library loading code of bindings with CPU variants. `__init__` opens the first variant
+that the host can run, else the default library, and resolves every function pointer.
+`JMAKE_CPU_VARIANT=<cpu>` forces a variant (any other value: the default library).
+"""
+function variant_loader(compiler::LLVMJuliaCompiler, lib_name::String, function_names::Vector{String})
+    entries = join(["    (\"$cpu\", \"$isa\", \"$(variant_library(lib_name, cpu))\"),\n"
+                    for (cpu, isa) in variant_table(compiler)])
+    pointers = join(["const _fptr_$name = Ref{Ptr{Cvoid}}(C_NULL)\n" for name in function_names])
+    lookups = join(["    _fptr_$name[] = Libdl.dlsym(_lib_handle[], :$name)\n" for name in function_names])
+
+    return """
+    # CPU variants of the library, most capable first: (LLVM CPU, CPUID ISA, file)
+    const _variants = Tuple{String,String,String}[
+    $entries]
+
+    const _lib_path = Ref(joinpath(@__DIR__, "$(variant_library(lib_name))"))
+    const _lib_handle = Ref{Ptr{Cvoid}}(C_NULL)
+    $pointers
+    # Library for this host: JMAKE_CPU_VARIANT if set, else the first variant built for
+    # exactly this CPU or for an ISA it supports, else the default library
+    function _select_library()
+        CPUID = Base.BinaryPlatforms.CPUID
+        forced = get(ENV, "JMAKE_CPU_VARIANT", "")
+        host = CPUID.cpu_isa()
+        isas = Dict(get(CPUID.ISAs_by_family, string(Sys.ARCH), ()))
+        for (cpu, isa, file) in _variants
+            path = joinpath(@__DIR__, file)
+            usable = isempty(forced) ? cpu == Sys.CPU_NAME || (haskey(isas, isa) && isas[isa] <= host) :
+                     cpu == forced
+            usable && isfile(path) && return path
+        end
+        return joinpath(@__DIR__, "$(variant_library(lib_name))")
+    end
+
+    function __init__()
+        _lib_path[] = _select_library()
+        _lib_handle[] = Libdl.dlopen(_lib_path[])
+    $(lookups)end
+
+    """
+end
+
+# ============================================================================
+# INCREMENTAL BUILD PLANNER
+# ============================================================================
+
+# Bump when the persisted build state layout changes
+const BUILD_STATE_VERSION = 2
+
+"""
+What one component needs in this build, and why
+"""
+struct ComponentPlan
+    name::String
+    files::Vector{String}
+    affected::Vector{String}    # TUs to recompile
+    rebuild::Bool               # relink the component's library
+    reason::String
+    flags::String               # digest of the flags it is built with
+end
+
+"""
+Location of the persisted per-component build snapshots
+"""
+function build_state_path(compiler::LLVMJuliaCompiler)
+    return joinpath(compiler.config.build_dir, "build_state.json")
+end
+
+"""
+Load the build state written by the previous `compile_project` (empty if missing or stale)
+"""
+function load_build_state(path::String)
+    state = Dict{String,Any}("version" => BUILD_STATE_VERSION,
+                             "components" => Dict{String,Any}(), "mtimes" => Dict{String,Any}())
+    isfile(path) || return state
+
+    try
+        data = JSON.parsefile(path)
+        get(data, "version", 0) == BUILD_STATE_VERSION && merge!(state, data)
+    catch e
+        @warn "Ignoring unreadable build state $path: $e"
+    end
+    return state
+end
+
+"""
+Write the build state atomically
+"""
+function save_build_state(path::String, state::Dict{String,Any})
+    mkpath(dirname(path))
+    tmp = "$path.tmp.$(getpid()).$(rand(UInt64))"
+    open(tmp, "w") do f
+        JSON.print(f, state)
+    end
+    mv(tmp, path, force=true)
+end
+
+"""
+Content digest of a file, reusing the previous digest while its mtime is unchanged.
+Paths in `force` are always re-read (change sets pushed by the watcher).
+"""
+function file_digest!(mtimes::Dict{String,Any}, path::String; force::Set{String}=Set{String}())
+    isfile(path) || return ""
+
+    current_mtime = mtime(path)
+    cached = get(mtimes, path, nothing)
+    if !(path in force) && cached !== nothing && cached[1] == current_mtime
+        return cached[2]
+    end
+
+    digest = bytes2hex(sha256(read(path)))
+    mtimes[path] = Any[current_mtime, digest]
+    return digest
+end
+
+"""
+Headers each TU depends on: from the depfile graph when the TU has been compiled before,
+otherwise from the resolved project header closure
+"""
+function translation_unit_headers(compiler::LLVMJuliaCompiler, cpp_files::Vector{String})
+    depfile_graph = ASTWalker.load_depfile_graph(depfile_graph_path(compiler))
+    include_dirs = BuildCache.include_dirs_from_flags(get_compiler_flags(compiler))
+
+    headers = Dict{String,Vector{String}}()
+    for file in cpp_files
+        source = abspath(file)
+        headers[source] = get(() -> BuildCache.resolve_header_closure(source, include_dirs),
+                              depfile_graph, source)
+    end
+    return headers
+end
+
+"""
+Invert a TU => headers map into header => dependent TUs
+"""
+function reverse_include_graph(include_graph::Dict{String,Vector{String}})
+    reverse_graph = Dict{String,Vector{String}}()
+    for (source, headers) in include_graph
+        for header in headers
+            push!(get!(reverse_graph, header, String[]), source)
+        end
+    end
+    return reverse_graph
+end
+
+"""
+TUs among `sources` that are in `changed` or include one of its headers (`reverse_graph`
+from `reverse_include_graph`)
+"""
+function affected_sources(changed, reverse_graph::Dict{String,Vector{String}}, sources::Set{String})
+    affected = Set(filter(in(sources), changed))
+    for path in changed
+        for dependent in get(reverse_graph, path, String[])
+            dependent in sources && push!(affected, dependent)
+        end
+    end
+    return affected
+end
+
+"""
+Decide per component which TUs to recompile and whether to relink.
+
+A change set comes from the digests recorded at the component's last successful build:
+every TU and every header it includes is compared, and `changed_files` (from the
+watcher) are always re-read. A component last built with other flags is rebuilt
+whole. Changed headers are walked through the reverse include graph to the exact
+dependent TUs. Unchanged components are skipped with a reason.
+"""
+function plan_build(compiler::LLVMJuliaCompiler, file_groups::Dict{String,Vector{String}},
+                    state::Dict{String,Any}; changed_files::Vector{String}=String[])
+    flags_digest = bytes2hex(sha256(join(vcat(ir_output_flags(compiler), get_compiler_flags(compiler),
+                                              compiler.config.target.variants), "\0")))
+    force = Set(abspath.(changed_files))
+    mtimes = state["mtimes"]
+
+    all_files = unique(vcat(values(file_groups)...))
+    include_graph = translation_unit_headers(compiler, all_files)
+    reverse_graph = reverse_include_graph(include_graph)
+
+    plans = ComponentPlan[]
+    for (name, files) in file_groups
+        previous = get(state["components"], name, nothing)
+        libraries = [joinpath(compiler.config.output_dir, variant_library(name, cpu))
+                     for cpu in ["", compiler.config.target.variants...]]
+
+        if previous === nothing
+            push!(plans, ComponentPlan(name, files, files, true, "first build", flags_digest))
+            continue
+        elseif get(previous, "flags", "") != flags_digest
+            push!(plans, ComponentPlan(name, files, files, true, "compiler flags changed", flags_digest))
+            continue
+        end
+
+        sources = Set(abspath.(files))
+        snapshot = previous["digests"]
+
+        # Changed inputs of this component
+        changed = String[]
+        headers = reduce(vcat, [include_graph[s] for s in sources]; init=String[])
+        for path in union(sources, headers)
+            if file_digest!(mtimes, path; force=force) != get(snapshot, path, "")
+                push!(changed, path)
+            end
+        end
+
+        # Walk changed headers back to the TUs of this component that include them
+        affected = affected_sources(changed, reverse_graph, sources)
+
+        # TUs whose IR is gone must be recompiled too (unity batches check their own IR)
+        compiler.config.unity || for file in files
+            isfile(BuildCache.output_path(compiler.config.build_dir, file, ir_extension(compiler))) ||
+                push!(affected, abspath(file))
+        end
+
+        affected_files = [f for f in files if abspath(f) in affected]
+        removed = setdiff(Set(String.(previous["files"])), sources)
+
+        reason = if !isempty(affected_files)
+            "$(length(affected_files)) of $(length(files)) translation units affected"
+        elseif !isempty(removed)
+            "$(length(removed)) translation units removed"
+        elseif !all(isfile, libraries)
+            "library missing"
+        else
+            ""
+        end
+
+        push!(plans, ComponentPlan(name, files, affected_files, !isempty(reason),
+                                   isempty(reason) ? "no changes" : reason, flags_digest))
+    end
+
+    return plans, include_graph
+end
+
+"""
+Record a successful component build in the state, with the flags it was built with
+"""
+function record_component!(state::Dict{String,Any}, plan::ComponentPlan,
+                           include_graph::Dict{String,Vector{String}}, signature_digest::String)
+    mtimes = state["mtimes"]
+    sources = abspath.(plan.files)
+    headers = reduce(vcat, [get(include_graph, s, String[]) for s in sources]; init=String[])
+    inputs = union(sources, headers)
+
+    state["components"][plan.name] = Dict{String,Any}(
+        "files" => sources,
+        "digests" => Dict(path => file_digest!(mtimes, path) for path in inputs),
+        "signatures" => signature_digest,
+        "flags" => plan.flags
+    )
+end
+
+"""
+Digest of a component's exported signature table (and of the CPU variants the
+bindings choose from, which their loader lists)
+"""
+function signature_digest(functions::Vector{FunctionSignature}, variants::Vector{String}=String[])
+    lines = ["$(f.name)($(join([p.type for p in f.params], ","))) -> $(f.return_type)" for f in functions]
+    append!(lines, ["variant $cpu" for cpu in variants])
+    return bytes2hex(sha256(join(sort(lines), "\n")))
 end
 
 """
@@ -987,8 +2189,8 @@ function save_metadata(compiler::LLVMJuliaCompiler, components::Vector{String})
         "timestamp" => now(),
         "config" => compiler.config,
         "components" => components,
-        "compiler_version" => read(`$(compiler.config.clang_path) --version`, String),
-        "llvm_version" => read(`$(compiler.config.llvm_config_path) --version`, String)
+        "compiler_version" => compiler_version(compiler.config.clang_path),
+        "llvm_version" => compiler_version(compiler.config.llvm_config_path)
     )
 
     metadata_file = joinpath(compiler.config.output_dir, "compilation_metadata.json")
@@ -1007,7 +2209,7 @@ function main()
 
         Usage:
             julia LLVMake.jl init [project_dir]
-            julia LLVMake.jl compile [config_file]
+            julia LLVMake.jl compile [config_file] [--changed <file>...]
             julia LLVMake.jl compile-file <file.cpp> [config_file]
             julia LLVMake.jl info [config_file]
             julia LLVMake.jl clean [config_file]
@@ -1015,6 +2217,7 @@ function main()
         Examples:
             julia LLVMake.jl init myproject
             julia LLVMake.jl compile
+            julia LLVMake.jl compile jmake.toml --changed include/math.h
             julia LLVMake.jl compile-file src/math.cpp
             julia LLVMake.jl info
         """)
@@ -1040,10 +2243,12 @@ function main()
         println("📝 Edit $config_file to configure your project")
 
     elseif command == "compile"
-        # Compile entire project
-        config_file = length(ARGS) >= 2 ? ARGS[2] : "jmake.toml"
+        # Compile entire project; files after --changed (e.g. from an editor hook) are
+        # re-read even when their mtime did not move
+        marker = something(findfirst(==("--changed"), ARGS), length(ARGS) + 1)
+        config_file = marker > 2 ? ARGS[2] : "jmake.toml"
         compiler = LLVMJuliaCompiler(config_file)
-        compile_project(compiler)
+        compile_project(compiler, changed_files=String[ARGS[marker+1:end]...])
 
     elseif command == "compile-file"
         # Compile specific file
@@ -1113,7 +2318,7 @@ export LLVMJuliaCompiler, CompilerConfig, TargetConfig
 export compile_project, parse_cpp_ast, compile_to_ir
 export optimize_and_link_ir, compile_ir_to_shared_lib
 export generate_julia_bindings, load_config, create_default_config
-export find_cpp_files, group_files_by_component
+export find_cpp_files, group_files_by_component, build_component
 
 end # module LLVMake
 
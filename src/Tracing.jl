@@ -0,0 +1,298 @@
+#!/usr/bin/env julia
+# Tracing.jl - Instrumentation spans and cache hit/miss counters for the build pipeline
+# Off unless JMAKE_TRACE is set (or `enable!` is called): a disabled span is one Ref load
+# Spans export as Chrome trace JSON, which chrome://tracing, Perfetto and speedscope open
+# Self-contained (stdlib only): every instrumented module includes its own copy, and the
+# exports gather the events of all copies loaded in the process
+
+module Tracing
+
+# A completed span; times are `time_ns()` values, `task` identifies the lane it ran on
+const Event = NamedTuple{(:name, :cat, :start, :stop, :task, :args),
+                         Tuple{String,String,UInt64,UInt64,UInt64,Vector{Pair{String,Any}}}}
+
+const ENABLED = Ref(false)
+const EVENTS = Event[]
+const COUNTERS = Dict{Tuple{String,Symbol},Int}()  # (cache, :hit or :miss) => count
+const LOCK = ReentrantLock()
+
+"""
+    enabled() -> Bool
+
+Whether this copy records spans and counters.
+"""
+enabled() = ENABLED[]
+
+# ============================================================================
+# RECORDING
+# ============================================================================
+
+"""
+    span(f, name; cat="jmake", args...)
+
+Run `f()` and, while tracing, record how long it took as `name`. Keyword `args` are
+attached to the event (shown in the trace viewer's details pane).
+"""
+function span(f::Function, name::AbstractString; cat::AbstractString="jmake", args...)
+    ENABLED[] || return f()
+    start = time_ns()
+    try
+        return f()
+    finally
+        push_event!(name, cat, start, time_ns(), args)
+    end
+end
+
+"""
+    record_span!(name, start, stop; cat="jmake", args...)
+
+Record an interval measured by the caller (`time_ns()` values), e.g. the spawn and
+run phases of one process.
+"""
+function record_span!(name::AbstractString, start::UInt64, stop::UInt64; cat::AbstractString="jmake", args...)
+    ENABLED[] && push_event!(name, cat, start, stop, args)
+    return nothing
+end
+
+function push_event!(name::AbstractString, cat::AbstractString, start::UInt64, stop::UInt64, args)
+    event = Event((String(name), String(cat), start, stop, objectid(current_task()),
+                   Pair{String,Any}[string(k) => v for (k, v) in args]))
+    lock(() -> push!(EVENTS, event), LOCK)
+    return nothing
+end
+
+"""
+    count_cache!(cache::AbstractString, hit::Bool) -> Bool
+
+Count a hit or a miss of `cache` while tracing; returns `hit`, so a lookup can be
+wrapped in place: `count_cache!("signatures", haskey(memo, key))`.
+"""
+function count_cache!(cache::AbstractString, hit::Bool)
+    if ENABLED[]
+        lock(LOCK) do
+            key = (String(cache), hit ? :hit : :miss)
+            COUNTERS[key] = get(COUNTERS, key, 0) + 1
+        end
+    end
+    return hit
+end
+
+# ============================================================================
+# COPIES
+# ============================================================================
+
+"""
+    copies() -> Vector{Module}
+
+Every loaded copy of this module: the ones nested in the package this copy belongs
+to, and the ones in modules included into `Main` (e.g. a daemon's JobQueue).
+"""
+function copies()
+    found = Module[]
+    seen = Set{Module}()
+    function walk(m::Module)
+        m in seen && return
+        push!(seen, m)
+        nameof(m) === :Tracing && isdefined(m, :EVENTS) && push!(found, m)
+        for name in names(m; all=true)
+            isdefined(m, name) || continue
+            value = getfield(m, name)
+            value isa Module && value !== m && parentmodule(value) === m && walk(value)
+        end
+    end
+    walk(Base.moduleroot(@__MODULE__))
+    walk(Main)
+    @__MODULE__() in found || push!(found, @__MODULE__)
+    return found
+end
+
+"""
+    enable!()
+    disable!()
+
+Switch recording on or off in every loaded copy. Copies loaded later follow `JMAKE_TRACE`.
+"""
+enable!() = foreach(m -> m.ENABLED[] = true, copies())
+disable!() = foreach(m -> m.ENABLED[] = false, copies())
+
+"""
+    reset!()
+
+Drop the spans and counters recorded so far, in every copy.
+"""
+function reset!()
+    for m in copies()
+        lock(m.LOCK) do
+            empty!(m.EVENTS)
+            empty!(m.COUNTERS)
+        end
+    end
+end
+
+"""
+    events() -> Vector{Event}
+
+Spans recorded by all copies, by start time.
+"""
+function events()
+    all_events = Event[]
+    for m in copies()
+        lock(() -> append!(all_events, m.EVENTS), m.LOCK)
+    end
+    return sort!(all_events, by=e -> e.start)
+end
+
+"""
+    counters() -> Dict{String,Tuple{Int,Int}}
+
+Cache name => (hits, misses), summed over all copies.
+"""
+function counters()
+    totals = Dict{String,Tuple{Int,Int}}()
+    for m in copies()
+        lock(m.LOCK) do
+            for ((cache, outcome), n) in m.COUNTERS
+                hits, misses = get(totals, cache, (0, 0))
+                totals[cache] = outcome === :hit ? (hits + n, misses) : (hits, misses + n)
+            end
+        end
+    end
+    return totals
+end
+
+# ============================================================================
+# EXPORT
+# ============================================================================
+
+"""
+    write_trace(path::String) -> String
+
+Write the recorded spans as Chrome trace JSON (`ph: "X"` complete events, microseconds,
+one `tid` lane per task), with the cache counters as final counter events.
+"""
+function write_trace(path::String)
+    recorded = events()
+    origin = isempty(recorded) ? time_ns() : first(recorded).start
+    lanes = Dict{UInt64,Int}()
+    pid = getpid()
+
+    mkpath(dirname(abspath(path)))
+    open(path, "w") do io
+        print(io, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[")
+        print(io, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":$pid,\"tid\":0,\"args\":{\"name\":\"jmake $pid\"}}")
+        last_stop = origin
+        for e in recorded
+            tid = get!(lanes, e.task, length(lanes) + 1)
+            print(io, ",\n{\"name\":")
+            json_value(io, e.name)
+            print(io, ",\"cat\":")
+            json_value(io, e.cat)
+            print(io, ",\"ph\":\"X\",\"pid\":$pid,\"tid\":$tid,\"ts\":", micros(e.start - origin),
+                  ",\"dur\":", micros(e.stop - e.start), ",\"args\":")
+            json_object(io, e.args)
+            last_stop = max(last_stop, e.stop)
+        end
+        for (cache, (hits, misses)) in sort!(collect(counters()))
+            print(io, ",\n{\"name\":")
+            json_value(io, "cache:$cache")
+            print(io, ",\"ph\":\"C\",\"pid\":$pid,\"tid\":0,\"ts\":", micros(last_stop - origin),
+                  ",\"args\":{\"hit\":$hits,\"miss\":$misses}}")
+        end
+        print(io, "]}\n")
+    end
+    return path
+end
+
+micros(ns::UInt64) = round(ns / 1e3, digits=3)
+
+function json_object(io::IO, pairs::Vector{Pair{String,Any}})
+    print(io, "{")
+    for (i, (k, v)) in enumerate(pairs)
+        i > 1 && print(io, ",")
+        json_value(io, k)
+        print(io, ":")
+        json_value(io, v)
+    end
+    print(io, "}")
+end
+
+json_value(io::IO, v::Bool) = print(io, v ? "true" : "false")
+json_value(io::IO, v::Integer) = print(io, v)
+json_value(io::IO, v::AbstractFloat) = isfinite(v) ? print(io, Float64(v)) : print(io, "null")
+function json_value(io::IO, v)
+    print(io, '"')
+    for c in string(v)
+        if c == '"' || c == '\\'
+            print(io, '\\', c)
+        elseif c < ' '
+            print(io, "\\u", string(UInt16(c), base=16, pad=4))
+        else
+            print(io, c)
+        end
+    end
+    print(io, '"')
+end
+
+"""
+    print_summary(io::IO=stdout)
+
+Per span name: count, total and slowest time; per cache: hits, misses and hit rate.
+"""
+function print_summary(io::IO=stdout)
+    totals = Dict{String,Tuple{Int,Float64,Float64}}()  # name => (count, total s, max s)
+    for e in events()
+        s = (e.stop - e.start) / 1e9
+        n, total, slowest = get(totals, e.name, (0, 0.0, 0.0))
+        totals[e.name] = (n + 1, total + s, max(slowest, s))
+    end
+
+    println(io, rpad("span", 32), lpad("count", 8), lpad("total s", 12), lpad("max s", 12))
+    for (name, (n, total, slowest)) in sort!(collect(totals), by=p -> -p.second[2])
+        println(io, rpad(name, 32), lpad(n, 8), lpad(round(total, digits=4), 12), lpad(round(slowest, digits=4), 12))
+    end
+
+    caches = counters()
+    isempty(caches) && return
+    println(io, "\n", rpad("cache", 32), lpad("hits", 8), lpad("misses", 12), lpad("hit rate", 12))
+    for (cache, (hits, misses)) in sort!(collect(caches))
+        rate = hits + misses == 0 ? 0.0 : hits / (hits + misses)
+        println(io, rpad(cache, 32), lpad(hits, 8), lpad(misses, 12), lpad("$(round(100rate, digits=1))%", 12))
+    end
+end
+
+# ============================================================================
+# ENVIRONMENT
+# ============================================================================
+
+"""
+Trace file for a `JMAKE_TRACE` value: "1" writes `jmake-trace-<pid>.json` in the working
+directory, a directory gets that file inside it, anything else is the file itself
+"""
+function trace_file(target::AbstractString)
+    file = "jmake-trace-$(getpid()).json"
+    target == "1" && return abspath(file)
+    (isdir(target) || endswith(target, '/')) && return joinpath(target, file)
+    return String(target)
+end
+
+function __init__()
+    target = get(ENV, "JMAKE_TRACE", "")
+    (isempty(target) || target == "0") && return
+    ENABLED[] = true
+
+    # One copy per process writes the trace at exit (and gathers the others')
+    get(ENV, "JMAKE_TRACE_WRITER", "") == string(getpid()) && return
+    ENV["JMAKE_TRACE_WRITER"] = string(getpid())
+    atexit() do
+        try
+            println(stderr, "[TRACE] Written to $(write_trace(trace_file(target)))")
+            get(ENV, "JMAKE_TRACE_SUMMARY", "0") == "1" && print_summary(stderr)
+        catch e
+            @warn "Could not write trace: $e"
+        end
+    end
+end
+
+export span, record_span!, count_cache!
+
+end # module Tracing
@@ -30,7 +30,8 @@ println("=" ^ 60)
 try
     # Create sysimage with JMake and all dependencies precompiled
     create_sysimage(
-        [:JMake, :TOML, :JSON, :Dates, :Libdl];
+        [:JMake, :TOML, :JSON, :Dates, :Libdl, :SQLite, :DBInterface, :DataFrames,
+         :SHA, :Mmap, :Serialization, :Sockets, :DaemonMode];
         sysimage_path=sysimage_path,
         precompile_execution_file=precompile_file,
         project=project_dir
@@ -48,6 +49,7 @@ try
     # Display size reduction info
     sysimage_size_mb = filesize(sysimage_path) / (1024 * 1024)
     println("\n📊 Sysimage size: $(round(sysimage_size_mb, digits=2)) MB")
+    println("⏱  Measure time-to-first-build: julia --project=$project_dir $(joinpath(project_dir, "benchmarks", "time_to_first_build.jl"))")
 
 catch e
     println("\n❌ Error building sysimage:")
@@ -1,112 +1,255 @@
 #!/usr/bin/env julia
-# Precompilation statements for JMake
-# This file helps PackageCompiler.jl create an optimized sysimage
+# Precompilation workload for JMake
+# Runs the real pipeline (discover → compile → link → wrap), error learning and the
+# daemon request handlers against copies of the bundled examples/ projects, so
+# PackageCompiler.jl records the methods a first build actually needs.
+#
+# Stages that need a tool this machine lacks (e.g. no LLVM toolchain) are skipped
+# with a warning; the rest still run.
+#
+# Run standalone to check it: julia --project=.. precompile_jmake.jl
 
 using JMake
+using Libdl
+
+println("Running JMake precompilation workload...")
+
+const EXAMPLES_DIR = joinpath(dirname(@__DIR__), "examples")
+const DAEMONS_DIR = joinpath(dirname(@__DIR__), "daemons", "servers")
+const WORKSPACE = mktempdir()
+const STAGE_TIMES = Pair{String,Float64}[]
+
+"""
+Run one workload stage; failures are reported and do not stop the others
+"""
+function stage(f::Function, name::String)
+    println("\n▶ $name")
+    t = @elapsed try
+        f()
+    catch e
+        @warn "Precompile stage '$name' incomplete: $(sprint(showerror, e))"
+    end
+    push!(STAGE_TIMES, name => t)
+end
 
-println("Running JMake precompilation...")
-
-# Core initialization functions
-JMake.info()
-JMake.help()
+"""
+Copy an example project's sources into the workspace (generated files stay behind)
+"""
+function example_project(name::String)
+    dest = joinpath(WORKSPACE, name)
+    mkpath(dest)
+    for dir in ("src", "include")
+        src = joinpath(EXAMPLES_DIR, name, dir)
+        isdir(src) && cp(src, joinpath(dest, dir))
+    end
+    for file in ("CMakeLists.txt",)
+        src = joinpath(EXAMPLES_DIR, name, file)
+        isfile(src) && cp(src, joinpath(dest, file))
+    end
+    return dest
+end
 
-# BuildBridge functions - command checking
-JMake.BuildBridge.command_exists("gcc")
-JMake.BuildBridge.command_exists("clang")
-JMake.BuildBridge.command_exists("julia")
-try
-    JMake.BuildBridge.find_executable("gcc")
-catch e
-    # Expected to fail sometimes, that's ok
+"""
+Load a daemon server script into its own module; `main()` only runs when it is the program
+"""
+function daemon_module(file::String)
+    mod = Module(Symbol(splitext(file)[1]))
+    Core.eval(mod, :(using JMake))
+    Base.include(mod, joinpath(DAEMONS_DIR, file))
+    return mod
 end
 
-# JuliaWrapItUp core functions - identifier handling
-JMake.JuliaWrapItUp.make_julia_identifier("test_function")
-JMake.JuliaWrapItUp.make_julia_identifier("MyClass::method")
-JMake.JuliaWrapItUp.make_julia_identifier("operator+")
-JMake.JuliaWrapItUp.make_julia_identifier("123invalid")
-JMake.JuliaWrapItUp.make_julia_identifier("while")  # reserved word
-
-# Module name generation
-JMake.JuliaWrapItUp.generate_module_name("testlib")
-JMake.JuliaWrapItUp.generate_module_name("libmath")
-JMake.JuliaWrapItUp.generate_module_name("lib_crypto_ssl")
-
-# Binary type identification
-JMake.JuliaWrapItUp.identify_binary_type("/usr/lib/libc.so")
-JMake.JuliaWrapItUp.identify_binary_type("test.a")
-JMake.JuliaWrapItUp.identify_binary_type("test.o")
-JMake.JuliaWrapItUp.identify_binary_type("test.dylib")
-
-# Configuration creation
-wrapper_config = JMake.JuliaWrapItUp.create_default_wrapper_config()
-
-# Type registry loading
-type_registry = JMake.JuliaWrapItUp.load_type_registry(wrapper_config)
-
-# Create a temporary wrapper config file for testing
-temp_dir = mktempdir()
-temp_config = joinpath(temp_dir, "test_wrapper_config.toml")
-try
-    JMake.JuliaWrapItUp.save_wrapper_config(wrapper_config, temp_config)
-
-    # Now create a BinaryWrapper using the temporary config
-    test_wrapper = JMake.JuliaWrapItUp.BinaryWrapper(temp_config)
-
-    # Type inference with different types
-    JMake.JuliaWrapItUp.infer_julia_type(test_wrapper, "int")
-    JMake.JuliaWrapItUp.infer_julia_type(test_wrapper, "void*")
-    JMake.JuliaWrapItUp.infer_julia_type(test_wrapper, "const char*")
-    JMake.JuliaWrapItUp.infer_julia_type(test_wrapper, "float")
-    JMake.JuliaWrapItUp.infer_julia_type(test_wrapper, "double")
-    JMake.JuliaWrapItUp.infer_julia_type(test_wrapper, "uint64_t")
-    JMake.JuliaWrapItUp.infer_julia_type(test_wrapper, "std::string")
-    JMake.JuliaWrapItUp.infer_julia_type(test_wrapper, "int*")
-    JMake.JuliaWrapItUp.infer_julia_type(test_wrapper, "const int&")
-    JMake.JuliaWrapItUp.infer_julia_type(test_wrapper, nothing)
-
-catch e
-    @warn "Wrapper instance creation skipped: $e"
-finally
-    rm(temp_dir, recursive=true, force=true)
+toolchain_available() = try
+    JMake.LLVMEnvironment.get_toolchain()
+    true
+catch
+    JMake.BuildBridge.command_exists("clang++")
 end
 
-# Symbol parsing - various C++ signatures
-JMake.JuliaWrapItUp.parse_symbol_signature("myfunction(int, float)")
-JMake.JuliaWrapItUp.parse_symbol_signature("std::vector<int>::push_back(int const&)")
-JMake.JuliaWrapItUp.parse_symbol_signature("operator+(MyClass const&, MyClass const&)")
-JMake.JuliaWrapItUp.parse_symbol_signature("simple_func")
-JMake.JuliaWrapItUp.parse_symbol_signature("void function()")
-JMake.JuliaWrapItUp.parse_symbol_signature("int* getPointer(const char*)")
-
-# Parameter parsing
-JMake.JuliaWrapItUp.parse_single_parameter("const int value")
-JMake.JuliaWrapItUp.parse_single_parameter("float* ptr")
-JMake.JuliaWrapItUp.parse_single_parameter("std::string&")
-JMake.JuliaWrapItUp.parse_single_parameter("volatile int x")
-JMake.JuliaWrapItUp.parse_single_parameter("double")
-
-# Parameter list parsing
-JMake.JuliaWrapItUp.parse_parameter_list("int a, float b, const char* c")
-JMake.JuliaWrapItUp.parse_parameter_list("std::vector<int> v, std::map<std::string, int> m")
-JMake.JuliaWrapItUp.parse_parameter_list("void")
-JMake.JuliaWrapItUp.parse_parameter_list("")
-
-# Templates functions
-try
-    JMake.Templates.detect_project_type([])
+const SIMPLE_MATH = example_project("simple_math")
+const MATHLIB = example_project("mathlib")
+const CMAKE_IMPORT = example_project("cmake_import")
+
+# ============================================================================
+# CORE HELPERS
+# ============================================================================
+
+stage("core helpers") do
+    JMake.info()
+    JMake.help()
+
+    JMake.BuildBridge.command_exists("clang")
+    JMake.BuildBridge.find_executable("clang++")
+
+    for name in ["test_function", "MyClass::method", "operator+", "123invalid", "while"]
+        JMake.JuliaWrapItUp.make_julia_identifier(name)
+    end
+    for name in ["testlib", "libmath", "lib_crypto_ssl"]
+        JMake.JuliaWrapItUp.generate_module_name(name)
+    end
+    for signature in ["myfunction(int, float)", "std::vector<int>::push_back(int const&)",
+                      "operator+(MyClass const&, MyClass const&)", "int* getPointer(const char*)"]
+        JMake.JuliaWrapItUp.parse_symbol_signature(signature)
+    end
+    JMake.JuliaWrapItUp.parse_parameter_list("std::vector<int> v, std::map<std::string, int> m")
     JMake.Templates.detect_project_type(["main.cpp", "test.h"])
-    JMake.Templates.detect_project_type(["main.c", "utils.c"])
-catch e
-    @warn "Template functions skipped: $e"
 end
 
-# Test isexecutable helper
-try
-    JMake.JuliaWrapItUp.isexecutable("/usr/bin/gcc")
-    JMake.JuliaWrapItUp.isexecutable("/usr/lib/libc.so")
-catch e
-    # May fail on some systems
+# ============================================================================
+# CONFIGURATION, DISCOVERY, CMAKE IMPORT
+# ============================================================================
+
+stage("discovery") do
+    for project in (SIMPLE_MATH, MATHLIB)
+        JMake.Discovery.discover(project; force=true)
+    end
+end
+
+stage("configuration") do
+    for project in (SIMPLE_MATH, MATHLIB)
+        config = JMake.ConfigurationManager.load_config(joinpath(project, "jmake.toml"))
+        JMake.ConfigurationManager.save_config(config)
+    end
+end
+
+stage("dependency graph") do
+    files = [joinpath(root, f) for (root, _, fs) in walkdir(MATHLIB) for f in fs
+             if endswith(f, ".cpp") || endswith(f, ".h")]
+    JMake.ASTWalker.build_dependency_graph(files, [joinpath(MATHLIB, "include")])
+end
+
+stage("cmake import") do
+    cmake_file = joinpath(CMAKE_IMPORT, "CMakeLists.txt")
+    project = JMake.CMakeParser.parse_cmake_file(cmake_file)
+    isempty(project.targets) ||
+        JMake.CMakeParser.write_jmake_config(project, first(keys(project.targets)),
+                                             joinpath(CMAKE_IMPORT, "jmake_imported.toml"))
 end
 
-println("✅ Precompilation statements executed successfully")
+# ============================================================================
+# COMPILE → LINK → WRAP
+# ============================================================================
+
+if toolchain_available()
+    stage("bridge pipeline") do
+        cd(() -> JMake.compile(joinpath(SIMPLE_MATH, "jmake.toml")), SIMPLE_MATH)
+    end
+
+    stage("LLVMake pipeline") do
+        cd(MATHLIB) do
+            config_file = joinpath(MATHLIB, "jmake_llvmake.toml")
+            JMake.LLVMake.create_default_config(config_file)
+            compiler = JMake.LLVMake.LLVMJuliaCompiler(config_file)
+            JMake.LLVMake.compile_project(compiler)
+            # Second run is the no-op incremental path (state, signature and IR caches)
+            JMake.LLVMake.compile_project(compiler)
+        end
+    end
+else
+    @warn "No LLVM toolchain found; compile and link stages skipped"
+end
+
+stage("binary wrapping") do
+    libm = Libdl.dlpath(Libdl.dlopen(Base.Math.libm))
+    JMake.BinaryReader.exported_symbols(JMake.BinaryReader.read_binary(libm))
+
+    for call_mode in ("cached", "lazy")
+        dir = joinpath(WORKSPACE, "wrap_$call_mode")
+        mkpath(dir)
+        config_file = joinpath(dir, "wrapper_config.toml")
+        write(config_file, """
+        project_root = "$(escape_string(dir))"
+
+        [wrapper]
+        call_mode = "$call_mode"
+        output_dir = "julia_wrappers"
+
+        [scanning]
+        include_symbols = ["sin", "cos", "fabs", "pow"]
+        """)
+        JMake.wrap_binary(libm; config_file=config_file)
+    end
+
+    # Wrap what the pipeline built, when it built something
+    for (root, _, files) in walkdir(WORKSPACE), file in files
+        if startswith(root, SIMPLE_MATH) && endswith(file, ".so")
+            JMake.JuliaWrapItUp.identify_binary_type(joinpath(root, file))
+        end
+    end
+end
+
+# ============================================================================
+# ERROR LEARNING
+# ============================================================================
+
+stage("error learning") do
+    EL = JMake.ErrorLearning
+    output = """
+    src/math_ops.cpp:3:10: fatal error: 'missing.h' file not found
+    #include "missing.h"
+    1 error generated.
+    """
+    db = EL.init_db(joinpath(WORKSPACE, "errors.db"))
+    (id, _, _) = EL.record_error(db, "clang++ -c src/math_ops.cpp", output)
+    EL.record_fix(db, id, "Add include directory", "add_include_dir", "config_change", true)
+    EL.suggest_fixes(db, output)
+    EL.find_similar_errors(db, "unknown", "ld.lld: error: undefined symbol: vector_dot")
+    EL.get_error_stats(db)
+
+    store = EL.ErrorStore(joinpath(WORKSPACE, "store.db"))
+    (pending, _, _) = EL.record_error!(store, "clang++ -c a.cpp", output)
+    EL.record_fix!(store, pending, "Add include directory", "add_include_dir", "config_change", true)
+    EL.flush!(store)
+    EL.suggest_fixes(store, output)
+    close(store)
+
+    JMake.BuildBridge.export_error_log(joinpath(WORKSPACE, "errors.db"), joinpath(WORKSPACE, "errors.md"))
+end
+
+# ============================================================================
+# DAEMON HANDLERS
+# ============================================================================
+
+stage("daemon handlers") do
+    # Arguments arrive as Dict{String,Any}, both over DaemonMode and DaemonRPC
+    args(pairs...) = Dict{String,Any}(pairs...)
+
+    discovery = daemon_module("discovery_daemon.jl")
+    discovery.scan_files(args("path" => MATHLIB, "force" => true))
+    discovery.walk_ast_dependencies(args("path" => MATHLIB, "include_dirs" => [joinpath(MATHLIB, "include")]))
+    discovery.discover_project(args("path" => SIMPLE_MATH, "force" => true))
+    discovery.cache_stats(args())
+
+    setup = daemon_module("setup_daemon.jl")
+    setup.generate_config(args("path" => MATHLIB, "force" => true))
+    setup.validate_config(args("config" => joinpath(MATHLIB, "jmake.toml")))
+    setup.get_config_section(args("config" => joinpath(MATHLIB, "jmake.toml"), "section" => "compile"))
+
+    errors = daemon_module("error_handler_daemon.jl")
+    db_path = joinpath(WORKSPACE, "daemon_errors.db")
+    report = errors.queue_error(args("db_path" => db_path, "command" => "clang++",
+                                     "output" => "fatal error: 'missing.h' file not found"))
+    errors.queue_fix(args("db_path" => db_path, "ticket" => report[:ticket], "description" => "Add include",
+                          "action" => "add_include_dir", "type" => "config_change", "success" => true))
+    errors.flush_errors(args("db_path" => db_path))
+    errors.error_stats(args("db_path" => db_path))
+
+    # Typed RPC: framing, listener and client round trip
+    port = 47900 + rand(0:90)
+    server = JMake.DaemonRPC.serve_rpc(port, ["stats" => errors.error_stats])
+    try
+        JMake.DaemonRPC.ping(port)
+        JMake.DaemonRPC.call(port, :stats, Dict("db_path" => db_path))
+    finally
+        close(server)
+    end
+    JMake.ErrorLearning.close_stores()
+end
+
+rm(WORKSPACE; recursive=true, force=true)
+
+println("\nPrecompile workload stages:")
+for (name, t) in STAGE_TIMES
+    println("  $(rpad(name, 20)) $(round(t, digits=2)) s")
+end
+println("✅ Precompilation workload finished")
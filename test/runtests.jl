@@ -17,6 +17,16 @@ test_files = [
     "test_astwalker.jl",
     "test_discovery.jl",
     "test_cmake_parser.jl",
+    "test_build_cache.jl",
+    "test_ast_signatures.jl",
+    "test_job_queue.jl",
+    "test_daemon_rpc.jl",
+    "test_wrapper_codegen.jl",
+    "test_binary_reader.jl",
+    "test_error_store.jl",
+    "test_tracing.jl",
+    "test_unity_build.jl",
+    "test_build_plan.jl",
 ]
 
 @testset "JMake Unit Tests" begin
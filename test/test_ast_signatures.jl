@@ -0,0 +1,206 @@
+@testset "ASTSignatures" begin
+    @testset "Return types from qualType" begin
+        @test JMake.ASTSignatures.return_type_from_qualtype("int (int, int)") == "int"
+        @test JMake.ASTSignatures.return_type_from_qualtype("void ()") == "void"
+        @test JMake.ASTSignatures.return_type_from_qualtype("const char *(const char *) noexcept") == "const char *"
+    end
+
+    @testset "Streaming main-file filter" begin
+        # Shape of clang's pretty-printed dump: a location's "file" is only written
+        # when it changes, so `cbrt` inherits math.h and `scale` inherits main.cpp
+        ast = """
+        {
+          "id": "0x1",
+          "kind": "TranslationUnitDecl",
+          "loc": {},
+          "range": {
+            "begin": {},
+            "end": {}
+          },
+          "inner": [
+            {
+              "id": "0x2",
+              "kind": "TypedefDecl",
+              "loc": {},
+              "range": {
+                "begin": {},
+                "end": {}
+              },
+              "isImplicit": true,
+              "name": "__int128_t"
+            },
+            {
+              "id": "0x3",
+              "kind": "FunctionDecl",
+              "loc": {
+                "offset": 10,
+                "file": "/usr/include/math.h",
+                "line": 3,
+                "includedFrom": {
+                  "file": "main.cpp"
+                }
+              },
+              "range": {
+                "begin": {},
+                "end": {}
+              },
+              "name": "sqrt",
+              "type": {
+                "qualType": "double (double)"
+              },
+              "inner": [
+                {
+                  "id": "0x4",
+                  "kind": "ParmVarDecl",
+                  "loc": {},
+                  "range": {
+                    "begin": {},
+                    "end": {}
+                  },
+                  "name": "x",
+                  "type": {
+                    "qualType": "double"
+                  }
+                }
+              ]
+            },
+            {
+              "id": "0x5",
+              "kind": "FunctionDecl",
+              "loc": {
+                "offset": 30,
+                "line": 5
+              },
+              "range": {
+                "begin": {},
+                "end": {}
+              },
+              "name": "cbrt",
+              "type": {
+                "qualType": "double (double)"
+              },
+              "inner": []
+            },
+            {
+              "id": "0x6",
+              "kind": "FunctionDecl",
+              "loc": {
+                "offset": 4,
+                "file": "main.cpp",
+                "line": 2
+              },
+              "range": {
+                "begin": {},
+                "end": {}
+              },
+              "name": "add",
+              "type": {
+                "qualType": "int (int, int)"
+              },
+              "inner": [
+                {
+                  "id": "0x7",
+                  "kind": "ParmVarDecl",
+                  "loc": {},
+                  "range": {
+                    "begin": {},
+                    "end": {}
+                  },
+                  "name": "a",
+                  "type": {
+                    "qualType": "int"
+                  }
+                },
+                {
+                  "id": "0x8",
+                  "kind": "ParmVarDecl",
+                  "loc": {},
+                  "range": {
+                    "begin": {},
+                    "end": {}
+                  },
+                  "name": "b",
+                  "type": {
+                    "qualType": "int"
+                  }
+                },
+                {
+                  "id": "0x9",
+                  "kind": "CompoundStmt",
+                  "range": {
+                    "begin": {},
+                    "end": {}
+                  }
+                }
+              ]
+            },
+            {
+              "id": "0xa",
+              "kind": "FunctionDecl",
+              "loc": {
+                "offset": 50,
+                "line": 6
+              },
+              "range": {
+                "begin": {},
+                "end": {}
+              },
+              "name": "scale",
+              "type": {
+                "qualType": "void (double *, unsigned long) noexcept"
+              },
+              "inner": [
+                {
+                  "id": "0xb",
+                  "kind": "ParmVarDecl",
+                  "loc": {},
+                  "range": {
+                    "begin": {},
+                    "end": {}
+                  },
+                  "name": "data",
+                  "type": {
+                    "qualType": "double *"
+                  }
+                }
+              ]
+            }
+          ]
+        }
+        """
+
+        signatures = JMake.ASTSignatures.scan_ast_stream(IOBuffer(ast), "main.cpp")
+        @test [s.name for s in signatures] == ["add", "scale"]
+        @test signatures[1].return_type == "int"
+        @test [(p.name, p.type) for p in signatures[1].params] == [("a", "int"), ("b", "int")]
+        @test signatures[2].return_type == "void"
+        @test signatures[2].params == [JMake.ASTSignatures.ParamSignature("data", "double *")]
+
+        # The same dump parsed whole yields the header declarations as well
+        all_signatures = JMake.ASTSignatures.signatures_from_ast(JMake.JSON.parse(ast))
+        @test [s.name for s in all_signatures] == ["sqrt", "cbrt", "add", "scale"]
+    end
+
+    @testset "Signature cache" begin
+        mktempdir() do dir
+            source = joinpath(dir, "add.cpp")
+            write(source, "int add(int a, int b) { return a + b; }\n")
+            signatures = [JMake.ASTSignatures.FunctionSignature("add", "int",
+                [JMake.ASTSignatures.ParamSignature("a", "int"), JMake.ASTSignatures.ParamSignature("b", "int")])]
+
+            table = joinpath(dir, "table.json")
+            JMake.ASTSignatures.save_signatures(table, signatures)
+            @test JMake.ASTSignatures.load_signatures(table) == signatures
+
+            # Seed the store under the key the parser derives; a hit must not need clang
+            clang = joinpath(dir, "no-such-clang")
+            cache = JMake.BuildCache.ArtifactCache(joinpath(dir, "cache"))
+            key = JMake.BuildCache.cache_key(source, ["-Xclang", "-ast-dump=json", "-fsyntax-only", "-O2"];
+                                             toolchain=JMake.BuildCache.toolchain_version(clang))
+            JMake.BuildCache.store!(cache, key, ".sig.json", table)
+
+            @test JMake.ASTSignatures.cached_main_file_signatures(cache, clang, ["-O2"], source) == signatures
+            @test cache.hits[] == 1
+        end
+    end
+end
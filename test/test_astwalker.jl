@@ -3,4 +3,43 @@
         # Placeholder for AST walker tests
         @test true  # TODO: Add AST analysis tests
     end
+
+    @testset "Depfile graph" begin
+        mktempdir() do dir
+            source = joinpath(dir, "main.cpp")
+            header = joinpath(dir, "my util.h")
+            write(source, "#include \"my util.h\"\n")
+            write(header, "int util();\n")
+
+            depfile = joinpath(dir, "main.ll.d")
+            write(depfile, "$(joinpath(dir, "main.ll")): $source \\\n  $(replace(header, " " => "\\ "))\n")
+            @test JMake.ASTWalker.parse_depfile(depfile) == [source, header]
+
+            store = joinpath(dir, "depgraph.json")
+            JMake.ASTWalker.record_depfiles!(store, [source => depfile])
+            graph = JMake.ASTWalker.load_depfile_graph(store)
+            @test graph[source] == [header]
+
+            # Harvested edges are used without preprocessing; headers resolve by regex
+            dep_graph = JMake.ASTWalker.build_dependency_graph([source, header], [dir]; depfile_graph=graph)
+            @test dep_graph.include_graph[source] == [header]
+            @test dep_graph.reverse_graph[header] == [source]
+        end
+    end
+
+    @testset "Depfile graph location" begin
+        mktempdir() do dir
+            shared = joinpath(dir, "shared_cache")
+            a = JMake.ASTWalker.depfile_graph_path(joinpath(dir, "a"), shared)
+            b = JMake.ASTWalker.depfile_graph_path(joinpath(dir, "b"), shared)
+            @test startswith(a, shared) && a != b
+            @test JMake.ASTWalker.depfile_graph_path(joinpath(dir, "a", "."), shared) == a
+
+            # Discovery reads the graph from the cache directory the project config names
+            project = joinpath(dir, "a")
+            mkpath(project)
+            write(joinpath(project, "jmake.toml"), "[cache]\ndirectory = \"../shared_cache\"\n")
+            @test normpath(JMake.Discovery.depfile_graph_file(project)) == normpath(a)
+        end
+    end
 end
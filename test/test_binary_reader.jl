@@ -0,0 +1,168 @@
+using Libdl
+
+const BR = JMake.BinaryReader
+
+# Little-endian writers for the hand-built images below
+le(x::Integer, T) = reinterpret(UInt8, [htol(T(x))])
+padded(s::String, n; pad=0x00) = vcat(Vector{UInt8}(codeunits(s)), fill(pad, n - ncodeunits(s)))
+
+"""
+ELF64 shared object with a .dynsym of four symbols and a .dynamic naming its SONAME and one DT_NEEDED
+"""
+function tiny_elf(; e_type=3)
+    strtab = "\0foo\0bar\0undef_x\0hidden_h\0libc.so.6\0libtiny.so.1\0"
+    offset_of(name) = findfirst("\0$name\0", strtab).start   # 0-based offset of the name
+
+    sym(name, info, other, shndx) = vcat(le(name == "" ? 0 : offset_of(name), UInt32), [UInt8(info), UInt8(other)],
+                                         le(shndx, UInt16), le(0, UInt64), le(8, UInt64))
+    dynsym = vcat(sym("", 0, 0, 0),
+                  sym("foo", 0x12, 0, 7),       # GLOBAL FUNC
+                  sym("bar", 0x21, 0, 8),       # WEAK OBJECT
+                  sym("undef_x", 0x12, 0, 0),   # undefined
+                  sym("hidden_h", 0x12, 2, 7))  # hidden
+    dynamic = vcat(le(1, UInt64), le(offset_of("libc.so.6"), UInt64),
+                   le(14, UInt64), le(offset_of("libtiny.so.1"), UInt64),
+                   le(0, UInt64), le(0, UInt64))
+
+    str_off = 64
+    sym_off = str_off + ncodeunits(strtab)
+    dyn_off = sym_off + length(dynsym)
+    sh_off = dyn_off + length(dynamic)
+
+    section(type, offset, size, link, entsize) = vcat(le(0, UInt32), le(type, UInt32), le(0, UInt64), le(0, UInt64),
+        le(offset, UInt64), le(size, UInt64), le(link, UInt32), le(0, UInt32), le(8, UInt64), le(entsize, UInt64))
+
+    header = vcat(UInt8[0x7f, 'E', 'L', 'F', 2, 1, 1], zeros(UInt8, 9),
+                  le(e_type, UInt16), le(0x3E, UInt16), le(1, UInt32), le(0, UInt64),
+                  le(0, UInt64), le(sh_off, UInt64), le(0, UInt32),
+                  le(64, UInt16), le(56, UInt16), le(0, UInt16), le(64, UInt16), le(4, UInt16), le(1, UInt16))
+
+    return vcat(header, Vector{UInt8}(codeunits(strtab)), dynsym, dynamic,
+                section(0, 0, 0, 0, 0),
+                section(3, str_off, ncodeunits(strtab), 0, 0),
+                section(11, sym_off, length(dynsym), 1, 24),
+                section(6, dyn_off, length(dynamic), 1, 16))
+end
+
+"""
+arm64 Mach-O dylib with `_foo` in __text, an undefined `_bar`, and one LC_LOAD_DYLIB
+"""
+function tiny_macho()
+    dylib = "/usr/lib/libSystem.B.dylib"
+    dylib_size = 24 + 8 * cld(ncodeunits(dylib) + 1, 8)
+    sizeofcmds = 152 + 24 + dylib_size
+    sym_off = 32 + sizeofcmds
+    strtab = "\0_foo\0_bar\0"
+    str_off = sym_off + 32
+
+    segment = vcat(le(0x19, UInt32), le(152, UInt32), padded("__TEXT", 16), zeros(UInt8, 32),
+                   le(5, UInt32), le(5, UInt32), le(1, UInt32), le(0, UInt32),
+                   padded("__text", 16), padded("__TEXT", 16), zeros(UInt8, 16),
+                   le(0, UInt32), le(0, UInt32), le(0, UInt32), le(0, UInt32), le(0x80000400, UInt32), zeros(UInt8, 12))
+    symtab = vcat(le(0x2, UInt32), le(24, UInt32), le(sym_off, UInt32), le(2, UInt32),
+                  le(str_off, UInt32), le(ncodeunits(strtab), UInt32))
+    load_dylib = vcat(le(0xC, UInt32), le(dylib_size, UInt32), le(24, UInt32), zeros(UInt8, 12),
+                      padded(dylib, dylib_size - 24))
+    header = vcat(le(0xfeedfacf, UInt32), le(0x0100000C, UInt32), le(0, UInt32), le(6, UInt32),
+                  le(3, UInt32), le(sizeofcmds, UInt32), le(0, UInt32), le(0, UInt32))
+    nlist(strx, type, sect) = vcat(le(strx, UInt32), [UInt8(type), UInt8(sect)], le(0, UInt16), le(0, UInt64))
+
+    return vcat(header, segment, symtab, load_dylib,
+                nlist(1, 0x0f, 1), nlist(6, 0x01, 0),
+                Vector{UInt8}(codeunits(strtab)))
+end
+
+@testset "BinaryReader" begin
+    mktempdir() do dir
+        @testset "ELF" begin
+            path = joinpath(dir, "libtiny.so")
+            write(path, tiny_elf())
+            image = BR.read_binary(path)
+
+            @test image.format == :elf
+            @test image.kind == :shared_lib
+            @test image.arch == "x86_64"
+            @test image.needed == ["libc.so.6"]
+            @test image.soname == "libtiny.so.1"
+
+            foo = only(filter(s -> s.name == "foo", image.symbols))
+            @test foo.kind == :function && foo.binding == :global && foo.defined
+            @test only(filter(s -> s.name == "bar", image.symbols)).binding == :weak
+            @test !only(filter(s -> s.name == "undef_x", image.symbols)).defined
+            @test sort([s.name for s in BR.exported_symbols(image)]) == ["bar", "foo"]
+        end
+
+        @testset "Mach-O" begin
+            path = joinpath(dir, "libtiny.dylib")
+            write(path, tiny_macho())
+            image = BR.read_binary(path)
+
+            @test image.format == :macho
+            @test image.kind == :shared_lib
+            @test image.arch == "arm64"
+            @test image.needed == ["/usr/lib/libSystem.B.dylib"]
+            @test [s.name for s in BR.exported_symbols(image)] == ["foo"]
+            @test only(BR.exported_symbols(image)).kind == :function
+            @test !only(filter(s -> s.name == "bar", image.symbols)).defined
+        end
+
+        @testset "Archives" begin
+            object = tiny_elf(e_type=1)
+            field(s, n) = padded(s, n; pad=UInt8(' '))
+            member(name, body) = vcat(field(name, 16), field("0", 12), field("0", 6), field("0", 6),
+                                      field("644", 8), field(string(length(body)), 10), UInt8['`', '\n'],
+                                      body, isodd(length(body)) ? UInt8['\n'] : UInt8[])
+            path = joinpath(dir, "libtiny.a")
+            write(path, vcat(Vector{UInt8}(codeunits("!<arch>\n")), member("/", zeros(UInt8, 4)), member("tiny.o/", object)))
+
+            image = BR.read_binary(path)
+            @test image.format == :archive
+            @test image.kind == :static_lib
+            @test "foo" in [s.name for s in BR.exported_symbols(image)]
+        end
+
+        @testset "Caching" begin
+            path = joinpath(dir, "libtiny.so")
+            copy_path = joinpath(dir, "libcopy.so")
+            cp(path, copy_path)
+            cache_dir = joinpath(dir, "cache")
+
+            first_read, second_read = BR.read_binaries([path, copy_path]; cache_dir=cache_dir)
+            @test first_read.hash == second_read.hash
+            @test second_read.path == copy_path
+            @test isfile(BR.cache_file(cache_dir, first_read.hash))
+
+            # A fresh process would start from the on-disk entry
+            empty!(BR.STAT_CACHE)
+            empty!(BR.IMAGE_CACHE)
+            @test BR.read_binary(path; cache_dir=cache_dir).symbols == first_read.symbols
+        end
+
+        @testset "Unknown input" begin
+            path = joinpath(dir, "notes.txt")
+            write(path, "just some text, not a binary")
+            @test BR.read_binary(path).format == :unknown
+            @test BR.read_binary(joinpath(dir, "missing")).format == :unknown
+
+            # Truncated headers are reported as unknown rather than thrown
+            write(path, tiny_elf()[1:80])
+            @test BR.read_binary(path).format == :unknown
+        end
+    end
+
+    @testset "Host libm" begin
+        libm = Libdl.dlpath(Libdl.dlopen(Base.Math.libm))
+        image = BR.read_binary(libm)
+        @test image.format in (:elf, :macho)
+        @test image.kind == :shared_lib
+        @test "fabs" in [s.name for s in BR.exported_symbols(image)]
+    end
+
+    @testset "Demangling" begin
+        @test BR.demangle("fabs") == "fabs"
+        if BR.demangler() != C_NULL
+            @test BR.demangle("_ZN3foo3barEi") == "foo::bar(int)"
+            @test BR.demangle("_Znot_valid") == "_Znot_valid"
+        end
+    end
+end
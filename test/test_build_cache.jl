@@ -0,0 +1,164 @@
+@testset "BuildCache" begin
+    @testset "Content-addressed keys" begin
+        mktempdir() do dir
+            mkpath(joinpath(dir, "include"))
+            header = joinpath(dir, "include", "util.h")
+            source = joinpath(dir, "main.cpp")
+            write(header, "int util();\n")
+            write(source, "#include \"util.h\"\nint main() { return util(); }\n")
+
+            flags = ["-S", "-emit-llvm", "-O2", "-I$(joinpath(dir, "include"))"]
+            key = JMake.BuildCache.cache_key(source, flags; toolchain="clang 20")
+
+            @test JMake.BuildCache.resolve_header_closure(source, [joinpath(dir, "include")]) == [abspath(header)]
+            @test key == JMake.BuildCache.cache_key(source, flags; toolchain="clang 20")
+            @test key != JMake.BuildCache.cache_key(source, [flags; "-DNDEBUG"]; toolchain="clang 20")
+            @test key != JMake.BuildCache.cache_key(source, flags; toolchain="clang 21")
+
+            # Header edits invalidate the key even though the source is untouched
+            write(header, "int util(int);\n")
+            @test key != JMake.BuildCache.cache_key(source, flags; toolchain="clang 20")
+        end
+    end
+
+    @testset "Per-unit include dirs" begin
+        mktempdir() do dir
+            inc, other, late = joinpath(dir, "include"), joinpath(dir, "other"), joinpath(dir, "late")
+            mkpath.([inc, other, late])
+            write(joinpath(inc, "api.h"), "#include \"detail.h\"\n#include <vector>\n")
+            write(joinpath(inc, "detail.h"), "int detail();\n")
+            write(joinpath(other, "unused.h"), "")
+            write(joinpath(late, "late.h"), "")
+            source = joinpath(dir, "main.cpp")
+            write(source, "#include \"api.h\"\nint main() { return detail(); }\n")
+
+            # Only the directory that supplies headers is kept; <vector> is not a project header
+            @test JMake.BuildCache.unit_include_dirs(source, [other, inc]) == [inc]
+            @test JMake.BuildCache.unit_include_dirs(source, [other]; strict=true) === nothing
+            @test JMake.BuildCache.unit_include_dirs(source, [other]) == String[]
+
+            write(joinpath(dir, "macro.cpp"), "#define H \"api.h\"\n#include H\n")
+            @test JMake.BuildCache.unit_include_dirs(joinpath(dir, "macro.cpp"), [inc]) === nothing
+
+            # The subset resolves the same closure as the full list
+            @test JMake.BuildCache.resolve_header_closure(source, [inc]) ==
+                  JMake.BuildCache.resolve_header_closure(source, [other, inc, late])
+        end
+    end
+
+    @testset "Artifact store" begin
+        mktempdir() do dir
+            cache = JMake.BuildCache.ArtifactCache(joinpath(dir, "cache"))
+            artifact = joinpath(dir, "a.ll")
+            write(artifact, "; ModuleID = 'a'\n")
+            key = repeat("ab", 32)
+
+            @test JMake.BuildCache.lookup(cache, key, ".ll") === nothing
+            JMake.BuildCache.store!(cache, key, ".ll", artifact)
+            dest = joinpath(dir, "out", "a.ll")
+            @test JMake.BuildCache.fetch!(cache, key, ".ll", dest)
+            @test read(dest, String) == "; ModuleID = 'a'\n"
+            @test cache.hits[] == 1 && cache.misses[] == 1
+
+            # Same basename in different directories must not collide
+            @test JMake.BuildCache.output_path(dir, "/a/util.cpp", ".ll") !=
+                  JMake.BuildCache.output_path(dir, "/b/util.cpp", ".ll")
+        end
+    end
+
+    @testset "Remote store" begin
+        mktempdir() do dir
+            remote = JMake.BuildCache.remote_store(joinpath(dir, "shared"))
+            @test remote isa JMake.BuildCache.FileStore
+            @test JMake.BuildCache.remote_store("https://cache.example.com/jmake/") isa JMake.BuildCache.HTTPStore
+            @test JMake.BuildCache.remote_store("") === nothing
+
+            artifact = joinpath(dir, "a.bc")
+            write(artifact, "BC\xc0\xde")
+            key = repeat("cd", 32)
+
+            # Write-back: a store on one node is uploaded to the shared store
+            node_a = JMake.BuildCache.ArtifactCache(joinpath(dir, "node_a"); remote=remote)
+            JMake.BuildCache.store!(node_a, key, ".bc", artifact)
+            JMake.BuildCache.flush!(node_a)
+            @test isfile(joinpath(dir, "shared", "objects", key[1:2], key * ".bc"))
+
+            # Read-through: another node's miss is served remotely and kept locally
+            node_b = JMake.BuildCache.ArtifactCache(joinpath(dir, "node_b"); remote=remote)
+            dest = joinpath(dir, "out", "a.bc")
+            @test JMake.BuildCache.fetch!(node_b, key, ".bc", dest)
+            @test read(dest) == read(artifact)
+            @test node_b.remote_hits[] == 1
+            @test isfile(JMake.BuildCache.artifact_path(node_b, key, ".bc"))
+            @test JMake.BuildCache.lookup(node_b, key, ".bc") !== nothing
+            @test node_b.remote_hits[] == 1
+
+            @test JMake.BuildCache.lookup(node_b, repeat("ef", 32), ".bc") === nothing
+            @test JMake.BuildCache.cache_stats(node_b)["remote"] == remote.root
+
+            local_only = JMake.BuildCache.ArtifactCache(joinpath(dir, "node_c"); remote=nothing)
+            @test JMake.BuildCache.lookup(local_only, key, ".bc") === nothing
+        end
+    end
+
+    @testset "Precompiled headers" begin
+        BC = JMake.BuildCache
+        mktempdir() do dir
+            inc = joinpath(dir, "include")
+            mkpath(joinpath(inc, "detail"))
+            write(joinpath(inc, "common.h"), "#pragma once\n#include \"detail/impl.h\"\n")
+            write(joinpath(inc, "detail", "impl.h"), "#pragma once\nint impl();\n")
+            write(joinpath(inc, "math.h"), "#pragma once\ninline int sq(int x) { return x * x; }\n")
+            write(joinpath(inc, "rare.h"), "#pragma once\n")
+            write(joinpath(inc, "ops.def"), "OP(add)\n")
+            pch_dir = joinpath(dir, "build", "pch")
+            h(name) = joinpath(inc, name)
+
+            graph = Dict(
+                "/src/a.cpp" => [h("common.h"), h("detail/impl.h"), h("math.h"), h("ops.def")],
+                "/src/b.cpp" => [h("common.h"), h("detail/impl.h"), h("math.h"), h("ops.def")],
+                "/src/c.cpp" => [h("common.h"), h("detail/impl.h"), h("rare.h"), joinpath(pch_dir, "core.h")],
+                "/src/d.cpp" => [h("common.h"), h("detail/impl.h"), h("ops.def"), joinpath(pch_dir, "core.h")]
+            )
+            # detail/impl.h comes in through common.h; fragments and old umbrellas never do
+            @test BC.hot_headers(graph; exclude_dir=pch_dir) == [h("common.h"), h("math.h")]
+            @test BC.hot_headers(graph; threshold=0.9) == [h("common.h")]
+            @test isempty(BC.hot_headers(Dict("/src/a.cpp" => [h("math.h")])))
+
+            umbrella = BC.write_pch_umbrella(joinpath(pch_dir, "core.h"), [h("common.h"), h("math.h")])
+            @test read(umbrella, String) == "// Generated by JMake: precompiled header members\n" *
+                                            "#include \"$(h("common.h"))\"\n#include \"$(h("math.h"))\"\n"
+            stamp = mtime(umbrella)
+            sleep(0.01)
+            BC.write_pch_umbrella(umbrella, [h("common.h"), h("math.h")])
+            @test mtime(umbrella) == stamp
+
+            @test BC.pch_flags(nothing) == String[]
+            @test BC.pch_flags("/b/core-0123456789abcdef.pch")[end-1:end] == ["-include-pch", "/b/core-0123456789abcdef.pch"]
+            @test BC.pch_umbrella(BC.pch_path(umbrella, repeat("ab", 32))) == umbrella
+
+            builds = Ref(0)
+            fake_clang(args) = (builds[] += 1; write(args[end], "CPCH"); ("", 0))
+            cache = BC.ArtifactCache(joinpath(dir, "cache"); remote=nothing)
+            flags = ["-x", "c++-header", "-std=c++17", "-I$inc"]
+
+            pch = BC.precompile_header!(fake_clang, cache, umbrella, flags)
+            @test isfile(pch) && builds[] == 1
+            @test BC.precompile_header!(fake_clang, cache, umbrella, flags) == pch
+            rm(pch)
+            @test BC.precompile_header!(fake_clang, cache, umbrella, flags) == pch
+            @test builds[] == 1
+
+            # A member header edit (even one only reached through another member) is a new PCH
+            write(joinpath(inc, "detail", "impl.h"), "#pragma once\nlong impl();\n")
+            edited = BC.precompile_header!(fake_clang, cache, umbrella, flags)
+            @test edited != pch && builds[] == 2
+            @test isfile(edited) && !isfile(pch) && isfile(umbrella)
+            @test BC.precompile_header!(fake_clang, cache, umbrella, [flags; "-O2"]) != edited
+
+            failing(args) = ("error: unknown type name", 1)
+            write(joinpath(inc, "math.h"), "#pragma once\nbroken\n")
+            @test (@test_logs (:warn,) BC.precompile_header!(failing, cache, umbrella, flags)) === nothing
+        end
+    end
+end
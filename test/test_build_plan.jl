@@ -0,0 +1,94 @@
+@testset "Incremental build plan" begin
+    LM = JMake.LLVMake
+
+    mktempdir() do dir
+        mkpath(joinpath(dir, "include"))
+        header = joinpath(dir, "include", "shared.h")
+        write(header, "int shared();\n")
+
+        sources = Dict(
+            "a" => joinpath(dir, "src", "core", "a.cpp"),
+            "b" => joinpath(dir, "src", "core", "b.cpp"),
+            "c" => joinpath(dir, "src", "util", "c.cpp")
+        )
+        for (name, path) in sources
+            mkpath(dirname(path))
+            include_line = name == "b" ? "" : "#include \"shared.h\"\n"
+            write(path, include_line * "int $name() { return 1; }\n")
+        end
+        a, b, c = sources["a"], sources["b"], sources["c"]
+
+        config_file = joinpath(dir, "jmake.toml")
+        write_config(extra) = write(config_file, """
+            project_root = "$dir"
+            [llvm]
+            root = "$(joinpath(dir, "llvm"))"
+            [compile]
+            include_dirs = ["include"]
+            extra_flags = [$(join(repr.(extra), ", "))]
+            """)
+        write_config(String[])
+        compiler = LM.LLVMJuliaCompiler(config_file)
+        groups = LM.group_files_by_component([a, b, c])
+        state = LM.load_build_state(LM.build_state_path(compiler))
+
+        # What compile_project does after a successful component build
+        function built!(plans, include_graph)
+            for plan in plans
+                LM.record_component!(state, plan, include_graph, "signatures")
+                for file in plan.files
+                    ir = JMake.BuildCache.output_path(compiler.config.build_dir, file, LM.ir_extension(compiler))
+                    mkpath(dirname(ir))
+                    touch(ir)
+                end
+                library = joinpath(compiler.config.output_dir, LM.variant_library(plan.name))
+                mkpath(dirname(library))
+                touch(library)
+            end
+        end
+        by_name(plans) = Dict(plan.name => plan for plan in plans)
+
+        plans, include_graph = LM.plan_build(compiler, groups, state)
+        @test all(plan -> plan.rebuild && plan.reason == "first build", plans)
+        @test include_graph[abspath(a)] == [abspath(header)]
+        @test isempty(include_graph[abspath(b)])
+
+        reverse_graph = LM.reverse_include_graph(include_graph)
+        @test Set(reverse_graph[abspath(header)]) == Set(abspath.([a, c]))
+        @test !any(dependents -> abspath(b) in dependents, values(reverse_graph))
+        built!(plans, include_graph)
+        @test Set(keys(state["components"])) == Set(["core", "util"])
+        @test all(entry -> entry["flags"] == first(plans).flags, values(state["components"]))
+
+        @testset "No change skips everything" begin
+            plans, _ = LM.plan_build(compiler, groups, state)
+            @test all(plan -> !plan.rebuild && isempty(plan.affected), plans)
+            @test all(plan -> plan.reason == "no changes", plans)
+        end
+
+        @testset "Header edit rebuilds only its dependents" begin
+            write(header, "int shared();\nint more();\n")
+            # The watcher's change set is re-read even if the mtime did not move
+            plans, include_graph = LM.plan_build(compiler, groups, state; changed_files=[header])
+            planned = by_name(plans)
+            @test planned["core"].rebuild && planned["core"].affected == [a]
+            @test planned["util"].rebuild && planned["util"].affected == [c]
+            built!(plans, include_graph)
+
+            write(b, "int b() { return 2; }\n")
+            plans, include_graph = LM.plan_build(compiler, groups, state; changed_files=[b])
+            planned = by_name(plans)
+            @test planned["core"].affected == [b]
+            @test !planned["util"].rebuild
+            built!(plans, include_graph)
+        end
+
+        @testset "Flags change rebuilds everything" begin
+            write_config(["-DJMAKE_TEST"])
+            compiler = LM.LLVMJuliaCompiler(config_file)
+            plans, _ = LM.plan_build(compiler, groups, state)
+            @test all(plan -> plan.rebuild && plan.reason == "compiler flags changed", plans)
+            @test all(plan -> plan.affected == plan.files, plans)
+        end
+    end
+end
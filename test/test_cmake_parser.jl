@@ -1,6 +1,87 @@
 @testset "CMakeParser" begin
-    @testset "CMake Parsing" begin
-        # Placeholder for CMake parser tests
-        @test true  # TODO: Add CMake parsing tests
+    CP = JMake.CMakeParser
+
+    @testset "Variable expansion" begin
+        vars = Dict("ROOT" => "/src", "arch" => "x86", "lib_x86" => "fast", "SRCS" => "a.cpp;b.cpp")
+        @test CP.expand_variables("\${ROOT}/include", vars) == "/src/include"
+        @test CP.expand_variables("\${lib_\${arch}}", vars) == "fast"
+        @test CP.expand_variables("x\${MISSING}y", vars) == "xy"
+        @test CP.expand_variables("\$ENV{JMAKE_CMAKE_TEST_UNSET}", vars) == ""
+        @test CP.expand_variables("\${ROOT", vars) == "\${ROOT"
+        @test CP.substitute_variables("\${ROOT}/\$(arch)/\${MISSING}", vars) == "/src/x86/\${MISSING}"
+        @test CP.expand_arguments(["\${SRCS}", "c.cpp", "\${MISSING}"], vars) == ["a.cpp", "b.cpp", "c.cpp"]
+    end
+
+    @testset "Tokenizing" begin
+        @test CP.tokenize_line("add_library(mylib SHARED \"a b.cpp\" c.cpp)") ==
+              ["add_library", "(", "mylib", "SHARED", "a b.cpp", "c.cpp", ")"]
+        @test CP.remove_comments("set(X \"#not a comment\") # comment") == "set(X \"#not a comment\") "
+    end
+
+    @testset "Subdirectory tree" begin
+        mktempdir() do root
+            write(joinpath(root, "CMakeLists.txt"), """
+            cmake_minimum_required(VERSION 3.16)
+            project(Tree)
+            set(COMMON_FLAGS -O2 -fPIC)
+            option(WITH_EXTRAS "Build extras" ON)
+            add_subdirectory(core)
+            add_subdirectory(apps)
+            # Applies to a target defined in a subdirectory
+            target_compile_definitions(core PRIVATE FROM_ROOT=1)
+            """)
+            mkpath(joinpath(root, "core"))
+            write(joinpath(root, "core", "CMakeLists.txt"), """
+            set(CORE_SOURCES
+                core.cpp   # main file
+                util.cpp)
+            list(APPEND CORE_SOURCES extra.cpp)
+            add_library(core SHARED \${CORE_SOURCES})
+            target_compile_options(core PRIVATE \${COMMON_FLAGS})
+            target_include_directories(core PUBLIC \${CMAKE_CURRENT_SOURCE_DIR}/include)
+            set(COMMON_FLAGS -O0)  # local to core/
+            """)
+            mkpath(joinpath(root, "apps"))
+            write(joinpath(root, "apps", "CMakeLists.txt"), """
+            add_executable(app main.cpp)
+            target_compile_options(app PRIVATE \${COMMON_FLAGS})
+            target_link_libraries(app core)
+            add_subdirectory(missing_dir)
+            """)
+
+            cache_dir = joinpath(root, ".jmake_cache")
+            project, stats = CP.parse_cmake_tree(joinpath(root, "CMakeLists.txt"); cache_dir=cache_dir)
+            @test stats == (lists=3, reparsed=3)
+            @test project.project_name == "Tree"
+            @test project.subdirectories == ["core", "apps", joinpath("apps", "missing_dir")]
+            @test project.variables["WITH_EXTRAS"] == "ON"
+            @test project.variables["COMMON_FLAGS"] == "-O2;-fPIC"
+
+            core = project.targets["core"]
+            @test core.type == :shared_library
+            @test basename.(core.sources) == ["core.cpp", "util.cpp", "extra.cpp"]
+            @test all(startswith(joinpath(root, "core")), core.sources)
+            @test core.compile_options == ["-O2", "-fPIC"]
+            @test core.include_dirs == [joinpath(root, "core", "include")]
+            @test core.compile_definitions["FROM_ROOT"] == "1"
+
+            app = project.targets["app"]
+            @test app.compile_options == ["-O2", "-fPIC"]
+            @test app.link_libraries == ["core"]
+
+            # Only the edited list is tokenized again, here and in a fresh process (disk cache)
+            open(io -> println(io, "add_executable(tool tool.cpp)"), joinpath(root, "apps", "CMakeLists.txt"), "a")
+            project, stats = CP.parse_cmake_tree(joinpath(root, "CMakeLists.txt"); cache_dir=cache_dir)
+            @test stats == (lists=3, reparsed=1)
+            @test haskey(project.targets, "tool")
+
+            empty!(CP.COMMAND_CACHE)
+            _, stats = CP.parse_cmake_tree(joinpath(root, "CMakeLists.txt"); cache_dir=cache_dir)
+            @test stats == (lists=3, reparsed=0)
+
+            flat = CP.parse_cmake_file(joinpath(root, "CMakeLists.txt"); recursive=false)
+            @test isempty(flat.targets)
+            @test flat.subdirectories == ["core", "apps"]
+        end
     end
 end
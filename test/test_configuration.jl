@@ -1,6 +1,81 @@
+using TOML
+
 @testset "ConfigurationManager" begin
+    CM = JMake.ConfigurationManager
+
     @testset "Config Loading" begin
-        # Placeholder for configuration tests
-        @test true  # TODO: Add actual configuration tests
+        mktempdir() do dir
+            config_file = joinpath(dir, "jmake.toml")
+            cd(() -> CM.load_config(config_file), dir)
+            @test isfile(config_file)
+            @test !isfile(CM.index_path(config_file))
+            config = CM.load_config(config_file)
+            @test config.discovery isa CM.IndexedSection && isempty(config.discovery.pending)
+        end
+    end
+
+    @testset "Binary index" begin
+        mktempdir() do dir
+            file = joinpath(dir, "values.index")
+            value = Dict("paths" => ["a.cpp", "b.cpp", "a.cpp"], "count" => 3, "ratio" => 0.5,
+                         "flags" => Any[true, false, nothing, Any[]], "nested" => Dict("x" => "a.cpp"))
+            CM.write_index(file, Dict("value" => CM.encode_entry(value), "name" => CM.encode_entry(:sym)))
+            index = CM.open_index(file)
+            @test sort(collect(keys(index.entries))) == ["name", "value"]
+            @test CM.read_entry(index, "value") == value
+            @test CM.read_entry(index, "value")["paths"] isa Vector{String}
+            @test CM.read_entry(index, "name") == "sym"
+
+            # Other versions and foreign files are ignored
+            write(file, "JMKINDEX", htol(UInt32(99)), htol(UInt32(0)))
+            @test (@test_logs (:warn,) CM.open_index(file)) === nothing
+            @test CM.open_index(joinpath(dir, "missing.index")) === nothing
+
+            CM.write_index(file, Dict{String,Vector{UInt8}}())
+            @test !isfile(file)
+        end
+    end
+
+    @testset "Bulky stage data in the sidecar" begin
+        mktempdir() do dir
+            config_file = joinpath(dir, "jmake.toml")
+            config = cd(() -> CM.load_config(config_file), dir)
+            sources = ["src/file$i.cpp" for i in 1:500]
+            graph = Dict(s => ["include/common.h"] for s in sources)
+            CM.set_source_files(config, Dict("cpp_sources" => sources, "cpp_headers" => ["include/common.h"]))
+            CM.set_dependency_graph(config, graph)
+            CM.set_include_dirs(config, ["include"])
+            CM.update_symbols_data(config, Dict("table" => ["sym$i" for i in 1:100], "method" => "nm"))
+            CM.save_config(config)
+
+            # The TOML keeps the settings; lists and graphs are in the index
+            toml = TOML.parsefile(config_file)
+            @test toml["discovery"]["include_dirs"] == ["include"]
+            @test !haskey(toml["discovery"], "files") && !haskey(toml["discovery"], "dependency_graph")
+            @test toml["symbols"]["method"] == "nm" && !haskey(toml["symbols"], "table")
+            @test occursin("compile", read(config_file, String))
+            @test isfile(CM.index_path(config_file))
+
+            # Indexed fields are decoded on first access only
+            loaded = CM.load_config(config_file)
+            @test loaded.discovery.pending == Set(["files", "dependency_graph"])
+            @test haskey(loaded.discovery, "files") && length(loaded.discovery) == length(config.discovery)
+            @test CM.get_source_files(loaded)["cpp_sources"] == sources
+            @test loaded.discovery.pending == Set(["dependency_graph"])
+
+            # Untouched entries survive a save without being decoded
+            loaded.compile["jobs"] = 8
+            CM.save_config(loaded)
+            @test loaded.discovery.pending == Set(["dependency_graph"])
+            again = CM.load_config(config_file)
+            @test CM.get_dependency_graph(again) == graph
+            @test again.compile["jobs"] == 8
+            @test Dict(again.symbols) == Dict(config.symbols)
+
+            # A field edited by hand in the TOML wins over the index
+            edited = replace(read(config_file, String), r"\[discovery\]" => "[discovery]\nfiles = \"edited\"")
+            write(config_file, edited)
+            @test CM.get_source_files(CM.load_config(config_file)) == "edited"
+        end
     end
 end
@@ -0,0 +1,190 @@
+using Sockets
+
+@testset "DaemonRPC" begin
+    @testset "Framing" begin
+        io = IOBuffer()
+        DaemonRPC.write_frame(io, DaemonRPC.Request(7, :scan_files, Dict{String,Any}("path" => "/tmp")))
+        seekstart(io)
+        @test read(io, UInt8) == DaemonRPC.PROTOCOL_VERSION
+        seekstart(io)
+        request = DaemonRPC.read_frame(io)
+        @test request isa DaemonRPC.Request
+        @test request.id == 7 && request.func == :scan_files
+        @test request.args["path"] == "/tmp"
+
+        bad = IOBuffer(UInt8[DaemonRPC.PROTOCOL_VERSION + 0x01, 0, 0, 0, 0])
+        @test_throws ErrorException DaemonRPC.read_frame(bad)
+    end
+
+    @testset "Calls over the socket" begin
+        # Random high port so parallel test runs don't collide
+        port = 47000 + rand(0:800)
+
+        echo(args) = Dict(:success => true, :echo => args["value"])
+        function stream(args)
+            for i in 1:args["n"]
+                DaemonRPC.progress(Dict("step" => i))
+            end
+            return Dict(:success => true, :steps => args["n"])
+        end
+        fail(args) = error("handler exploded")
+        slow(args) = (sleep(args["delay"]); args["delay"])
+
+        server = DaemonRPC.serve_rpc(port, [echo, stream, fail, slow, "renamed" => echo])
+        try
+            @test DaemonRPC.ping(port)
+            @test DaemonRPC.call(port, "echo", Dict("value" => [1, 2, 3]))[:echo] == [1, 2, 3]
+            @test DaemonRPC.call(port, :renamed, Dict(:value => "x"))[:echo] == "x"
+
+            events = Dict{String,Any}[]
+            result = DaemonRPC.call(port, "stream", Dict("n" => 3); on_progress=e -> push!(events, e))
+            @test result[:steps] == 3
+            @test [e["step"] for e in events] == [1, 2, 3]
+
+            unknown = DaemonRPC.call(port, "nope")
+            @test unknown[:success] == false
+            @test occursin("Unknown function", unknown[:error])
+
+            failed = DaemonRPC.call(port, "fail")
+            @test failed[:success] == false
+            @test occursin("handler exploded", failed[:error])
+
+            # Concurrent calls share pooled connections and finish out of order
+            delays = [0.3, 0.1, 0.2]
+            tasks = [@async DaemonRPC.call(port, "slow", Dict("delay" => d)) for d in delays]
+            @test fetch.(tasks) == delays
+            @test length(DaemonRPC.CONNECTIONS[("127.0.0.1", port)]) <= DaemonRPC.MAX_CONNECTIONS_PER_SERVICE
+
+            timed_out = DaemonRPC.call(port, "slow", Dict("delay" => 1.0); timeout=0.1)
+            @test timed_out[:success] == false
+            @test occursin("Timed out", timed_out[:error])
+        finally
+            DaemonRPC.close_connections()
+            close(server)
+        end
+
+        @test !DaemonRPC.ping(port; timeout=0.5)
+        @test DaemonRPC.call(port, "echo", Dict("value" => 1))[:success] == false
+    end
+
+    @testset "Separately included copies" begin
+        # The CLI includes its own copy of DaemonRPC.jl next to JMake's; frames carry no
+        # types of either, so the two copies call each other
+        other = Module(:OtherDaemonRPC)
+        Base.include(other, joinpath(@__DIR__, "..", "src", "DaemonRPC.jl"))
+        Other = other.DaemonRPC
+        @test Other.Request !== DaemonRPC.Request
+
+        port = 45000 + rand(0:400)
+        other_port = port + 401
+        function stream(args)
+            DaemonRPC.progress(Dict("step" => 1))
+            return Dict(:success => true, :value => args["value"])
+        end
+        other_echo(args) = Dict(:success => true, :value => args["value"])
+
+        server = DaemonRPC.serve_rpc(port, [stream])
+        other_server = Other.serve_rpc(other_port, [other_echo])
+        try
+            events = Any[]
+            result = Other.call(port, :stream, Dict("value" => [1, 2]); timeout=5.0,
+                                on_progress=e -> push!(events, e))
+            @test result[:success] && result[:value] == [1, 2]
+            @test events == [Dict{String,Any}("step" => 1)]
+            @test DaemonRPC.call(other_port, :other_echo, Dict("value" => "x"); timeout=5.0)[:value] == "x"
+            @test Other.ping(port) && DaemonRPC.ping(other_port)
+
+            # A frame the server cannot use is answered with an error, not dropped
+            socket = connect(ip"127.0.0.1", port + DaemonRPC.RPC_PORT_OFFSET)
+            DaemonRPC.write_frame(socket, DaemonRPC.Response(11, :stray, nothing))
+            reply = DaemonRPC.read_frame(socket)
+            @test reply isa DaemonRPC.Response && reply.id == 11 && reply.error !== nothing
+
+            garbage = UInt8[0xff, 0xfe, 0xfd]
+            write(socket, DaemonRPC.PROTOCOL_VERSION, htol(UInt32(9 + length(garbage))),
+                  DaemonRPC.FRAME_REQUEST, htol(UInt64(12)), garbage)
+            reply = DaemonRPC.read_frame(socket)
+            @test reply isa DaemonRPC.Response && reply.id == 12
+            @test occursin("Cannot decode", reply.error)
+            close(socket)
+        finally
+            DaemonRPC.close_connections()
+            Other.close_connections()
+            close(server)
+            close(other_server)
+        end
+    end
+
+    @testset "In-process fast path" begin
+        port = 47900 + rand(0:90)
+        seen = Ref{Any}(nothing)
+        capture(args) = (seen[] = args; DaemonRPC.progress(Dict("local" => true)); :done)
+
+        DaemonRPC.register_service(port, [capture])
+        try
+            payload = [1.0, 2.0]
+            events = Any[]
+            @test DaemonRPC.call(port, "capture", Dict("data" => payload); on_progress=e -> push!(events, e)) == :done
+            @test seen[]["data"] === payload  # passed by reference, never serialized
+            @test events == [Dict{String,Any}("local" => true)]
+            @test DaemonRPC.ping(port)
+            @test DaemonRPC.call(port, "missing")[:success] == false
+        finally
+            lock(() -> delete!(DaemonRPC.LOCAL_SERVICES, port), DaemonRPC.LOCAL_LOCK)
+        end
+    end
+
+    @testset "Remote listener" begin
+        # Data-only values survive the round trip; other types are sent as strings
+        io = IOBuffer()
+        value = Dict{String,Any}("n" => 3, "x" => 1.5, "ok" => true, "none" => nothing, "name" => :sym,
+                                 "bytes" => UInt8[1, 2, 3], "list" => Any["a", 1], "range" => 1:2)
+        DaemonRPC.encode_value(io, value)
+        seekstart(io)
+        decoded = DaemonRPC.decode_value(io)
+        @test decoded isa Dict{String,Any}
+        @test decoded["n"] === 3 && decoded["x"] === 1.5 && decoded["ok"] === true
+        @test decoded["none"] === nothing && decoded["name"] === :sym
+        @test decoded["bytes"] == UInt8[1, 2, 3] && decoded["list"] == ["a", 1]
+        @test decoded["range"] == Any[1, 2]
+        @test_throws ErrorException DaemonRPC.decode_value(IOBuffer(UInt8[0xff]))
+        @test_throws ErrorException DaemonRPC.decode_value(IOBuffer(UInt8[DaemonRPC.VALUE_BYTES, 0xff, 0xff, 0, 0]))
+        nested = foldl((v, _) -> Any[v], 1:DaemonRPC.MAX_VALUE_DEPTH + 2; init=1)
+        io = IOBuffer()
+        DaemonRPC.encode_value(io, nested)
+        @test_throws ErrorException DaemonRPC.decode_value(seekstart(io))
+
+        @test DaemonRPC.token_matches("secret", "secret")
+        @test !DaemonRPC.token_matches("secreT", "secret") && !DaemonRPC.token_matches("", "secret")
+        @test_throws ErrorException DaemonRPC.serve_remote(47000, []; token="")
+
+        port = 46000 + rand(0:800)
+        echo(args) = Dict(:success => true, :echo => args["value"])
+        hidden(args) = :should_not_be_reachable
+        server = DaemonRPC.serve_remote(port, [echo]; token="secret", host=ip"127.0.0.1")
+        try
+            result = DaemonRPC.call_remote("127.0.0.1", port, :echo, Dict("value" => UInt8[7, 8]); token="secret")
+            @test result[:success] && result[:echo] == UInt8[7, 8]
+            @test DaemonRPC.call_remote("127.0.0.1", port, :ping; token="secret") === :pong
+
+            denied = DaemonRPC.call_remote("127.0.0.1", port, :echo, Dict("value" => 1); token="wrong")
+            @test denied[:success] == false && occursin("Invalid token", denied[:error])
+            unknown = DaemonRPC.call_remote("127.0.0.1", port, :hidden; token="secret")
+            @test unknown[:success] == false && occursin("Unknown function", unknown[:error])
+
+            # A Serialization frame is never deserialized by the remote listener
+            socket = connect(ip"127.0.0.1", port + DaemonRPC.REMOTE_PORT_OFFSET)
+            DaemonRPC.write_frame(socket, DaemonRPC.Request(1, :echo, Dict{String,Any}("value" => 1)))
+            @test eof(socket)
+            close(socket)
+        finally
+            close(server)
+        end
+        @test DaemonRPC.call_remote("127.0.0.1", port, :ping; token="secret", timeout=1.0)[:success] == false
+    end
+
+    @testset "Service ports" begin
+        @test length(unique(values(DaemonRPC.SERVICE_PORTS))) == length(DaemonRPC.SERVICE_PORTS)
+        @test DaemonRPC.call("no-such-daemon", "ping")[:success] == false
+    end
+end
@@ -3,4 +3,50 @@
         # Placeholder for discovery pipeline tests
         @test true  # TODO: Add discovery tests
     end
+
+    @testset "Incremental file scan" begin
+        mktempdir() do dir
+            mkpath(joinpath(dir, "src"))
+            mkpath(joinpath(dir, "build"))
+            write(joinpath(dir, "src", "main.cpp"), "int main() { return 0; }\n")
+            write(joinpath(dir, "src", "api.h"), "namespace api { int f(); }\n")
+            write(joinpath(dir, "src", "capi.h"), "int f(void);\n")
+            write(joinpath(dir, "build", "ignored.cpp"), "")
+            write(joinpath(dir, "tool"), UInt8[0x7f, 0x45, 0x4c, 0x46, 0x02])
+            write(joinpath(dir, "notes"), "plain text\n")
+
+            scan = JMake.Discovery.scan_all_files(dir)
+            @test scan.cpp_sources == [joinpath("src", "main.cpp")]
+            @test scan.cpp_headers == [joinpath("src", "api.h")]
+            @test scan.c_headers == [joinpath("src", "capi.h")]
+            @test scan.binaries == ["tool"]
+            @test "notes" in scan.other
+            @test isfile(joinpath(dir, ".jmake_cache", "scan_index.json"))
+
+            # A rescan from the index gives the same result; new files are picked up
+            @test JMake.Discovery.scan_all_files(dir).cpp_sources == scan.cpp_sources
+            write(joinpath(dir, "src", "util.cpp"), "")
+            @test sort(JMake.Discovery.scan_all_files(dir).cpp_sources) ==
+                  [joinpath("src", "main.cpp"), joinpath("src", "util.cpp")]
+        end
+    end
+
+    @testset "Streamed scan" begin
+        mktempdir() do dir
+            mkpath(joinpath(dir, "lib", "include"))
+            write(joinpath(dir, "lib", "a.cpp"), "")
+            write(joinpath(dir, "lib", "include", "a.hpp"), "")
+
+            seen = String[]
+            scan = JMake.Discovery.scan_all_files(dir; use_index=false,
+                                                  on_directory=(rel, listing) -> push!(seen, rel))
+            @test seen == ["", "lib", joinpath("lib", "include")]
+
+            # Include dirs from part of the scan are a sorted subset of the final list
+            full = JMake.Discovery.build_include_dirs(dir, scan)
+            partial = JMake.Discovery.build_include_dirs(dir, String[])
+            @test issorted(full) && issubset(partial, full)
+            @test abspath(joinpath(dir, "lib", "include")) in full
+        end
+    end
 end
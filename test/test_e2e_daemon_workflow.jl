@@ -119,7 +119,7 @@ println()
                 # Check IR files were generated
                 ir_dir = joinpath(EXAMPLE_DIR, "build")
                 @test isdir(ir_dir)
-                ir_files = filter(f -> endswith(f, ".ll"), readdir(ir_dir))
+                ir_files = filter(f -> endswith(f, ".bc") || endswith(f, ".ll"), readdir(ir_dir))
                 @test !isempty(ir_files)
                 println("  ✓ IR files: $(length(ir_files)) generated")
 
@@ -260,9 +260,10 @@ println()
             println("  ✓ LLVM tools: $(length(tools)) discovered")
         end
 
-        # Verify files were discovered
-        if haskey(config, "discovery") && haskey(config["discovery"], "files")
-            files = config["discovery"]["files"]
+        # Verify files were discovered (file lists are kept in jmake.index)
+        discovery = JMake.ConfigurationManager.load_config(config_path).discovery
+        if haskey(discovery, "files")
+            files = discovery["files"]
             @test haskey(files, "cpp_sources")
             println("  ✓ Source discovery: $(length(files["cpp_sources"])) files")
         end
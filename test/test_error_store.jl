@@ -0,0 +1,79 @@
+using SQLite
+using DBInterface
+
+const EL = JMake.ErrorLearning
+
+@testset "Error store" begin
+    missing_header(file, line) = """
+    $file:$line:10: fatal error: 'vector_utils.h' file not found
+    #include "vector_utils.h"
+             ^~~~~~~~~~~~~~~~
+    1 error generated.
+    """
+
+    @testset "Fingerprints" begin
+        a = missing_header("/home/a/project/src/math.cpp", 3)
+        b = missing_header("/tmp/checkout/src/math.cpp", 17)
+        @test EL.normalize_error(a) == EL.normalize_error(b)
+        @test EL.error_fingerprint(a) == EL.error_fingerprint(b)
+        @test EL.error_fingerprint(a) != EL.error_fingerprint(replace(a, "vector_utils" => "matrix_utils"))
+        @test !occursin("/home/a", EL.normalize_error(a))
+    end
+
+    mktempdir() do dir
+        @testset "Indexed lookups" begin
+            db = EL.init_db(joinpath(dir, "errors.db"))
+            (id, pattern, _) = EL.record_error(db, "clang++ -c math.cpp", missing_header("/src/math.cpp", 3))
+            @test pattern == "missing_header"
+
+            # Same error elsewhere: found through its fingerprint
+            similar = EL.find_similar_errors(db, "missing_header", missing_header("/other/math.cpp", 9))
+            @test similar.id == [id]
+
+            # Unrecognised errors are matched on their terms, not on the "unknown" pattern
+            (link_id, _, _) = EL.record_error(db, "ld", "ld.lld: error: duplicate symbol: jmake_widget_init")
+            EL.record_error(db, "ld", "ld.lld: error: relocation overflow in libother.a")
+            if EL.has_search_index(db)
+                similar = EL.find_similar_errors(db, "unknown", "error: duplicate symbol: jmake_widget_init in widget.o")
+                @test first(similar.id) == link_id
+            end
+        end
+
+        @testset "Background writer" begin
+            store = EL.ErrorStore(joinpath(dir, "store.db"))
+            (pending, pattern, _) = EL.record_error!(store, "clang++ -c a.cpp", missing_header("/src/a.cpp", 1))
+            @test pattern == "missing_header"
+            EL.record_fix!(store, pending, "Add include directory", "add_include_dir", "config_change", true)
+
+            EL.flush!(store)
+            @test EL.committed_id(pending) > 0
+            @test EL.get_error_stats(store)["successful_fixes"] == 1
+
+            suggestions = EL.suggest_fixes(store, missing_header("/elsewhere/b.cpp", 40))
+            @test suggestions[1]["description"] == "Add include directory"
+            @test suggestions[1]["confidence"] == 1.0
+
+            close(store)
+            @test !isopen(store.queue)
+        end
+
+        @testset "Schema migration" begin
+            path = joinpath(dir, "old.db")
+            old = SQLite.DB(path)
+            DBInterface.execute(old, """
+                CREATE TABLE compilation_errors (
+                    id INTEGER PRIMARY KEY AUTOINCREMENT, timestamp TEXT NOT NULL, command TEXT NOT NULL,
+                    error_output TEXT NOT NULL, error_pattern TEXT, project_path TEXT, file_path TEXT)
+            """)
+            DBInterface.execute(old, """
+                INSERT INTO compilation_errors (timestamp, command, error_output, error_pattern)
+                VALUES ('2024-01-01', 'clang++', ?, 'missing_header')
+            """, [missing_header("/src/old.cpp", 2)])
+            DBInterface.close!(old)
+
+            db = EL.init_db(path)
+            similar = EL.find_similar_errors(db, "missing_header", missing_header("/new/old.cpp", 5))
+            @test size(similar, 1) == 1
+        end
+    end
+end
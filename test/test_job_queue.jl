@@ -0,0 +1,59 @@
+# JobQueue is daemon-side and not part of the JMake module
+isdefined(Main, :JobQueue) || include(joinpath(@__DIR__, "..", "src", "JobQueue.jl"))
+
+@testset "JobQueue" begin
+    @testset "Critical-path scheduling" begin
+        mktempdir() do dir
+            config = JobQueue.ConfigurationManager.load_config(joinpath(dir, "jmake.toml"))
+            job_file = joinpath(dir, "jobs.toml")
+            job(id, priority, deps) = """
+                [[jobs]]
+                id = "$id"
+                type = "test"
+                daemon = "test"
+                port = 0
+                priority = $priority
+                depends_on = [$(join(["\"$d\"" for d in deps], ", "))]
+                target_section = "compile.$id"
+                callback = "noop"
+                """
+            write(job_file, "[job_queue]\nmax_workers = 2\n\n" * join([
+                job("scan", 1, String[]),
+                job("tools", 10, String[]),
+                job("compile", 5, ["scan", "tools"]),
+                job("link", 5, ["compile"]),
+                job("orphan", 5, ["missing"]),
+                job("loop_a", 5, ["loop_b"]),
+                job("loop_b", 5, ["loop_a"]),
+            ], "\n"))
+
+            manager = JobQueue.load_jobs(job_file, config)
+            @test manager.max_workers == 2
+
+            dependents = JobQueue.job_dependents(manager)
+            @test sort(dependents["compile"]) == ["link"]
+
+            weights = Dict("scan" => 4.0, "tools" => 1.0, "compile" => 10.0, "link" => 2.0)
+            ranks = JobQueue.critical_path_lengths(manager, dependents, weights)
+            @test ranks["link"] == 2.0
+            @test ranks["compile"] == 12.0
+            @test ranks["scan"] == 16.0
+            @test ranks["tools"] == 13.0
+
+            # The long branch goes first even though `tools` has the higher priority
+            @test JobQueue.schedule_key(manager.jobs["scan"], ranks) >
+                  JobQueue.schedule_key(manager.jobs["tools"], ranks)
+
+            # Unknown dependencies and cycles never get a rank
+            @test !haskey(ranks, "orphan")
+            @test !haskey(ranks, "loop_a") && !haskey(ranks, "loop_b")
+
+            # A failure only reaches downstream jobs
+            JobQueue.fail_job!(manager.jobs["scan"], "boom")
+            JobQueue.fail_downstream!(manager, dependents, "scan")
+            @test manager.jobs["compile"].status == :failed
+            @test manager.jobs["link"].error == "Dependency failed: compile"
+            @test manager.jobs["tools"].status == :pending
+        end
+    end
+end
@@ -3,4 +3,86 @@
         # Test that we can get toolchain info
         @test_nowarn JMake.LLVMEnvironment.get_toolchain()
     end
+
+    @testset "Per-command environment" begin
+        LE = JMake.LLVMEnvironment
+        toolchain = LE.LLVMToolchain("/opt/llvm", "/opt/llvm/bin", "/opt/llvm/lib", "/opt/llvm/include",
+                                     "/opt/llvm/libexec", "/opt/llvm/share", "20.1.2", 20, 1, 2,
+                                     Dict{String,String}(), Dict{String,String}(), String[], String[], "",
+                                     Dict("LLVM_ROOT" => "/opt/llvm", "JMAKE_TEST_VAR" => "set"),
+                                     true, "intree")
+        before = copy(ENV)
+
+        cmd = LE.llvm_cmd(`true`; toolchain=toolchain)
+        @test "JMAKE_TEST_VAR=set" in cmd.env
+        @test "LLVM_ROOT=/opt/llvm" in cmd.env
+        @test ENV == before
+
+        # One vector per toolchain, shared by every command
+        @test LE.llvm_cmd(`false`; toolchain=toolchain).env === cmd.env
+        @test LE.llvm_env(toolchain) === cmd.env
+
+        # Commands with their own environment keep it
+        own = LE.llvm_cmd(setenv(`true`, ["ONLY=this"]); toolchain=toolchain)
+        @test "ONLY=this" in own.env
+        @test "JMAKE_TEST_VAR=set" in own.env
+        @test !any(startswith("PATH="), own.env)
+
+        # Threads spawning at once see the same environment and leave ENV alone
+        outputs = fetch.([Threads.@spawn read(LE.llvm_cmd(`sh -c 'echo $JMAKE_TEST_VAR'`; toolchain=toolchain), String)
+                          for _ in 1:8])
+        @test all(==("set\n"), outputs)
+        @test !haskey(ENV, "JMAKE_TEST_VAR")
+
+        LE.TOOLCHAIN_ENV[] = nothing
+    end
+
+    @testset "Toolchain manifest" begin
+        LE = JMake.LLVMEnvironment
+        mktempdir() do dir
+            root = joinpath(dir, "LLVM")
+            foreach(d -> mkpath(joinpath(root, d)), ["tools", "lib", "include"])
+            calls = joinpath(dir, "calls")
+            llvm_config = joinpath(root, "tools", "llvm-config")
+            write_config(version) = (write(llvm_config, """
+                #!/bin/sh
+                echo "\$1" >> $calls
+                case "\$1" in
+                    --version) echo $version ;;
+                    --cxxflags) echo -I/opt/llvm/include ;;
+                    --ldflags) echo -L/opt/llvm/lib ;;
+                    *) echo -lLLVM ;;
+                esac
+                """); chmod(llvm_config, 0o755))
+            write_config("20.1.2")
+            probes() = isfile(calls) ? length(readlines(calls)) : 0
+            init() = LE.init_toolchain(config=(llvm=Dict{String,Any}("root" => root, "source" => "intree"),))
+
+            withenv("JMAKE_TOOLCHAIN_CACHE" => joinpath(dir, "manifests")) do
+                first_run = init()
+                @test first_run.version == "20.1.2"
+                @test first_run.cxxflags == ["-I/opt/llvm/include"]
+                @test first_run.tools["llvm-config"] == llvm_config
+                @test probes() == 4
+
+                # Unchanged installation: everything comes from the manifest
+                second_run = init()
+                @test probes() == 4
+                @test second_run.cxxflags == first_run.cxxflags
+                @test second_run.tools == first_run.tools
+
+                # Tool versions are recorded once, then served without running the tool
+                @test strip(LE.tool_version(llvm_config)) == "20.1.2"
+                @test strip(LE.tool_version(llvm_config)) == "20.1.2"
+                init()
+                @test strip(LE.tool_version(llvm_config)) == "20.1.2"
+                @test probes() == 5
+
+                # A replaced binary changes the fingerprint
+                write_config("20.1.10")
+                @test init().version == "20.1.10"
+                @test probes() == 9
+            end
+        end
+    end
 end
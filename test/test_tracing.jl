@@ -0,0 +1,102 @@
+using JSON
+
+@testset "Tracing" begin
+    Tracing = JMake.Tracing
+    was_enabled = Tracing.enabled()
+
+    @testset "Disabled by default" begin
+        Tracing.disable!()
+        Tracing.reset!()
+        @test Tracing.span(() -> 41 + 1, "noop") == 42
+        @test Tracing.count_cache!("noop", true)
+        @test isempty(Tracing.events())
+        @test isempty(Tracing.counters())
+    end
+
+    @testset "Spans and counters across module copies" begin
+        Tracing.enable!()
+        # Each instrumenting module has its own copy; enable! reaches all of them
+        @test JMake.LLVMake.Tracing.enabled()
+        @test JMake.BuildBridge.Tracing.enabled()
+        @test JMake.BuildCache.Tracing.enabled()
+
+        @test Tracing.span("outer"; label="x") do
+            JMake.LLVMake.Tracing.span(() -> :inner, "inner")
+        end == :inner
+        @test_throws ErrorException Tracing.span(() -> error("boom"), "failing")
+
+        names = [e.name for e in Tracing.events()]
+        @test names ⊇ ["outer", "inner", "failing"]
+        outer = only(filter(e -> e.name == "outer", Tracing.events()))
+        @test outer.stop >= outer.start
+        @test outer.args == ["label" => "x"]
+
+        mktempdir() do dir
+            cache = JMake.BuildCache.ArtifactCache(joinpath(dir, "cache"); remote=nothing)
+            artifact = joinpath(dir, "a.bc")
+            write(artifact, "bitcode")
+            key = repeat("ab", 32)
+            @test JMake.BuildCache.lookup(cache, key, ".bc") === nothing
+            JMake.BuildCache.store!(cache, key, ".bc", artifact)
+            @test JMake.BuildCache.lookup(cache, key, ".bc") !== nothing
+        end
+        @test Tracing.counters()["artifact.bc"] == (1, 1)
+
+        # A process is recorded as its spawn and its run
+        output, exitcode = JMake.BuildBridge.run_command(`echo traced`; use_llvm_env=false)
+        @test exitcode == 0 && occursin("traced", output)
+        process_events = filter(e -> e.cat == "process", Tracing.events())
+        @test any(e -> e.name == "spawn", process_events)
+        @test any(e -> e.name == "echo", process_events)
+
+        failed_output, failed_code = JMake.BuildBridge.run_command(`sh -c "echo failing >&2; exit 3"`;
+                                                                    use_llvm_env=false)
+        @test failed_code == 1
+        @test occursin("failing", failed_output)
+    end
+
+    @testset "Chrome trace export" begin
+        mktempdir() do dir
+            file = Tracing.write_trace(joinpath(dir, "trace.json"))
+            trace = JSON.parsefile(file)
+            spans = filter(e -> e["ph"] == "X", trace["traceEvents"])
+            @test length(spans) == length(Tracing.events())
+            @test all(e -> e["dur"] >= 0 && e["ts"] >= 0, spans)
+            @test any(e -> e["name"] == "outer" && e["args"]["label"] == "x", spans)
+
+            counter = only(filter(e -> e["ph"] == "C" && e["name"] == "cache:artifact.bc", trace["traceEvents"]))
+            @test counter["args"]["hit"] == 1 && counter["args"]["miss"] == 1
+
+            summary = sprint(Tracing.print_summary)
+            @test occursin("outer", summary) && occursin("artifact.bc", summary)
+        end
+
+        @test Tracing.trace_file("/tmp/traces/") == "/tmp/traces/jmake-trace-$(getpid()).json"
+        @test Tracing.trace_file("build.json") == "build.json"
+    end
+
+    @testset "Trace requests to a service" begin
+        port = 47000 + rand(0:800)
+        server = JMake.DaemonRPC.serve_rpc(port, ["work" => args -> Dict(:success => true)])
+        try
+            Tracing.reset!()
+            JMake.DaemonRPC.call(port, :work)
+            names = [e.name for e in Tracing.events()]
+            @test "rpc:work" in names
+            @test "serve:work" in names
+
+            mktempdir() do dir
+                path = joinpath(dir, "service.json")
+                result = JMake.DaemonRPC.call(port, :trace, Dict("path" => path, "reset" => true))
+                @test result[:success] && result[:enabled]
+                @test isfile(path)
+                @test isempty(filter(e -> e.name == "serve:work", Tracing.events()))
+            end
+        finally
+            close(server)
+        end
+    end
+
+    Tracing.reset!()
+    was_enabled ? Tracing.enable!() : Tracing.disable!()
+end
@@ -0,0 +1,62 @@
+@testset "Unity builds" begin
+    LM = JMake.LLVMake
+
+    @testset "File-local names" begin
+        mktempdir() do dir
+            source = joinpath(dir, "a.cpp")
+            write(source, """
+            #include "common.h"
+            #define SCRATCH 4
+            #define TEMP 1
+            #undef TEMP
+            namespace {
+            int counter = 0;
+            struct Helper { int x; };
+            int helper(int x) { if (x) { return x; } return 0; }
+            }
+            static int table[] = {1, 2};
+            static double scale(double v) { return v * 2; }
+            // static int commented_out;
+            const char* text = "static int in_string;";
+            int exported(int y) { return helper(y) + table[0]; }
+            """)
+            @test LM.file_local_names(source) == Set(["SCRATCH", "counter", "Helper", "helper", "table", "scale"])
+            @test isempty(LM.file_local_names(joinpath(dir, "missing.cpp")))
+        end
+    end
+
+    @testset "Batches" begin
+        mktempdir() do dir
+            files = String[]
+            for i in 1:8
+                push!(files, joinpath(dir, "f$i.cpp"))
+                write(files[end], "int f$i() { return $i; }\n")
+            end
+            clash_a = joinpath(dir, "clash_a.cpp")
+            clash_b = joinpath(dir, "clash_b.cpp")
+            write(clash_a, "namespace { int helper() { return 1; } }\nint a() { return helper(); }\n")
+            write(clash_b, "namespace { int helper() { return 2; } }\nint b() { return helper(); }\n")
+            big = joinpath(dir, "z_big.cpp")
+            write(big, "int big() { return 0; }\n" * "// padding\n"^200)
+            all_files = [files; clash_a; clash_b; big]
+
+            batches = LM.unity_batches(all_files; batch_size=3)
+            @test reduce(vcat, batches) == sort(all_files)
+            @test all(b -> length(b) <= 3, batches)
+            @test !any(b -> clash_a in b && clash_b in b, batches)
+            @test LM.unity_batches(all_files; batch_size=3) == batches
+
+            # Isolated files build alone; the others keep their order
+            isolated = LM.unity_batches(all_files, Set([files[2]]); batch_size=3)
+            @test [files[2]] in isolated
+            @test reduce(vcat, filter(b -> b != [files[2]], isolated)) == filter(!=(files[2]), sort(all_files))
+
+            # The byte bound keeps the large file out of every batch with others
+            bounded = LM.unity_batches(all_files; batch_size=8, batch_bytes=1024)
+            @test [big] in bounded
+            @test all(b -> sum(filesize, b) <= 1024 || length(b) == 1, bounded)
+
+            @test all(b -> length(b) == 1, LM.unity_batches(all_files; batch_size=1))
+        end
+    end
+end
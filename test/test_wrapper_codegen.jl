@@ -0,0 +1,214 @@
+using Libdl
+
+@testset "Wrapper codegen" begin
+    libm = Libdl.dlpath(Libdl.dlopen(Base.Math.libm))
+    symbols = [
+        Dict{String,Any}("name" => "fabs", "type" => "function", "return_type" => "double",
+                         "parameters" => [Dict("name" => "x", "type" => "double")],
+                         "signature" => "double fabs(double x)"),
+        Dict{String,Any}("name" => "jmake_not_exported", "type" => "function", "return_type" => "int",
+                         "parameters" => Dict{String,String}[], "signature" => "int jmake_not_exported()")
+    ]
+    binary = JMake.JuliaWrapItUp.BinaryInfo(libm, "libm", :shared_lib, string(Sys.ARCH), symbols,
+                                            String[], Dict{String,Any}())
+
+    function wrapper_module(dir, call_mode, safety_checks)
+        config_file = joinpath(dir, "wrapper_$(call_mode)_$(safety_checks).toml")
+        write(config_file, """
+        project_root = "$(escape_string(dir))"
+
+        [wrapper]
+        call_mode = "$call_mode"
+        safety_checks = $safety_checks
+        """)
+        wrapper = JMake.JuliaWrapItUp.BinaryWrapper(config_file)
+        code = JMake.JuliaWrapItUp.generate_advanced_wrapper(wrapper, binary)
+
+        file = joinpath(dir, "wrapper_$(call_mode)_$(safety_checks).jl")
+        write(file, code)
+        host = Module(:WrapperHost)
+        Base.include(host, file)
+        return code, getfield(host, :Libm)
+    end
+
+    mktempdir() do dir
+        @testset "Cached calls" begin
+            code, lib = wrapper_module(dir, "cached", true)
+            @test occursin("ccall(\n        _fptr_fabs[],", code)
+            @test !occursin("(:fabs, _lib_handle[])", code)
+
+            @test lib.is_loaded()
+            @test lib.fabs(-2.5) == 2.5
+            @test lib._fptr_fabs[] == Libdl.dlsym(Libdl.dlopen(libm), :fabs)
+
+            # A missing symbol is reported at load time and on call, not resolved per call
+            @test any(e -> occursin("jmake_not_exported", e), lib.get_load_errors())
+            @test_throws ErrorException lib.jmake_not_exported()
+        end
+
+        @testset "Unchecked cached calls" begin
+            code, lib = wrapper_module(dir, "cached", false)
+            @test occursin("const CHECK_CALLS = false", code)
+            @test lib.fabs(-1.0) == 1.0
+        end
+
+        @testset "Dynamic calls" begin
+            code, lib = wrapper_module(dir, "dynamic", true)
+            @test occursin("(:fabs, _lib_handle[])", code)
+            @test !occursin("_fptr_", code)
+            @test lib.fabs(-3.0) == 3.0
+        end
+
+        @testset "Lazy calls" begin
+            config_file = joinpath(dir, "wrapper_lazy.toml")
+            write(config_file, """
+            project_root = "$(escape_string(dir))"
+
+            [wrapper]
+            call_mode = "lazy"
+            shard_size = 1
+            """)
+            wrapper = JMake.JuliaWrapItUp.BinaryWrapper(config_file)
+            code, shards = JMake.JuliaWrapItUp.generate_lazy_wrapper(wrapper, binary)
+            @test length(shards) == 2
+            @test !occursin("ccall", code)
+
+            file = joinpath(dir, "Libm.jl")
+            write(file, code)
+            JMake.JuliaWrapItUp.write_shards(dir, "Libm", shards)
+            host = Module(:LazyHost)
+            Base.include(host, file)
+            lib = getfield(host, :Libm)
+
+            # Nothing is opened or included until a wrapped name is called
+            @test lib._lib_handle[] == C_NULL
+            @test all(isnothing, lib._shards)
+
+            @test lib.fabs(-2.5) == 2.5
+            @test lib._lib_handle[] != C_NULL
+            @test count(!isnothing, lib._shards) == 1
+            @test lib.load_function(:fabs)(-1.0) == 1.0
+
+            @test_throws ErrorException lib.jmake_not_exported()
+            @test lib.library_info()[:shards_loaded] == 2
+        end
+
+        @testset "Overloads" begin
+            # Two overloads of one base name (fabs and fabsf stand in for their mangled names)
+            overload(link, cpp) = Dict{String,Any}("name" => "magnitude", "mangled" => link, "type" => "function",
+                                                   "return_type" => cpp, "signature" => "$cpp magnitude($cpp)",
+                                                   "parameters" => [Dict("name" => "x", "type" => cpp)])
+            overloads = JMake.JuliaWrapItUp.BinaryInfo(libm, "libm", :shared_lib, string(Sys.ARCH),
+                                                       [overload("fabs", "double"), overload("fabsf", "float")],
+                                                       String[], Dict{String,Any}())
+            handle = Libdl.dlopen(libm)
+
+            for mode in ("cached", "dynamic", "lazy")
+                config_file = joinpath(dir, "wrapper_overloads_$mode.toml")
+                write(config_file, """
+                project_root = "$(escape_string(dir))"
+
+                [wrapper]
+                call_mode = "$mode"
+                """)
+                wrapper = JMake.JuliaWrapItUp.BinaryWrapper(config_file)
+                module_dir = mkpath(joinpath(dir, "overloads_$mode"))
+                file = joinpath(module_dir, "Libm.jl")
+                if mode == "lazy"
+                    code, shards = JMake.JuliaWrapItUp.generate_lazy_wrapper(wrapper, overloads)
+                    JMake.JuliaWrapItUp.write_shards(module_dir, "Libm", shards)
+                else
+                    code = JMake.JuliaWrapItUp.generate_advanced_wrapper(wrapper, overloads)
+                end
+                write(file, code)
+                host = Module(:OverloadHost)
+                Base.include(host, file)
+                lib = getfield(host, :Libm)
+
+                # Each method calls its own symbol: the Float32 one would read garbage through fabs
+                @test lib.magnitude(-2.5) === 2.5
+                @test lib.magnitude(-1.5f0) === 1.5f0
+                if mode == "cached"
+                    @test lib._fptr_magnitude[] == Libdl.dlsym(handle, :fabs)
+                    @test lib._fptr_magnitude_2[] == Libdl.dlsym(handle, :fabsf)
+                end
+            end
+        end
+    end
+
+    @testset "Array parameters" begin
+        jl_type(t) = JMake.julia_type_from_cpp(String(t))
+        plan = JMake.JuliaWrapItUp.array_parameters(["a", "b", "result", "size"],
+            ["const double *", "const double *", "double *", "int"], jl_type)
+        @test [p.kind for p in plan] == [:array, :array, :array, :length]
+        @test [p.output for p in plan[1:3]] == [false, false, true]
+        @test all(p -> p.length_index == 4, plan[1:3])
+        @test plan[1].jl_type == "Ptr{Cdouble}"
+
+        # Demangled symbols have no names; integer parameters still size the arrays before them
+        plan = JMake.JuliaWrapItUp.array_parameters(["arg1", "arg2", "arg3"],
+            ["double const*", "double", "unsigned long"], jl_type)
+        @test [p.kind for p in plan] == [:array, :scalar, :length]
+        # ... but an unnamed int is a flag or mode as often as a length
+        @test JMake.JuliaWrapItUp.array_parameters(["arg1", "arg2"], ["double const*", "int"], jl_type) === nothing
+        @test JMake.JuliaWrapItUp.array_parameters(["x", "n"], ["const double *", "int"], jl_type) !== nothing
+
+        # Pointer-level wrappers keep their signatures
+        @test jl_type("const double *") == "Ptr{Cvoid}"
+
+        @test JMake.JuliaWrapItUp.array_parameters(["x", "power"], ["double *", "int"], jl_type) === nothing
+        @test JMake.JuliaWrapItUp.array_parameters(["s", "n"], ["const char *", "int"], jl_type) === nothing
+        @test JMake.JuliaWrapItUp.array_parameters(["x"], ["double *"], jl_type) === nothing
+    end
+
+    @testset "Array methods" begin
+        # Callees are Julia @cfunctions, so the generated methods run without a C library
+        host = Module(:ArrayHost)
+        Core.eval(host, quote
+            function c_scale(a::Ptr{Cdouble}, s::Cdouble, out::Ptr{Cdouble}, n::Cint)::Cvoid
+                for i in 1:n
+                    unsafe_store!(out, s * unsafe_load(a, i), i)
+                end
+            end
+            c_dot(a::Ptr{Cdouble}, b::Ptr{Cdouble}, n::Csize_t)::Cdouble =
+                sum(unsafe_load(a, i) * unsafe_load(b, i) for i in 1:n; init=0.0)
+            const SCALE = Ref{Ptr{Cvoid}}(C_NULL)
+            const DOT = Ref{Ptr{Cvoid}}(C_NULL)
+        end)
+        Core.eval(host, :(SCALE[] = @cfunction(c_scale, Cvoid, (Ptr{Cdouble}, Cdouble, Ptr{Cdouble}, Cint))))
+        Core.eval(host, :(DOT[] = @cfunction(c_dot, Cdouble, (Ptr{Cdouble}, Ptr{Cdouble}, Csize_t))))
+
+        jl_type(t) = JMake.julia_type_from_cpp(String(t))
+        scale_plan = JMake.JuliaWrapItUp.array_parameters(["a", "scalar", "result", "n"],
+            ["const double *", "double", "double *", "int"], jl_type)
+        dot_plan = JMake.JuliaWrapItUp.array_parameters(["a", "b", "n"],
+            ["const double *", "const double *", "size_t"], jl_type)
+        code = JMake.JuliaWrapItUp.generate_array_helpers() *
+               JMake.JuliaWrapItUp.generate_array_methods("scale", "scale", scale_plan, "Cvoid", "SCALE[]") *
+               JMake.JuliaWrapItUp.generate_array_methods("dot", "dot", dot_plan, "Cdouble", "DOT[]")
+        Core.eval(host, Meta.parseall(code))
+
+        x = [1.0, 2.0, 3.0]
+        out = zeros(3)
+        @test host.scale(x, 2.0, out) === out
+        @test out == [2.0, 4.0, 6.0]
+        @test host.scale(x, 3.0) == [3.0, 6.0, 9.0]
+        @test host.dot(x, x) == 14.0
+
+        # Contiguous views go through as they are; strided inputs are copied, strided outputs refused
+        @test host.dot(view([0.0, 1.0, 2.0, 3.0], 2:4), x) == 14.0
+        @test host.dot(1.0:3.0, x) == 14.0
+        @test_throws DimensionMismatch host.dot(x, [1.0, 2.0])
+        @test_throws ArgumentError host.scale(x, 1.0, view(zeros(6), 1:2:6))
+    end
+
+    @testset "Pointer slot names" begin
+        slots = JMake.JuliaWrapItUp.pointer_slots(Dict{String,Any}[
+            Dict("name" => "a::f", "type" => "function"),
+            Dict("name" => "b::f", "type" => "function"),
+            Dict("name" => "g", "type" => "data"),
+            Dict("name" => "h", "type" => "other")
+        ])
+        @test slots == Dict("a::f" => "_fptr_f", "b::f" => "_fptr_f_2", "g" => "_dptr_g")
+    end
+end